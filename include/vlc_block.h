@@ -86,6 +86,10 @@
 #define block_Release vlc_frame_Release
 #define block_CopyProperties vlc_frame_CopyProperties
 #define block_Duplicate vlc_frame_Duplicate
+#define block_Shareable vlc_frame_Shareable
+#define block_Share vlc_frame_Share
+#define block_IsShared vlc_frame_IsShared
+#define block_Unshare vlc_frame_Unshare
 #define block_heap_Alloc vlc_frame_heap_Alloc
 #define block_mmap_Alloc vlc_frame_mmap_Alloc
 #define block_shm_Alloc vlc_frame_shm_Alloc
@@ -187,6 +187,30 @@ VLC_API vlc_frame_t *vlc_frame_New(const struct vlc_frame_callbacks *cbs,
  */
 VLC_API vlc_frame_t *vlc_frame_Alloc(size_t size) VLC_USED VLC_MALLOC;
 
+/**
+ * Frame cache statistics.
+ *
+ * Counters are accumulated since the process started. Per-thread hits are
+ * accounted in batches, so the values lag slightly behind.
+ */
+struct vlc_frame_cache_stats
+{
+    uint64_t hits; /**< allocations served from a cache */
+    uint64_t misses; /**< allocations that had to use the heap */
+    uint64_t recycled; /**< frames handed over to the shared cache */
+    uint64_t dropped; /**< frames freed because the shared cache was full */
+};
+
+/**
+ * Reads the frame cache statistics.
+ *
+ * The frame cache is used by vlc_frame_Alloc() when the "frame-cache" option
+ * is enabled.
+ *
+ * @param stats storage for the statistics [OUT]
+ */
+VLC_API void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *stats);
+
 VLC_API vlc_frame_t *vlc_frame_TryRealloc(vlc_frame_t *, ssize_t pre, size_t body) VLC_USED;
 
 /**
@@ -324,6 +348,64 @@ static inline vlc_frame_t *vlc_frame_Duplicate( const vlc_frame_t *frame )
     return p_dup;
 }
 
+/**
+ * Makes a frame shareable.
+ *
+ * Converts a frame into a frame whose payload can be referenced by other
+ * frames with vlc_frame_Share(), without copying it. This is a no-op if the
+ * frame is already shareable.
+ *
+ * @param frame the frame to convert, which must not be used anymore
+ *        after the call to this function
+ * @return the shareable frame, or NULL on memory error (the frame is then
+ *         released)
+ */
+VLC_API vlc_frame_t *vlc_frame_Shareable(vlc_frame_t *frame) VLC_USED;
+
+/**
+ * Shares the payload of a frame.
+ *
+ * Creates a new frame referencing the payload of a shareable frame, with
+ * copied properties. The payload is released with the last frame
+ * referencing it.
+ *
+ * @note The payload of shared frames is read-only: vlc_frame_Realloc() and
+ * vlc_frame_TryRealloc() will copy it before any growth, but it must not be
+ * written to directly. Writers call vlc_frame_Unshare() first.
+ *
+ * @param frame a frame returned by vlc_frame_Shareable() or
+ *        vlc_frame_Share()
+ * @return the new frame on success, NULL on error.
+ */
+VLC_API vlc_frame_t *vlc_frame_Share(const vlc_frame_t *frame) VLC_USED;
+
+/**
+ * Checks if the payload of a frame is referenced by other frames.
+ *
+ * The payload of such a frame must not be written to.
+ */
+VLC_API bool vlc_frame_IsShared(const vlc_frame_t *frame) VLC_USED;
+
+/**
+ * Makes the payload of a frame writable.
+ *
+ * @param frame the frame, which must not be used anymore after the call to
+ *        this function
+ * @return the frame itself if its payload is not shared, a private copy of
+ *         it otherwise (the frame is then released), or NULL on memory error
+ *         (the frame is then released)
+ */
+VLC_USED
+static inline vlc_frame_t *vlc_frame_Unshare(vlc_frame_t *frame)
+{
+    if (!vlc_frame_IsShared(frame))
+        return frame;
+
+    vlc_frame_t *dup = vlc_frame_Duplicate(frame);
+    vlc_frame_Release(frame);
+    return dup;
+}
+
 /**
  * Wraps heap in a frame.
  *
@@ -626,6 +708,21 @@ static inline vlc_frame_t *vlc_frame_ChainGather( vlc_frame_t *p_list )
  */
 VLC_API vlc_fifo_t *vlc_fifo_New(void) VLC_USED VLC_MALLOC;
 
+/**
+ * Creates a thread-safe FIFO queue of blocks with a single consumer.
+ *
+ * This is the same as vlc_fifo_New(), except that queueing only wakes the
+ * consumer up when the FIFO was empty, sparing a condition variable signal
+ * per block on busy queues.
+ *
+ * @warning At most one thread may wait on the FIFO (with vlc_fifo_Wait(),
+ * vlc_fifo_WaitCond() or vlc_fifo_Get()) at any given time, and it must not
+ * rely on being woken up when a block is queued to a non-empty FIFO.
+ *
+ * @return the FIFO or NULL on memory error
+ */
+VLC_API vlc_fifo_t *vlc_fifo_NewSingleConsumer(void) VLC_USED VLC_MALLOC;
+
 /**
  * Delete a FIFO created by vlc_fifo_New().
  *
@@ -101,6 +101,9 @@ typedef struct httpd_message_t
     int64_t i_body_offset;
     size_t  i_body;
     uint8_t *p_body;
+    /* answer body sent as is after p_body, without any copy: the chain is
+     * released by httpd once written out */
+    block_t *p_body_chain;
 
 } httpd_message_t;
 
@@ -113,7 +116,23 @@ VLC_API httpd_url_t * httpd_UrlNew( httpd_host_t *, const char *psz_url, const c
 VLC_API int httpd_UrlCatch( httpd_url_t *, int i_msg, httpd_callback_t, httpd_callback_sys_t * );
 /* delete a url */
 VLC_API void httpd_UrlDelete( httpd_url_t * );
+/**
+ * Wakes up the queries deferred on a url.
+ *
+ * The callback of each deferred query is invoked again.
+ */
+VLC_API void httpd_UrlWakeUp( httpd_url_t * );
 
+/**
+ * Defers the answer to a query.
+ *
+ * When called from a URL callback, nothing is sent for now: the callback is
+ * invoked again with the same query after httpd_UrlWakeUp(), until it
+ * answers. This allows holding requests for content that is not available
+ * yet. If it still defers once the timeout, counted from the first deferral,
+ * has elapsed, 503 (Service Unavailable) is answered.
+ */
+VLC_API void httpd_ClientDefer( httpd_client_t *, vlc_tick_t timeout );
 VLC_API char* httpd_ClientIP( const httpd_client_t *cl, char *, int * );
 VLC_API char* httpd_ServerIP( const httpd_client_t *cl, char *, int * );
 
@@ -584,6 +584,9 @@ vlc_player_GetRate(vlc_player_t *player);
  *
  * @note The rate is saved across several medias
  *
+ * @note From the "keyframes-rate" option (8.f by default), only the keyframes
+ * of the video are decoded, for a smooth trick play on costly streams
+ *
  * @param player locked player instance
  * @param rate new rate (< 1.f is slower, > 1.f is faster)
  */
@@ -744,6 +747,51 @@ vlc_player_JumpTime(vlc_player_t *player, vlc_tick_t jumptime)
                           VLC_PLAYER_WHENCE_RELATIVE);
 }
 
+/**
+ * Get the timeshift window of the current media
+ *
+ * Live media that can't be seeked are buffered by the timeshift when
+ * "input-timeshift-window" is set. vlc_player_SeekByPos() and
+ * vlc_player_SeekByTime() then seek inside this window, positions and times
+ * being relative to its start.
+ *
+ * @see vlc_player_cbs.on_timeshift_changed
+ *
+ * @param player locked player instance
+ * @param length a pointer that will be assigned with the window length
+ * @param delay a pointer that will be assigned with the delay of the playback
+ * behind the newest received data
+ * @retval VLC_SUCCESS when length and delay have been assigned
+ * @retval VLC_EGENERIC if there is no timeshift window
+ */
+VLC_API int
+vlc_player_GetTimeshiftWindow(vlc_player_t *player, vlc_tick_t *length,
+                              vlc_tick_t *delay);
+
+/**
+ * Seek inside the timeshift window of the current media
+ *
+ * @param player locked player instance
+ * @param delay delay behind the newest received data, 0 to go back to live,
+ * clamped to the window length
+ */
+VLC_API void
+vlc_player_SeekTimeshift(vlc_player_t *player, vlc_tick_t delay);
+
+/**
+ * Helper to seek inside the timeshift window by position
+ *
+ * @param player locked player instance
+ * @param position position in the range [0.f;1.f], 1.f being live
+ */
+static inline void
+vlc_player_SetTimeshiftPosition(vlc_player_t *player, double position)
+{
+    vlc_tick_t length, delay;
+    if (vlc_player_GetTimeshiftWindow(player, &length, &delay) == VLC_SUCCESS)
+        vlc_player_SeekTimeshift(player, (1. - position) * length);
+}
+
 /**
  * Display the player position on the vout OSD
  *
@@ -3283,6 +3331,19 @@ struct vlc_player_cbs
      */
     void (*on_stopping_current_media)(vlc_player_t *player,
             input_item_t *current_media, void *data);
+
+    /**
+     * Called when the timeshift window or the playback delay has changed
+     *
+     * @see vlc_player_GetTimeshiftWindow()
+     *
+     * @param player locked player instance
+     * @param length length of the window, 0 if there is no window anymore
+     * @param delay delay of the playback behind the newest received data
+     * @param data opaque pointer set by vlc_player_AddListener()
+     */
+    void (*on_timeshift_changed)(vlc_player_t *player,
+            vlc_tick_t length, vlc_tick_t delay, void *data);
 };
 
 /**
@@ -51,6 +51,7 @@ typedef size_t vlc_preparser_req_id;
 #define VLC_PREPARSER_TYPE_FETCHMETA_NET    0x04
 #define VLC_PREPARSER_TYPE_THUMBNAIL        0x08
 #define VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES 0x10
+#define VLC_PREPARSER_TYPE_STORYBOARD       0x20
 #define VLC_PREPARSER_TYPE_FETCHMETA_ALL \
     (VLC_PREPARSER_TYPE_FETCHMETA_LOCAL|VLC_PREPARSER_TYPE_FETCHMETA_NET)
 
@@ -215,6 +216,105 @@ struct vlc_thumbnailer_output
     unsigned int creat_mode;
 };
 
+/**
+ * Preparser storyboard callbacks
+ *
+ * Used by vlc_preparser_GenerateStoryboard()
+ */
+struct vlc_thumbnailer_storyboard_cbs
+{
+    /**
+     * Event received for each generated frame, in order
+     *
+     * This callback is optional. The picture is owned by the thumbnailer,
+     * and must be acquired by using \link picture_Hold \endlink to use it
+     * pass the callback's scope.
+     *
+     * @param item item used for the thumbnailer
+     * @param index index of the frame, also its index in the sprite
+     * @param time requested time of the frame
+     * @param picture decoded picture, in its original size
+     * @param data opaque pointer passed by vlc_preparser_GenerateStoryboard()
+     */
+    void (*on_picture)(input_item_t *item, size_t index, vlc_tick_t time,
+                       picture_t *picture, void *data);
+
+    /**
+     * Event received on storyboard completion or error
+     *
+     * This callback will always be called, provided
+     * vlc_preparser_GenerateStoryboard() returned a valid request, and
+     * provided the request is not cancelled before its completion.
+     *
+     * @note This callback is mandatory if calling
+     * vlc_preparser_GenerateStoryboard()
+     *
+     * Seek points past the end of the media are not generated, times and
+     * count only describe the frames that were. The sprite, if any, is owned
+     * by the thumbnailer, like the pictures of on_picture().
+     *
+     * @param item item used for the thumbnailer
+     * @param status VLC_SUCCESS if at least one frame was generated,
+     * VLC_ETIMEOUT in case of timeout, -EINTR if cancelled, an error otherwise
+     * @param sprite frames tiled in RGBA, row by row, or NULL if no sprite was
+     * requested or in case of failure
+     * @param times requested time of each frame, NULL in case of failure
+     * @param count number of generated frames
+     * @param data opaque pointer passed by vlc_preparser_GenerateStoryboard()
+     */
+    void (*on_ended)(input_item_t *item, int status, picture_t *sprite,
+                     const vlc_tick_t *times, size_t count, void *data);
+};
+
+/**
+ * Storyboard argument
+ *
+ * Used by vlc_preparser_GenerateStoryboard()
+ */
+struct vlc_thumbnailer_storyboard_arg
+{
+    /**
+     * Seek points, in ascending order, or NULL to take a frame every
+     * interval, starting from the beginning of the media
+     */
+    const vlc_tick_t *times;
+
+    /**
+     * Number of seek points, or the maximum number of frames if times is NULL
+     * (0 to reach the end of the media)
+     */
+    size_t count;
+
+    /** Time between two frames if times is NULL */
+    vlc_tick_t interval;
+
+    /**
+     * Seek speed, fast seeks jump from keyframe to keyframe and only decode
+     * these
+     */
+    enum
+    {
+        /** Precise, but potentially slow */
+        VLC_THUMBNAILER_STORYBOARD_PRECISE,
+        /** Fast, but potentially imprecise */
+        VLC_THUMBNAILER_STORYBOARD_FAST,
+    } speed;
+
+    /** True to enable hardware decoder (false by default) */
+    bool hw_dec;
+
+    /** Number of tiles per row of the sprite, 0 to not generate a sprite */
+    unsigned columns;
+
+    /** Width of a tile, must be set if columns is not 0 */
+    unsigned tile_width;
+
+    /**
+     * Height of a tile, 0 to follow the aspect ratio of the first frame
+     */
+    unsigned tile_height;
+};
+
 /**
  * Preparser creation configuration
  */
@@ -347,6 +447,31 @@ vlc_preparser_GenerateThumbnailToFiles( vlc_preparser_t *preparser, input_item_t
                                         const struct vlc_thumbnailer_to_files_cbs *cbs,
                                         void *cbs_userdata );
 
+/**
+ * This function generates several frames of an item with a single input
+ *
+ * The input is opened once and seeked from one point to the next, which is
+ * much cheaper than generating one thumbnail per point.
+ *
+ * @param preparser the preparser object, created with
+ * VLC_PREPARSER_TYPE_STORYBOARD
+ * @param item a valid item to generate the storyboard for
+ * @param arg pointer to the arg struct (can't be NULL)
+ * @param cbs callback to listen to events (can't be NULL)
+ * @param cbs_userdata opaque pointer used by the callbacks
+ * @return VLC_PREPARSER_REQ_ID_INVALID in case of error, or a valid id if the
+ * item was scheduled for thumbnailing. If this returns an
+ * error, the storyboard.on_ended callback will *not* be invoked
+ *
+ * The provided input_item will be held by the thumbnailer and can safely be
+ * released safely after calling this function.
+ */
+VLC_API vlc_preparser_req_id
+vlc_preparser_GenerateStoryboard( vlc_preparser_t *preparser, input_item_t *item,
+                                  const struct vlc_thumbnailer_storyboard_arg *arg,
+                                  const struct vlc_thumbnailer_storyboard_cbs *cbs,
+                                  void *cbs_userdata );
+
 /**
  * This function cancel all preparsing requests for a given id
  *
@@ -292,6 +292,30 @@ static inline void vlc_tracer_TracePCR( struct vlc_tracer *tracer, const char *t
                              VLC_TRACE_END);
 }
 
+/**
+ * Trace the progress of a frame through the playback pipeline
+ *
+ * Tracer modules can match the stages of a same frame by stream id and pts
+ * to break its end-to-end latency down. The stages are, in pipeline order:
+ * "demux", "decode_in", "decode_out", "filter", "prepare", then "display"
+ * for video or "play" for audio. A frame that is discarded on its way ends
+ * with the "drop" stage instead.
+ *
+ * Frames without a valid pts are not traced.
+ */
+static inline void vlc_tracer_TraceFrame(struct vlc_tracer *tracer,
+                                         const char *id, const char *stage,
+                                         vlc_tick_t pts)
+{
+    if (pts == VLC_TICK_INVALID)
+        return;
+    vlc_tracer_Trace(tracer, VLC_TRACE("type", "FRAME"),
+                             VLC_TRACE("id", id),
+                             VLC_TRACE("stage", stage),
+                             VLC_TRACE_TICK_NS("pts", pts),
+                             VLC_TRACE_END);
+}
+
 /**
  * @}
  */
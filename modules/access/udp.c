@@ -53,13 +53,29 @@
  */
 #define MRU 65507u
 
+#ifdef HAVE_RECVMMSG
+/* Datagrams received per system call */
+# define VLEN 32
+/* Initial receive buffer size, grown to MRU on first truncated datagram */
+# define DEFAULT_MRU 2048u
+#endif
+
 typedef struct {
     int fd;
     int timeout;
 
+#ifdef HAVE_RECVMMSG
+    size_t mru;
+    unsigned count; /* datagrams received by the last call */
+    unsigned next; /* next datagram to return */
+    block_t *blocks[VLEN];
+    struct mmsghdr msgs[VLEN];
+    struct iovec iovecs[VLEN];
+#else
     size_t length;
     char *offset;
     char buf[MRU];
+#endif
 } access_sys_t;
 
 static int Control(stream_t *access, int query, va_list args)
@@ -83,6 +99,75 @@ static int Control(stream_t *access, int query, va_list args)
     return VLC_SUCCESS;
 }
 
+#ifdef HAVE_RECVMMSG
+static block_t *BlockUDP(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->next < sys->count) {
+        block_t *block = sys->blocks[sys->next];
+
+        sys->blocks[sys->next++] = NULL;
+        return block;
+    }
+
+    /* Refill the ring with the buffers handed out by the previous batch,
+     * and replace the unused ones allocated before the MRU was raised */
+    for (unsigned i = 0; i < VLEN; i++) {
+        if (sys->blocks[i] != NULL) {
+            if (likely(sys->blocks[i]->i_buffer >= sys->mru))
+                continue;
+            block_Release(sys->blocks[i]);
+        }
+
+        sys->blocks[i] = block_Alloc(sys->mru);
+        if (unlikely(sys->blocks[i] == NULL))
+            return NULL;
+        sys->iovecs[i].iov_base = sys->blocks[i]->p_buffer;
+        sys->iovecs[i].iov_len = sys->mru;
+    }
+    sys->count = sys->next = 0;
+
+    struct pollfd ufd[1];
+
+    ufd[0].fd = sys->fd;
+    ufd[0].events = POLLIN;
+
+    switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
+        case 0:
+            msg_Err(access, "receive time-out");
+            *eof = true;
+            /* fall through */
+        case -1:
+            return NULL;
+    }
+
+    /* Only take what is already queued, do not wait for a full batch */
+    int val = recvmmsg(sys->fd, sys->msgs, VLEN, MSG_DONTWAIT, NULL);
+    if (val <= 0)
+        return NULL;
+
+    for (int i = 0; i < val; i++) {
+        block_t *block = sys->blocks[i];
+
+        if (unlikely(sys->msgs[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+            msg_Err(access, "datagram truncated (MRU was %zu)", sys->mru);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            /* Allocate larger buffers from the next batch on */
+            sys->mru = MRU;
+        }
+        else
+            block->i_buffer = sys->msgs[i].msg_len;
+        sys->msgs[i].msg_hdr.msg_flags = 0;
+    }
+    sys->count = val;
+    sys->next = 1;
+
+    block_t *block = sys->blocks[0];
+    sys->blocks[0] = NULL;
+    return block;
+}
+#else
 static ssize_t Read(stream_t *access, void *buf, size_t len)
 {
     access_sys_t *sys = access->p_sys;
@@ -131,6 +216,7 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
 
     return val;
 }
+#endif
 
 /*****************************************************************************
  * Open: open the socket
@@ -147,10 +233,23 @@ static int Open( vlc_object_t *p_this )
     if( unlikely( sys == NULL ) )
         return VLC_ENOMEM;
 
-    sys->length = 0;
     p_access->p_sys = sys;
+#ifdef HAVE_RECVMMSG
+    sys->mru = DEFAULT_MRU;
+    sys->count = sys->next = 0;
+    for (unsigned i = 0; i < VLEN; i++) {
+        sys->blocks[i] = NULL;
+        memset(&sys->msgs[i], 0, sizeof (sys->msgs[i]));
+        sys->msgs[i].msg_hdr.msg_iov = &sys->iovecs[i];
+        sys->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    p_access->pf_read = NULL;
+    p_access->pf_block = BlockUDP;
+#else
+    sys->length = 0;
     p_access->pf_read = Read;
     p_access->pf_block = NULL;
+#endif
     p_access->pf_control = Control;
     p_access->pf_seek = NULL;
 
@@ -229,6 +328,11 @@ static void Close( vlc_object_t *p_this )
     access_sys_t *sys = p_access->p_sys;
 
     net_Close( sys->fd );
+#ifdef HAVE_RECVMMSG
+    for (unsigned i = 0; i < VLEN; i++)
+        if (sys->blocks[i] != NULL)
+            block_Release(sys->blocks[i]);
+#endif
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
@@ -934,6 +934,14 @@ static int Statistics(struct cli_client *cl, const char *const *args,
                    item->p_stats->i_lost_abuffers);
         cli_printf(cl, "|");
 
+        /* Frame cache */
+        cli_printf(cl, "%s", _("+-[Frame Cache]"));
+        cli_printf(cl, _("| cache hits       :    %5"PRIi64),
+                   item->p_stats->i_frame_cache_hits);
+        cli_printf(cl, _("| cache misses     :    %5"PRIi64),
+                   item->p_stats->i_frame_cache_misses);
+        cli_printf(cl, "|");
+
         vlc_mutex_unlock(&item->lock);
         cli_printf(cl,  "+----[ end of statistical info ]" );
     }
@@ -24,6 +24,7 @@
 
 #include "SegmentTracker.hpp"
 #include "SharedResources.hpp"
+#include "http/HTTPConnectionManager.h"
 #include "playlist/BasePlaylist.hpp"
 #include "playlist/BaseRepresentation.h"
 #include "playlist/BaseAdaptationSet.h"
@@ -582,6 +583,7 @@ void SegmentTracker::notifyBufferingLevel(vlc_tick_t min, vlc_tick_t max,
                                           vlc_tick_t current, vlc_tick_t target) const
 {
     notify(BufferingLevelChangedEvent(adaptationSet->getID(), min, max, current, target));
+    resources->getConnManager()->updateBufferingLevel(adaptationSet->getID(), current, min);
 }
 
 void SegmentTracker::registerListener(SegmentTrackerListenerInterface *listener)
@@ -33,6 +33,7 @@
 #include <vlc_demux.h>
 
 #include "SharedResources.hpp"
+#include "http/Downloader.hpp"
 #include "logic/BufferingLogic.hpp"
 #include "xml/DOMParser.h"
 
@@ -81,6 +82,15 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_CONNECTIONS_TEXT N_("Parallel downloads per host")
+#define ADAPT_CONNECTIONS_LONGTEXT N_("Maximum number of segments downloaded " \
+                                      "at the same time from a single host")
+
+#define ADAPT_DISKCACHE_TEXT N_("Segment disk cache size (MiB)")
+#define ADAPT_DISKCACHE_LONGTEXT N_("Keeps downloaded segments in a persistent " \
+                                    "cache on disk, revalidated with the server " \
+                                    "when expired. 0 disables the cache.")
+
 #define ADAPT_LOWLATENCY_TEXT N_("Low latency")
 #define ADAPT_LOWLATENCY_LONGTEXT N_("Overrides low latency parameters")
 
@@ -143,6 +153,10 @@ vlc_module_begin ()
                      ADAPT_MAXBUFFER_TEXT, nullptr )
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT )
             change_integer_list(rgi_latency, ppsz_latency)
+        add_integer_with_range( "adaptive-connections", 2, 1, Downloader::MAX_WORKERS,
+                                ADAPT_CONNECTIONS_TEXT, ADAPT_CONNECTIONS_LONGTEXT )
+        add_integer( "adaptive-disk-cache", 0, ADAPT_DISKCACHE_TEXT, ADAPT_DISKCACHE_LONGTEXT )
+            change_integer_range( 0, INT64_C(1) << 20 )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
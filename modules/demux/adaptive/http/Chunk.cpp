@@ -28,6 +28,7 @@
 #include "Chunk.h"
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
+#include "DiskCache.hpp"
 #include "Downloader.hpp"
 
 #include <vlc_common.h>
@@ -45,6 +46,7 @@ AbstractChunkSource::AbstractChunkSource(ChunkType t, const BytesRange &range)
     type = t;
     contentLength = 0;
     requeststatus = RequestStatus::Success;
+    progressive = false;
     bytesRange = range;
     if(bytesRange.isValid() && bytesRange.getEndByte())
         contentLength = bytesRange.getEndByte() - bytesRange.getStartByte();
@@ -80,6 +82,16 @@ ChunkType AbstractChunkSource::getChunkType() const
     return type;
 }
 
+bool AbstractChunkSource::isDone() const
+{
+    return true;
+}
+
+void AbstractChunkSource::setProgressive(bool b)
+{
+    progressive = b;
+}
+
 AbstractChunk::AbstractChunk(AbstractChunkSource *source_)
 {
     bytesRead = 0;
@@ -301,7 +313,8 @@ bool HTTPChunkSource::prepare()
                 break;
         }
 
-        requeststatus = connection->request(connparams.getPath(), bytesRange);
+        requeststatus = connection->request(connparams.getPath(), bytesRange,
+                                            cacheinfo.hasValidators() ? &cacheinfo : nullptr);
         if(requeststatus != RequestStatus::Success)
         {
             if(requeststatus == RequestStatus::Redirection)
@@ -318,6 +331,7 @@ bool HTTPChunkSource::prepare()
         /* Because we don't know Chunk size at start, we need to get size
                from content length */
         contentLength = connection->getContentLength();
+        cacheinfo = connection->getCacheInfo();
         prepared = true;
         responseTime = vlc_tick_now();
         return true;
@@ -345,6 +359,9 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     held = false;
     p_read = nullptr;
     inblockreadoffset = 0;
+    diskcache = nullptr;
+    cachefile = nullptr;
+    measuring = false;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -365,6 +382,12 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         pp_tail = &p_head;
     }
     buffered = 0;
+
+    if(cachefile)
+        fclose(cachefile);
+
+    if(measuring)
+        connManager->transferAborted();
 }
 
 bool HTTPChunkBufferedSource::isDone() const
@@ -386,6 +409,42 @@ void HTTPChunkBufferedSource::release()
     avail.signal();
 }
 
+bool HTTPChunkBufferedSource::prepare()
+{
+    if(prepared)
+        return true;
+
+    uint64_t cachedsize = 0;
+    if(diskcache && !progressive)
+    {
+        requestStartTime = vlc_tick_now();
+        cachefile = diskcache->open(storeid, &cacheinfo, &cachedsize);
+    }
+
+    if(!cachefile)
+        return HTTPChunkSource::prepare();
+
+    if(!cacheinfo.isFresh(time(nullptr)))
+    {
+        /* stale entry, its validators make the request conditional */
+        if(HTTPChunkSource::prepare() ||
+           requeststatus != RequestStatus::NotModified || !connection)
+        {
+            fclose(cachefile);
+            cachefile = nullptr;
+            return prepared;
+        }
+        cacheinfo.expires = connection->getCacheInfo().expires;
+        diskcache->refresh(storeid, cacheinfo);
+    }
+
+    contentLength = cachedsize;
+    requeststatus = RequestStatus::Success;
+    responseTime = vlc_tick_now();
+    prepared = true;
+    return true;
+}
+
 void HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
     {
@@ -403,6 +462,14 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
 
         if(contentLength && readsize > contentLength - buffered)
             readsize = contentLength - buffered;
+
+        /* progressive transfers are paced by the encoder, not the network */
+        if(!measuring && !done && !cachefile && !progressive &&
+           type == ChunkType::Segment)
+        {
+            measuring = true;
+            connManager->transferStarted(requestStartTime);
+        }
     }
 
     block_t *p_block = block_Alloc(readsize);
@@ -412,24 +479,34 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         return;
     }
 
-    struct
+    vlc_tick_t latency = 0;
+    bool b_ended = false;
+
+    ssize_t ret;
+    if(cachefile)
     {
-        size_t size;
-        vlc_tick_t time;
-        vlc_tick_t latency;
-    } rate = {0,0,0};
+        size_t i_read = fread(p_block->p_buffer, 1, readsize, cachefile);
+        ret = (i_read == 0 && ferror(cachefile)) ? -1 : (ssize_t) i_read;
+    }
+    /* Chunked transfers of segments still being produced must be handed
+       over as soon as received, and not once the whole read is filled */
+    else if(progressive)
+        ret = connection->readPartial(p_block->p_buffer, readsize);
+    else
+        ret = connection->read(p_block->p_buffer, readsize);
 
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    bool b_completed = false;
     if(ret <= 0)
     {
         block_Release(p_block);
         p_block = nullptr;
         mutex_locker locker {lock};
         done = true;
+        b_completed = (ret == 0);
         downloadEndTime = vlc_tick_now();
-        rate.size = buffered;
-        rate.time = downloadEndTime - requestStartTime;
-        rate.latency = responseTime - requestStartTime;
+        latency = responseTime - requestStartTime;
+        b_ended = measuring;
+        measuring = false;
         avail.signal();
     }
     else
@@ -443,22 +520,28 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             p_read = p_block;
             inblockreadoffset = 0;
         }
-        if((size_t) ret < readsize)
+        if(!progressive && (size_t) ret < readsize)
         {
             done = true;
+            b_completed = true;
             downloadEndTime = vlc_tick_now();
-            rate.size = buffered;
-            rate.time = downloadEndTime - requestStartTime;
-            rate.latency = responseTime - requestStartTime;
+            latency = responseTime - requestStartTime;
+            b_ended = measuring;
+            measuring = false;
         }
+        if(measuring || b_ended)
+            connManager->transferProgress(ret);
         avail.signal();
     }
 
-    if(rate.size && rate.time && type == ChunkType::Segment)
-    {
-        connManager->updateDownloadRate(sourceid, rate.size,
-                                        rate.time, rate.latency);
-    }
+    if(b_ended)
+        connManager->transferEnded(sourceid, latency);
+
+    /* Still active in the downloader, so nothing else touches the
+     * completed chain and the source cannot go away while writing */
+    if(b_completed && diskcache && !cachefile && !progressive &&
+       (!contentLength || buffered == contentLength))
+        diskcache->store(storeid, cacheinfo, p_head, buffered);
 }
 
 bool HTTPChunkBufferedSource::hasMoreData() const
@@ -43,6 +43,7 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class DiskCache;
 
         enum class ChunkType
         {
@@ -78,6 +79,8 @@ namespace adaptive
                 const StorageID &   getStorageID    () const;
                 const std::string & getContentType  () const override;
                 RequestStatus getRequestStatus() const override;
+                void                setProgressive  (bool);
+                virtual bool        isDone          () const; /* reads no longer wait */
                 virtual void        recycle() = 0;
 
             protected:
@@ -88,6 +91,7 @@ namespace adaptive
                 RequestStatus       requeststatus;
                 size_t              contentLength;
                 BytesRange          bytesRange;
+                bool                progressive; /* still being produced, deliver as received */
         };
 
         class AbstractChunk : public ChunkInterface
@@ -139,6 +143,7 @@ namespace adaptive
 
                 virtual bool        prepare();
                 void                setIdentifier(const std::string &, const BytesRange &);
+                const ConnectionParams & getConnectionParams() const { return params; }
                 AbstractConnection    *connection;
                 AbstractConnectionManager *connManager;
                 mutable vlc::threads::mutex lock;
@@ -149,6 +154,7 @@ namespace adaptive
                 vlc_tick_t          requestStartTime;
                 vlc_tick_t          responseTime;
                 vlc_tick_t          downloadEndTime;
+                CacheInfo           cacheinfo; /* response metadata, or validators */
 
             private:
                 bool init(const std::string &);
@@ -165,14 +171,15 @@ namespace adaptive
                 block_t *  readBlock       ()  override;
                 block_t *  read            (size_t)  override;
                 bool       hasMoreData     () const  override;
+                bool       isDone          () const  override;
                 void        recycle() override;
 
             protected:
                 HTTPChunkBufferedSource(const std::string &url, AbstractConnectionManager *,
                                         const ID &, ChunkType, const BytesRange &,
                                         bool = false);
+                bool               prepare() override;
                 void               bufferize(size_t);
-                bool               isDone() const;
                 void               hold();
                 void               release();
 
@@ -186,6 +193,9 @@ namespace adaptive
                 bool                eof;
                 vlc::threads::condition_variable avail;
                 bool                held;
+                DiskCache          *diskcache;
+                FILE               *cachefile; /* served from disk cache when set */
+                bool                measuring; /* counted in the shared bandwidth */
         };
 
         class HTTPChunk : public AbstractChunk
@@ -117,3 +117,19 @@ void ConnectionParams::parse()
 
     vlc_UrlClean(&url_components);
 }
+
+CacheInfo::CacheInfo()
+{
+    expires = 0;
+    storable = false;
+}
+
+bool CacheInfo::hasValidators() const
+{
+    return !etag.empty() || !lastModified.empty();
+}
+
+bool CacheInfo::isFresh(time_t now) const
+{
+    return now < expires;
+}
@@ -22,6 +22,7 @@
 
 #include <vlc_common.h>
 #include <string>
+#include <ctime>
 
 namespace adaptive
 {
@@ -35,9 +36,23 @@ namespace adaptive
             Redirection,
             Unauthorized,
             NotFound,
+            NotModified,
             GenericError,
         };
 
+        /* HTTP caching metadata of a response, also used as request validators */
+        class CacheInfo
+        {
+            public:
+                CacheInfo();
+                bool hasValidators() const;
+                bool isFresh(time_t) const;
+                std::string etag;
+                std::string lastModified;
+                time_t expires;
+                bool storable;
+        };
+
         class BackendPrefInterface
         {
             /* Design Hack for now to force fallback on regular access
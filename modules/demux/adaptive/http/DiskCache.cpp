@@ -0,0 +1,285 @@
+/*
+ * DiskCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "DiskCache.hpp"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_hash.h>
+#include <vlc_strings.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+#include <sys/stat.h>
+
+using namespace adaptive::http;
+
+/* Entry layout: magic, fixed width expiry (rewritten in place when
+ * revalidated), storage ID, ETag, Last-Modified, body size, then body */
+static const char MAGIC[] = "VLC adaptive cache 1\n";
+static const size_t ENTRY_NAME_LENGTH = VLC_HASH_MD5_DIGEST_HEX_SIZE - 1;
+/* Temporary files older than this were left by interrupted stores */
+static const time_t TMP_MAX_AGE = 3600;
+
+static bool readLine(FILE *f, std::string &line)
+{
+    line.clear();
+    int c;
+    while((c = fgetc(f)) != EOF && c != '\n')
+        line.push_back(c);
+    return c == '\n';
+}
+
+static bool writeAll(int fd, const void *p, size_t size)
+{
+    const uint8_t *buf = static_cast<const uint8_t *>(p);
+    while(size)
+    {
+        ssize_t ret = vlc_write(fd, buf, size);
+        if(ret < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        buf += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+DiskCache::DiskCache(vlc_object_t *obj, const std::string &dir_, uint64_t maxsize_)
+{
+    p_object = obj;
+    dir = dir_;
+    maxsize = maxsize_;
+    total = 0;
+    if(vlc_mkdir_parent(dir.c_str(), 0700) != 0 && errno != EEXIST)
+        msg_Warn(p_object, "cannot create segment cache directory %s", dir.c_str());
+
+    vlc::threads::mutex_locker locker {lock};
+    evict();
+}
+
+DiskCache::~DiskCache()
+{
+}
+
+std::string DiskCache::getPath(const StorageID &id) const
+{
+    vlc_hash_md5_t md5;
+    uint8_t digest[VLC_HASH_MD5_DIGEST_SIZE];
+    char hex[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hash_md5_Init(&md5);
+    vlc_hash_md5_Update(&md5, id.c_str(), id.length());
+    vlc_hash_md5_Finish(&md5, digest, sizeof(digest));
+    vlc_hex_encode_binary(digest, sizeof(digest), hex);
+    return dir + DIR_SEP + hex;
+}
+
+FILE * DiskCache::open(const StorageID &id, CacheInfo *info, uint64_t *size)
+{
+    const std::string path = getPath(id);
+
+    /* opened for update so that reading the entry bumps it in the LRU */
+    bool b_touch = true;
+    FILE *f = vlc_fopen(path.c_str(), "r+b");
+    if(f == nullptr)
+    {
+        f = vlc_fopen(path.c_str(), "rb");
+        if(f == nullptr)
+            return nullptr;
+        b_touch = false;
+    }
+
+    std::string magic, expires, key, bodysize;
+    CacheInfo entry;
+    if(!readLine(f, magic) || magic + "\n" != MAGIC ||
+       !readLine(f, expires) || !readLine(f, key) || key != id ||
+       !readLine(f, entry.etag) || !readLine(f, entry.lastModified) ||
+       !readLine(f, bodysize))
+    {
+        fclose(f);
+        return nullptr;
+    }
+
+    const long offset = ftell(f);
+    struct stat st;
+    entry.expires = strtoll(expires.c_str(), nullptr, 10);
+    entry.storable = true;
+    *size = strtoull(bodysize.c_str(), nullptr, 10);
+    if(offset < 0 || vlc_stat(path.c_str(), &st) != 0 ||
+       (uint64_t) st.st_size != offset + *size)
+    {
+        fclose(f);
+        return nullptr;
+    }
+
+    if(b_touch)
+    {
+        /* rewrite the first byte to update the modification time */
+        if(fseek(f, 0, SEEK_SET) == 0)
+        {
+            fputc(MAGIC[0], f);
+            fflush(f);
+        }
+    }
+
+    if(fseek(f, offset, SEEK_SET) != 0)
+    {
+        fclose(f);
+        return nullptr;
+    }
+
+    *info = entry;
+    return f;
+}
+
+void DiskCache::refresh(const StorageID &id, const CacheInfo &info)
+{
+    FILE *f = vlc_fopen(getPath(id).c_str(), "r+b");
+    if(f == nullptr)
+        return;
+    if(fseek(f, sizeof(MAGIC) - 1, SEEK_SET) == 0)
+        fprintf(f, "%020" PRId64 "\n", (int64_t) info.expires);
+    fclose(f);
+}
+
+void DiskCache::store(const StorageID &id, const CacheInfo &info,
+                      const block_t *p_chain, uint64_t size)
+{
+    if(!info.storable || size == 0 || size > maxsize / 4)
+        return;
+    /* entries we could never reuse nor revalidate */
+    if(!info.hasValidators() && !info.isFresh(time(nullptr)))
+        return;
+    if(id.find_first_of('\n') != std::string::npos ||
+       info.etag.find_first_of('\n') != std::string::npos ||
+       info.lastModified.find_first_of('\n') != std::string::npos)
+        return;
+
+    char *psz_header;
+    if(asprintf(&psz_header, "%s%020" PRId64 "\n%s\n%s\n%s\n%" PRIu64 "\n",
+                MAGIC, (int64_t) info.expires, id.c_str(), info.etag.c_str(),
+                info.lastModified.c_str(), size) < 0)
+        return;
+
+    /* write aside then rename, so readers never see partial entries */
+    std::string tmp = dir + DIR_SEP "tmp.XXXXXX";
+    std::vector<char> tmppath(tmp.begin(), tmp.end());
+    tmppath.push_back('\0');
+    int fd = vlc_mkstemp(tmppath.data());
+    if(fd == -1)
+    {
+        free(psz_header);
+        return;
+    }
+
+    const uint64_t written = strlen(psz_header) + size;
+    bool b_ok = writeAll(fd, psz_header, strlen(psz_header));
+    free(psz_header);
+    for(const block_t *p = p_chain; p && b_ok; p = p->p_next)
+        b_ok = writeAll(fd, p->p_buffer, p->i_buffer);
+    vlc_close(fd);
+
+    const std::string path = getPath(id);
+    vlc::threads::mutex_locker locker {lock};
+
+    /* an overwritten entry no longer uses its space */
+    struct stat st;
+    const uint64_t replaced = (vlc_stat(path.c_str(), &st) == 0) ? st.st_size : 0;
+
+    if(!b_ok || vlc_rename(tmppath.data(), path.c_str()) != 0)
+    {
+        vlc_unlink(tmppath.data());
+        return;
+    }
+
+    total -= std::min(total, replaced);
+    total += written;
+    if(total > maxsize)
+        evict(path);
+}
+
+void DiskCache::evict(const std::string &keep)
+{
+    struct Entry
+    {
+        std::string path;
+        time_t mtime;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+
+    vlc_DIR *d = vlc_opendir(dir.c_str());
+    if(d == nullptr)
+        return;
+
+    total = 0;
+    const time_t now = time(nullptr);
+    const char *psz_name;
+    while((psz_name = vlc_readdir(d)) != nullptr)
+    {
+        const bool b_tmp = !strncmp(psz_name, "tmp.", 4);
+        if(!b_tmp && strlen(psz_name) != ENTRY_NAME_LENGTH)
+            continue;
+        Entry entry;
+        entry.path = dir + DIR_SEP + psz_name;
+        struct stat st;
+        if(vlc_stat(entry.path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+        if(b_tmp)
+        {
+            /* other instances rename their file once written */
+            if(now - st.st_mtime > TMP_MAX_AGE)
+                vlc_unlink(entry.path.c_str());
+            continue;
+        }
+        entry.mtime = st.st_mtime;
+        entry.size = st.st_size;
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    vlc_closedir(d);
+
+    if(total <= maxsize)
+        return;
+
+    /* drop least recently used down to 90%, to not evict on every store */
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.mtime < b.mtime; });
+    for(const Entry &entry : entries)
+    {
+        if(total <= maxsize / 10 * 9)
+            break;
+        /* times have a coarse resolution, never drop what was just stored */
+        if(entry.path == keep)
+            continue;
+        if(vlc_unlink(entry.path.c_str()) == 0)
+            total -= entry.size;
+    }
+    msg_Dbg(p_object, "segment cache usage %" PRIu64 " bytes", total);
+}
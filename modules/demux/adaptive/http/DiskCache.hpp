@@ -0,0 +1,61 @@
+/*
+ * DiskCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef DISKCACHE_HPP
+#define DISKCACHE_HPP
+
+#include "ConnectionParams.hpp"
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include <vlc_cxx_helpers.hpp>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        using StorageID = std::string;
+
+        /* Persistent, size bounded, least recently used store of downloaded
+         * sources. Entries are plain files named after the storage ID hash,
+         * so that the cache can be shared by any number of instances. */
+        class DiskCache
+        {
+            public:
+                DiskCache(vlc_object_t *, const std::string &, uint64_t);
+                ~DiskCache();
+
+                FILE * open(const StorageID &, CacheInfo *, uint64_t *);
+                void   refresh(const StorageID &, const CacheInfo &);
+                void   store(const StorageID &, const CacheInfo &, const block_t *, uint64_t);
+
+            private:
+                std::string getPath(const StorageID &) const;
+                void        evict(const std::string & = std::string());
+                vlc_object_t *p_object;
+                std::string dir;
+                uint64_t    maxsize;
+                uint64_t    total;
+                vlc::threads::mutex lock;
+        };
+    }
+}
+
+#endif // DISKCACHE_HPP
@@ -25,68 +25,159 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
+#include <algorithm>
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Stream::Stream(const ID &id_) : id(id_)
 {
-    killed = false;
-    thread_handle_valid = false;
-    current = nullptr;
-    cancel_current = false;
+    level = VLC_TICK_INVALID;
+    minimum = 0;
+    busy = false;
 }
 
-bool Downloader::start()
+bool Downloader::Stream::isUnderrun() const
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread, static_cast<void *>(this)))
-    {
-        return false;
-    }
-    thread_handle_valid = true;
-    return true;
+    return level != VLC_TICK_INVALID && level < minimum;
+}
+
+Downloader::Downloader(unsigned perhost)
+{
+    killed = false;
+    idle = 0;
+    max_per_host = std::max(perhost, 1U);
 }
 
 Downloader::~Downloader()
 {
     kill();
 
-    if(thread_handle_valid)
+    for(vlc_thread_t thread_handle : threads)
         vlc_join(thread_handle, nullptr);
+
+    /* Left in queue, their deletion must not wait for a worker */
+    for(Stream &stream : streams)
+    {
+        for(HTTPChunkBufferedSource *source : stream.queue)
+            source->release();
+    }
 }
 
 void Downloader::kill()
 {
     vlc::threads::mutex_locker locker {lock};
     killed = true;
-    wait_cond.signal();
+    wait_cond.broadcast();
 }
 
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
     vlc::threads::mutex_locker locker {lock};
     source->hold();
-    chunks.push_back(source);
-    wait_cond.signal();
+    Stream *stream = getStream(source->sourceid);
+    if(stream == nullptr)
+    {
+        streams.emplace_back(source->sourceid);
+        stream = &streams.back();
+    }
+    stream->queue.push_back(source);
+    wakeup();
 }
 
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc::threads::mutex_locker locker {lock};
-    while (current == source)
+    if(isActive(source))
     {
-        cancel_current = true;
-        updated_cond.wait(lock);
+        cancelled.push_back(source);
+        while(isActive(source))
+            updated_cond.wait(lock);
     }
 
     if(!source->isDone())
     {
-        chunks.remove(source);
+        Stream *stream = getStream(source->sourceid);
+        if(stream)
+            stream->queue.remove(source);
         source->release();
     }
 }
 
+void Downloader::setBufferingLevel(const ID &id, vlc_tick_t level, vlc_tick_t minimum)
+{
+    vlc::threads::mutex_locker locker {lock};
+    Stream *stream = getStream(id);
+    if(stream == nullptr)
+    {
+        streams.emplace_back(id);
+        stream = &streams.back();
+    }
+    stream->level = level;
+    stream->minimum = minimum;
+}
+
+bool Downloader::isActive(const HTTPChunkBufferedSource *source) const
+{
+    return std::find(active.cbegin(), active.cend(), source) != active.cend();
+}
+
+Downloader::Stream * Downloader::getStream(const ID &id)
+{
+    /* one entry per adaptation set, only a few */
+    for(Stream &stream : streams)
+    {
+        if(stream.id == id)
+            return &stream;
+    }
+    return nullptr;
+}
+
+std::list<Downloader::Stream>::iterator Downloader::pick()
+{
+    auto candidate = streams.end();
+
+    for(auto it = streams.begin(); it != streams.end(); ++it)
+    {
+        /* Only the oldest source of a stream, and one transfer per stream,
+         * so that segments of a stream still complete in order */
+        if(it->busy || it->queue.empty())
+            continue;
+
+        const HTTPChunkBufferedSource *source = it->queue.front();
+        auto host = hosts.find(source->getConnectionParams().getHostname());
+        if(host != hosts.end() && host->second >= max_per_host)
+            continue;
+
+        /* Below the minimum buffering, serve first the emptiest stream,
+         * otherwise the first one in rotation order */
+        if(candidate == streams.end() ||
+           (it->isUnderrun() && (!candidate->isUnderrun() ||
+                                 it->level < candidate->level)))
+            candidate = it;
+    }
+
+    return candidate;
+}
+
+void Downloader::wakeup()
+{
+    if(killed || pick() == streams.end())
+        return;
+
+    if(idle > 0)
+    {
+        wait_cond.signal();
+        return;
+    }
+
+    if(threads.size() < MAX_WORKERS)
+    {
+        vlc_thread_t thread_handle;
+        if(vlc_clone(&thread_handle, downloaderThread, static_cast<void *>(this)) == 0)
+            threads.push_back(thread_handle);
+    }
+}
+
 void * Downloader::downloaderThread(void *opaque)
 {
     vlc_thread_set_name("vlc-adapt-dl");
@@ -97,31 +188,53 @@ void * Downloader::downloaderThread(void *opaque)
 
 void Downloader::Run()
 {
+    vlc::threads::mutex_locker locker {lock};
+
     while(1)
     {
-        lock.lock();
+        auto stream = streams.end();
 
-        while(chunks.empty() && !killed)
+        idle++;
+        while(!killed && (stream = pick()) == streams.end())
             wait_cond.wait(lock);
+        idle--;
 
         if(killed)
-        {
-            lock.unlock();
             break;
-        }
 
-        current = chunks.front();
+        HTTPChunkBufferedSource *current = stream->queue.front();
+        const std::string host = current->getConnectionParams().getHostname();
+        stream->busy = true;
+        hosts[host]++;
+        active.push_back(current);
+        /* Another source may be eligible, for an idle or a new worker */
+        wakeup();
+
         lock.unlock();
         current->bufferize(HTTPChunkSource::CHUNK_SIZE);
         lock.lock();
+
+        active.remove(current);
+        stream->busy = false;
+        if(--hosts[host] == 0)
+            hosts.erase(host);
+
+        auto it = std::find(cancelled.begin(), cancelled.end(), current);
+        bool cancel_current = it != cancelled.end();
+        if(cancel_current)
+            cancelled.erase(it);
+
         if(current->isDone() || cancel_current)
         {
-            chunks.pop_front();
+            stream->queue.remove(current);
             current->release();
         }
-        cancel_current = false;
-        current = nullptr;
-        updated_cond.signal();
-        lock.unlock();
+
+        /* Move the stream behind the others, keeping its sources in order */
+        streams.splice(streams.end(), streams, stream);
+
+        updated_cond.broadcast();
+        /* Sources held back by this transfer may now be eligible */
+        wait_cond.broadcast();
     }
 }
@@ -26,6 +26,9 @@
 #include <vlc_threads.h>
 #include <vlc_cxx_helpers.hpp>
 #include <list>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace adaptive
 {
@@ -36,25 +39,44 @@ namespace adaptive
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned perhost = 1);
                 ~Downloader();
-                bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
+                void setBufferingLevel(const ID &, vlc_tick_t, vlc_tick_t);
+
+                static const unsigned MAX_WORKERS = 8;
 
             private:
+                class Stream
+                {
+                    public:
+                        Stream(const ID &);
+                        bool isUnderrun() const;
+                        ID id;
+                        std::list<HTTPChunkBufferedSource *> queue; /* in segments order */
+                        vlc_tick_t level; /* buffered amount, reported by the buffering */
+                        vlc_tick_t minimum;
+                        bool busy; /* one transfer at a time */
+                };
                 static void * downloaderThread(void *);
                 void Run();
                 void kill();
-                vlc_thread_t thread_handle;
+                void wakeup();
+                bool isActive(const HTTPChunkBufferedSource *) const;
+                Stream * getStream(const ID &);
+                std::list<Stream>::iterator pick();
+                std::vector<vlc_thread_t> threads; /* spawned on demand */
                 vlc::threads::mutex lock;
                 vlc::threads::condition_variable wait_cond;
                 vlc::threads::condition_variable updated_cond;
-                bool         thread_handle_valid;
+                unsigned     max_per_host;
+                unsigned     idle;
                 bool         killed;
-                bool         cancel_current;
-                std::list<HTTPChunkBufferedSource *> chunks;
-                HTTPChunkBufferedSource *current;
+                std::list<Stream> streams; /* rotation order */
+                std::map<std::string, unsigned> hosts; /* transfers per host */
+                std::list<HTTPChunkBufferedSource *> active; /* being bufferized */
+                std::list<HTTPChunkBufferedSource *> cancelled;
         };
 
     }
@@ -63,6 +63,11 @@ bool AbstractConnection::prepare(const ConnectionParams &params_)
     return true;
 }
 
+ssize_t AbstractConnection::readPartial(void *p_buffer, size_t len)
+{
+    return read(p_buffer, len);
+}
+
 size_t AbstractConnection::getContentLength() const
 {
     return contentLength;
@@ -83,6 +88,38 @@ const ConnectionParams & AbstractConnection::getRedirection() const
     return locationparams;
 }
 
+const CacheInfo & AbstractConnection::getCacheInfo() const
+{
+    return cacheInfo;
+}
+
+static void parseCacheInfo(const struct vlc_http_msg *resp, CacheInfo &info)
+{
+    const time_t now = time(nullptr);
+    const char *s;
+
+    info = CacheInfo();
+    if((s = vlc_http_msg_get_header(resp, "ETag")))
+        info.etag = s;
+    if((s = vlc_http_msg_get_header(resp, "Last-Modified")))
+        info.lastModified = s;
+
+    info.storable = !vlc_http_msg_get_token(resp, "Cache-Control", "no-store") &&
+                    !vlc_http_msg_get_token(resp, "Cache-Control", "private");
+
+    unsigned maxage;
+    time_t t;
+    if((s = vlc_http_msg_get_header(resp, "Cache-Control")) &&
+       (s = strstr(s, "max-age=")) && sscanf(s, "max-age=%u", &maxage) == 1)
+        info.expires = now + maxage;
+    else if(vlc_http_msg_get_token(resp, "Cache-Control", "no-cache"))
+        info.expires = 0;
+    else if((t = vlc_http_msg_get_time(resp, "Expires")) != -1)
+        info.expires = t;
+    else if((t = vlc_http_msg_get_mtime(resp)) != -1 && t < now)
+        info.expires = now + (now - t) / 10; /* RFC 7234 heuristic freshness */
+}
+
 class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
 {
      friend class LibVLCHTTPConnection;
@@ -132,6 +169,11 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
         {
             vlc_http_msg_add_header(req, "Accept-Encoding", "deflate, gzip");
             vlc_http_msg_add_header(req, "Cache-Control", "no-cache");
+            if(!validators.etag.empty())
+                vlc_http_msg_add_header(req, "If-None-Match", "%s", validators.etag.c_str());
+            if(!validators.lastModified.empty())
+                vlc_http_msg_add_header(req, "If-Modified-Since", "%s",
+                                        validators.lastModified.c_str());
             if(range.isValid())
             {
                 if(range.getEndByte() > 0)
@@ -187,11 +229,13 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
         size_t totalRead;
         struct vlc_http_mgr *http_mgr;
         BytesRange range;
+        CacheInfo validators;
 
     public:
         struct vlc_http_resource *http_res;
         int create(const char *uri,const std::string &ua,
-                   const std::string &ref, const BytesRange &range)
+                   const std::string &ref, const BytesRange &range,
+                   const CacheInfo *validators)
         {
             auto *tpl = static_cast<struct restuple *>(
                 std::malloc(sizeof(struct restuple)));
@@ -200,6 +244,7 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
 
             tpl->source = this;
             this->range = range;
+            this->validators = validators ? *validators : CacheInfo();
             if (vlc_http_res_init(&tpl->resource, &this->callbacks, http_mgr, uri,
                                   ua.empty() ? nullptr : ua.c_str(),
                                   ref.empty() ? nullptr : ref.c_str()))
@@ -277,6 +322,7 @@ void LibVLCHTTPConnection::reset()
     }
     bytesRange = BytesRange();
     contentType = std::string();
+    cacheInfo = CacheInfo();
     bytesRead = 0;
     contentLength = 0;
 }
@@ -291,7 +337,8 @@ bool LibVLCHTTPConnection::canReuse(const ConnectionParams &params_) const
 }
 
 RequestStatus LibVLCHTTPConnection::request(const std::string &path,
-                                            const BytesRange &range)
+                                            const BytesRange &range,
+                                            const CacheInfo *validators)
 {
     if(source->http_mgr == nullptr)
         return RequestStatus::GenericError;
@@ -307,7 +354,7 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
     else
         msg_Dbg(p_object, "Retrieving %s", params.getUrl().c_str());
 
-    if(source->create(params.getUrl().c_str(), useragent,referer, range))
+    if(source->create(params.getUrl().c_str(), useragent,referer, range, validators))
         return RequestStatus::GenericError;
 
     struct vlc_credential crd;
@@ -378,6 +425,11 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
     if (status >= 400)
         return RequestStatus::GenericError;
 
+    parseCacheInfo(source->http_res->response, cacheInfo);
+
+    if (status == 304)
+        return RequestStatus::NotModified;
+
     char *psz_redir = vlc_http_res_get_redirect(source->http_res);
     if(psz_redir)
     {
@@ -424,6 +476,13 @@ ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
     return read;
 }
 
+ssize_t LibVLCHTTPConnection::readPartial(void *p_buffer, size_t len)
+{
+    ssize_t read = vlc_stream_ReadPartial(stream, p_buffer, len);
+    bytesRead = source->totalRead;
+    return read;
+}
+
 void LibVLCHTTPConnection::setUsed( bool b )
 {
     available = !b;
@@ -465,7 +524,8 @@ bool StreamUrlConnection::canReuse(const ConnectionParams &params_) const
 }
 
 RequestStatus StreamUrlConnection::request(const std::string &path,
-                                           const BytesRange &range)
+                                           const BytesRange &range,
+                                           const CacheInfo *)
 {
     reset();
 
@@ -511,6 +571,16 @@ RequestStatus StreamUrlConnection::request(const std::string &path,
 }
 
 ssize_t StreamUrlConnection::read(void *p_buffer, size_t len)
+{
+    return doRead(p_buffer, len, false);
+}
+
+ssize_t StreamUrlConnection::readPartial(void *p_buffer, size_t len)
+{
+    return doRead(p_buffer, len, true);
+}
+
+ssize_t StreamUrlConnection::doRead(void *p_buffer, size_t len, bool b_partial)
 {
     if( !p_streamurl )
         return VLC_EGENERIC;
@@ -525,11 +595,12 @@ ssize_t StreamUrlConnection::read(void *p_buffer, size_t len)
     if(len > toRead)
         len = toRead;
 
-    ssize_t ret = vlc_stream_Read(p_streamurl, p_buffer, len);
+    ssize_t ret = b_partial ? vlc_stream_ReadPartial(p_streamurl, p_buffer, len)
+                            : vlc_stream_Read(p_streamurl, p_buffer, len);
     if(ret >= 0)
         bytesRead += ret;
 
-    if(ret < 0 || (size_t)ret < len || /* set EOF */
+    if(ret < 0 || (b_partial ? ret == 0 : (size_t)ret < len) || /* set EOF */
        contentLength == bytesRead )
     {
         reset();
@@ -50,12 +50,15 @@ namespace adaptive
                 virtual bool    canReuse     (const ConnectionParams &) const = 0;
 
                 virtual RequestStatus request(const std::string& path,
-                                              const BytesRange & = BytesRange()) = 0;
+                                              const BytesRange & = BytesRange(),
+                                              const CacheInfo * = nullptr) = 0;
                 virtual ssize_t read        (void *p_buffer, size_t len) = 0;
+                virtual ssize_t readPartial (void *p_buffer, size_t len);
 
                 virtual size_t  getContentLength() const;
                 virtual size_t  getBytesRead() const;
                 virtual const std::string & getContentType() const;
+                const CacheInfo & getCacheInfo() const;
                 virtual const ConnectionParams &getRedirection() const;
                 virtual void    setUsed( bool ) = 0;
 
@@ -68,6 +71,7 @@ namespace adaptive
                 std::string        contentType;
                 BytesRange         bytesRange;
                 size_t             bytesRead;
+                CacheInfo          cacheInfo;
         };
 
        class LibVLCHTTPSource;
@@ -79,8 +83,10 @@ namespace adaptive
                virtual ~LibVLCHTTPConnection();
                bool    canReuse     (const ConnectionParams &) const override;
                RequestStatus request(const std::string& path,
-                                     const BytesRange & = BytesRange()) override;
+                                     const BytesRange & = BytesRange(),
+                                     const CacheInfo * = nullptr) override;
                ssize_t read         (void *p_buffer, size_t len) override;
+               ssize_t readPartial  (void *p_buffer, size_t len) override;
                void    setUsed      ( bool ) override;
 
             private:
@@ -101,13 +107,16 @@ namespace adaptive
                 bool    canReuse     (const ConnectionParams &) const override;
 
                 RequestStatus request(const std::string& path,
-                                      const BytesRange & = BytesRange()) override;
+                                      const BytesRange & = BytesRange(),
+                                      const CacheInfo * = nullptr) override;
                 ssize_t read        (void *p_buffer, size_t len) override;
+                ssize_t readPartial (void *p_buffer, size_t len) override;
 
                 void    setUsed( bool ) override;
 
             protected:
                 void reset();
+                ssize_t doRead(void *p_buffer, size_t len, bool);
                 stream_t *p_streamurl;
        };
 
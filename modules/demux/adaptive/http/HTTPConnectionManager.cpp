@@ -29,9 +29,11 @@
 #include "HTTPConnection.hpp"
 #include "ConnectionParams.hpp"
 #include "Downloader.hpp"
+#include "DiskCache.hpp"
 #include "../tools/Debug.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
+#include <vlc_configuration.h>
 
 #include <cassert>
 
@@ -42,6 +44,11 @@ AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
 {
     p_object = p_object_;
     rateObserver = nullptr;
+    vlc_mutex_init(&transfers_lock);
+    transfers_active = 0;
+    transfers_since = VLC_TICK_INVALID;
+    transfers_busy = 0;
+    transfers_bytes = 0;
 }
 
 AbstractConnectionManager::~AbstractConnectionManager()
@@ -62,6 +69,55 @@ void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid,
     }
 }
 
+void AbstractConnectionManager::addBusyTime(vlc_tick_t now)
+{
+    if(transfers_active > 0 && now > transfers_since)
+    {
+        transfers_busy += now - transfers_since;
+        transfers_since = now;
+    }
+}
+
+void AbstractConnectionManager::transferStarted(vlc_tick_t start)
+{
+    vlc_mutex_locker locker(&transfers_lock);
+    if(transfers_active++ == 0)
+        transfers_since = start;
+}
+
+void AbstractConnectionManager::transferProgress(size_t size)
+{
+    vlc_mutex_locker locker(&transfers_lock);
+    transfers_bytes += size;
+}
+
+void AbstractConnectionManager::transferEnded(const adaptive::ID &sourceid,
+                                              vlc_tick_t latency)
+{
+    vlc_mutex_lock(&transfers_lock);
+    addBusyTime(vlc_tick_now());
+    assert(transfers_active > 0);
+    transfers_active--;
+    /* everything received since the last sample, by all transfers */
+    const size_t size = transfers_bytes;
+    const vlc_tick_t time = transfers_busy;
+    transfers_bytes = 0;
+    transfers_busy = 0;
+    vlc_mutex_unlock(&transfers_lock);
+
+    if(size && time)
+        updateDownloadRate(sourceid, size, time, latency);
+}
+
+void AbstractConnectionManager::transferAborted()
+{
+    /* keep what was received for the next sample */
+    vlc_mutex_locker locker(&transfers_lock);
+    addBusyTime(vlc_tick_now());
+    assert(transfers_active > 0);
+    transfers_active--;
+}
+
 void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *obs)
 {
     rateObserver = obs;
@@ -77,12 +133,28 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_)
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new Downloader();
-    downloaderhp = new Downloader();
-    downloader->start();
-    downloaderhp->start();
+    /* Workers are spawned as transfers become possible, so the number of
+     * threads follows the per host limit and the hosts in use */
+    unsigned perhost = var_InheritInteger(p_object, "adaptive-connections");
+    downloader = new Downloader(perhost);
+    /* Keys and playlists share one stream ID and stay serialized, while
+     * each Low-Latency HLS blocking reload, held by the server, gets its own */
+    downloaderhp = new Downloader(Downloader::MAX_WORKERS);
     cache_total = 0;
     cache_max = 1 << 19;
+
+    diskcache = nullptr;
+    const int64_t disksize = var_InheritInteger(p_object, "adaptive-disk-cache");
+    if(disksize > 0)
+    {
+        char *psz_dir = config_GetUserDir(VLC_CACHE_DIR);
+        if(psz_dir)
+        {
+            diskcache = new DiskCache(p_object, std::string(psz_dir) + DIR_SEP "adaptive",
+                                      (uint64_t) disksize << 20);
+            free(psz_dir);
+        }
+    }
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
@@ -99,6 +171,7 @@ HTTPConnectionManager::~HTTPConnectionManager   ()
     }
     delete downloader;
     delete downloaderhp;
+    delete diskcache;
     this->closeAllConnections();
     while(!factories.empty())
     {
@@ -191,6 +264,11 @@ AbstractChunkSource *HTTPConnectionManager::makeSource(const std::string &url,
             }
             // fallthrough
         case ChunkType::Segment:
+        {
+            HTTPChunkBufferedSource *source = new HTTPChunkBufferedSource(url, this, id, type, range);
+            source->diskcache = diskcache;
+            return source;
+        }
         case ChunkType::Key:
         case ChunkType::Playlist:
         default:
@@ -267,6 +345,13 @@ void HTTPConnectionManager::cancel(AbstractChunkSource *source)
         getDownloadQueue(src)->cancel(src);
 }
 
+void HTTPConnectionManager::updateBufferingLevel(const adaptive::ID &id,
+                                                 vlc_tick_t level, vlc_tick_t minimum)
+{
+    /* Keys and playlists are not prioritized */
+    downloader->setBufferingLevel(id, level, minimum);
+}
+
 void HTTPConnectionManager::setLocalConnectionsAllowed()
 {
     localAllowed = true;
@@ -45,6 +45,7 @@ namespace adaptive
         class Downloader;
         class AbstractChunkSource;
         class HTTPChunkBufferedSource;
+        class DiskCache;
         enum class ChunkType;
 
         class AbstractConnectionManager : public IDownloadRateObserver
@@ -65,13 +66,28 @@ namespace adaptive
                 virtual void updateDownloadRate(const ID &, size_t,
                                                 vlc_tick_t, vlc_tick_t) override;
                 void setDownloadRateObserver(IDownloadRateObserver *);
+                virtual void updateBufferingLevel(const ID &, vlc_tick_t,
+                                                  vlc_tick_t) {}
+
+                /* Concurrent segment transfers share the link: the rate is
+                 * measured over the time any of them is running */
+                void transferStarted(vlc_tick_t);
+                void transferProgress(size_t);
+                void transferEnded(const ID &, vlc_tick_t);
+                void transferAborted();
 
             protected:
                 void deleteSource(AbstractChunkSource *);
                 vlc_object_t                                       *p_object;
 
             private:
+                void addBusyTime(vlc_tick_t);
                 IDownloadRateObserver                              *rateObserver;
+                vlc_mutex_t                                         transfers_lock;
+                unsigned                                            transfers_active;
+                vlc_tick_t                                          transfers_since;
+                vlc_tick_t                                          transfers_busy;
+                size_t                                              transfers_bytes;
         };
 
         class HTTPConnectionManager : public AbstractConnectionManager
@@ -89,6 +105,8 @@ namespace adaptive
 
                 void start(AbstractChunkSource *)  override;
                 void cancel(AbstractChunkSource *)  override;
+                void updateBufferingLevel(const ID &, vlc_tick_t,
+                                          vlc_tick_t) override;
                 void         setLocalConnectionsAllowed();
                 void         addFactory(AbstractConnectionFactory *);
 
@@ -105,6 +123,7 @@ namespace adaptive
                 std::list<HTTPChunkBufferedSource *> cache;
                 size_t cache_total;
                 size_t cache_max;
+                DiskCache                                          *diskcache;
         };
     }
 }
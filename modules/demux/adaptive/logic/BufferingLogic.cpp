@@ -239,8 +239,10 @@ uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *re
         stime_t scaledduration = mediaSegmentTemplate->inheritDuration();
         if(scaledduration)
         {
-            /* Compute playback offset and effective finished segment from wall time */
-            vlc_tick_t now = vlc_tick_from_sec(time(nullptr));
+            /* Compute playback offset and effective finished segment from wall time,
+             * early available segments moving the live edge forward */
+            vlc_tick_t now = vlc_tick_from_sec(time(nullptr)) +
+                             mediaSegmentTemplate->inheritAvailabilityTimeOffset();
             vlc_tick_t playbacktime = now - i_buffering;
             vlc_tick_t minavailtime = playlist->availabilityStartTime.Get() + rep->getPeriodStart();
             const uint64_t startnumber = mediaSegmentTemplate->inheritStartNumber();
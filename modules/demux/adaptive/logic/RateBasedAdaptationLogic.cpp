@@ -78,6 +78,7 @@ BaseRepresentation *RateBasedAdaptationLogic::getNextRepresentation(BaseAdaptati
 void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size,
                                                   vlc_tick_t time, vlc_tick_t)
 {
+    vlc_mutex_locker locker(&lock);
     if(unlikely(time == 0))
         return;
     /* Accumulate up to observation window */
@@ -89,7 +90,6 @@ void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size,
 
     const size_t bps = CLOCK_FREQ * dlsize * 8 / dllength;
 
-    vlc_mutex_locker locker(&lock);
     bpsAvg = average.push(bps);
 
 //    BwDebug(msg_Dbg(p_obj, "alpha1 %lf alpha0 %lf dmax %ld ds %ld", alpha,
@@ -96,6 +96,9 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, size_t index, BaseRepresen
                                                           range);
     if(source)
     {
+        /* low latency chunked segments can be fetched before completion */
+        if(chunkType == ChunkType::Segment && !rep->inheritAvailabilityTimeComplete())
+            source->setProgressive(true);
         SegmentChunk *chunk = createChunk(source, rep);
         if(chunk)
         {
@@ -0,0 +1,219 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2024 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/DiskCache.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_hash.h>
+#include <vlc_strings.h>
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <ctime>
+#include <sys/stat.h>
+#include <utime.h>
+
+using namespace adaptive::http;
+
+#define MAXSIZE 40000
+#define ENTRYSIZE 9000 /* four fit, five do not */
+
+/* Same naming as the cache, to age entries */
+static std::string EntryPath(const std::string &dir, const StorageID &id)
+{
+    vlc_hash_md5_t md5;
+    uint8_t digest[VLC_HASH_MD5_DIGEST_SIZE];
+    char hex[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hash_md5_Init(&md5);
+    vlc_hash_md5_Update(&md5, id.c_str(), id.length());
+    vlc_hash_md5_Finish(&md5, digest, sizeof(digest));
+    vlc_hex_encode_binary(digest, sizeof(digest), hex);
+    return dir + DIR_SEP + hex;
+}
+
+static bool Exists(const std::string &path)
+{
+    struct stat st;
+    return vlc_stat(path.c_str(), &st) == 0;
+}
+
+static void SetAge(const std::string &path, time_t age)
+{
+    struct utimbuf times;
+    times.actime = times.modtime = time(nullptr) - age;
+    utime(path.c_str(), &times);
+}
+
+static CacheInfo MakeInfo(const std::string &etag)
+{
+    CacheInfo info;
+    info.storable = true;
+    info.etag = etag;
+    info.expires = time(nullptr) + 60;
+    return info;
+}
+
+/* Stores the body as a chain of two blocks, filled with the byte value */
+static void Store(DiskCache &cache, const StorageID &id, const std::string &etag,
+                  size_t size, uint8_t value)
+{
+    block_t *p_chain = block_Alloc(size / 2);
+    block_t *p_next = block_Alloc(size - size / 2);
+    memset(p_chain->p_buffer, value, p_chain->i_buffer);
+    memset(p_next->p_buffer, value, p_next->i_buffer);
+    p_chain->p_next = p_next;
+    cache.store(id, MakeInfo(etag), p_chain, size);
+    block_ChainRelease(p_chain);
+}
+
+/* Reads back an entry, checking its body */
+static bool Load(DiskCache &cache, const StorageID &id, const std::string &etag,
+                 size_t size, uint8_t value)
+{
+    CacheInfo info;
+    uint64_t cachedsize;
+    FILE *f = cache.open(id, &info, &cachedsize);
+    if(f == nullptr)
+        return false;
+
+    std::vector<uint8_t> body(size + 1);
+    size_t read = fread(body.data(), 1, body.size(), f);
+    fclose(f);
+
+    if(cachedsize != size || read != size || info.etag != etag ||
+       !info.isFresh(time(nullptr)))
+        return false;
+    for(size_t i = 0; i < size; i++)
+        if(body[i] != value)
+            return false;
+    return true;
+}
+
+static int DiskCache_check(const std::string &dir)
+{
+    DiskCache *cache = nullptr;
+    try
+    {
+        cache = new DiskCache(nullptr, dir, MAXSIZE);
+
+        /* Hit, and miss */
+        Store(*cache, "http://host/a", "\"1\"", ENTRYSIZE, 0x11);
+        Expect(Load(*cache, "http://host/a", "\"1\"", ENTRYSIZE, 0x11));
+        CacheInfo info;
+        uint64_t size;
+        Expect(cache->open("http://host/none", &info, &size) == nullptr);
+
+        /* Overwrite: the new body and validators are served */
+        Store(*cache, "http://host/a", "\"2\"", ENTRYSIZE - 1000, 0x22);
+        Expect(Load(*cache, "http://host/a", "\"2\"", ENTRYSIZE - 1000, 0x22));
+
+        /* Repeated overwrites keep a single file: nothing is evicted while
+         * the cached files fit */
+        Store(*cache, "http://host/b", "\"1\"", ENTRYSIZE, 0x33);
+        Store(*cache, "http://host/c", "\"1\"", ENTRYSIZE, 0x44);
+        for(int i = 0; i < 10; i++)
+            Store(*cache, "http://host/d", "\"1\"", ENTRYSIZE, 0x55);
+        Expect(Exists(EntryPath(dir, "http://host/a")));
+        Expect(Exists(EntryPath(dir, "http://host/b")));
+        Expect(Exists(EntryPath(dir, "http://host/c")));
+        Expect(Exists(EntryPath(dir, "http://host/d")));
+
+        /* Eviction of the least recently used down to 90%, reading bumps
+         * an entry */
+        SetAge(EntryPath(dir, "http://host/a"), 400);
+        SetAge(EntryPath(dir, "http://host/b"), 300);
+        SetAge(EntryPath(dir, "http://host/c"), 200);
+        SetAge(EntryPath(dir, "http://host/d"), 100);
+        Expect(Load(*cache, "http://host/a", "\"2\"", ENTRYSIZE - 1000, 0x22));
+        Store(*cache, "http://host/e", "\"1\"", ENTRYSIZE, 0x66);
+        Expect(!Exists(EntryPath(dir, "http://host/b")));
+        Expect(Load(*cache, "http://host/c", "\"1\"", ENTRYSIZE, 0x44));
+        Expect(Load(*cache, "http://host/a", "\"2\"", ENTRYSIZE - 1000, 0x22));
+        Expect(Load(*cache, "http://host/d", "\"1\"", ENTRYSIZE, 0x55));
+        Expect(Load(*cache, "http://host/e", "\"1\"", ENTRYSIZE, 0x66));
+
+        /* Too large to be cached */
+        Store(*cache, "http://host/f", "\"1\"", MAXSIZE / 2, 0x77);
+        Expect(cache->open("http://host/f", &info, &size) == nullptr);
+
+        delete cache;
+        cache = nullptr;
+
+        /* Files left by interrupted stores are removed once stale */
+        const std::string stale = dir + DIR_SEP "tmp.stale0";
+        const std::string recent = dir + DIR_SEP "tmp.recent";
+        FILE *f = vlc_fopen(stale.c_str(), "wb");
+        Expect(f != nullptr);
+        fclose(f);
+        f = vlc_fopen(recent.c_str(), "wb");
+        Expect(f != nullptr);
+        fclose(f);
+        SetAge(stale, 2 * 3600);
+
+        cache = new DiskCache(nullptr, dir, MAXSIZE);
+        Expect(!Exists(stale));
+        Expect(Exists(recent));
+        vlc_unlink(recent.c_str());
+        Expect(Load(*cache, "http://host/e", "\"1\"", ENTRYSIZE, 0x66));
+    } catch(...) {
+        delete cache;
+        return 1;
+    }
+
+    delete cache;
+    return 0;
+}
+
+int DiskCache_test()
+{
+    char tmpdir[] = "/tmp/vlc_adaptive_XXXXXX";
+    if(mkdtemp(tmpdir) == nullptr)
+    {
+        std::cerr << "skip: mkdtemp failed" << std::endl;
+        return 0;
+    }
+    const std::string dir = std::string(tmpdir) + DIR_SEP "cache";
+
+    int ret = DiskCache_check(dir);
+
+    /* Remove the cache files */
+    vlc_DIR *d = vlc_opendir(dir.c_str());
+    if(d)
+    {
+        const char *psz_name;
+        while((psz_name = vlc_readdir(d)) != nullptr)
+        {
+            if(psz_name[0] != '.')
+                vlc_unlink((dir + DIR_SEP + psz_name).c_str());
+        }
+        vlc_closedir(d);
+    }
+    rmdir(dir.c_str());
+    rmdir(tmpdir);
+
+    return ret;
+}
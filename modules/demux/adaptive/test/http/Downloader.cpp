@@ -0,0 +1,468 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2024 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/Chunk.h"
+#include "../../http/Downloader.hpp"
+#include "../../http/HTTPConnection.hpp"
+#include "../../http/HTTPConnectionManager.h"
+
+#include "../test.hpp"
+
+#include <vlc_block.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstring>
+
+using namespace adaptive;
+using namespace adaptive::http;
+
+/* Every read of the fake connections goes through the gate, and is logged */
+class Transfers
+{
+    public:
+        Transfers()
+        {
+            open = false;
+            running = 0;
+            maxrunning = 0;
+            cancels = 0;
+            size = HTTPChunkSource::CHUNK_SIZE + 100; /* two reads */
+        }
+
+        void enter(const std::string &host)
+        {
+            vlc::threads::mutex_locker locker {lock};
+            running++;
+            maxrunning = std::max(maxrunning, running);
+            hostmax[host] = std::max(hostmax[host], ++hostrunning[host]);
+            cond.broadcast();
+            while(!open)
+                cond.wait(lock);
+        }
+
+        void leave(const std::string &host, const std::string &path)
+        {
+            vlc::threads::mutex_locker locker {lock};
+            running--;
+            hostrunning[host]--;
+            reads.push_back(path);
+            cond.broadcast();
+        }
+
+        void waitRunning(unsigned count)
+        {
+            vlc::threads::mutex_locker locker {lock};
+            while(running < count)
+                cond.wait(lock);
+        }
+
+        void setOpen(bool b)
+        {
+            vlc::threads::mutex_locker locker {lock};
+            open = b;
+            cond.broadcast();
+        }
+
+        void cancelling()
+        {
+            vlc::threads::mutex_locker locker {lock};
+            cancels++;
+            cond.broadcast();
+        }
+
+        void waitCancels(unsigned count)
+        {
+            vlc::threads::mutex_locker locker {lock};
+            while(cancels < count)
+                cond.wait(lock);
+        }
+
+        std::vector<std::string> getReads()
+        {
+            vlc::threads::mutex_locker locker {lock};
+            return reads;
+        }
+
+        unsigned getMaxRunning(const std::string &host)
+        {
+            vlc::threads::mutex_locker locker {lock};
+            return hostmax[host];
+        }
+
+        unsigned getMaxRunning()
+        {
+            vlc::threads::mutex_locker locker {lock};
+            return maxrunning;
+        }
+
+        size_t size;
+
+    private:
+        vlc::threads::mutex lock;
+        vlc::threads::condition_variable cond;
+        bool open;
+        unsigned running;
+        unsigned maxrunning;
+        unsigned cancels;
+        std::map<std::string, unsigned> hostrunning;
+        std::map<std::string, unsigned> hostmax;
+        std::vector<std::string> reads;
+};
+
+class TestConnection : public AbstractConnection
+{
+    public:
+        TestConnection(Transfers *t, const std::string &h)
+            : AbstractConnection(nullptr), transfers(t), host(h) {}
+        virtual ~TestConnection() = default;
+
+        bool canReuse(const ConnectionParams &) const override { return false; }
+        RequestStatus request(const std::string &p, const BytesRange &,
+                              const CacheInfo *) override
+        {
+            path = p;
+            bytesRead = 0;
+            return RequestStatus::Success;
+        }
+        ssize_t read(void *p_buffer, size_t len) override
+        {
+            transfers->enter(host);
+            len = std::min(len, transfers->size - bytesRead);
+            std::memset(p_buffer, 0x55, len);
+            bytesRead += len;
+            transfers->leave(host, path);
+            return len;
+        }
+        void setUsed(bool) override {}
+
+    private:
+        Transfers *transfers;
+        std::string host;
+        std::string path;
+};
+
+class TestConnectionManager : public AbstractConnectionManager
+{
+    public:
+        TestConnectionManager(Transfers *t)
+            : AbstractConnectionManager(nullptr), downloader(nullptr), transfers(t) {}
+        virtual ~TestConnectionManager()
+        {
+            for(AbstractConnection *conn : connections)
+                delete conn;
+        }
+        void closeAllConnections () override {}
+        AbstractConnection * getConnection(ConnectionParams &params) override
+        {
+            vlc::threads::mutex_locker locker {lock};
+            AbstractConnection *conn = new TestConnection(transfers, params.getHostname());
+            connections.push_back(conn);
+            return conn;
+        }
+        AbstractChunkSource *makeSource(const std::string &, const ID &,
+                                        ChunkType, const BytesRange &) override
+        {
+            return nullptr;
+        }
+        void recycleSource(AbstractChunkSource *) override {}
+        void start(AbstractChunkSource *) override {}
+        void cancel(AbstractChunkSource *source) override
+        {
+            transfers->cancelling();
+            if(downloader)
+                downloader->cancel(static_cast<HTTPChunkBufferedSource *>(source));
+        }
+
+        Downloader *downloader;
+
+    private:
+        vlc::threads::mutex lock;
+        Transfers *transfers;
+        std::vector<AbstractConnection *> connections;
+};
+
+class TestSource : public HTTPChunkBufferedSource
+{
+    public:
+        TestSource(const std::string &url, AbstractConnectionManager *manager,
+                   const std::string &stream)
+            : HTTPChunkBufferedSource(url, manager, ID(stream),
+                                      ChunkType::Segment, BytesRange()) {}
+
+        /* Reads like the demuxer, waiting for the downloader */
+        size_t drain()
+        {
+            size_t total = 0;
+            block_t *p_block;
+            while((p_block = readBlock()))
+            {
+                total += p_block->i_buffer;
+                block_Release(p_block);
+            }
+            return total;
+        }
+};
+
+using Reads = std::vector<std::string>;
+
+static int Downloader_check_order()
+{
+    Transfers transfers;
+    TestConnectionManager manager(&transfers);
+    Downloader *downloader = new Downloader(1);
+    manager.downloader = downloader;
+    TestSource *a1 = new TestSource("http://host/a1", &manager, "A");
+    TestSource *a2 = new TestSource("http://host/a2", &manager, "A");
+    TestSource *b1 = new TestSource("http://host/b1", &manager, "B");
+
+    try
+    {
+        /* Streams take turns after each chunk, and their own segments
+         * complete in order */
+        downloader->schedule(a1);
+        transfers.waitRunning(1);
+        downloader->schedule(a2);
+        downloader->schedule(b1);
+        transfers.setOpen(true);
+
+        Expect(a1->drain() == transfers.size);
+        Expect(a2->drain() == transfers.size);
+        Expect(b1->drain() == transfers.size);
+        Expect(transfers.getReads() ==
+               Reads({"/a1", "/b1", "/a1", "/b1", "/a2", "/a2"}));
+        Expect(transfers.getMaxRunning() == 1);
+    } catch(...) {
+        transfers.setOpen(true);
+        delete a1; delete a2; delete b1;
+        delete downloader;
+        return 1;
+    }
+
+    delete a1; delete a2; delete b1;
+    delete downloader;
+    return 0;
+}
+
+static int Downloader_check_priority()
+{
+    Transfers transfers;
+    TestConnectionManager manager(&transfers);
+    Downloader *downloader = new Downloader(1);
+    manager.downloader = downloader;
+    TestSource *x1 = new TestSource("http://host/x1", &manager, "X");
+    TestSource *a1 = new TestSource("http://host/a1", &manager, "A");
+    TestSource *b1 = new TestSource("http://host/b1", &manager, "B");
+    TestSource *c1 = new TestSource("http://host/c1", &manager, "C");
+
+    try
+    {
+        /* Streams below the minimum buffering go first, the emptiest one
+         * first, and keep the worker until they have caught up */
+        downloader->schedule(x1);
+        transfers.waitRunning(1);
+        downloader->schedule(a1);
+        downloader->schedule(b1);
+        downloader->schedule(c1);
+        downloader->setBufferingLevel(ID("A"), VLC_TICK_FROM_SEC(5), VLC_TICK_FROM_SEC(2));
+        downloader->setBufferingLevel(ID("B"), VLC_TICK_FROM_SEC(1), VLC_TICK_FROM_SEC(2));
+        downloader->setBufferingLevel(ID("C"), VLC_TICK_FROM_MS(500), VLC_TICK_FROM_SEC(2));
+        transfers.setOpen(true);
+
+        Expect(x1->drain() == transfers.size);
+        Expect(a1->drain() == transfers.size);
+        Expect(b1->drain() == transfers.size);
+        Expect(c1->drain() == transfers.size);
+        Expect(transfers.getReads() ==
+               Reads({"/x1", "/c1", "/c1", "/b1", "/b1", "/a1", "/x1", "/a1"}));
+    } catch(...) {
+        transfers.setOpen(true);
+        delete x1; delete a1; delete b1; delete c1;
+        delete downloader;
+        return 1;
+    }
+
+    delete x1; delete a1; delete b1; delete c1;
+    delete downloader;
+    return 0;
+}
+
+static int Downloader_check_hosts()
+{
+    Transfers transfers;
+    TestConnectionManager manager(&transfers);
+    Downloader *downloader = new Downloader(2);
+    manager.downloader = downloader;
+    std::vector<TestSource *> sources = {
+        new TestSource("http://host1/a1", &manager, "A"),
+        new TestSource("http://host1/b1", &manager, "B"),
+        new TestSource("http://host1/c1", &manager, "C"),
+        new TestSource("http://host2/d1", &manager, "D"),
+    };
+
+    try
+    {
+        /* Workers are added up to the per host limit, for each host */
+        for(TestSource *source : sources)
+            downloader->schedule(source);
+        transfers.waitRunning(3);
+        transfers.setOpen(true);
+
+        for(TestSource *source : sources)
+            Expect(source->drain() == transfers.size);
+        Expect(transfers.getMaxRunning("host1") == 2);
+        Expect(transfers.getMaxRunning("host2") == 1);
+        Expect(transfers.getMaxRunning() == 3);
+    } catch(...) {
+        transfers.setOpen(true);
+        for(TestSource *source : sources)
+            delete source;
+        delete downloader;
+        return 1;
+    }
+
+    for(TestSource *source : sources)
+        delete source;
+    delete downloader;
+    return 0;
+}
+
+static void * Delete_thread(void *opaque)
+{
+    delete static_cast<TestSource *>(opaque);
+    return nullptr;
+}
+
+static int Downloader_check_cancel()
+{
+    Transfers transfers;
+    TestConnectionManager manager(&transfers);
+    Downloader *downloader = new Downloader(1);
+    manager.downloader = downloader;
+    transfers.size = 100 * HTTPChunkSource::CHUNK_SIZE;
+    TestSource *a1 = new TestSource("http://host/a1", &manager, "A");
+    TestSource *b1 = new TestSource("http://host/b1", &manager, "B");
+    TestSource *c1 = new TestSource("http://host/c1", &manager, "C");
+
+    try
+    {
+        downloader->schedule(a1);
+        transfers.waitRunning(1);
+        downloader->schedule(b1);
+
+        /* Cancelled while queued: never downloaded */
+        delete b1;
+        b1 = nullptr;
+        transfers.waitCancels(1);
+
+        /* Cancelled while downloading: waits for the current chunk only */
+        vlc_thread_t th;
+        Expect(vlc_clone(&th, Delete_thread, a1) == 0);
+        a1 = nullptr;
+        transfers.waitCancels(2);
+        transfers.setOpen(true);
+        vlc_join(th, nullptr);
+
+        /* The worker is still usable */
+        downloader->schedule(c1);
+        Expect(c1->drain() == transfers.size);
+
+        Reads reads = transfers.getReads();
+        Expect(std::count(reads.begin(), reads.end(), "/b1") == 0);
+        /* Nothing read from a deleted source */
+        Expect(reads.back() == "/c1");
+        Expect(std::find(std::find(reads.begin(), reads.end(), "/c1"),
+                         reads.end(), "/a1") == reads.end());
+    } catch(...) {
+        transfers.setOpen(true);
+        delete a1; delete b1; delete c1;
+        delete downloader;
+        return 1;
+    }
+
+    delete c1;
+    delete downloader;
+    return 0;
+}
+
+static void * Kill_thread(void *opaque)
+{
+    delete static_cast<Downloader *>(opaque);
+    return nullptr;
+}
+
+static int Downloader_check_kill()
+{
+    Transfers transfers;
+    TestConnectionManager manager(&transfers);
+    Downloader *downloader = new Downloader(2);
+    manager.downloader = downloader;
+    transfers.size = 100 * HTTPChunkSource::CHUNK_SIZE;
+    std::vector<TestSource *> sources = {
+        new TestSource("http://host/a1", &manager, "A"),
+        new TestSource("http://host/a2", &manager, "A"),
+        new TestSource("http://host/b1", &manager, "B"),
+        new TestSource("http://host/c1", &manager, "C"),
+    };
+
+    try
+    {
+        for(TestSource *source : sources)
+            downloader->schedule(source);
+        transfers.waitRunning(2);
+
+        /* Destroyed while downloading: the current chunks complete */
+        vlc_thread_t th;
+        Expect(vlc_clone(&th, Kill_thread, downloader) == 0);
+        transfers.setOpen(true);
+        vlc_join(th, nullptr);
+        manager.downloader = nullptr;
+        downloader = nullptr;
+
+        /* No transfer left, and unfinished sources were released */
+        const size_t count = transfers.getReads().size();
+        for(TestSource *source : sources)
+            delete source;
+        sources.clear();
+        Expect(transfers.getReads().size() == count);
+    } catch(...) {
+        transfers.setOpen(true);
+        delete downloader;
+        return 1;
+    }
+
+    return 0;
+}
+
+int Downloader_test()
+{
+    return
+        Downloader_check_order() ||
+        Downloader_check_priority() ||
+        Downloader_check_hosts() ||
+        Downloader_check_cancel() ||
+        Downloader_check_kill() ||
+        0;
+}
@@ -543,5 +543,40 @@ int M3U8Playlist_test()
         return 1;
     }
 
+    /* Manifest 6 */
+    const char manifest6[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.0,HOLD-BACK=8.5\n"
+    "#EXT-X-PART-INF:PART-TARGET=0.33334\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4\n"
+    "foobar.ts\n"
+    "#EXTINF:4\n"
+    "foobar.ts\n"
+    "#EXT-X-PART:DURATION=0.33334,URI=\"part0.ts\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part1.ts\"\n";
+
+    m3u = ParseM3U8(obj, manifest6, sizeof(manifest6));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLive() == true);
+        Expect(m3u->suggestedPresentationDelay.Get() == vlc_tick_from_sec(8.5));
+        HLSRepresentation *rep = static_cast<HLSRepresentation *>
+                (m3u->getFirstPeriod()->getAdaptationSets().front()->getRepresentations().front());
+        Expect(rep->getMediaSegment(11));
+        Expect(!rep->getMediaSegment(12));
+        const std::string url = rep->getPlaylistUpdateUrl();
+        Expect(url.find("_HLS_msn=12") != std::string::npos);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
     return 0;
 }
@@ -33,6 +33,7 @@
 #include "../test.hpp"
 
 #include <limits>
+#include <ctime>
 
 using namespace adaptive;
 using namespace adaptive::playlist;
@@ -96,6 +97,12 @@ int SegmentTemplate_test()
         Expect(templ->getLiveTemplateNumber(now + timescale.ToTime(100) * 2 + 1, true) ==
                templ->getStartSegmentNumber() + 1);
 
+        /* segments available ahead of completion */
+        pl->availabilityStartTime.Set(vlc_tick_from_sec(::time(nullptr)) - VLC_TICK_FROM_SEC(1000));
+        const vlc_tick_t ahead = templ->getMinAheadTime(11);
+        rep->addAttribute(new AvailabilityTimeOffsetAttr(VLC_TICK_FROM_SEC(100)));
+        Expect(templ->getMinAheadTime(11) >= ahead + VLC_TICK_FROM_SEC(99));
+
         /* reset */
         pl->availabilityStartTime.Set(0);
         pl->availabilityEndTime.Set(0);
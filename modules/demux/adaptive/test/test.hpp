@@ -49,5 +49,7 @@ int CommandsQueue_test();
 int BufferingLogic_test();
 int FakeEsOut_test();
 int SegmentTracker_test();
+int Downloader_test();
+int DiskCache_test();
 
 #endif
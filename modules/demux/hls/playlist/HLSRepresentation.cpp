@@ -29,12 +29,20 @@
 #include "HLSSegment.hpp"
 #include "../../adaptive/playlist/BaseAdaptationSet.h"
 #include "../../adaptive/playlist/SegmentList.h"
+#include "../../adaptive/http/HTTPConnectionManager.h"
+#include "../../adaptive/http/Chunk.h"
+#include "../../adaptive/SharedResources.hpp"
+
+#include <vlc_block.h>
 
 #include <ctime>
 #include <limits>
+#include <sstream>
+#include <algorithm>
 
 using namespace hls;
 using namespace hls::playlist;
+using namespace adaptive::http;
 
 HLSRepresentation::HLSRepresentation  ( BaseAdaptationSet *set ) :
                 BaseRepresentation( set )
@@ -44,12 +52,18 @@ HLSRepresentation::HLSRepresentation  ( BaseAdaptationSet *set ) :
     updateFailureCount = 0;
     lastUpdateTime = 0;
     targetDuration = 0;
+    partTargetDuration = 0;
+    b_canBlockReload = false;
+    nextMediaSequence = 0;
+    pendingReload = nullptr;
     streamFormat = StreamFormat::Type::Unknown;
     channels = 0;
 }
 
 HLSRepresentation::~HLSRepresentation ()
 {
+    if(pendingReload)
+        pendingReload->recycle();
 }
 
 StreamFormat HLSRepresentation::getStreamFormat() const
@@ -87,6 +101,21 @@ Url HLSRepresentation::getPlaylistUrl() const
     }
 }
 
+std::string HLSRepresentation::getPlaylistUpdateUrl() const
+{
+    std::string url = getPlaylistUrl().toString();
+    if(!b_canBlockReload || !b_loaded || !isLive() || updateFailureCount)
+        return url;
+
+    /* Low-Latency HLS blocking reload: the server holds the request
+       until the next media segment is published */
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << url << (url.find('?') == std::string::npos ? '?' : '&')
+       << "_HLS_msn=" << nextMediaSequence;
+    return ss.str();
+}
+
 void HLSRepresentation::debug(vlc_object_t *obj, int indent) const
 {
     BaseRepresentation::debug(obj, indent);
@@ -138,6 +167,13 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
                             : VLC_TICK_FROM_SEC(2);
         if(updateFailureCount)
             duration /= 2;
+
+        /* blocking reloads return as soon as a new segment is available,
+           only guard against servers replying immediately */
+        if(pendingReload)
+            return pendingReload->isDone() &&
+                   elapsed >= std::max(partTargetDuration, VLC_TICK_FROM_MS(200));
+
         if(elapsed < duration)
             return false;
 
@@ -150,11 +186,51 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
     return false;
 }
 
+void HLSRepresentation::startBlockingReload(SharedResources *res)
+{
+    if(pendingReload || !b_canBlockReload || !isLive())
+        return;
+
+    /* Held by the server until the next segment is published, so it is run
+       by the downloader and only its result is picked up by updates */
+    AbstractConnectionManager *connManager = res->getConnManager();
+    try
+    {
+        pendingReload = connManager->makeSource(getPlaylistUpdateUrl(), getID(),
+                                                ChunkType::Playlist, BytesRange());
+    } catch (...) {
+        pendingReload = nullptr;
+    }
+    if(pendingReload)
+        connManager->start(pendingReload);
+}
+
+block_t * HLSRepresentation::takeBlockingReload()
+{
+    block_t *p_head = nullptr;
+    block_t **pp_tail = &p_head;
+    if(pendingReload->getRequestStatus() == RequestStatus::Success)
+    {
+        block_t *p_block;
+        while((p_block = pendingReload->readBlock()))
+            block_ChainLastAppend(&pp_tail, p_block);
+    }
+    pendingReload->recycle();
+    pendingReload = nullptr;
+    return p_head ? block_ChainGather(p_head) : nullptr;
+}
+
 bool HLSRepresentation::runLocalUpdates(SharedResources *res)
 {
     BasePlaylist *playlist = getPlaylist();
     M3U8Parser parser(res);
-    if(!parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this))
+    bool b_ok;
+    if(pendingReload)
+        b_ok = parser.appendSegmentsFromPlaylistData(playlist->getVLCObject(), this,
+                                                     takeBlockingReload());
+    else
+        b_ok = parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this);
+    if(!b_ok)
     {
         msg_Warn(playlist->getVLCObject(), "Failed to update %u/%u playlist ID %s",
                  updateFailureCount, MAX_UPDATE_FAILED_UPDATE_COUNT,
@@ -167,6 +243,7 @@ bool HLSRepresentation::runLocalUpdates(SharedResources *res)
     {
         updateFailureCount = 0;
         b_loaded = true;
+        startBlockingReload(res);
         return true;
     }
 }
@@ -25,6 +25,14 @@
 #include "../../adaptive/tools/Properties.hpp"
 #include "../../adaptive/StreamFormat.hpp"
 
+namespace adaptive
+{
+    namespace http
+    {
+        class AbstractChunkSource;
+    }
+}
+
 namespace hls
 {
     namespace playlist
@@ -45,6 +53,7 @@ namespace hls
 
                 void setPlaylistUrl(const std::string &);
                 Url getPlaylistUrl() const;
+                std::string getPlaylistUpdateUrl() const;
                 bool isLive() const;
                 bool initialized() const;
                 void scheduleNextUpdate(uint64_t, bool) override;
@@ -60,10 +69,16 @@ namespace hls
 
             protected:
                 time_t targetDuration;
+                vlc_tick_t partTargetDuration;
+                bool b_canBlockReload;
+                uint64_t nextMediaSequence;
                 Url playlistUrl;
 
             private:
+                void startBlockingReload(SharedResources *);
+                block_t * takeBlockingReload();
                 static const unsigned MAX_UPDATE_FAILED_UPDATE_COUNT = 3;
+                adaptive::http::AbstractChunkSource *pendingReload;
                 StreamFormat streamFormat;
                 bool b_live;
                 bool b_loaded;
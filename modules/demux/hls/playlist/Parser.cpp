@@ -226,6 +226,12 @@ void M3U8Parser::fillAdaptsetFromMediainfo(const AttributesTag *mediatag,
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresentation *rep)
 {
     block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUrl().toString());
+    return appendSegmentsFromPlaylistData(p_obj, rep, p_block);
+}
+
+bool M3U8Parser::appendSegmentsFromPlaylistData(vlc_object_t *p_obj, HLSRepresentation *rep,
+                                                block_t *p_block)
+{
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -290,6 +296,7 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
 
     rep->b_loaded = true;
     rep->b_live = !b_vod;
+    rep->b_canBlockReload = false;
 
     vlc_tick_t totalduration = 0;
     vlc_tick_t nzStartTime = 0;
@@ -437,6 +444,27 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
             }
             break;
 
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *controltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *attr = controltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_canBlockReload = attr && attr->value == "YES";
+                attr = controltag->getAttributeByName("HOLD-BACK");
+                if(attr && attr->floatingPoint() > 0)
+                    rep->getPlaylist()->suggestedPresentationDelay.Set(
+                                vlc_tick_from_sec(attr->floatingPoint()));
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *attr = static_cast<const AttributesTag *>(tag)->
+                                            getAttributeByName("PART-TARGET");
+                if(attr)
+                    rep->partTargetDuration = vlc_tick_from_sec(attr->floatingPoint());
+            }
+            break;
+
             case SingleValueTag::EXTXDISCONTINUITYSEQUENCE:
                 discontinuitySequence = static_cast<const SingleValueTag *>(tag)->getValue().decimal();
                 break;
@@ -455,6 +483,8 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
         segmentList->addSegment(seg);
     segmentstoappend.clear();
 
+    rep->nextMediaSequence = sequenceNumber;
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
@@ -99,6 +99,8 @@ namespace hls
                     EXTXSTART,
                     EXTXSTREAMINF,
                     EXTXSESSIONKEY,
+                    EXTXSERVERCONTROL,
+                    EXTXPARTINF,
                 };
                 AttributesTag(int, const std::string &);
                 virtual ~AttributesTag();
@@ -46,6 +46,7 @@ typedef int64_t stime_t;
 #define BRAND_qt__ VLC_FOURCC( 'q', 't', ' ', ' ' )
 #define BRAND_f4v  VLC_FOURCC( 'f', '4', 'v', ' ' ) /* Adobe Flash */
 #define BRAND_dash VLC_FOURCC( 'd', 'a', 's', 'h' )
+#define BRAND_cmfc VLC_FOURCC( 'c', 'm', 'f', 'c' )
 #define BRAND_smoo VLC_FOURCC( 's', 'm', 'o', 'o' ) /* Internal use */
 #define BRAND_mp41 VLC_FOURCC( 'm', 'p', '4', '1' )
 #define BRAND_av01 VLC_FOURCC( 'a', 'v', '0', '1' )
@@ -49,6 +49,7 @@
 #include "sections.h"
 #include "pes.h"
 #include "timestamps.h"
+#include "ts_sync.h"
 
 #include "ts.h"
 
@@ -194,6 +195,8 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, vlc_tick_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static uint64_t TSTell( demux_sys_t * );
+static int TSSeek( demux_sys_t *, uint64_t );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, vlc_tick_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, ts_90khz_t );
@@ -205,6 +208,9 @@ static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 #define TS_PACKET_SIZE_MAX 204
 #define TS_HEADER_SIZE 4
 
+/* read-ahead buffer size, in packets */
+#define TS_READ_BUFFER_PACKETS 100
+
 #define PROBE_CHUNK_COUNT 500
 #define PROBE_MAX         (PROBE_CHUNK_COUNT * 10)
 
@@ -218,23 +224,23 @@ static int DetectPacketSize( demux_t *p_demux, unsigned *pi_header_size, int i_o
 
     for( int i_sync = 0; i_sync < TS_PACKET_SIZE_MAX; i_sync++ )
     {
-        if( p_peek[i_offset + i_sync] != 0x47 )
-            continue;
+        const uint8_t *p_sync = memchr( &p_peek[i_offset + i_sync], TS_SYNC_BYTE,
+                                        TS_PACKET_SIZE_MAX - i_sync );
+        if( p_sync == NULL )
+            break;
+        i_sync = p_sync - &p_peek[i_offset];
 
         /* Check next 3 sync bytes */
         int i_peek = i_offset + TS_PACKET_SIZE_MAX * 3 + i_sync + 1;
         if( ( vlc_stream_Peek( p_demux->s, &p_peek, i_peek ) ) < i_peek )
             return -1;
+        p_sync = &p_peek[i_offset + i_sync];
 
-        if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_188] == 0x47 &&
-            p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_188] == 0x47 &&
-            p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_188] == 0x47 )
+        if( ts_sync_Check( p_sync, TS_PACKET_SIZE_188, 4 ) )
         {
             return TS_PACKET_SIZE_188;
         }
-        else if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_192] == 0x47 &&
-                 p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_192] == 0x47 &&
-                 p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_192] == 0x47 )
+        else if( ts_sync_Check( p_sync, TS_PACKET_SIZE_192, 4 ) )
         {
             if( i_sync == 4 )
             {
@@ -242,9 +248,7 @@ static int DetectPacketSize( demux_t *p_demux, unsigned *pi_header_size, int i_o
             }
             return TS_PACKET_SIZE_192;
         }
-        else if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_204] == 0x47 &&
-                 p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_204] == 0x47 &&
-                 p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_204] == 0x47 )
+        else if( ts_sync_Check( p_sync, TS_PACKET_SIZE_204, 4 ) )
         {
             return TS_PACKET_SIZE_204;
         }
@@ -405,6 +409,14 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->readbuf.i_size = i_packet_size * TS_READ_BUFFER_PACKETS;
+    p_sys->readbuf.p_buffer = malloc( p_sys->readbuf.i_size );
+    if( !p_sys->readbuf.p_buffer )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    ReadBufferReset( p_sys );
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
     p_sys->record_dir_path = NULL;
@@ -420,12 +432,14 @@ static int Open( vlc_object_t *p_this )
     patpid = GetPID(p_sys, 0);
     if ( !PIDSetup( p_demux, TYPE_PAT, patpid, NULL ) )
     {
+        free( p_sys->readbuf.p_buffer );
         free( p_sys );
         return VLC_ENOMEM;
     }
     if( !ts_psi_PAT_Attach( patpid, p_demux ) )
     {
         PIDRelease( p_demux, patpid );
+        free( p_sys->readbuf.p_buffer );
         free( p_sys );
         return VLC_EGENERIC;
     }
@@ -597,6 +611,7 @@ static void Close( vlc_object_t *p_this )
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
+    free( p_sys->readbuf.p_buffer );
     free( p_sys->record_dir_path );
     free( p_sys );
 }
@@ -965,7 +980,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TSTell( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -1012,7 +1027,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            TSSeek( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1162,9 +1177,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
+        ReadBufferReset( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
 
     case DEMUX_SET_SEEKPOINT:
+        ReadBufferReset( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
                                      args );
 
@@ -1796,14 +1813,82 @@ static void PESDataChainHandle( vlc_object_t *p_obj, void *priv, block_t *p_data
     ParsePESDataChain( (demux_t *)p_obj, (ts_pid_t *) priv, p_data, i_flags, i_appendpcr );
 }
 
+static void TSPacketViewRelease( block_t *p_pkt )
+{
+    /* storage is owned by the read-ahead buffer */
+    VLC_UNUSED(p_pkt);
+}
+
+static const struct vlc_block_callbacks TSPacketViewCbs =
+{
+    TSPacketViewRelease,
+};
+
+/* Drops any read-ahead data, to be called whenever the stream position
+ * is changed behind our back (seek, title/seekpoint change) */
+void ReadBufferReset( demux_sys_t *p_sys )
+{
+    p_sys->readbuf.i_offset = 0;
+    p_sys->readbuf.i_data = 0;
+}
+
+static inline size_t ReadBufferAvail( const demux_sys_t *p_sys )
+{
+    return p_sys->readbuf.i_data - p_sys->readbuf.i_offset;
+}
+
+/* Current position of the next unread TS packet */
+static uint64_t TSTell( demux_sys_t *p_sys )
+{
+    return vlc_stream_Tell( p_sys->stream ) - ReadBufferAvail( p_sys );
+}
+
+static int TSSeek( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    ReadBufferReset( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+/* Ensures at least i_min bytes are available in the read-ahead buffer.
+ * Only blocks for the missing bytes: whatever the stream already has
+ * buffered is appended as well, up to the buffer size. */
+static bool ReadBufferFill( demux_sys_t *p_sys, size_t i_min )
+{
+    size_t i_avail = ReadBufferAvail( p_sys );
+    if( i_avail >= i_min )
+        return true;
+
+    assert( i_min <= p_sys->readbuf.i_size );
+    if( p_sys->readbuf.i_offset > 0 )
+    {
+        memmove( p_sys->readbuf.p_buffer,
+                 &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset], i_avail );
+        p_sys->readbuf.i_offset = 0;
+        p_sys->readbuf.i_data = i_avail;
+    }
+
+    while( p_sys->readbuf.i_data < i_min )
+    {
+        ssize_t i_read = vlc_stream_ReadPartial( p_sys->stream,
+                                &p_sys->readbuf.p_buffer[p_sys->readbuf.i_data],
+                                p_sys->readbuf.i_size - p_sys->readbuf.i_data );
+        if( i_read <= 0 )
+            return false;
+        p_sys->readbuf.i_data += i_read;
+    }
+    return true;
+}
+
+/* Returns the next TS packet. The returned block is a view on the
+ * read-ahead buffer which remains valid until the next call:
+ * it must be duplicated if it has to be kept. */
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-
-    block_t     *p_pkt;
+    const size_t i_packet_size = p_sys->i_packet_size;
 
     /* Get a new TS packet */
-    if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+    if( !ReadBufferFill( p_sys, i_packet_size ) )
     {
         int64_t size = stream_Size( p_sys->stream );
         if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
@@ -1813,64 +1898,59 @@ static block_t* ReadTSPacket( demux_t *p_demux )
         return NULL;
     }
 
-    if( p_pkt->i_buffer < TS_HEADER_SIZE + p_sys->i_packet_header_size )
-    {
-        block_Release( p_pkt );
-        return NULL;
-    }
-
     /* Skip header (BluRay streams).
      * re-sync logic would do this (by adjusting packet start), but this would result in losing first and last ts packets.
      * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
      */
-    p_pkt->p_buffer += p_sys->i_packet_header_size;
-    p_pkt->i_buffer -= p_sys->i_packet_header_size;
+    const uint8_t *p_peek = &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset];
 
     /* Check sync byte and re-sync if needed */
-    if( p_pkt->p_buffer[0] != 0x47 )
+    if( p_peek[p_sys->i_packet_header_size] != TS_SYNC_BYTE )
     {
         msg_Warn( p_demux, "lost synchro" );
-        block_Release( p_pkt );
         for( ;; )
         {
-            const uint8_t *p_peek;
-            int i_peek = 0;
-            unsigned i_skip = 0;
-
-            i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
-                    p_sys->i_packet_size * 10 );
-            if( i_peek < 0 || (unsigned)i_peek < p_sys->i_packet_size + 1 )
+            /* Need the next packet sync byte to validate a candidate */
+            if( !ReadBufferFill( p_sys, __MIN( i_packet_size * 10,
+                                               p_sys->readbuf.i_size ) ) &&
+                ReadBufferAvail( p_sys ) < p_sys->i_packet_header_size +
+                                           i_packet_size + 1 )
             {
                 msg_Dbg( p_demux, "eof ?" );
                 return NULL;
             }
 
-            while( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
-                {
-                    break;
-                }
-                i_skip++;
-            }
-            msg_Dbg( p_demux, "skipping %d bytes of garbage at %"PRIu64,
-                     i_skip, vlc_stream_Tell( p_sys->stream ) );
-            if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
-                return NULL;
+            const size_t i_peek = ReadBufferAvail( p_sys ) - p_sys->i_packet_header_size;
+            p_peek = &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset];
 
-            if( i_skip < i_peek - p_sys->i_packet_size )
+            /* Look for two sync bytes one packet apart */
+            size_t i_skip = ts_sync_Find( &p_peek[p_sys->i_packet_header_size],
+                                          i_peek, i_packet_size, 2 );
+            msg_Dbg( p_demux, "skipping %zu bytes of garbage at %"PRIu64,
+                     i_skip, TSTell( p_sys ) );
+            p_sys->readbuf.i_offset += i_skip;
+
+            if( i_skip < i_peek - i_packet_size )
             {
                 break;
             }
         }
-        msg_Dbg( p_demux, "resynced at %" PRIu64, vlc_stream_Tell( p_sys->stream ) );
-        if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+        msg_Dbg( p_demux, "resynced at %" PRIu64, TSTell( p_sys ) );
+        if( !ReadBufferFill( p_sys, i_packet_size ) )
         {
             msg_Dbg( p_demux, "eof ?" );
             return NULL;
         }
     }
+
+    block_t *p_pkt = block_Init( &p_sys->readbuf.pkt, &TSPacketViewCbs,
+                                 &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset],
+                                 i_packet_size );
+    p_sys->readbuf.i_offset += i_packet_size;
+
+    p_pkt->p_buffer += p_sys->i_packet_header_size;
+    p_pkt->i_buffer -= p_sys->i_packet_header_size;
+
     return p_pkt;
 }
 
@@ -2002,13 +2082,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_seektime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return TSSeek( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSTell( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -2024,7 +2104,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( TSSeek( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -2038,7 +2118,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TSTell( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -2095,7 +2175,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, vlc_tick_t i_see
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
+        if( TSSeek( p_sys, i_initial_pos ) != VLC_SUCCESS )
             msg_Err( p_demux, "Can't seek back to %" PRIu64, i_initial_pos );
         return VLC_EGENERIC;
     }
@@ -2181,7 +2261,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
                         if( b_end )
                         {
                             p_pmt->i_last_dts = FROM_SCALE(i_pcr);
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TSTell( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == VLC_TICK_INVALID )
@@ -2209,7 +2289,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2221,7 +2301,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = (int64_t)p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TSSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count =  ProbeChunk( p_demux, i_program, false, &b_found );
@@ -2233,7 +2313,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TSSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2242,7 +2322,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2254,7 +2334,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TSSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count = ProbeChunk( p_demux, i_program, true, &b_found );
@@ -2266,7 +2346,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TSSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2322,14 +2402,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, i_pcr );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TSTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TSTell( p_sys );
             }
         }
     }
@@ -2701,6 +2781,11 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *p_pid, block_t *p_pkt, si
     p_pkt->p_buffer += i_skip; /* point to PES */
     p_pkt->i_buffer -= i_skip;
 
+    /* Packet is a view on the read buffer, only copy out the payload */
+    p_pkt = block_Duplicate( p_pkt );
+    if( unlikely(p_pkt == NULL) )
+        return false;
+
     const ts_es_t *p_es = p_pid->u.p_stream->p_es;
     ts_90khz_t i_append_pcr = ( p_es && p_es->p_program && p_es->p_program->pcr.i_current != VLC_TICK_INVALID )
                                   ? TO_SCALE(p_es->p_program->pcr.i_current)
@@ -66,6 +66,17 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Read-ahead buffer: TS packets are walked in place and only
+     * copied out when their payload needs to be kept (PES gathering) */
+    struct
+    {
+        uint8_t    *p_buffer;
+        size_t      i_size;   /* allocated size */
+        size_t      i_offset; /* start of the next unread packet */
+        size_t      i_data;   /* end of valid data */
+        block_t     pkt;      /* current packet, pointing into p_buffer */
+    } readbuf;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -152,4 +163,6 @@ int ProbeEnd( demux_t *p_demux, int i_program );
 void AddAndCreateES( demux_t *p_demux, ts_pid_t *pid, bool b_create_delayed );
 int FindPCRCandidate( ts_pmt_t *p_pmt );
 
+void ReadBufferReset( demux_sys_t * );
+
 #endif
@@ -42,8 +42,8 @@ void ts_pid_list_Init( ts_pid_list_t *p_list )
     p_list->pp_all = NULL;
     p_list->i_all = 0;
     p_list->i_all_alloc = 0;
-    p_list->i_last_pid = 0;
-    p_list->p_last = NULL;
+    for( size_t i = 0; i < TS_PID_INDEX_PAGES; i++ )
+        p_list->pp_index[i] = NULL;
 }
 
 void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
@@ -60,6 +60,8 @@ void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
         free( pid );
     }
     free( p_list->pp_all );
+    for( size_t i = 0; i < TS_PID_INDEX_PAGES; i++ )
+        free( p_list->pp_index[i] );
 }
 
 struct searchkey
@@ -78,22 +80,9 @@ static int ts_bsearch_searchkey_Compare( const void *key, const void *other )
     return ( p_key->i_pid >= p_pid->i_pid ) ? p_key->i_pid - p_pid->i_pid : -1;
 }
 
-ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
+/* Slow path, on index miss: inserts into the sorted list used for iteration */
+static ts_pid_t * ts_pid_New( ts_pid_list_t *p_list, uint16_t i_pid )
 {
-    switch( i_pid )
-    {
-        case 0:
-            return &p_list->pat;
-        case 0x1FFB:
-            return &p_list->base_si;
-        case 0x1FFF:
-            return &p_list->dummy;
-        default:
-            if( p_list->i_last_pid == i_pid )
-                return p_list->p_last;
-        break;
-    }
-
     size_t i_index = 0;
     ts_pid_t *p_pid = NULL;
 
@@ -152,8 +141,45 @@ ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
 
     }
 
-    p_list->p_last = p_pid;
-    p_list->i_last_pid = i_pid;
+    return p_pid;
+}
+
+ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
+{
+    switch( i_pid )
+    {
+        case 0:
+            return &p_list->pat;
+        case 0x1FFB:
+            return &p_list->base_si;
+        case 0x1FFF:
+            return &p_list->dummy;
+        default:
+        break;
+    }
+
+    assert( i_pid < 0x2000 );
+
+    ts_pid_t **pp_page = p_list->pp_index[i_pid >> TS_PID_INDEX_PAGE_BITS];
+    if( likely(pp_page) )
+    {
+        ts_pid_t *p_pid = pp_page[i_pid & (TS_PID_INDEX_PAGE_SIZE - 1)];
+        if( likely(p_pid) )
+            return p_pid;
+    }
+    else
+    {
+        pp_page = calloc( TS_PID_INDEX_PAGE_SIZE, sizeof(ts_pid_t *) );
+        if( !pp_page )
+        {
+            abort();
+            //return NULL;
+        }
+        p_list->pp_index[i_pid >> TS_PID_INDEX_PAGE_BITS] = pp_page;
+    }
+
+    ts_pid_t *p_pid = ts_pid_New( p_list, i_pid );
+    pp_page[i_pid & (TS_PID_INDEX_PAGE_SIZE - 1)] = p_pid;
 
     return p_pid;
 }
@@ -86,19 +86,21 @@ struct ts_pid_t
 
 };
 
+#define TS_PID_INDEX_PAGE_BITS 8
+#define TS_PID_INDEX_PAGE_SIZE (1 << TS_PID_INDEX_PAGE_BITS)
+#define TS_PID_INDEX_PAGES     (8192 >> TS_PID_INDEX_PAGE_BITS)
+
 struct ts_pid_list_t
 {
     ts_pid_t   pat;
     ts_pid_t   dummy;
     ts_pid_t   base_si;
-    /* all non commons ones, dynamically allocated */
+    /* all non commons ones, dynamically allocated, sorted by pid */
     ts_pid_t **pp_all;
     int        i_all;
     int        i_all_alloc;
-    /* last recently used */
-    uint16_t   i_last_pid;
-    ts_pid_t  *p_last;
-
+    /* direct pid lookup, pages of the 13 bits space allocated on use */
+    ts_pid_t **pp_index[TS_PID_INDEX_PAGES];
 };
 
 /* opacified pid list */
@@ -2118,7 +2118,11 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
     /* Install CAM descrambling */
     if ( p_sys->standard == TS_STANDARD_ARIB && p_sys->stream == p_demux->s && b_encryption )
     {
-        stream_t *wrapper = ts_stream_wrapper_New( p_demux->s );
+        /* The read-ahead packets were not descrambled yet: the filter reads
+         * them first */
+        stream_t *wrapper = ts_stream_wrapper_New( p_demux->s,
+                                &p_sys->readbuf.p_buffer[p_sys->readbuf.i_offset],
+                                p_sys->readbuf.i_data - p_sys->readbuf.i_offset );
         if( wrapper )
         {
             p_sys->stream = vlc_stream_FilterNew( wrapper, "aribcam" );
@@ -2127,6 +2131,8 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
                 vlc_stream_Delete( wrapper );
                 p_sys->stream = p_demux->s;
             }
+            else
+                ReadBufferReset( p_sys );
         }
     }
 
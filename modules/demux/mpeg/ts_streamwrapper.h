@@ -18,43 +18,103 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 #include <vlc_stream.h>
+#include <vlc_block.h>
+
+/* Data already read from the demux stream, served before reading it again */
+struct ts_stream_wrapper_sys
+{
+    stream_t *demuxstream;
+    uint8_t *p_pending;
+    size_t i_pending;
+    size_t i_offset;
+};
+
+static void ts_stream_wrapper_DropPending(struct ts_stream_wrapper_sys *sys)
+{
+    free(sys->p_pending);
+    sys->p_pending = NULL;
+    sys->i_pending = sys->i_offset = 0;
+}
 
 static int ts_stream_wrapper_Control(stream_t *s, int i_query, va_list va)
 {
-    stream_t *demuxstream = s->p_sys;
-    return demuxstream->pf_control(demuxstream, i_query, va);
+    struct ts_stream_wrapper_sys *sys = s->p_sys;
+    return sys->demuxstream->pf_control(sys->demuxstream, i_query, va);
 }
 
 static ssize_t ts_stream_wrapper_Read(stream_t *s, void *buf, size_t len)
 {
-    stream_t *demuxstream = s->p_sys;
-    return demuxstream->pf_read(demuxstream, buf, len);
+    struct ts_stream_wrapper_sys *sys = s->p_sys;
+    if(sys->i_offset < sys->i_pending)
+    {
+        size_t i_copy = __MIN(len, sys->i_pending - sys->i_offset);
+        memcpy(buf, &sys->p_pending[sys->i_offset], i_copy);
+        sys->i_offset += i_copy;
+        if(sys->i_offset == sys->i_pending)
+            ts_stream_wrapper_DropPending(sys);
+        return i_copy;
+    }
+    return sys->demuxstream->pf_read(sys->demuxstream, buf, len);
 }
 
 static block_t * ts_stream_wrapper_ReadBlock(stream_t *s, bool *restrict eof)
 {
-    stream_t *demuxstream = s->p_sys;
-    return demuxstream->pf_block(demuxstream, eof);
+    struct ts_stream_wrapper_sys *sys = s->p_sys;
+    if(sys->i_offset < sys->i_pending)
+    {
+        block_t *p_block = block_Alloc(sys->i_pending - sys->i_offset);
+        if(p_block)
+        {
+            memcpy(p_block->p_buffer, &sys->p_pending[sys->i_offset],
+                   p_block->i_buffer);
+            ts_stream_wrapper_DropPending(sys);
+        }
+        return p_block;
+    }
+    return sys->demuxstream->pf_block(sys->demuxstream, eof);
 }
 
 static int ts_stream_wrapper_Seek(stream_t *s, uint64_t pos)
 {
-    stream_t *demuxstream = s->p_sys;
-    return demuxstream->pf_seek(demuxstream, pos);
+    struct ts_stream_wrapper_sys *sys = s->p_sys;
+    ts_stream_wrapper_DropPending(sys);
+    return sys->demuxstream->pf_seek(sys->demuxstream, pos);
 }
 
 static void ts_stream_wrapper_Destroy(stream_t *s)
 {
-    VLC_UNUSED(s);
+    struct ts_stream_wrapper_sys *sys = s->p_sys;
+    ts_stream_wrapper_DropPending(sys);
+    free(sys);
 }
 
-static stream_t * ts_stream_wrapper_New(stream_t *demuxstream)
+static stream_t * ts_stream_wrapper_New(stream_t *demuxstream,
+                                        const uint8_t *p_pending,
+                                        size_t i_pending)
 {
+    struct ts_stream_wrapper_sys *sys = malloc(sizeof(*sys));
+    if(!sys)
+        return NULL;
+    sys->demuxstream = demuxstream;
+    sys->p_pending = NULL;
+    sys->i_pending = sys->i_offset = 0;
+    if(i_pending > 0)
+    {
+        sys->p_pending = malloc(i_pending);
+        if(!sys->p_pending)
+        {
+            free(sys);
+            return NULL;
+        }
+        memcpy(sys->p_pending, p_pending, i_pending);
+        sys->i_pending = i_pending;
+    }
+
     stream_t *s = vlc_stream_CommonNew(VLC_OBJECT(demuxstream),
                                        ts_stream_wrapper_Destroy);
     if(s)
     {
-        s->p_sys = demuxstream;
+        s->p_sys = sys;
         s->s = s;
         if(demuxstream->pf_read)
             s->pf_read = ts_stream_wrapper_Read;
@@ -65,5 +125,10 @@ static stream_t * ts_stream_wrapper_New(stream_t *demuxstream)
         if(demuxstream->pf_block)
             s->pf_block = ts_stream_wrapper_ReadBlock;
     }
+    else
+    {
+        ts_stream_wrapper_DropPending(sys);
+        free(sys);
+    }
     return s;
 }
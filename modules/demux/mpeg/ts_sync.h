@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * ts_sync.h: MPEG TS sync byte scanning helpers
+ *****************************************************************************
+ * Copyright (C) 2004-2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_MPEG_TS_SYNC_H
+#define VLC_MPEG_TS_SYNC_H
+
+#include <string.h>
+
+/*
+ * Only the demuxer looks for sync bytes in unaligned data. The TS muxer
+ * writes them, the DTV accesses read whole packets from the kernel, and the
+ * adaptive streaming format probe only looks at fixed offsets, so these
+ * helpers stay with the demuxer.
+ */
+
+#define TS_SYNC_BYTE 0x47
+
+/**
+ * Checks that sync bytes repeat with the given stride.
+ *
+ * \param p_sync pointer to a sync byte candidate
+ * \param i_stride packet size
+ * \param i_count number of consecutive sync bytes to check, including the
+ *                candidate itself; the caller must ensure that
+ *                (i_count - 1) * i_stride bytes are readable after p_sync
+ */
+static inline bool ts_sync_Check( const uint8_t *p_sync, size_t i_stride,
+                                  unsigned i_count )
+{
+    for( unsigned i = 0; i < i_count; i++ )
+        if( p_sync[i * i_stride] != TS_SYNC_BYTE )
+            return false;
+    return true;
+}
+
+/**
+ * Finds the first position where sync bytes repeat with the given stride.
+ *
+ * Candidates are located with memchr(), which the C library implements
+ * with vector instructions where available, so garbage is skipped in bulk
+ * rather than byte by byte.
+ *
+ * \param p_data buffer to scan
+ * \param i_data buffer size
+ * \param i_stride packet size
+ * \param i_count number of consecutive sync bytes required
+ * \return the offset of the first matching sync byte, or, if none was found,
+ *         the number of leading bytes that cannot start a match and can be
+ *         discarded
+ */
+static inline size_t ts_sync_Find( const uint8_t *p_data, size_t i_data,
+                                   size_t i_stride, unsigned i_count )
+{
+    const size_t i_span = (i_count - 1) * i_stride;
+    if( i_data <= i_span )
+        return 0;
+
+    const size_t i_limit = i_data - i_span;
+    const uint8_t *p = p_data;
+
+    while( (p = memchr( p, TS_SYNC_BYTE, i_limit - (p - p_data) )) != NULL )
+    {
+        if( ts_sync_Check( p, i_stride, i_count ) )
+            return p - p_data;
+        p++;
+    }
+    return i_limit;
+}
+
+#endif
@@ -0,0 +1,452 @@
+/*****************************************************************************
+ * chrome.c: Chrome trace event format tracer plugin
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_fs.h>
+#include <vlc_charset.h>
+#include <vlc_tracer.h>
+#include <vlc_vector.h>
+
+#include <errno.h>
+#include <math.h>
+#include <assert.h>
+
+/* The output can be loaded as is in chrome://tracing or ui.perfetto.dev.
+ *
+ * Frame traces (see vlc_tracer_TraceFrame()) of a same stream and pts are
+ * gathered until the frame is displayed, played or dropped. Each frame is
+ * then written as an asynchronous slice, nesting one slice per pipeline stage
+ * that lasts from the previous stage the frame went through. Frames that
+ * never end, such as the ones buffered by a filter, are eventually written
+ * as evicted. Other traces are written as instant events. */
+
+#define CHROME_FILENAME "vlc-trace.json"
+
+/* Frames in flight per stream, the oldest one is evicted when exceeded. It
+ * is far more than the frames buffered with large caching values. */
+#define FRAME_MAX_IN_FLIGHT 16384
+
+#define TIME_FROM_TICK(ts) US_FROM_VLC_TICK(ts)
+
+enum frame_stage
+{
+    STAGE_DEMUX,
+    STAGE_DECODE_IN,
+    STAGE_DECODE_OUT,
+    STAGE_FILTER,
+    STAGE_PREPARE,
+    STAGE_DISPLAY,
+    STAGE_PLAY,
+    STAGE_DROP,
+    STAGE_COUNT
+};
+
+static const char *const stage_names[STAGE_COUNT] =
+{
+    "demux", "decode_in", "decode_out", "filter", "prepare", "display",
+    "play", "drop",
+};
+
+struct frame
+{
+    vlc_tick_t pts;
+    vlc_tick_t ts[STAGE_COUNT];
+};
+
+struct track
+{
+    char *id;
+    unsigned tid;
+    struct VLC_VECTOR(struct frame) frames; /* in flight, oldest first */
+};
+
+typedef struct
+{
+    FILE *stream;
+    vlc_mutex_t lock;
+    struct VLC_VECTOR(struct track *) tracks;
+    uint64_t frame_count;
+    bool first_event;
+} vlc_tracer_sys_t;
+
+static void PrintString(FILE *stream, const char *str)
+{
+    if (str == NULL || !IsUTF8(str))
+    {
+        fputs("\"invalid string\"", stream);
+        return;
+    }
+
+    fputc('\"', stream);
+    for (; *str != '\0'; str++)
+    {
+        unsigned char byte = *str;
+        if (byte == '\"' || byte == '\\')
+            fprintf(stream, "\\%c", byte);
+        else if (byte <= 0x1F || byte == 0x7F)
+            fprintf(stream, "\\u%04x", byte);
+        else
+            fputc(byte, stream);
+    }
+    fputc('\"', stream);
+}
+
+static void PrintValue(FILE *stream, const struct vlc_tracer_entry *entry)
+{
+    switch (entry->type)
+    {
+        case VLC_TRACER_UINT:
+            fprintf(stream, "%"PRIu64, entry->value.uinteger);
+            break;
+        case VLC_TRACER_INT:
+            fprintf(stream, "%"PRId64, entry->value.integer);
+            break;
+        case VLC_TRACER_DOUBLE:
+            if (isfinite(entry->value.double_))
+                vlc_fprintf_c(stream, "%g", entry->value.double_);
+            else
+                fputs("null", stream);
+            break;
+        case VLC_TRACER_STRING:
+            PrintString(stream, entry->value.string);
+            break;
+        default:
+            vlc_assert_unreachable();
+    }
+}
+
+static void StartEvent(vlc_tracer_sys_t *sys, const char *name,
+                       const char *phase, vlc_tick_t ts, unsigned tid)
+{
+    FILE *stream = sys->stream;
+
+    fputs(sys->first_event ? "\n" : ",\n", stream);
+    sys->first_event = false;
+
+    fputs("{\"name\":", stream);
+    PrintString(stream, name);
+    fprintf(stream, ",\"ph\":\"%s\",\"ts\":%"PRId64",\"pid\":1,\"tid\":%u",
+            phase, TIME_FROM_TICK(ts), tid);
+}
+
+static struct track *GetTrack(vlc_tracer_sys_t *sys, const char *id,
+                              vlc_tick_t ts)
+{
+    struct track *track;
+    vlc_vector_foreach(track, &sys->tracks)
+        if (strcmp(track->id, id) == 0)
+            return track;
+
+    track = malloc(sizeof (*track));
+    if (unlikely(track == NULL))
+        return NULL;
+    track->id = strdup(id);
+    if (unlikely(track->id == NULL))
+    {
+        free(track);
+        return NULL;
+    }
+    /* tid 0 is used for traces that are not bound to a stream */
+    track->tid = sys->tracks.size + 1;
+    vlc_vector_init(&track->frames);
+
+    if (!vlc_vector_push(&sys->tracks, track))
+    {
+        free(track->id);
+        free(track);
+        return NULL;
+    }
+
+    StartEvent(sys, "thread_name", "M", ts, track->tid);
+    fputs(",\"args\":{\"name\":", sys->stream);
+    PrintString(sys->stream, id);
+    fputs("}}", sys->stream);
+    return track;
+}
+
+static void WriteFrame(vlc_tracer_sys_t *sys, const struct track *track,
+                       const struct frame *frame, bool evicted)
+{
+    FILE *stream = sys->stream;
+    const uint64_t id = sys->frame_count++;
+    const bool dropped = frame->ts[STAGE_DROP] != VLC_TICK_INVALID;
+    const char *name = evicted ? "evicted frame"
+                     : dropped ? "dropped frame" : "frame";
+
+    vlc_tick_t first = VLC_TICK_INVALID, last = VLC_TICK_INVALID;
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        if (frame->ts[i] == VLC_TICK_INVALID)
+            continue;
+        if (first == VLC_TICK_INVALID)
+            first = frame->ts[i];
+        last = frame->ts[i];
+    }
+
+    /* The frame slice, with the latency of each stage as arguments */
+    StartEvent(sys, name, "b", first, track->tid);
+    fprintf(stream, ",\"cat\":\"frame\",\"id\":%"PRIu64",\"args\":{", id);
+    fputs("\"id\":", stream);
+    PrintString(stream, track->id);
+    fprintf(stream, ",\"pts\":%"PRId64",\"total\":%"PRId64,
+            TIME_FROM_TICK(frame->pts), TIME_FROM_TICK(last - first));
+    /* Its end was not traced, or too many frames were in flight */
+    if (evicted)
+        fputs(",\"evicted\":true", stream);
+
+    vlc_tick_t prev = VLC_TICK_INVALID;
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        if (frame->ts[i] == VLC_TICK_INVALID)
+            continue;
+        if (prev != VLC_TICK_INVALID)
+            fprintf(stream, ",\"%s\":%"PRId64, stage_names[i],
+                    TIME_FROM_TICK(frame->ts[i] - prev));
+        prev = frame->ts[i];
+    }
+    fputs("}}", stream);
+
+    /* One nested slice per stage, lasting since the previous one */
+    prev = VLC_TICK_INVALID;
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        if (frame->ts[i] == VLC_TICK_INVALID)
+            continue;
+        if (prev != VLC_TICK_INVALID)
+        {
+            StartEvent(sys, stage_names[i], "b", prev, track->tid);
+            fprintf(stream, ",\"cat\":\"frame\",\"id\":%"PRIu64"}", id);
+            StartEvent(sys, stage_names[i], "e", frame->ts[i], track->tid);
+            fprintf(stream, ",\"cat\":\"frame\",\"id\":%"PRIu64"}", id);
+        }
+        prev = frame->ts[i];
+    }
+
+    StartEvent(sys, name, "e", last, track->tid);
+    fprintf(stream, ",\"cat\":\"frame\",\"id\":%"PRIu64"}", id);
+}
+
+static void TraceFrame(vlc_tracer_sys_t *sys, vlc_tick_t ts, const char *id,
+                       const char *stage_name, vlc_tick_t pts)
+{
+    size_t stage = 0;
+    while (strcmp(stage_names[stage], stage_name) != 0)
+        if (++stage == STAGE_COUNT)
+            return;
+
+    struct track *track = GetTrack(sys, id, ts);
+    if (track == NULL)
+        return;
+
+    const bool ending = stage == STAGE_DISPLAY || stage == STAGE_PLAY
+                     || stage == STAGE_DROP;
+
+    size_t index = 0;
+    while (index < track->frames.size && track->frames.data[index].pts != pts)
+        index++;
+
+    if (index == track->frames.size)
+    {
+        /* Pictures displayed again (while paused, on redraw) or frames whose
+         * previous stages were not traced: nothing to break down */
+        if (ending)
+            return;
+
+        if (track->frames.size == FRAME_MAX_IN_FLIGHT)
+        {
+            WriteFrame(sys, track, &track->frames.data[0], true);
+            vlc_vector_remove(&track->frames, 0);
+            index--;
+        }
+
+        struct frame new_frame = { .pts = pts };
+        for (size_t i = 0; i < STAGE_COUNT; ++i)
+            new_frame.ts[i] = VLC_TICK_INVALID;
+        if (!vlc_vector_push(&track->frames, new_frame))
+            return;
+    }
+
+    struct frame *frame = &track->frames.data[index];
+
+    /* Keep the first time a stage is reached, eg. for fields that are
+     * deinterlaced into two pictures of a same date */
+    if (frame->ts[stage] == VLC_TICK_INVALID)
+        frame->ts[stage] = ts;
+
+    if (ending)
+    {
+        WriteFrame(sys, track, frame, false);
+        vlc_vector_remove(&track->frames, index);
+    }
+}
+
+static void TraceEvent(vlc_tracer_sys_t *sys, vlc_tick_t ts,
+                       const struct vlc_tracer_trace *trace)
+{
+    const char *type = NULL, *id = NULL, *event = NULL;
+    const struct vlc_tracer_entry *entry;
+
+    for (entry = trace->entries; entry->key != NULL; entry++)
+    {
+        if (entry->type != VLC_TRACER_STRING)
+            continue;
+        if (strcmp(entry->key, "type") == 0)
+            type = entry->value.string;
+        else if (strcmp(entry->key, "id") == 0)
+            id = entry->value.string;
+        else if (strcmp(entry->key, "event") == 0)
+            event = entry->value.string;
+    }
+
+    const struct track *track = id != NULL ? GetTrack(sys, id, ts) : NULL;
+
+    char *name = NULL;
+    if (type != NULL && event != NULL && asprintf(&name, "%s %s", type, event) < 0)
+        name = NULL;
+
+    StartEvent(sys, name != NULL ? name : type != NULL ? type : "trace", "i",
+               ts, track != NULL ? track->tid : 0);
+    free(name);
+
+    FILE *stream = sys->stream;
+    fputs(",\"s\":\"t\",\"args\":{", stream);
+    for (entry = trace->entries; entry->key != NULL; entry++)
+    {
+        if (entry != trace->entries)
+            fputc(',', stream);
+        PrintString(stream, entry->key);
+        fputc(':', stream);
+        PrintValue(stream, entry);
+    }
+    fputs("}}", stream);
+}
+
+static void Trace(void *opaque, vlc_tick_t ts,
+                  const struct vlc_tracer_trace *trace)
+{
+    vlc_tracer_sys_t *sys = opaque;
+    const char *type = NULL, *id = NULL, *stage = NULL;
+    vlc_tick_t pts = VLC_TICK_INVALID;
+
+    for (const struct vlc_tracer_entry *entry = trace->entries;
+         entry->key != NULL; entry++)
+    {
+        if (strcmp(entry->key, "pts") == 0 && entry->type == VLC_TRACER_INT)
+            pts = VLC_TICK_FROM_NS(entry->value.integer);
+        else if (entry->type != VLC_TRACER_STRING)
+            continue;
+        else if (strcmp(entry->key, "type") == 0)
+            type = entry->value.string;
+        else if (strcmp(entry->key, "id") == 0)
+            id = entry->value.string;
+        else if (strcmp(entry->key, "stage") == 0)
+            stage = entry->value.string;
+    }
+
+    vlc_mutex_lock(&sys->lock);
+    if (type != NULL && strcmp(type, "FRAME") == 0)
+    {
+        if (id != NULL && stage != NULL && pts != VLC_TICK_INVALID)
+            TraceFrame(sys, ts, id, stage, pts);
+    }
+    else
+        TraceEvent(sys, ts, trace);
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void Close(void *opaque)
+{
+    vlc_tracer_sys_t *sys = opaque;
+
+    /* Frames still in flight are not written, they have no end */
+    struct track *track;
+    vlc_vector_foreach(track, &sys->tracks)
+    {
+        vlc_vector_destroy(&track->frames);
+        free(track->id);
+        free(track);
+    }
+    vlc_vector_destroy(&sys->tracks);
+
+    fputs("\n]\n", sys->stream);
+    fclose(sys->stream);
+    free(sys);
+}
+
+static const struct vlc_tracer_operations chrome_ops =
+{
+    Trace,
+    Close
+};
+
+static const struct vlc_tracer_operations *Open(vlc_object_t *obj,
+                                               void **restrict sysp)
+{
+    vlc_tracer_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return NULL;
+
+    char *path = var_InheritString(obj, "chrome-tracer-file");
+    const char *filename = path != NULL ? path : CHROME_FILENAME;
+
+    /* The trace is a single JSON array: start over rather than append */
+    msg_Dbg(obj, "opening trace file `%s'", filename);
+    sys->stream = vlc_fopen(filename, "wt");
+    if (sys->stream == NULL)
+    {
+        msg_Err(obj, "error opening trace file `%s': %s", filename,
+                vlc_strerror_c(errno));
+        free(path);
+        free(sys);
+        return NULL;
+    }
+    free(path);
+
+    vlc_mutex_init(&sys->lock);
+    vlc_vector_init(&sys->tracks);
+    sys->frame_count = 0;
+    sys->first_event = true;
+
+    fputc('[', sys->stream);
+    StartEvent(sys, "process_name", "M", 0, 0);
+    fputs(",\"args\":{\"name\":\"VLC\"}}", sys->stream);
+
+    *sysp = sys;
+    return &chrome_ops;
+}
+
+#define TRACEFILE_NAME_TEXT N_("Trace filename")
+#define TRACEFILE_NAME_LONGTEXT N_("Specify the trace filename.")
+
+vlc_module_begin()
+    set_shortname(N_("Chrome tracer"))
+    set_description(N_("Chrome trace event format tracer"))
+    set_subcategory(SUBCAT_ADVANCED_MISC)
+    set_capability("tracer", 0)
+    set_callback(Open)
+
+    add_savefile("chrome-tracer-file", NULL, TRACEFILE_NAME_TEXT,
+                 TRACEFILE_NAME_LONGTEXT)
+vlc_module_end()
@@ -224,6 +224,12 @@ static void CloseDemux ( vlc_object_t *p_this )
 
     msg_Dbg( p_demux, "Closing Stat demux" );
 
+    struct vlc_frame_cache_stats stats;
+    vlc_frame_cache_GetStats( &stats );
+    msg_Dbg( p_demux, "frame cache: %"PRIu64" hits, %"PRIu64" misses, "
+             "%"PRIu64" recycled, %"PRIu64" dropped", stats.hits,
+             stats.misses, stats.recycled, stats.dropped );
+
     free( p_demux->p_sys );
 }
 
@@ -79,7 +79,7 @@ add_submodule ()
     set_description(N_("Fragmented and streamable MP4 muxer"))
     set_subcategory(SUBCAT_SOUT_MUX)
     set_shortname("MP4 Frag")
-    add_shortcut("mp4frag", "mp4stream")
+    add_shortcut("mp4frag", "mp4stream", "cmaf")
     set_capability("sout mux", 0)
     set_callbacks(Open, CloseFrag)
 
@@ -298,7 +298,8 @@ static int Open(vlc_object_t *p_this)
     {
         if(!strcmp(p_mux->psz_mux, "mov"))
             options |= QUICKTIME;
-        if(!strcmp(p_mux->psz_mux, "mp4frag") || !strcmp(p_mux->psz_mux, "mp4stream"))
+        if(!strcmp(p_mux->psz_mux, "mp4frag") || !strcmp(p_mux->psz_mux, "mp4stream") ||
+           !strcmp(p_mux->psz_mux, "cmaf"))
             options |= FRAGMENTED;
     }
 
@@ -328,6 +329,12 @@ static int Open(vlc_object_t *p_this)
         mp4mux_SetBrand(p_sys->muxh, BRAND_3gp6, 0x0);
         mp4mux_AddExtraBrand(p_sys->muxh, BRAND_3gp4);
     }
+    else if(p_mux->psz_mux && !strcmp(p_mux->psz_mux, "cmaf"))
+    {
+        mp4mux_SetBrand(p_sys->muxh, BRAND_iso6, 0x0);
+        mp4mux_AddExtraBrand(p_sys->muxh, BRAND_iso6);
+        mp4mux_AddExtraBrand(p_sys->muxh, BRAND_cmfc);
+    }
     else
     {
         mp4mux_SetBrand(p_sys->muxh, BRAND_isom, 0x0);
@@ -1392,6 +1399,16 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 
     if (moof)
     {
+        /* advertise the fragment duration, for segmenting access outputs */
+        for (unsigned int i = 0; i < p_sys->i_nb_streams; i++)
+        {
+            vlc_tick_t i_duration = 0;
+            for (const mp4_fragentry_t *p_entry = p_sys->pp_streams[i]->towrite.p_first;
+                 p_entry != NULL; p_entry = p_entry->p_next)
+                i_duration += p_entry->p_block->i_length;
+            moof->b->i_length = __MAX(moof->b->i_length, i_duration);
+        }
+
         msg_Dbg(p_mux, "writing moof @ %"PRId64, p_sys->i_pos);
         p_sys->i_pos += bo_size(moof);
         assert(moof->b->i_flags & BLOCK_FLAG_TYPE_I); /* http sout */
@@ -1116,6 +1116,10 @@ static block_t *Encap_J2K( block_t *p_data, const es_format_t *p_fmt )
     }
     else
     {
+        /* The header is written over the skipped boxes */
+        p_data = block_Unshare( p_data );
+        if( unlikely(!p_data) )
+            return NULL;
         p_data->p_buffer += (i_offset - 38);
         p_data->i_buffer -= (i_offset - 38);
     }
@@ -453,11 +453,19 @@ static int Send( sout_stream_t *p_stream, void *_id, vlc_frame_t *frame )
     /* Should be ensured in `Add`. */
     assert(id->dup_ids.size > 0);
 
+    /* Branches reference the same payload instead of copying it */
+    if( id->dup_ids.size > 1 )
+    {
+        frame = vlc_frame_Shareable( frame );
+        if( unlikely(frame == NULL) )
+            return VLC_ENOMEM;
+    }
+
     duplicated_id_t *dup_id;
     vlc_vector_foreach_ref( dup_id, &id->dup_ids )
     {
         const bool is_last = dup_id == vlc_vector_last_ref( &id->dup_ids );
-        vlc_frame_t *to_send = (is_last) ? frame : vlc_frame_Duplicate( frame );
+        vlc_frame_t *to_send = (is_last) ? frame : vlc_frame_Share( frame );
         if ( unlikely(to_send == NULL) )
         {
             vlc_frame_Release( frame );
@@ -23,6 +23,7 @@
 
 #include <vlc_common.h>
 
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include <vlc_configuration.h>
 #include <vlc_frame.h>
@@ -33,9 +34,13 @@
 #include <vlc_messages.h>
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
+#include <vlc_strings.h>
+#include <vlc_threads.h>
 #include <vlc_tick.h>
 #include <vlc_vector.h>
 
+#include <time.h>
+
 #include "codecs.h"
 #include "hls.h"
 #include "segments.h"
@@ -74,6 +79,18 @@ typedef struct hls_playlist
     struct vlc_list tracks;
 
     hls_block_chain_t muxed_output;
+    /**
+     * Parts already published of the segment being produced (Low-Latency
+     * mode only).
+     */
+    hls_block_chain_t open_segment;
+    /**
+     * Length of the GOP being published and of the previous one, used to
+     * predict where the open segment should be closed (Low-Latency mode
+     * only).
+     */
+    vlc_tick_t open_gop_length;
+    vlc_tick_t last_gop_length;
 
     /**
      * Completed segments queue.
@@ -84,16 +101,40 @@ typedef struct hls_playlist
      */
     hls_segment_queue_t segments;
 
+    /**
+     * Media initialization section as in RFC 8216 section 4.3.2.5 (CMAF
+     * playlists only).
+     */
+    struct hls_storage *init_segment;
+    char *init_url;
+    httpd_url_t *http_init;
+
     char *url;
     const char *name;
+    /** Storage name of the delta update (Low-Latency mode only). */
+    char *delta_name;
     struct vlc_logger *logger;
 
     /**
      * Current playlist manifest as in RFC 8216 section 4.3.3.
      */
     struct hls_storage *manifest;
+    /**
+     * Playlist delta update as in RFC 8216bis section 6.2.5.1 (Low-Latency
+     * mode only).
+     */
+    struct hls_storage *delta_manifest;
     httpd_url_t *http_manifest;
 
+    /**
+     * Protects the manifests and the published sequence numbers below, read
+     * by the HTTP threads to answer blocking playlist reloads.
+     */
+    vlc_mutex_t lock;
+    unsigned int published_msn;
+    unsigned int published_parts;
+    bool published_ended;
+
     bool ended;
 
     /**
@@ -118,6 +159,26 @@ typedef struct
     struct vlc_list node;
 } hls_track_t;
 
+/**
+ * DASH description of one CMAF playlist.
+ *
+ * Kept past the playlist lifetime so that the manifest still lists the
+ * segments of the ended playlists.
+ */
+struct hls_dash_representation
+{
+    unsigned int playlist_id;
+    /** Adaptation Set and Representation opening, from the tracks. */
+    char *description;
+    /** Segment Template and Timeline, from the segments. */
+    char *timeline;
+    vlc_tick_t duration;
+    bool ended;
+};
+
+typedef struct VLC_VECTOR(struct hls_dash_representation)
+    hls_dash_representation_vec_t;
+
 typedef struct
 {
     /** All the plugin constants. */
@@ -151,6 +212,15 @@ typedef struct
     struct hls_storage *manifest;
     httpd_url_t *http_manifest;
 
+    /**
+     * DASH manifest describing the CMAF playlists segments.
+     */
+    struct hls_storage *dash_manifest;
+    httpd_url_t *http_dash_manifest;
+    /** Description of every CMAF playlist that produced segments. */
+    hls_dash_representation_vec_t dash_representations;
+    time_t availability_start;
+
     /**
      * Global advancement of the stream in media time.
      */
@@ -167,16 +237,10 @@ typedef struct
             (i_##it == 0 ? &sys->variant_playlists : &sys->media_playlists),   \
             node)
 
-static int HTTPCallback(httpd_callback_sys_t *sys,
-                        httpd_client_t *client,
-                        httpd_message_t *answer,
-                        const httpd_message_t *query)
+static void HTTPAnswerStorage(httpd_message_t *answer,
+                              const httpd_message_t *query,
+                              struct hls_storage *storage)
 {
-    if (answer == NULL || query == NULL || client == NULL)
-        return VLC_SUCCESS;
-
-    struct hls_storage *storage = (struct hls_storage *)sys;
-
     httpd_MsgAdd(answer, "Content-Type", "%s", storage->mime);
     httpd_MsgAdd(answer, "Cache-Control", "no-cache");
 
@@ -184,10 +248,12 @@ static int HTTPCallback(httpd_callback_sys_t *sys,
     answer->i_version = 0;
     answer->i_type = HTTPD_MSG_ANSWER;
 
-    const ssize_t size = storage->get_content(storage, &answer->p_body);
-    if (size != -1)
+    /* Shared with every client requesting the same storage, no copy. */
+    size_t size = 0;
+    answer->p_body_chain = storage->get_content(storage);
+    if (answer->p_body_chain != NULL)
     {
-        answer->i_body = size;
+        block_ChainProperties(answer->p_body_chain, NULL, &size, NULL);
         answer->i_status = 200;
     }
     else
@@ -195,11 +261,99 @@ static int HTTPCallback(httpd_callback_sys_t *sys,
 
     if (httpd_MsgGet(query, "Connection") != NULL)
         httpd_MsgAdd(answer, "Connection", "close");
-    httpd_MsgAdd(answer, "Content-Length", "%zu", answer->i_body);
+    httpd_MsgAdd(answer, "Content-Length", "%zu", size);
+}
+
 
+static int HTTPCallback(httpd_callback_sys_t *sys,
+                        httpd_client_t *client,
+                        httpd_message_t *answer,
+                        const httpd_message_t *query)
+{
+    if (answer == NULL || query == NULL || client == NULL)
+        return VLC_SUCCESS;
+
+    HTTPAnswerStorage(answer, query, (struct hls_storage *)sys);
     return VLC_SUCCESS;
 }
 
+
+/**
+ * Finds a query string argument, as sent by Low-Latency HLS clients.
+ *
+ * \return the argument value, terminated by '&' or '\0', or NULL if absent.
+ */
+static const char *GetQueryArgument(const httpd_message_t *query,
+                                    const char *name)
+{
+    const char *args = (const char *)query->psz_args;
+    const size_t name_len = strlen(name);
+    for (const char *it = args; it != NULL; it = strchr(it, '&'))
+    {
+        if (*it == '&')
+            ++it;
+        if (strncmp(it, name, name_len) == 0 && it[name_len] == '=')
+            return it + name_len + 1;
+    }
+    return NULL;
+}
+
+static int PlaylistHTTPCallback(httpd_callback_sys_t *sys,
+                                httpd_client_t *client,
+                                httpd_message_t *answer,
+                                const httpd_message_t *query)
+{
+    if (answer == NULL || query == NULL || client == NULL)
+        return VLC_SUCCESS;
+
+    hls_playlist_t *playlist = (hls_playlist_t *)sys;
+
+    /* Blocking playlist reload, as in RFC 8216bis section 6.2.5.2. */
+    const char *msn_arg = GetQueryArgument(query, "_HLS_msn");
+    const char *part_arg = GetQueryArgument(query, "_HLS_part");
+    const char *skip_arg = GetQueryArgument(query, "_HLS_skip");
+    const unsigned long msn =
+        (msn_arg != NULL) ? strtoul(msn_arg, NULL, 10) : 0;
+    const unsigned long part =
+        (part_arg != NULL) ? strtoul(part_arg, NULL, 10) : 0;
+    const bool skip = skip_arg != NULL &&
+                      strncmp(skip_arg, "YES", 3) == 0 &&
+                      (skip_arg[3] == '\0' || skip_arg[3] == '&');
+
+    vlc_mutex_lock(&playlist->lock);
+    if (msn_arg != NULL && !playlist->published_ended)
+    {
+        if (msn > playlist->published_msn + 1ul)
+        {
+            vlc_mutex_unlock(&playlist->lock);
+            answer->i_proto = HTTPD_PROTO_HTTP;
+            answer->i_version = 0;
+            answer->i_type = HTTPD_MSG_ANSWER;
+            answer->i_status = 400;
+            httpd_MsgAdd(answer, "Content-Length", "0");
+            return VLC_SUCCESS;
+        }
+
+        const bool available =
+            msn < playlist->published_msn ||
+            (part_arg != NULL && msn == playlist->published_msn &&
+             part < playlist->published_parts);
+        if (!available)
+        {
+            vlc_mutex_unlock(&playlist->lock);
+            httpd_ClientDefer(client,
+                              hls_config_GetHoldTimeout(playlist->config));
+            return VLC_SUCCESS;
+        }
+    }
+
+    struct hls_storage *manifest =
+        (skip && playlist->delta_manifest != NULL) ? playlist->delta_manifest
+                                                   : playlist->manifest;
+    HTTPAnswerStorage(answer, query, manifest);
+    vlc_mutex_unlock(&playlist->lock);
+    return VLC_SUCCESS;
+}
 typedef struct VLC_VECTOR(const es_format_t *) es_format_vec_t;
 
 static inline bool IsCodecAlreadyDescribed(const es_format_vec_t *vec,
@@ -399,8 +553,298 @@ error:
     return NULL;
 }
 
+/**
+ * Describe the tracks of a CMAF playlist as a DASH Adaptation Set (ISO/IEC
+ * 23009-1 section 5.3.3) with a single Representation.
+ */
+VLC_MALLOC static char *
+GenerateDashDescription(const hls_playlist_t *playlist)
+{
+    struct vlc_list no_media;
+    vlc_list_init(&no_media);
+    char *codecs = GeneratePlaylistCodecInfo(&no_media, playlist);
+    if (unlikely(codecs == NULL))
+        return NULL;
+
+    bool has_video = false;
+    unsigned int bandwidth = 0;
+    const iso639_lang_t *lang = NULL;
+    const hls_track_t *track;
+    vlc_list_foreach_const (track, &playlist->tracks, node)
+    {
+        const es_format_t *fmt = &track->input->fmt;
+        has_video |= fmt->i_cat == VIDEO_ES;
+        bandwidth += fmt->i_bitrate;
+        if (lang == NULL && fmt->psz_language != NULL)
+            lang = vlc_find_iso639(fmt->psz_language, false);
+    }
+
+    char *lang_attribute = NULL;
+    if (lang != NULL &&
+        asprintf(&lang_attribute, " lang=\"%3.3s\"", lang->psz_iso639_2T) == -1)
+        lang_attribute = NULL;
+
+    char *description;
+    if (asprintf(&description,
+                 "  <AdaptationSet id=\"%u\" segmentAlignment=\"true\"%s>\n"
+                 "   <Representation id=\"%u\" mimeType=\"%s\" "
+                 "codecs=\"%s\" bandwidth=\"%u\">\n",
+                 playlist->id,
+                 (lang_attribute != NULL) ? lang_attribute : "",
+                 playlist->id,
+                 has_video ? "video/mp4" : "audio/mp4",
+                 codecs,
+                 bandwidth) == -1)
+        description = NULL;
+    free(lang_attribute);
+    free(codecs);
+    return description;
+}
+
+/**
+ * Address the segments of a CMAF playlist with a DASH Segment Template and
+ * Timeline (ISO/IEC 23009-1 section 5.3.9).
+ */
+VLC_MALLOC static char *GenerateDashTimeline(const hls_playlist_t *playlist)
+{
+    struct vlc_memstream out;
+    vlc_memstream_open(&out);
+
+#define MPD_ADD(fmt, ...)                                                      \
+    do                                                                         \
+    {                                                                          \
+        if (vlc_memstream_printf(&out, fmt "\n", ##__VA_ARGS__) < 0)           \
+            goto error;                                                        \
+    } while (0)
+
+    /* Same naming as the segment queue, relative to the BaseURL. */
+    const hls_segment_t *first_seg = hls_segment_GetFirst(&playlist->segments);
+    MPD_ADD("    <SegmentTemplate timescale=\"%u\" initialization=\"%s\" "
+            "media=\"playlist-%u-$Number$.m4s\" startNumber=\"%u\">",
+            (unsigned int)CLOCK_FREQ,
+            playlist->init_url + strlen(playlist->config->base_url) + 1,
+            playlist->id,
+            (first_seg == NULL) ? 0u : first_seg->id);
+    MPD_ADD("     <SegmentTimeline>");
+
+    vlc_tick_t start = playlist->muxed_duration;
+    const hls_segment_t *segment;
+    hls_segment_queue_Foreach_const(&playlist->segments, segment)
+        start -= segment->length;
+    hls_segment_queue_Foreach_const(&playlist->segments, segment)
+    {
+        if (segment == first_seg)
+            MPD_ADD("      <S t=\"%" PRId64 "\" d=\"%" PRId64 "\"/>",
+                    start,
+                    segment->length);
+        else
+            MPD_ADD("      <S d=\"%" PRId64 "\"/>", segment->length);
+    }
+
+    MPD_ADD("     </SegmentTimeline>");
+    MPD_ADD("    </SegmentTemplate>");
+
+#undef MPD_ADD
+
+    if (vlc_memstream_close(&out) != 0)
+        return NULL;
+    return out.ptr;
+error:
+    if (vlc_memstream_close(&out) != 0)
+        return NULL;
+    free(out.ptr);
+    return NULL;
+}
+
+static void FormatUTCTime(char *buf, size_t size, time_t t)
+{
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(buf, size, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
+
+static struct hls_storage *GenerateDashManifest(const sout_stream_sys_t *sys)
+{
+    bool ended = true;
+    vlc_tick_t duration = 0;
+    const struct hls_dash_representation *rep;
+    vlc_vector_foreach_ref (rep, &sys->dash_representations)
+    {
+        ended &= rep->ended;
+        duration = __MAX(duration, rep->duration);
+    }
+
+    char *base_url = vlc_xml_encode(sys->config.base_url);
+    if (unlikely(base_url == NULL))
+        return NULL;
+
+    struct vlc_memstream out;
+    vlc_memstream_open(&out);
+
+    vlc_memstream_puts(&out,
+                       "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                       "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" "
+                       "profiles=\"urn:mpeg:dash:profile:isoff-live:2011,"
+                       "urn:mpeg:dash:profile:cmaf:2019\"");
+
+    const double seg_duration = secf_from_vlc_tick(sys->config.segment_length);
+    if (ended)
+    {
+        vlc_memstream_printf(&out,
+                             " type=\"static\" "
+                             "mediaPresentationDuration=\"PT%.3fS\"",
+                             secf_from_vlc_tick(duration));
+    }
+    else
+    {
+        char start[32], now[32];
+        FormatUTCTime(start, sizeof(start), sys->availability_start);
+        FormatUTCTime(now, sizeof(now), time(NULL));
+        vlc_memstream_printf(&out,
+                             " type=\"dynamic\" availabilityStartTime=\"%s\" "
+                             "publishTime=\"%s\" "
+                             "minimumUpdatePeriod=\"PT%.3fS\"",
+                             start,
+                             now,
+                             seg_duration);
+        if (sys->config.max_segments != 0)
+            vlc_memstream_printf(&out,
+                                 " timeShiftBufferDepth=\"PT%.3fS\"",
+                                 sys->config.max_segments * seg_duration);
+    }
+    vlc_memstream_printf(&out,
+                         " minBufferTime=\"PT%.3fS\">\n"
+                         " <BaseURL>%s/</BaseURL>\n"
+                         " <Period id=\"0\" start=\"PT0S\">\n",
+                         seg_duration,
+                         base_url);
+    free(base_url);
+
+    vlc_vector_foreach_ref (rep, &sys->dash_representations)
+    {
+        vlc_memstream_puts(&out, rep->description);
+        vlc_memstream_puts(&out, rep->timeline);
+        vlc_memstream_puts(&out, "   </Representation>\n  </AdaptationSet>\n");
+    }
+
+    vlc_memstream_puts(&out, " </Period>\n</MPD>\n");
+
+    if (vlc_memstream_close(&out) != 0)
+        return NULL;
+
+    const struct hls_storage_config storage_conf = {
+        .name = "index.mpd",
+        .mime = "application/dash+xml",
+    };
+    return hls_storage_FromBytes(
+        out.ptr, out.length, &storage_conf, &sys->config);
+}
+
+static int UpdateDashManifest(sout_stream_sys_t *sys,
+                              const hls_playlist_t *playlist)
+{
+    /* The tracks are already gone when the last segment is added. */
+    char *description = NULL;
+    if (!vlc_list_is_empty(&playlist->tracks))
+    {
+        description = GenerateDashDescription(playlist);
+        if (unlikely(description == NULL))
+            return VLC_ENOMEM;
+    }
+
+    char *timeline = GenerateDashTimeline(playlist);
+    if (unlikely(timeline == NULL))
+    {
+        free(description);
+        return VLC_ENOMEM;
+    }
+
+    struct hls_dash_representation *rep = NULL;
+    struct hls_dash_representation *it;
+    vlc_vector_foreach_ref (it, &sys->dash_representations)
+    {
+        if (it->playlist_id == playlist->id)
+        {
+            rep = it;
+            break;
+        }
+    }
+    if (rep == NULL)
+    {
+        const struct hls_dash_representation new_rep = {
+            .playlist_id = playlist->id};
+        if (description == NULL ||
+            !vlc_vector_push(&sys->dash_representations, new_rep))
+        {
+            free(description);
+            free(timeline);
+            return (description == NULL) ? VLC_SUCCESS : VLC_ENOMEM;
+        }
+        rep = vlc_vector_last_ref(&sys->dash_representations);
+    }
+
+    if (description != NULL)
+    {
+        free(rep->description);
+        rep->description = description;
+    }
+    free(rep->timeline);
+    rep->timeline = timeline;
+    rep->duration = playlist->muxed_duration;
+    rep->ended = playlist->ended;
+
+    struct hls_storage *new_manifest = GenerateDashManifest(sys);
+    if (unlikely(new_manifest == NULL))
+        return VLC_EGENERIC;
+
+    if (sys->http_dash_manifest != NULL)
+    {
+        httpd_UrlCatch(sys->http_dash_manifest,
+                       HTTPD_MSG_GET,
+                       HTTPCallback,
+                       (httpd_callback_sys_t *)new_manifest);
+    }
+
+    if (sys->dash_manifest != NULL)
+        hls_storage_Destroy(sys->dash_manifest);
+    sys->dash_manifest = new_manifest;
+    return VLC_SUCCESS;
+}
+
+static inline bool IsLowLatency(const hls_playlist_t *playlist)
+{
+    /* Subtitle segments are cut by their own segmenter, never in parts. */
+    return playlist->config->part_length != 0 &&
+           playlist->type == HLS_PLAYLIST_TYPE_TS;
+}
+
+/* Delta updates may skip the segments ending that many target durations
+ * before the end of the playlist. RFC 8216bis requires at least six. */
+#define HLS_SKIP_TARGET_DURATIONS 6
+
+static unsigned int CountSkippableSegments(const hls_playlist_t *playlist)
+{
+    const vlc_tick_t skip_until =
+        HLS_SKIP_TARGET_DURATIONS * playlist->config->segment_length;
+
+    vlc_tick_t remaining = 0;
+    const hls_segment_t *segment;
+    hls_segment_queue_Foreach_const(&playlist->segments, segment)
+        remaining += segment->length;
+
+    unsigned int count = 0;
+    hls_segment_queue_Foreach_const(&playlist->segments, segment)
+    {
+        remaining -= segment->length;
+        if (remaining < skip_until)
+            break;
+        ++count;
+    }
+    return count;
+}
+
 static struct hls_storage *
-GeneratePlaylistManifest(const hls_playlist_t *playlist)
+GeneratePlaylistManifest(const hls_playlist_t *playlist, bool delta)
 {
     struct vlc_memstream out;
     vlc_memstream_open(&out);
@@ -416,8 +860,13 @@ GeneratePlaylistManifest(const hls_playlist_t *playlist)
     const double seg_duration =
         secf_from_vlc_tick(playlist->config->segment_length);
     MANIFEST_ADD_TAG("#EXT-X-TARGETDURATION:%.0f", seg_duration);
-    // First version adding CMAF fragments support.
-    MANIFEST_ADD_TAG("#EXT-X-VERSION:7");
+    const bool low_latency = IsLowLatency(playlist);
+    if (low_latency)
+        // First version adding playlist delta updates.
+        MANIFEST_ADD_TAG("#EXT-X-VERSION:9");
+    else
+        // First version adding CMAF fragments support.
+        MANIFEST_ADD_TAG("#EXT-X-VERSION:7");
 
     const bool will_destroy_segments = playlist->config->max_segments == 0;
     if (playlist->ended)
@@ -425,17 +874,68 @@ GeneratePlaylistManifest(const hls_playlist_t *playlist)
     else if (!will_destroy_segments)
         MANIFEST_ADD_TAG("#EXT-X-PLAYLIST-TYPE:EVENT");
 
+    if (low_latency)
+    {
+        const double part_duration =
+            secf_from_vlc_tick(playlist->config->part_length);
+        MANIFEST_ADD_TAG("#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,"
+                         "PART-HOLD-BACK=%.3f,CAN-SKIP-UNTIL=%.1f",
+                         3 * part_duration,
+                         HLS_SKIP_TARGET_DURATIONS * seg_duration);
+        MANIFEST_ADD_TAG("#EXT-X-PART-INF:PART-TARGET=%.3f", part_duration);
+    }
+
     const hls_segment_t *first_seg = hls_segment_GetFirst(&playlist->segments);
     MANIFEST_ADD_TAG("#EXT-X-MEDIA-SEQUENCE:%u",
                      (first_seg == NULL) ? 0u : first_seg->id);
 
+    if (playlist->init_segment != NULL)
+        MANIFEST_ADD_TAG("#EXT-X-MAP:URI=\"%s\"", playlist->init_url);
+
+    unsigned int skipped = delta ? CountSkippableSegments(playlist) : 0;
+    if (skipped != 0)
+        MANIFEST_ADD_TAG("#EXT-X-SKIP:SKIPPED-SEGMENTS=%u", skipped);
+
+#define MANIFEST_ADD_PARTS(seg_id)                                             \
+    do                                                                         \
+    {                                                                          \
+        const hls_part_t *part;                                                \
+        hls_part_queue_Foreach_const(&playlist->segments, part)                \
+        {                                                                      \
+            if (part->segment_id != (seg_id))                                  \
+                continue;                                                      \
+            MANIFEST_ADD_TAG("#EXT-X-PART:DURATION=%.3f,URI=\"%s\"%s",         \
+                             secf_from_vlc_tick(part->length),                 \
+                             part->url,                                        \
+                             part->independent ? ",INDEPENDENT=YES" : "");     \
+        }                                                                      \
+    } while (0)
+
     const hls_segment_t *segment;
     hls_segment_queue_Foreach_const(&playlist->segments, segment)
     {
+        if (skipped != 0)
+        {
+            --skipped;
+            continue;
+        }
+        if (low_latency)
+            MANIFEST_ADD_PARTS(segment->id);
         MANIFEST_ADD_TAG("#EXTINF:%.2f,", secf_from_vlc_tick(segment->length));
         MANIFEST_ADD_TAG("%s", segment->url);
     }
 
+    if (low_latency && !playlist->ended)
+    {
+        MANIFEST_ADD_PARTS(playlist->segments.total_segments);
+
+        const hls_part_t *next_part = playlist->segments.next_part;
+        if (next_part != NULL)
+            MANIFEST_ADD_TAG("#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"%s\"",
+                             next_part->url);
+    }
+#undef MANIFEST_ADD_PARTS
+
     if (playlist->ended)
         MANIFEST_ADD_TAG("#EXT-X-ENDLIST");
 
@@ -445,7 +945,8 @@ GeneratePlaylistManifest(const hls_playlist_t *playlist)
         return NULL;
 
     const struct hls_storage_config storage_config = {
-        .name = playlist->name, .mime = "application/vnd.apple.mpegurl"};
+        .name = delta ? playlist->delta_name : playlist->name,
+        .mime = "application/vnd.apple.mpegurl"};
     return hls_storage_FromBytes(
         out.ptr, out.length, &storage_config, playlist->config);
 error:
@@ -457,21 +958,41 @@ error:
 
 static int UpdatePlaylistManifest(hls_playlist_t *playlist)
 {
-    struct hls_storage *new_manifest = GeneratePlaylistManifest(playlist);
+    struct hls_storage *new_manifest =
+        GeneratePlaylistManifest(playlist, false);
     if (unlikely(new_manifest == NULL))
         return VLC_EGENERIC;
 
-    if (playlist->http_manifest != NULL)
+    struct hls_storage *new_delta = NULL;
+    if (IsLowLatency(playlist))
     {
-        httpd_UrlCatch(playlist->http_manifest,
-                       HTTPD_MSG_GET,
-                       HTTPCallback,
-                       (httpd_callback_sys_t *)new_manifest);
+        new_delta = GeneratePlaylistManifest(playlist, true);
+        if (unlikely(new_delta == NULL))
+        {
+            hls_storage_Destroy(new_manifest);
+            return VLC_EGENERIC;
+        }
     }
 
-    if (playlist->manifest != NULL)
-        hls_storage_Destroy(playlist->manifest);
+    vlc_mutex_lock(&playlist->lock);
+    struct hls_storage *old_manifest = playlist->manifest;
+    struct hls_storage *old_delta = playlist->delta_manifest;
     playlist->manifest = new_manifest;
+    playlist->delta_manifest = new_delta;
+    playlist->published_msn = playlist->segments.total_segments;
+    playlist->published_parts = playlist->segments.open_parts;
+    playlist->published_ended = playlist->ended;
+    vlc_mutex_unlock(&playlist->lock);
+
+    /* Answer the blocking reloads waiting for this update. */
+    if (playlist->http_manifest != NULL)
+        httpd_UrlWakeUp(playlist->http_manifest);
+
+    /* Answers hold their own reference on the content. */
+    if (old_manifest != NULL)
+        hls_storage_Destroy(old_manifest);
+    if (old_delta != NULL)
+        hls_storage_Destroy(old_delta);
     return VLC_SUCCESS;
 }
 
@@ -544,6 +1065,14 @@ static hls_block_chain_t ExtractSubtitleSegment(hls_block_chain_t *muxed_output,
 
 static hls_block_chain_t ExtractSegment(hls_playlist_t *playlist)
 {
+    if (IsLowLatency(playlist))
+    {
+        /* The segment is made of the parts already published. */
+        hls_block_chain_t segment = playlist->open_segment;
+        hls_block_chain_Reset(&playlist->open_segment);
+        return segment;
+    }
+
     const vlc_tick_t seglen = playlist->config->segment_length;
     if (playlist->type == HLS_PLAYLIST_TYPE_WEBVTT)
         return ExtractSubtitleSegment(&playlist->muxed_output, seglen);
@@ -607,9 +1136,183 @@ static int ExtractAndAddSegment(hls_playlist_t *playlist,
               "Segment '%u' created",
               playlist->segments.total_segments);
 
+    if (sys->config.dash && playlist->type == HLS_PLAYLIST_TYPE_CMAF &&
+        UpdateDashManifest(sys, playlist) != VLC_SUCCESS)
+        return VLC_EGENERIC;
+
+    return UpdatePlaylistManifest(playlist);
+}
+
+/**
+ * Publish a part of the segment being produced.
+ *
+ * Segments only start on independent parts, like the regular segmenter only
+ * cuts on synchronization points: the segment is completed before an
+ * independent part if the GOP it starts would likely make the segment longer
+ * than the segment length.
+ */
+static int PublishPart(hls_playlist_t *playlist,
+                       sout_stream_sys_t *sys,
+                       hls_block_chain_t *part)
+{
+    hls_block_chain_t *segment = &playlist->open_segment;
+    const bool independent = part->begin->i_flags & BLOCK_FLAG_HEADER;
+    if (independent)
+    {
+        if (playlist->open_gop_length > 0)
+            playlist->last_gop_length = playlist->open_gop_length;
+        playlist->open_gop_length = 0;
+
+        const vlc_tick_t next_gop_length =
+            __MAX(playlist->last_gop_length, part->length);
+        if (segment->length > 0 &&
+            segment->length + next_gop_length >
+                playlist->config->segment_length &&
+            ExtractAndAddSegment(playlist, sys) != VLC_SUCCESS)
+        {
+            block_ChainRelease(part->begin);
+            return VLC_EGENERIC;
+        }
+    }
+    playlist->open_gop_length += part->length;
+
+    /* The part is served on its own while its blocks also make the
+     * segment. */
+    size_t size;
+    block_ChainProperties(part->begin, NULL, &size, NULL);
+    block_t *content = block_Alloc(size);
+    if (unlikely(content == NULL))
+    {
+        block_ChainRelease(part->begin);
+        return VLC_ENOMEM;
+    }
+    block_ChainExtract(part->begin, content->p_buffer, size);
+
+    block_ChainLastAppend(&segment->end, part->begin);
+    segment->length += part->length;
+
+    const int status = hls_segment_queue_NewPart(
+        &playlist->segments, content, part->length, independent);
+    if (unlikely(status != VLC_SUCCESS))
+    {
+        vlc_error(playlist->logger,
+                  "Part '%u' creation failed",
+                  playlist->segments.total_parts);
+        return status;
+    }
     return UpdatePlaylistManifest(playlist);
 }
 
+/**
+ * Find the end of the next part of the muxed output: parts last at most the
+ * part length and a new part starts on every synchronization point.
+ *
+ * \param[out] length The part length.
+ * \return The last block of the part, NULL if the part end is not known yet.
+ */
+static block_t *FindPartEnd(const hls_playlist_t *playlist,
+                            vlc_tick_t *length)
+{
+    const vlc_tick_t part_length = playlist->config->part_length;
+    *length = 0;
+    block_t *last = NULL;
+    for (block_t *it = playlist->muxed_output.begin; it != NULL;
+         it = it->p_next)
+    {
+        if (last != NULL && ((it->i_flags & BLOCK_FLAG_HEADER) ||
+                             *length + it->i_length > part_length))
+            return last;
+        *length += it->i_length;
+        last = it;
+    }
+    /* The part end is only known once the next block is muxed. */
+    return NULL;
+}
+
+static inline bool IsPartReady(const hls_playlist_t *playlist)
+{
+    vlc_tick_t length;
+    return FindPartEnd(playlist, &length) != NULL;
+}
+
+static int ExtractAndPublishPart(hls_playlist_t *playlist,
+                                 sout_stream_sys_t *sys)
+{
+    hls_block_chain_t *output = &playlist->muxed_output;
+    hls_block_chain_t part = {.begin = output->begin};
+    block_t *last = FindPartEnd(playlist, &part.length);
+    assert(last != NULL);
+
+    output->begin = last->p_next;
+    last->p_next = NULL;
+    output->length -= part.length;
+
+    return PublishPart(playlist, sys, &part);
+}
+
+static int SetInitSegment(hls_playlist_t *playlist, block_t *block)
+{
+    const struct hls_storage_config storage_conf = {
+        .name = playlist->init_url + strlen(playlist->config->base_url) + 1,
+        .mime = "video/mp4",
+    };
+    struct hls_storage *storage =
+        hls_storage_FromBlocks(block, &storage_conf, playlist->config);
+    if (unlikely(storage == NULL))
+        return VLC_ENOMEM;
+
+    if (playlist->http_init != NULL)
+    {
+        httpd_UrlCatch(playlist->http_init,
+                       HTTPD_MSG_GET,
+                       HTTPCallback,
+                       (httpd_callback_sys_t *)storage);
+    }
+
+    if (playlist->init_segment != NULL)
+        hls_storage_Destroy(playlist->init_segment);
+    playlist->init_segment = storage;
+
+    vlc_debug(playlist->logger, "Initialization segment created");
+    return VLC_SUCCESS;
+}
+
+/**
+ * Prepare the fragmented MP4 muxer output for segmenting.
+ *
+ * The ftyp and moov boxes are kept aside as the initialization segment.
+ * Fragments are the segmenting units: their moof box, flagged as a header,
+ * carries the whole fragment duration and the following data carries none.
+ */
+static int PrepareCMAFOutput(hls_playlist_t *playlist, block_t **block)
+{
+    block_t *it = *block;
+    if ((it->i_flags & (BLOCK_FLAG_HEADER | BLOCK_FLAG_TYPE_I)) ==
+        BLOCK_FLAG_HEADER)
+    {
+        *block = it->p_next;
+        it->p_next = NULL;
+        if (SetInitSegment(playlist, it) != VLC_SUCCESS)
+        {
+            block_Release(it);
+            block_ChainRelease(*block);
+            return VLC_ENOMEM;
+        }
+    }
+
+    for (it = *block; it != NULL; it = it->p_next)
+    {
+        if (it->i_flags & BLOCK_FLAG_TYPE_I)
+            it->i_flags |= BLOCK_FLAG_HEADER;
+        else
+        {
+            it->i_flags &= ~BLOCK_FLAG_HEADER;
+            it->i_length = 0;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
 static bool IsSegmentReady(enum hls_playlist_type type,
                            hls_block_chain_t *buffer,
                            vlc_tick_t seglen)
@@ -648,16 +1351,35 @@ static ssize_t AccessOutWrite(sout_access_out_t *access, block_t *block)
     }
 
     bool segments_ready = true;
+    bool parts_ready = true;
     hls_playlist_t *it;
     hls_playlists_foreach(it)
     {
         /* Append the muxed output to the playlist tied to this access call. */
         if (it->access == access)
         {
-            block_ChainLastAppend(&it->muxed_output.end, block);
-            it->muxed_output.length += length;
-            if (block->i_flags & BLOCK_FLAG_HEADER)
-                it->muxed_output.last_header = block;
+            if (it->type == HLS_PLAYLIST_TYPE_CMAF)
+            {
+                if (PrepareCMAFOutput(it, &block) != VLC_SUCCESS)
+                    return -1;
+                block_ChainProperties(block, NULL, NULL, &length);
+            }
+
+            if (block != NULL)
+            {
+                block_ChainLastAppend(&it->muxed_output.end, block);
+                it->muxed_output.length += length;
+                if (block->i_flags & BLOCK_FLAG_HEADER)
+                    it->muxed_output.last_header = block;
+            }
+        }
+
+        /* Low-Latency playlists publish their output part by part. */
+        if (IsLowLatency(it))
+        {
+            if (!IsPartReady(it))
+                parts_ready = false;
+            continue;
         }
 
         if (!IsSegmentReady(
@@ -665,11 +1387,30 @@ static ssize_t AccessOutWrite(sout_access_out_t *access, block_t *block)
             segments_ready = false;
     }
 
+    if (parts_ready)
+    {
+        hls_playlists_foreach (it)
+        {
+            if (!IsLowLatency(it))
+                continue;
+
+            while (IsPartReady(it) &&
+                   it->muxed_duration + it->open_segment.length <
+                       sys->elapsed_stream_time)
+            {
+                if (ExtractAndPublishPart(it, sys) != VLC_SUCCESS)
+                    return -1;
+            }
+        }
+    }
 
     if (segments_ready)
     {
         hls_playlists_foreach (it)
         {
+            if (IsLowLatency(it))
+                continue;
+
             while (IsSegmentReady(it->type,
                                   &it->muxed_output,
                                   sys->config.segment_length) &&
@@ -730,6 +1471,8 @@ static sout_mux_t *CreatePlaylistMuxer(sout_access_out_t *access,
             return sout_MuxNew(access, "ts{use-key-frames}");
         case HLS_PLAYLIST_TYPE_WEBVTT:
             return CreateSubtitleSegmenter(access, config);
+        case HLS_PLAYLIST_TYPE_CMAF:
+            return sout_MuxNew(access, "cmaf");
     }
     return NULL;
 }
@@ -756,6 +1499,8 @@ static hls_playlist_t *CreatePlaylist(sout_stream_t *stream,
     playlist->config = &sys->config;
     playlist->ended = false;
     playlist->muxed_duration = 0;
+    playlist->open_gop_length = 0;
+    playlist->last_gop_length = 0;
 
     playlist->url = FormatPlaylistManifestURL(playlist);
     if (unlikely(playlist->url == NULL))
@@ -763,6 +1508,16 @@ static hls_playlist_t *CreatePlaylist(sout_stream_t *stream,
 
     playlist->name = playlist->url + strlen(sys->config.base_url) + 1;
 
+    playlist->delta_name = NULL;
+    if (IsLowLatency(playlist) &&
+        asprintf(&playlist->delta_name,
+                 "playlist-%u-delta.m3u8",
+                 playlist->id) == -1)
+    {
+        playlist->delta_name = NULL;
+        goto delta_err;
+    }
+
     playlist->logger = vlc_LogHeaderCreate(stream->obj.logger, playlist->name);
     if (unlikely(playlist->logger == NULL))
         goto log_err;
@@ -776,20 +1531,50 @@ static hls_playlist_t *CreatePlaylist(sout_stream_t *stream,
     hls_segment_queue_Init(&playlist->segments, &config, &sys->config);
 
     hls_block_chain_Reset(&playlist->muxed_output);
+    hls_block_chain_Reset(&playlist->open_segment);
+
+    playlist->init_segment = NULL;
+    playlist->init_url = NULL;
+    playlist->http_init = NULL;
+    if (type == HLS_PLAYLIST_TYPE_CMAF)
+    {
+        if (asprintf(&playlist->init_url,
+                     "%s/playlist-%u-init.mp4",
+                     sys->config.base_url,
+                     playlist->id) == -1)
+        {
+            playlist->init_url = NULL;
+            goto init_err;
+        }
+
+        if (sys->http_host != NULL)
+        {
+            playlist->http_init =
+                httpd_UrlNew(sys->http_host, playlist->init_url, NULL, NULL);
+            if (playlist->http_init == NULL)
+                goto init_err;
+        }
+    }
 
+    vlc_mutex_init(&playlist->lock);
     playlist->manifest = NULL;
+    playlist->delta_manifest = NULL;
+    playlist->http_manifest = NULL;
+    if (UpdatePlaylistManifest(playlist) != VLC_SUCCESS)
+        goto manifest_err;
+
     if (sys->http_host != NULL)
     {
         playlist->http_manifest =
             httpd_UrlNew(sys->http_host, playlist->url, NULL, NULL);
         if (playlist->http_manifest == NULL)
-            goto manifest_err;
-    }
-    else
-        playlist->http_manifest = NULL;
+            goto error;
 
-    if (UpdatePlaylistManifest(playlist) != VLC_SUCCESS)
-        goto error;
+        httpd_UrlCatch(playlist->http_manifest,
+                       HTTPD_MSG_GET,
+                       PlaylistHTTPCallback,
+                       (httpd_callback_sys_t *)playlist);
+    }
 
     vlc_list_init(&playlist->tracks);
 
@@ -797,12 +1582,19 @@ static hls_playlist_t *CreatePlaylist(sout_stream_t *stream,
 
     return playlist;
 error:
-    if (playlist->http_manifest != NULL)
-        httpd_UrlDelete(playlist->http_manifest);
+    hls_storage_Destroy(playlist->manifest);
+    if (playlist->delta_manifest != NULL)
+        hls_storage_Destroy(playlist->delta_manifest);
 manifest_err:
+    if (playlist->http_init != NULL)
+        httpd_UrlDelete(playlist->http_init);
+init_err:
+    free(playlist->init_url);
     hls_segment_queue_Clear(&playlist->segments);
     vlc_LogDestroy(playlist->logger);
 log_err:
+    free(playlist->delta_name);
+delta_err:
     free(playlist->url);
 url_err:
     sout_MuxDelete(playlist->mux);
@@ -815,7 +1607,8 @@ access_err:
 
 static void DeletePlaylist(hls_playlist_t *playlist)
 {
-    sout_MuxDelete(playlist->mux);
+    if (playlist->mux != NULL)
+        sout_MuxDelete(playlist->mux);
 
     sout_AccessOutDelete(playlist->access);
 
@@ -824,13 +1617,23 @@ static void DeletePlaylist(hls_playlist_t *playlist)
 
     if (playlist->manifest != NULL)
         hls_storage_Destroy(playlist->manifest);
+    if (playlist->delta_manifest != NULL)
+        hls_storage_Destroy(playlist->delta_manifest);
+
+    if (playlist->http_init != NULL)
+        httpd_UrlDelete(playlist->http_init);
+    if (playlist->init_segment != NULL)
+        hls_storage_Destroy(playlist->init_segment);
+    free(playlist->init_url);
 
     block_ChainRelease(playlist->muxed_output.begin);
+    block_ChainRelease(playlist->open_segment.begin);
     hls_segment_queue_Clear(&playlist->segments);
 
     vlc_list_remove(&playlist->node);
 
     vlc_LogDestroy(playlist->logger);
+    free(playlist->delta_name);
     free(playlist->url);
 
     free(playlist);
@@ -858,6 +1661,8 @@ Add(sout_stream_t *stream, const es_format_t *fmt, const char *es_id)
         return NULL;
 
     sout_stream_sys_t *sys = stream->p_sys;
+    const enum hls_playlist_type media_type =
+        sys->config.cmaf ? HLS_PLAYLIST_TYPE_CMAF : HLS_PLAYLIST_TYPE_TS;
 
     // Either retrieve the already created playlist from the map or create it.
     struct hls_variant_stream_map *map =
@@ -867,14 +1672,13 @@ Add(sout_stream_t *stream, const es_format_t *fmt, const char *es_id)
     {
         playlist = map->playlist_ref;
         if (playlist == NULL)
-            playlist = AddPlaylist(stream, HLS_PLAYLIST_TYPE_TS, &sys->variant_playlists);
+            playlist = AddPlaylist(stream, media_type, &sys->variant_playlists);
     }
     else if (fmt->i_cat == SPU_ES)
         playlist = AddPlaylist(
             stream, HLS_PLAYLIST_TYPE_WEBVTT, &sys->media_playlists);
     else
-        playlist =
-            AddPlaylist(stream, HLS_PLAYLIST_TYPE_TS, &sys->media_playlists);
+        playlist = AddPlaylist(stream, media_type, &sys->media_playlists);
 
     if (playlist == NULL)
         return NULL;
@@ -941,7 +1745,26 @@ static void Del(sout_stream_t *stream, void *id)
             map->playlist_ref = NULL;
 
         track->playlist_ref->ended = true;
-        ExtractAndAddSegment(track->playlist_ref, sys);
+        if (track->playlist_ref->type == HLS_PLAYLIST_TYPE_CMAF)
+        {
+            /* The last fragment is only written when closing the muxer. */
+            sout_MuxDelete(track->playlist_ref->mux);
+            track->playlist_ref->mux = NULL;
+        }
+        if (IsLowLatency(track->playlist_ref) &&
+            track->playlist_ref->muxed_output.begin != NULL)
+        {
+            /* Publish the paced parts left, then the trailing output as the
+             * last part. */
+            while (IsPartReady(track->playlist_ref))
+                ExtractAndPublishPart(track->playlist_ref, sys);
+            hls_block_chain_t part = track->playlist_ref->muxed_output;
+            hls_block_chain_Reset(&track->playlist_ref->muxed_output);
+            PublishPart(track->playlist_ref, sys, &part);
+        }
+        do
+            ExtractAndAddSegment(track->playlist_ref, sys);
+        while (track->playlist_ref->muxed_output.begin != NULL);
         UpdatePlaylistManifest(track->playlist_ref);
 
         DeletePlaylist(track->playlist_ref);
@@ -965,6 +1788,7 @@ static void SetPCR(sout_stream_t *stream, vlc_tick_t pcr)
     if (sys->first_pcr == VLC_TICK_INVALID)
     {
         sys->first_pcr = pcr;
+        sys->availability_start = time(NULL);
         return;
     }
 
@@ -1011,7 +1835,23 @@ static int InitHTTP(sout_stream_t *stream)
     free(mainfest_url);
     if (sys->http_manifest == NULL)
         goto error;
+
+    sys->http_dash_manifest = NULL;
+    if (sys->config.dash)
+    {
+        if (asprintf(&mainfest_url, "%s/stream.mpd", sys->config.base_url) ==
+            -1)
+            goto dash_error;
+
+        sys->http_dash_manifest =
+            httpd_UrlNew(sys->http_host, mainfest_url, NULL, NULL);
+        free(mainfest_url);
+        if (sys->http_dash_manifest == NULL)
+            goto dash_error;
+    }
     return VLC_SUCCESS;
+dash_error:
+    httpd_UrlDelete(sys->http_manifest);
 error:
     httpd_HostDelete(sys->http_host);
     return VLC_EGENERIC;
@@ -1024,11 +1864,23 @@ static void Close(sout_stream_t *stream)
     if (sys->http_host != NULL)
     {
         httpd_UrlDelete(sys->http_manifest);
+        if (sys->http_dash_manifest != NULL)
+            httpd_UrlDelete(sys->http_dash_manifest);
         httpd_HostDelete(sys->http_host);
     }
 
     if (sys->manifest != NULL)
         hls_storage_Destroy(sys->manifest);
+    if (sys->dash_manifest != NULL)
+        hls_storage_Destroy(sys->dash_manifest);
+
+    struct hls_dash_representation *rep;
+    vlc_vector_foreach_ref (rep, &sys->dash_representations)
+    {
+        free(rep->description);
+        free(rep->timeline);
+    }
+    vlc_vector_destroy(&sys->dash_representations);
 
     hls_config_Clean(&sys->config);
 
@@ -1049,11 +1901,14 @@ static int Open(vlc_object_t *this)
     stream->p_sys = sys;
 
     static const char *const options[] = {"base-url",
+                                          "cmaf",
+                                          "dash",
                                           "host-http",
                                           "max-memory",
                                           "num-seg",
                                           "out-dir",
                                           "pace",
+                                          "part-len",
                                           "seg-len",
                                           "variants",
                                           NULL};
@@ -1067,8 +1922,26 @@ static int Open(vlc_object_t *this)
     sys->config.pace = var_GetBool(stream, SOUT_CFG_PREFIX "pace");
     sys->config.segment_length =
         VLC_TICK_FROM_SEC(var_GetInteger(stream, SOUT_CFG_PREFIX "seg-len"));
+    sys->config.part_length =
+        VLC_TICK_FROM_MS(var_GetInteger(stream, SOUT_CFG_PREFIX "part-len"));
     sys->config.max_memory =
         BYTES_FROM_KB(var_GetInteger(stream, SOUT_CFG_PREFIX "max-memory"));
+    sys->config.cmaf = var_GetBool(stream, SOUT_CFG_PREFIX "cmaf");
+    sys->config.dash = var_GetBool(stream, SOUT_CFG_PREFIX "dash");
+
+    if (sys->config.dash && !sys->config.cmaf)
+    {
+        msg_Warn(stream, "DASH output requires CMAF segments, enabling them");
+        sys->config.cmaf = true;
+    }
+
+    if (sys->config.part_length >= sys->config.segment_length)
+    {
+        msg_Warn(stream,
+                 "Parts must be shorter than segments, Low-Latency HLS is "
+                 "disabled");
+        sys->config.part_length = 0;
+    }
 
     int status = VLC_EINVAL;
 
@@ -1102,6 +1975,7 @@ static int Open(vlc_object_t *this)
     {
         sys->http_host = NULL;
         sys->http_manifest = NULL;
+        sys->http_dash_manifest = NULL;
     }
     else
     {
@@ -1113,6 +1987,9 @@ static int Open(vlc_object_t *this)
     }
 
     sys->manifest = NULL;
+    sys->dash_manifest = NULL;
+    vlc_vector_init(&sys->dash_representations);
+    sys->availability_start = time(NULL);
 
     sys->playlist_created_count = 0;
 
@@ -1153,6 +2030,14 @@ variant_error:
 #define VARIANTS_TEXT                                                          \
     N_("Map that group ES string IDs into variant streams (mandatory)")
 #define BASEURL_TEXT N_("Base of the URL")
+#define CMAF_LONGTEXT                                                          \
+    N_("Package audio and video in fragmented MP4 segments following the "    \
+       "CMAF structure, instead of MPEG-TS segments")
+#define CMAF_TEXT N_("Use CMAF segments")
+#define DASH_LONGTEXT                                                          \
+    N_("Also describe the CMAF segments in a DASH manifest, so that the same " \
+       "segments serve both protocols. This implies CMAF segments")
+#define DASH_TEXT N_("Generate a DASH manifest")
 #define HOSTHTTP_LONGTEXT                                                      \
     N_("The internal HTTP server will share the HLS output. This is "          \
        "unadvised for the common use case where an external HTTP server "      \
@@ -1173,6 +2058,12 @@ variant_error:
 #define PACE_LONGTEXT                                                          \
     N_("Enable input pacing, the media will play at playback rate")
 #define PACE_TEXT N_("Enable pacing")
+#define PARTLEN_LONGTEXT                                                       \
+    N_("Length of Low-Latency HLS parts in milliseconds. Segments are "       \
+       "published in parts of that length as soon as they are muxed, and "    \
+       "playlist requests can be held until the next part is ready. 0 "       \
+       "disables Low-Latency HLS")
+#define PARTLEN_TEXT N_("Part length (ms)")
 #define SEGLEN_LONGTEXT N_("Length of segments in seconds")
 #define SEGLEN_TEXT N_("Segment length (sec)")
 
@@ -1186,11 +2077,15 @@ vlc_module_begin()
     add_string(SOUT_CFG_PREFIX "variants", NULL, VARIANTS_TEXT, VARIANTS_LONGTEXT)
 
     add_string(SOUT_CFG_PREFIX "base-url", "", BASEURL_TEXT, BASEURL_TEXT)
+    add_bool(SOUT_CFG_PREFIX "cmaf", false, CMAF_TEXT, CMAF_LONGTEXT)
+    add_bool(SOUT_CFG_PREFIX "dash", false, DASH_TEXT, DASH_LONGTEXT)
     add_bool(SOUT_CFG_PREFIX "host-http", false, HOSTHTTP_TEXT, HOSTHTTP_LONGTEXT)
     add_integer(SOUT_CFG_PREFIX "max-memory", 20000, MAXMEMORY_TEXT, MAXMEMORY_LONGTEXT)
     add_integer(SOUT_CFG_PREFIX "num-seg", 0, NUMSEG_TEXT, NUMSEG_TEXT)
     add_string(SOUT_CFG_PREFIX "out-dir", NULL, OUTDIR_TEXT, OUTDIR_LONGTEXT)
     add_bool(SOUT_CFG_PREFIX "pace", false, PACE_TEXT, PACE_LONGTEXT)
+    add_integer(SOUT_CFG_PREFIX "part-len", 0, PARTLEN_TEXT, PARTLEN_LONGTEXT)
+        change_integer_range(0, 10000)
     add_integer(SOUT_CFG_PREFIX "seg-len", 4, SEGLEN_TEXT, SEGLEN_LONGTEXT)
 
     set_callback(Open)
@@ -24,6 +24,8 @@ enum hls_playlist_type
 {
     HLS_PLAYLIST_TYPE_TS,
     HLS_PLAYLIST_TYPE_WEBVTT,
+    /** Fragmented MP4 segments, following the CMAF structure. */
+    HLS_PLAYLIST_TYPE_CMAF,
 };
 
 struct hls_config
@@ -33,7 +35,13 @@ struct hls_config
     unsigned int max_segments;
     bool pace;
     vlc_tick_t segment_length;
+    /** Low-Latency HLS part length, or 0 if disabled. */
+    vlc_tick_t part_length;
     size_t max_memory;
+    /** Package audio and video in CMAF segments rather than TS. */
+    bool cmaf;
+    /** Also describe the CMAF segments in a DASH manifest. */
+    bool dash;
 };
 
 #define BYTES_FROM_KB(x) ((x) * 1000)
@@ -45,6 +53,16 @@ static inline void hls_config_Clean(struct hls_config *config)
     free(config->outdir);
 }
 
+/**
+ * Longest time a Low-Latency HLS request is held, three target durations as
+ * in RFC 8216bis section 6.2.5.2.
+ */
+static inline vlc_tick_t
+hls_config_GetHoldTimeout(const struct hls_config *config)
+{
+    return 3 * config->segment_length;
+}
+
 static inline bool
 hls_config_IsMemStorageEnabled(const struct hls_config *config)
 {
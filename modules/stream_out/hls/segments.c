@@ -25,6 +25,8 @@
 
 #include <vlc_common.h>
 
+#include <vlc_atomic.h>
+#include <vlc_block.h>
 #include <vlc_httpd.h>
 #include <vlc_list.h>
 #include <vlc_tick.h>
@@ -42,6 +44,83 @@ static void hls_segment_Destroy(hls_segment_t *segment)
     free(segment);
 }
 
+static void hls_part_Destroy(hls_part_t *part, bool remove)
+{
+    if (part->http_url != NULL)
+        httpd_UrlDelete(part->http_url);
+    struct hls_storage *storage =
+        atomic_load_explicit(&part->storage, memory_order_relaxed);
+    if (storage != NULL && remove)
+        hls_storage_Remove(storage);
+    else if (storage != NULL)
+        hls_storage_Destroy(storage);
+    free(part->url);
+    free(part);
+}
+
+static int hls_part_HTTPCallback(httpd_callback_sys_t *sys,
+                                 httpd_client_t *client,
+                                 httpd_message_t *answer,
+                                 const httpd_message_t *query)
+{
+    hls_part_t *part = (hls_part_t *)sys;
+    struct hls_storage *storage =
+        atomic_load_explicit(&part->storage, memory_order_acquire);
+
+    if (storage == NULL)
+    {
+        /* Preload hint: hold the request until the part is produced. */
+        if (client != NULL)
+            httpd_ClientDefer(client,
+                              hls_config_GetHoldTimeout(part->hls_config));
+        return VLC_SUCCESS;
+    }
+    return part->httpd_callback(
+        (httpd_callback_sys_t *)storage, client, answer, query);
+}
+
+static hls_part_t *hls_part_New(const hls_segment_queue_t *queue,
+                                unsigned int id)
+{
+    hls_part_t *part = malloc(sizeof(*part));
+    if (unlikely(part == NULL))
+        return NULL;
+
+    part->id = id;
+    atomic_init(&part->storage, NULL);
+    part->http_url = NULL;
+    part->httpd_callback = queue->httpd_callback;
+    part->hls_config = queue->hls_config;
+
+    if (asprintf(&part->url,
+                 "%s/playlist-%u-part-%u.%s",
+                 queue->hls_config->base_url,
+                 queue->playlist_id,
+                 id,
+                 queue->file_extension) == -1)
+    {
+        free(part);
+        return NULL;
+    }
+
+    if (queue->httpd_ref != NULL)
+    {
+        part->http_url =
+            httpd_UrlNew(queue->httpd_ref, part->url, NULL, NULL);
+        if (part->http_url == NULL)
+        {
+            hls_part_Destroy(part, false);
+            return NULL;
+        }
+
+        httpd_UrlCatch(part->http_url,
+                       HTTPD_MSG_GET,
+                       hls_part_HTTPCallback,
+                       (httpd_callback_sys_t *)part);
+    }
+    return part;
+}
+
 static const char *
 hls_segment_queue_GetFileExtension(enum hls_playlist_type type)
 {
@@ -51,6 +130,24 @@ hls_segment_queue_GetFileExtension(enum hls_playlist_type type)
             return "ts";
         case HLS_PLAYLIST_TYPE_WEBVTT:
             return "vtt";
+        case HLS_PLAYLIST_TYPE_CMAF:
+            return "m4s";
+        default:
+            vlc_assert_unreachable();
+    }
+}
+
+static const char *
+hls_segment_queue_GetMimeType(enum hls_playlist_type type)
+{
+    switch (type)
+    {
+        case HLS_PLAYLIST_TYPE_TS:
+            return "video/MP2T";
+        case HLS_PLAYLIST_TYPE_WEBVTT:
+            return "text/vtt";
+        case HLS_PLAYLIST_TYPE_CMAF:
+            return "video/mp4";
         default:
             vlc_assert_unreachable();
     }
@@ -68,14 +165,26 @@ void hls_segment_queue_Init(hls_segment_queue_t *queue,
 
     queue->file_extension =
         hls_segment_queue_GetFileExtension(config->playlist_type);
+    queue->mime = hls_segment_queue_GetMimeType(config->playlist_type);
 
     queue->hls_config = hls_config;
 
     vlc_list_init(&queue->segments);
+
+    queue->total_parts = 0;
+    queue->open_parts = 0;
+    vlc_list_init(&queue->parts);
+    queue->next_part = NULL;
 }
 
 void hls_segment_queue_Clear(hls_segment_queue_t *queue)
 {
+    hls_part_t *part;
+    vlc_list_foreach (part, &queue->parts, priv_node)
+        hls_part_Destroy(part, false);
+    if (queue->next_part != NULL)
+        hls_part_Destroy(queue->next_part, false);
+
     hls_segment_t *it;
     hls_segment_queue_Foreach(queue, it) { hls_segment_Destroy(it); }
 }
@@ -104,7 +213,7 @@ int hls_segment_queue_NewSegment(hls_segment_queue_t *queue,
 
     const struct hls_storage_config storage_conf = {
         .name = segment->url + strlen(queue->hls_config->base_url) + 1,
-        .mime = "video/MP2T",
+        .mime = queue->mime,
     };
     segment->storage =
         hls_storage_FromBlocks(content, &storage_conf, queue->hls_config);
@@ -136,6 +245,18 @@ int hls_segment_queue_NewSegment(hls_segment_queue_t *queue,
 
     ++queue->total_segments;
     vlc_list_append(&segment->priv_node, &queue->segments);
+
+    /* Only keep the parts of the last two complete segments, the older
+     * ones are no longer listed. */
+    queue->open_parts = 0;
+    hls_part_t *part;
+    vlc_list_foreach (part, &queue->parts, priv_node)
+    {
+        if (part->segment_id + 2 >= queue->total_segments)
+            break;
+        vlc_list_remove(&part->priv_node);
+        hls_part_Destroy(part, true);
+    }
     return VLC_SUCCESS;
 nomem:
     if (segment->storage != NULL)
@@ -144,3 +265,50 @@ nomem:
     free(segment);
     return VLC_ENOMEM;
 }
+
+int hls_segment_queue_NewPart(hls_segment_queue_t *queue,
+                              block_t *content,
+                              vlc_tick_t length,
+                              bool independent)
+{
+    hls_part_t *part = queue->next_part;
+    queue->next_part = NULL;
+    if (part == NULL)
+    {
+        part = hls_part_New(queue, queue->total_parts);
+        if (unlikely(part == NULL))
+        {
+            block_ChainRelease(content);
+            return VLC_ENOMEM;
+        }
+    }
+
+    const struct hls_storage_config storage_conf = {
+        .name = part->url + strlen(queue->hls_config->base_url) + 1,
+        .mime = queue->mime,
+    };
+    struct hls_storage *storage =
+        hls_storage_FromBlocks(content, &storage_conf, queue->hls_config);
+    if (unlikely(storage == NULL))
+    {
+        hls_part_Destroy(part, false);
+        return VLC_ENOMEM;
+    }
+
+    part->segment_id = queue->total_segments;
+    part->length = length;
+    part->independent = independent;
+    /* Publish to the HTTP requests possibly held on the preload hint. */
+    atomic_store_explicit(&part->storage, storage, memory_order_release);
+    if (part->http_url != NULL)
+        httpd_UrlWakeUp(part->http_url);
+
+    ++queue->total_parts;
+    ++queue->open_parts;
+    vlc_list_append(&part->priv_node, &queue->parts);
+
+    /* Failing here only loses the preload hint. */
+    if (queue->httpd_ref != NULL)
+        queue->next_part = hls_part_New(queue, queue->total_parts);
+    return VLC_SUCCESS;
+}
@@ -36,6 +36,31 @@ typedef struct hls_segment
     struct vlc_list priv_node;
 } hls_segment_t;
 
+/**
+ * Partial segment, as in the Low-Latency HLS extension.
+ *
+ * The next part of a queue is announced as a preload hint and reachable
+ * before it is produced: its storage is NULL until then.
+ */
+typedef struct hls_part
+{
+    char *url;
+    /** Part sequence number, over the whole playlist. */
+    unsigned int id;
+    /** Media sequence number of the parent segment. */
+    unsigned int segment_id;
+    vlc_tick_t length;
+    bool independent;
+
+    _Atomic(struct hls_storage *) storage;
+
+    httpd_url_t *http_url;
+    httpd_callback_t httpd_callback;
+    const struct hls_config *hls_config;
+
+    struct vlc_list priv_node;
+} hls_part_t;
+
 struct hls_segment_queue_config
 {
     unsigned int playlist_id;
@@ -54,10 +79,19 @@ typedef struct
     httpd_callback_t httpd_callback;
 
     const char *file_extension;
+    const char *mime;
 
     const struct hls_config *hls_config;
 
     struct vlc_list segments;
+
+    unsigned int total_parts;
+    /** Parts of the segment being produced. */
+    unsigned int open_parts;
+    /** Parts of the last complete segments and of the open one. */
+    struct vlc_list parts;
+    /** Upcoming part, or NULL. */
+    hls_part_t *next_part;
 } hls_segment_queue_t;
 
 #define hls_segment_queue_Foreach(queue, it)                                   \
@@ -66,6 +100,8 @@ typedef struct
     vlc_list_foreach_const (it, &(queue)->segments, priv_node)
 #define hls_segment_GetFirst(queue)                                            \
     vlc_list_first_entry_or_null(&(queue)->segments, hls_segment_t, priv_node);
+#define hls_part_queue_Foreach_const(queue, it)                                \
+    vlc_list_foreach_const (it, &(queue)->parts, priv_node)
 
 void hls_segment_queue_Init(hls_segment_queue_t *,
                             const struct hls_segment_queue_config *,
@@ -88,6 +124,25 @@ int hls_segment_queue_NewSegment(hls_segment_queue_t *,
                                  block_t *content,
                                  vlc_tick_t length);
 
+/**
+ * Add a new part to the segment being produced.
+ *
+ * Parts of segments older than the last two complete ones are destroyed.
+ * When the queue is served over HTTP, the next part is also registered
+ * ahead, so that requests for it are held until it gets produced.
+ *
+ * \param content A block containing the part's data.
+ * \param length The media time size of the part.
+ * \param independent Whether the part starts with a synchronization point.
+ *
+ * \retval VLC_SUCCESS on success.
+ * \retval VLC_ENOMEM on internal allocation failure.
+ */
+int hls_segment_queue_NewPart(hls_segment_queue_t *,
+                              block_t *content,
+                              vlc_tick_t length,
+                              bool independent);
+
 static inline bool
 hls_segment_queue_IsAtMaxCapacity(const hls_segment_queue_t *queue)
 {
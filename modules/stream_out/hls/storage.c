@@ -28,6 +28,7 @@
 
 #include <vlc_common.h>
 
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
 
@@ -39,6 +40,7 @@ struct storage_priv
     hls_storage_t storage;
     void (*destroy)(struct storage_priv *storage);
     size_t size;
+    vlc_atomic_rc_t rc;
 
     union
     {
@@ -50,33 +52,70 @@ struct storage_priv
         struct
         {
             char *path;
+            vlc_mutex_t lock;
+            block_t *mapping;
         } fs;
     };
 };
 
-static void mem_storage_Destroy(struct storage_priv *priv)
+/**
+ * Read-only block referencing a storage block payload.
+ */
+struct storage_view
 {
-    block_ChainRelease(priv->mem.content);
-    free(priv);
+    block_t self;
+    struct storage_priv *owner;
+};
+
+static void storage_Release(struct storage_priv *priv)
+{
+    if (vlc_atomic_rc_dec(&priv->rc))
+        priv->destroy(priv);
 }
 
-static ssize_t mem_storage_GetContent(const hls_storage_t *storage,
-                                      uint8_t **dest)
+static void storage_view_Release(block_t *block)
 {
-    const struct storage_priv *priv =
-        container_of(storage, struct storage_priv, storage);
+    struct storage_view *view = container_of(block, struct storage_view, self);
+    storage_Release(view->owner);
+    free(view);
+}
 
-    *dest = malloc(priv->size);
-    if (unlikely(*dest == NULL))
-        return -1;
+static const struct vlc_frame_callbacks storage_view_cbs = {
+    storage_view_Release,
+};
 
-    uint8_t *cursor = *dest;
-    for (const block_t *it = priv->mem.content; it != NULL; it = it->p_next)
+static block_t *storage_CreateViews(struct storage_priv *priv,
+                                    const block_t *content)
+{
+    block_t *views = NULL;
+    block_t **last = &views;
+    for (const block_t *it = content; it != NULL; it = it->p_next)
     {
-        memcpy(cursor, it->p_buffer, it->i_buffer);
-        cursor += it->i_buffer;
+        struct storage_view *view = malloc(sizeof(*view));
+        if (unlikely(view == NULL))
+        {
+            block_ChainRelease(views);
+            return NULL;
+        }
+        block_Init(&view->self, &storage_view_cbs, it->p_buffer, it->i_buffer);
+        view->owner = priv;
+        vlc_atomic_rc_inc(&priv->rc);
+        block_ChainLastAppend(&last, &view->self);
     }
-    return priv->size;
+    return views;
+}
+
+static void mem_storage_Destroy(struct storage_priv *priv)
+{
+    block_ChainRelease(priv->mem.content);
+    free(priv);
+}
+
+static block_t *mem_storage_GetContent(hls_storage_t *storage)
+{
+    struct storage_priv *priv =
+        container_of(storage, struct storage_priv, storage);
+    return storage_CreateViews(priv, priv->mem.content);
 }
 
 static hls_storage_t *mem_storage_FromBlock(block_t *content)
@@ -87,6 +126,7 @@ static hls_storage_t *mem_storage_FromBlock(block_t *content)
 
     priv->storage.get_content = mem_storage_GetContent;
     priv->destroy = mem_storage_Destroy;
+    vlc_atomic_rc_init(&priv->rc);
     priv->mem.content = content;
     block_ChainProperties(content, NULL, &priv->size, NULL);
     return &priv->storage;
@@ -107,56 +147,26 @@ static hls_storage_t *mem_storage_FromBytes(void *bytes, size_t size)
 
     priv->storage.get_content = mem_storage_GetContent;
     priv->destroy = mem_storage_Destroy;
+    vlc_atomic_rc_init(&priv->rc);
     priv->size = size;
     priv->mem.content = content;
     return &priv->storage;
 }
 
-static ssize_t fs_storage_Read(int fd, uint8_t buf[], size_t len)
-{
-    size_t total = 0;
-    while (total < len)
-    {
-        const ssize_t n = read(fd, buf + total, len - total);
-        if (n == -1)
-        {
-            if (errno == EINTR || errno == EAGAIN)
-                continue;
-            return -1;
-        }
-        else if (n == 0)
-            break;
-
-        total += n;
-    }
-    return total;
-}
-
-static ssize_t fs_storage_GetContent(const hls_storage_t *storage,
-                                     uint8_t **dest)
+static block_t *fs_storage_GetContent(hls_storage_t *storage)
 {
-    const struct storage_priv *priv =
+    struct storage_priv *priv =
         container_of(storage, struct storage_priv, storage);
 
-    const int fd = vlc_open(priv->fs.path, O_RDONLY);
-
-    if (fd == -1)
-        return -1;
-
-    *dest = malloc(priv->size);
-    if (unlikely(*dest == NULL))
-        goto err;
-
-    const ssize_t read = fs_storage_Read(fd, *dest, priv->size);
-    if (read == -1)
-        goto err;
-
-    close(fd);
-    return read;
-err:
-    free(dest);
-    close(fd);
-    return -1;
+    /* The file is mapped once, then shared by all the readers. */
+    vlc_mutex_lock(&priv->fs.lock);
+    if (priv->fs.mapping == NULL)
+        priv->fs.mapping = block_FilePath(priv->fs.path, false);
+    block_t *views = NULL;
+    if (priv->fs.mapping != NULL)
+        views = storage_CreateViews(priv, priv->fs.mapping);
+    vlc_mutex_unlock(&priv->fs.lock);
+    return views;
 }
 
 static int fs_storage_Write(int fd, const uint8_t *data, size_t len)
@@ -179,10 +189,47 @@ static int fs_storage_Write(int fd, const uint8_t *data, size_t len)
 
 static void fs_storage_Destroy(struct storage_priv *priv)
 {
+    if (priv->fs.mapping != NULL)
+        block_Release(priv->fs.mapping);
     free(priv->fs.path);
     free(priv);
 }
 
+static void fs_storage_Init(struct storage_priv *priv, size_t size)
+{
+    priv->storage.get_content = fs_storage_GetContent;
+    priv->size = size;
+    priv->destroy = fs_storage_Destroy;
+    vlc_atomic_rc_init(&priv->rc);
+    vlc_mutex_init(&priv->fs.lock);
+    priv->fs.mapping = NULL;
+}
+
+/* Files are written aside then renamed over the previous version, so that
+ * a mapping of the previous version is never truncated under its readers. */
+static int fs_storage_Open(const char *path, char **tmp_path)
+{
+    if (asprintf(tmp_path, "%s.tmp", path) == -1)
+        return -1;
+
+    const int fd = vlc_open(*tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1)
+        free(*tmp_path);
+    return fd;
+}
+
+static int fs_storage_Commit(int fd, char *tmp_path, const char *path,
+                             int status)
+{
+    close(fd);
+    if (status == VLC_SUCCESS && vlc_rename(tmp_path, path) != 0)
+        status = VLC_EGENERIC;
+    if (status != VLC_SUCCESS)
+        vlc_unlink(tmp_path);
+    free(tmp_path);
+    return status;
+}
+
 static inline char *fs_storage_CreatePath(const char *outdir,
                                           const char *storage_name)
 {
@@ -206,29 +253,26 @@ fs_storage_FromBlock(block_t *content,
     if (unlikely(priv->fs.path == NULL))
         goto err;
 
-    const int fd = vlc_open(priv->fs.path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    char *tmp_path;
+    const int fd = fs_storage_Open(priv->fs.path, &tmp_path);
     if (fd == -1)
         goto err;
 
     size_t size = 0;
+    int status = VLC_SUCCESS;
     for (const block_t *it = content; it != NULL; it = it->p_next)
     {
-        const int status = fs_storage_Write(fd, it->p_buffer, it->i_buffer);
+        status = fs_storage_Write(fd, it->p_buffer, it->i_buffer);
         if (status != VLC_SUCCESS)
-        {
-            close(fd);
-            goto err;
-        }
+            break;
         size += it->i_buffer;
     }
 
-    close(fd);
+    if (fs_storage_Commit(fd, tmp_path, priv->fs.path, status) != VLC_SUCCESS)
+        goto err;
     block_ChainRelease(content);
 
-    priv->storage.get_content = fs_storage_GetContent;
-    priv->size = size;
-    priv->destroy = fs_storage_Destroy;
-
+    fs_storage_Init(priv, size);
     return &priv->storage;
 err:
     block_ChainRelease(content);
@@ -252,19 +296,16 @@ fs_storage_FromBytes(void *bytes,
     if (unlikely(priv->fs.path == NULL))
         goto err;
 
-    const int fd = vlc_open(priv->fs.path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    char *tmp_path;
+    const int fd = fs_storage_Open(priv->fs.path, &tmp_path);
     if (fd == -1)
         goto err;
 
     const int status = fs_storage_Write(fd, bytes, size);
-    close(fd);
-
-    if (unlikely(status != VLC_SUCCESS))
+    if (fs_storage_Commit(fd, tmp_path, priv->fs.path, status) != VLC_SUCCESS)
         goto err;
 
-    priv->storage.get_content = fs_storage_GetContent;
-    priv->size = size;
-    priv->destroy = fs_storage_Destroy;
+    fs_storage_Init(priv, size);
 
     free(bytes);
     return &priv->storage;
@@ -318,5 +359,14 @@ void hls_storage_Destroy(hls_storage_t *storage)
 {
     struct storage_priv *priv =
         container_of(storage, struct storage_priv, storage);
-    priv->destroy(priv);
+    storage_Release(priv);
+}
+
+void hls_storage_Remove(hls_storage_t *storage)
+{
+    struct storage_priv *priv =
+        container_of(storage, struct storage_priv, storage);
+    if (priv->destroy == fs_storage_Destroy)
+        vlc_unlink(priv->fs.path);
+    storage_Release(priv);
 }
@@ -35,13 +35,16 @@ typedef struct hls_storage
 {
     const char *mime;
     /**
-     * Get a copy of the whole storage content.
+     * Get a view of the whole storage content.
      *
-     * \param[out] dest Pointer on a byte buffer, will be freshly allocated by
-     * the function call. \return Byte count of the byte buffer. \retval -1 On
-     * allocation error.
+     * The returned blocks point to the storage memory, or to a mapping of
+     * the storage file, and keep the storage alive until they are released:
+     * the content is never copied, whatever the number of readers.
+     *
+     * \return A block chain to release with \ref block_ChainRelease.
+     * \retval NULL On error.
      */
-    ssize_t (*get_content)(const struct hls_storage *, uint8_t **dest);
+    block_t *(*get_content)(struct hls_storage *);
 } hls_storage_t;
 
 /**
@@ -80,6 +83,19 @@ hls_storage_t *hls_storage_FromBytes(void *data,
 
 size_t hls_storage_GetSize(const hls_storage_t *);
 
+/**
+ * Release the storage.
+ *
+ * \note The content is actually freed once the views obtained with
+ * hls_storage_t::get_content are released as well.
+ */
 void hls_storage_Destroy(hls_storage_t *);
 
+/**
+ * Release the storage and remove its file, if any.
+ *
+ * \note Views obtained with hls_storage_t::get_content remain readable.
+ */
+void hls_storage_Remove(hls_storage_t *);
+
 #endif
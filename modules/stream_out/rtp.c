@@ -1345,10 +1345,6 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
-    vlc_thread_set_name("vlc-rt-send");
-
 #ifdef _WIN32
 # undef ENOBUFS
 # define ENOBUFS      WSAENOBUFS
@@ -1357,6 +1353,87 @@ static void* ThreadSend( void *data )
 # undef EWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+#ifdef HAVE_SENDMMSG
+/* Packets due at the same time sent with a single system call */
+# define RTP_SEND_BATCH 32
+#else
+# define RTP_SEND_BATCH 1
+#endif
+
+static inline bool rtp_send_error_is_transient( int err )
+{
+    return err == EAGAIN || err == EWOULDBLOCK
+        || err == ENOBUFS || err == ENOMEM;
+}
+
+/* Sends packets to a sink. Transient errors drop the packet.
+ * Returns the number of packets processed before a hard error. */
+static unsigned rtp_send_sink( int fd, block_t *const *outv, unsigned outc )
+{
+    unsigned i = 0;
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgv[RTP_SEND_BATCH];
+    struct iovec iov[RTP_SEND_BATCH];
+
+    assert( outc <= RTP_SEND_BATCH );
+    for( unsigned j = 0; j < outc; j++ )
+    {
+        iov[j].iov_base = outv[j]->p_buffer;
+        iov[j].iov_len = outv[j]->i_buffer;
+        memset( &msgv[j], 0, sizeof (msgv[j]) );
+        msgv[j].msg_hdr.msg_iov = &iov[j];
+        msgv[j].msg_hdr.msg_iovlen = 1;
+    }
+
+    while( i < outc )
+    {
+        int val = sendmmsg( fd, &msgv[i], outc - i, 0 );
+        if( val < 0 )
+        {
+            if( !rtp_send_error_is_transient( net_errno ) )
+                break;
+            i++;
+        }
+        else
+            i += val;
+    }
+#else
+    for( ; i < outc; i++ )
+        if( send( fd, outv[i]->p_buffer, outv[i]->i_buffer, 0 ) == -1
+         && !rtp_send_error_is_transient( net_errno ) )
+            break;
+#endif
+    return i;
+}
+
+#ifdef HAVE_SRTP
+static block_t *rtp_protect( sout_stream_id_sys_t *id, block_t *out )
+{
+    /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + 10 );
+    if( out == NULL )
+        return NULL;
+    out->i_buffer = len;
+
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+static void* ThreadSend( void *data )
+{
+    vlc_thread_set_name("vlc-rt-send");
+
     sout_stream_id_sys_t *id = data;
     vlc_tick_t i_caching = id->i_caching;
     block_t *out;
@@ -1364,26 +1441,35 @@ static void* ThreadSend( void *data )
     while ((out = vlc_queue_DequeueKillable(&id->queue, &id->dead)) != NULL)
     {
 #ifdef HAVE_SRTP
-        if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            if( val )
-            {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                continue;
-            }
-            out->i_buffer = len;
-        }
+        if( id->srtp && (out = rtp_protect( id, out )) == NULL )
+            continue;
 #endif
         vlc_tick_wait (out->i_dts + i_caching);
 
-        ssize_t len = out->i_buffer;
+        /* Take along the packets which are due by now as well */
+        block_t *outv[RTP_SEND_BATCH];
+        unsigned outc = 0;
+
+        outv[outc++] = out;
+        if( RTP_SEND_BATCH > 1 )
+        {
+            const vlc_tick_t now = vlc_tick_now();
+
+            vlc_queue_Lock( &id->queue );
+            while( outc < RTP_SEND_BATCH )
+            {
+                const block_t *next = (const block_t *)id->queue.first;
+                if( next == NULL || next->i_dts + i_caching > now )
+                    break;
+                out = vlc_queue_DequeueUnlocked( &id->queue );
+#ifdef HAVE_SRTP
+                if( id->srtp && (out = rtp_protect( id, out )) == NULL )
+                    continue;
+#endif
+                outv[outc++] = out;
+            }
+            vlc_queue_Unlock( &id->queue );
+        }
 
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
@@ -1394,26 +1480,28 @@ static void* ThreadSend( void *data )
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = 0; j < outc; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, outv[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
+            unsigned sent = rtp_send_sink( id->sinkv[i].rtp_fd, outv, outc );
+            if( sent < outc )
             {
                 int type;
                 getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
                             &type, &(socklen_t){ sizeof(type) });
                 if( type == SOCK_DGRAM )
                     /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
+                    rtp_send_sink( id->sinkv[i].rtp_fd, &outv[sent],
+                                   outc - sent );
                 else
                     /* Broken connection */
                     deadv[deadc++] = id->sinkv[i].rtp_fd;
             }
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        id->i_seq_sent_next = ntohs(((uint16_t *) outv[outc - 1]->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+        for( unsigned j = 0; j < outc; j++ )
+            block_Release( outv[j] );
 
         for( unsigned i = 0; i < deadc; i++ )
         {
@@ -144,39 +144,85 @@ static int Control(sout_stream_t *stream, int query, va_list args)
     return VLC_SUCCESS;
 }
 
+#ifdef HAVE_SENDMMSG
+/* Datagrams sent per system call */
+# define VLEN 64
+#else
+# define VLEN 1
+#endif
+
 static ssize_t AccessOutWrite(sout_access_out_t *access, block_t *block)
 {
     struct sout_stream_udp *sys = access->p_sys;
     ssize_t total = 0;
 
     while (block != NULL) {
-        struct iovec iov[16];
+        struct iovec iov[16 * VLEN];
         block_t *unsent = block;
         unsigned iovlen = 0;
-        size_t tosend = 0;
+#ifdef HAVE_SENDMMSG
+        struct mmsghdr msgv[VLEN];
+#else
+        struct msghdr msgv[VLEN];
+#endif
+        unsigned msgc = 0;
 
-        /* Count how many blocks to gather */
+        /* Gather the blocks into as many datagrams as can be sent at once */
         do {
-            if (iovlen >= ARRAY_SIZE(iov))
-                break;
-            if (unsent->i_buffer + tosend > sys->mtu && likely(iovlen > 0))
-                break;
-
-            iov[iovlen].iov_base = unsent->p_buffer;
-            iov[iovlen].iov_len = unsent->i_buffer;
-            iovlen++;
-            tosend += unsent->i_buffer;
-            unsent = unsent->p_next;
-        } while (unsent != NULL);
+            struct msghdr *hdr;
+            size_t tosend = 0;
+
+#ifdef HAVE_SENDMMSG
+            hdr = &msgv[msgc].msg_hdr;
+#else
+            hdr = &msgv[msgc];
+#endif
+            memset(hdr, 0, sizeof (*hdr));
+            hdr->msg_iov = &iov[iovlen];
+
+            /* Count how many blocks to gather */
+            do {
+                if (hdr->msg_iovlen >= 16)
+                    break;
+                if (unsent->i_buffer + tosend > sys->mtu
+                 && likely(hdr->msg_iovlen > 0))
+                    break;
+
+                iov[iovlen].iov_base = unsent->p_buffer;
+                iov[iovlen].iov_len = unsent->i_buffer;
+                iovlen++;
+                hdr->msg_iovlen++;
+                tosend += unsent->i_buffer;
+                unsent = unsent->p_next;
+            } while (unsent != NULL);
+
+            msgc++;
+        } while (unsent != NULL && msgc < VLEN);
 
         /* Send */
-        struct msghdr hdr = { .msg_iov = iov, .msg_iovlen = iovlen };
-        ssize_t val = sendmsg(sys->fd, &hdr, 0);
+#ifdef HAVE_SENDMMSG
+        for (unsigned i = 0; i < msgc;) {
+            int val = sendmmsg(sys->fd, &msgv[i], msgc - i, 0);
+
+            if (val < 0) {
+                /* Drop the failing datagram, carry on with the next ones */
+                msg_Err(access, "send error: %s", vlc_strerror_c(errno));
+                i++;
+                continue;
+            }
+
+            for (int j = 0; j < val; j++)
+                total += msgv[i + j].msg_len;
+            i += val;
+        }
+#else
+        ssize_t val = sendmsg(sys->fd, &msgv[0], 0);
 
         if (val < 0)
             msg_Err(access, "send error: %s", vlc_strerror_c(errno));
         else
             total += val;
+#endif
 
         /* Free */
         do {
@@ -871,8 +871,12 @@ int vlc_aout_stream_Play(vlc_aout_stream *stream, block_t *block)
 {
     aout_owner_t *owner = aout_stream_owner(stream);
     audio_output_t *aout = aout_stream_aout(stream);
+    struct vlc_tracer *tracer = aout_stream_tracer(stream);
 
     assert (block->i_pts != VLC_TICK_INVALID);
+    /* Filters may shift the timestamps, frames are traced by their decoded
+     * pts so that all their stages match */
+    const vlc_tick_t trace_pts = block->i_pts;
 
     block->i_length = vlc_tick_from_samples( block->i_nb_samples,
                                    stream->input_format.i_rate );
@@ -912,6 +916,9 @@ int vlc_aout_stream_Play(vlc_aout_stream *stream, block_t *block)
             return ret;
         assert (block->i_pts != VLC_TICK_INVALID);
 
+        if (tracer != NULL)
+            vlc_tracer_TraceFrame(tracer, stream->str_id, "filter", trace_pts);
+
         /* Re-trigger a clock convert if the filtered ts is different */
         if (prefilter_pts != block->i_pts)
             play_date = VLC_TICK_INVALID;
@@ -951,6 +958,9 @@ int vlc_aout_stream_Play(vlc_aout_stream *stream, block_t *block)
 
     vlc_audio_meter_Process(&owner->meter, block, play_date);
 
+    if (tracer != NULL)
+        vlc_tracer_TraceFrame(tracer, stream->str_id, "play", trace_pts);
+
     /* Output */
     stream->sync.played = true;
     stream->timing.played_samples += block->i_nb_samples;
@@ -959,6 +969,8 @@ int vlc_aout_stream_Play(vlc_aout_stream *stream, block_t *block)
     atomic_fetch_add_explicit(&stream->buffers_played, 1, memory_order_relaxed);
     return ret;
 drop:
+    if (tracer != NULL)
+        vlc_tracer_TraceFrame(tracer, stream->str_id, "drop", trace_pts);
     stream_ResetTimings(stream);
     block_Release (block);
     atomic_fetch_add_explicit(&stream->buffers_lost, 1, memory_order_relaxed);
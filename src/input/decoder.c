@@ -203,6 +203,10 @@ struct vlc_input_decoder_t
     unsigned frames_countdown;
     bool paused, output_paused;
 
+    /* Keyframes only */
+    bool keyframes_only;
+    bool wait_keyframe;
+
     bool error;
 
     /* Waiting */
@@ -1321,6 +1325,13 @@ static void ModuleThread_QueueCc( decoder_t *p_videodec, vlc_frame_t *p_cc,
     vlc_fifo_Unlock(p_owner->p_fifo);
 }
 
+static void DecoderTraceDrop( vlc_input_decoder_t *p_owner, vlc_tick_t pts )
+{
+    struct vlc_tracer *tracer = vlc_object_get_tracer( &p_owner->dec.obj );
+    if( tracer != NULL )
+        vlc_tracer_TraceFrame( tracer, p_owner->psz_id, "drop", pts );
+}
+
 static int ModuleThread_PlayVideo( vlc_input_decoder_t *p_owner, picture_t *p_picture )
 {
     decoder_t *p_dec = &p_owner->dec;
@@ -1346,6 +1357,7 @@ static int ModuleThread_PlayVideo( vlc_input_decoder_t *p_owner, picture_t *p_pi
     bool prerolled = p_owner->i_preroll_end != PREROLL_NONE;
     if( prerolled && p_owner->i_preroll_end > p_picture->date )
     {
+        DecoderTraceDrop( p_owner, p_picture->date );
         picture_Release( p_picture );
         return VLC_SUCCESS;
     }
@@ -1407,6 +1419,8 @@ static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
     {
         vlc_tracer_TraceStreamPTS( tracer, "DEC", p_owner->psz_id,
                             "OUT", p_pic->date );
+        vlc_tracer_TraceFrame( tracer, p_owner->psz_id, "decode_out",
+                               p_pic->date );
     }
 
     vlc_fifo_Lock( p_owner->p_fifo );
@@ -1458,8 +1472,10 @@ static void ModuleThread_QueueThumbnail( decoder_t *p_dec, picture_t *p_pic )
     bool b_first;
 
     vlc_fifo_Lock(p_owner->p_fifo);
-    b_first = p_owner->b_first;
-    p_owner->b_first = false;
+    /* A picture decoded before a flush belongs to the previous position */
+    b_first = p_owner->b_first && !p_owner->flushing;
+    if( b_first )
+        p_owner->b_first = false;
     vlc_fifo_Unlock(p_owner->p_fifo);
 
     if( b_first )
@@ -1468,6 +1484,12 @@ static void ModuleThread_QueueThumbnail( decoder_t *p_dec, picture_t *p_pic )
 
 }
 
+static bool DecoderIsThumbnailer( const vlc_input_decoder_t *p_owner )
+{
+    return p_owner->dec.fmt_in->i_cat == VIDEO_ES
+        && p_owner->dec.cbs->video.queue == ModuleThread_QueueThumbnail;
+}
+
 static int ModuleThread_PlayAudio( vlc_input_decoder_t *p_owner, vlc_frame_t *p_audio )
 {
     decoder_t *p_dec = &p_owner->dec;
@@ -1498,6 +1520,7 @@ static int ModuleThread_PlayAudio( vlc_input_decoder_t *p_owner, vlc_frame_t *p_
     bool prerolled = p_owner->i_preroll_end != PREROLL_NONE;
     if( prerolled && p_owner->i_preroll_end > p_audio->i_pts )
     {
+        DecoderTraceDrop( p_owner, p_audio->i_pts );
         block_Release( p_audio );
         return VLC_SUCCESS;
     }
@@ -1544,6 +1567,8 @@ static void ModuleThread_QueueAudio( decoder_t *p_dec, vlc_frame_t *p_aout_buf )
     {
         vlc_tracer_TraceStreamDTS( tracer, "DEC", p_owner->psz_id, "OUT",
                             p_aout_buf->i_pts, p_aout_buf->i_dts );
+        vlc_tracer_TraceFrame( tracer, p_owner->psz_id, "decode_out",
+                               p_aout_buf->i_pts );
     }
 
     vlc_fifo_Lock(p_owner->p_fifo);
@@ -1627,6 +1652,8 @@ static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, vlc_frame_t
     {
         vlc_tracer_TraceStreamDTS( tracer, "DEC", p_owner->psz_id, "IN",
                             frame->i_pts, frame->i_dts );
+        vlc_tracer_TraceFrame( tracer, p_owner->psz_id, "decode_in",
+                               frame->i_pts );
     }
 
     int ret = p_dec->pf_decode( p_dec, frame );
@@ -1656,6 +1683,36 @@ static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, vlc_frame_t
     }
 }
 
+/**
+ * Tell whether a packetized frame can be dropped before being decoded
+ *
+ * Only frames flagged by the packetizer or the demuxer as predicted are
+ * dropped in keyframes only mode, frames of unknown type are kept.
+ */
+static bool DecoderThread_SkipFrame( vlc_input_decoder_t *p_owner,
+                                     const vlc_frame_t *frame )
+{
+    vlc_fifo_Assert( p_owner->p_fifo );
+
+    /* A thumbnailer has nothing more to output until the next seek. Before
+     * that, every frame is kept: reordering decoders may need the following
+     * ones to output the first picture. */
+    if( DecoderIsThumbnailer( p_owner ) && !p_owner->b_first )
+        return true;
+
+    if( frame->i_flags & BLOCK_FLAG_TYPE_I )
+    {
+        p_owner->wait_keyframe = false;
+        return false;
+    }
+
+    if( !(frame->i_flags & (BLOCK_FLAG_TYPE_P | BLOCK_FLAG_TYPE_B |
+                            BLOCK_FLAG_TYPE_PB)) )
+        return false;
+
+    return p_owner->keyframes_only || p_owner->wait_keyframe;
+}
+
 /**
  * Decode a frame
  *
@@ -1739,7 +1796,13 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
                 vlc_frame_t *p_next = packetized_frame->p_next;
                 packetized_frame->p_next = NULL;
 
-                DecoderThread_DecodeBlock( p_owner, packetized_frame );
+                if( DecoderThread_SkipFrame( p_owner, packetized_frame ) )
+                {
+                    DecoderTraceDrop( p_owner, packetized_frame->i_pts );
+                    block_Release( packetized_frame );
+                }
+                else
+                    DecoderThread_DecodeBlock( p_owner, packetized_frame );
 
                 if( p_owner->error )
                 {
@@ -1754,6 +1817,11 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
         if( !ppframe )
             DecoderThread_DecodeBlock( p_owner, NULL );
     }
+    else if( frame != NULL && DecoderThread_SkipFrame( p_owner, frame ) )
+    {
+        DecoderTraceDrop( p_owner, frame->i_pts );
+        block_Release( frame );
+    }
     else
         DecoderThread_DecodeBlock( p_owner, frame );
     return;
@@ -1820,6 +1888,11 @@ static void *DecoderThread( void *p_data )
             p_owner->flushing = false;
             p_owner->out_started = false;
             p_owner->i_preroll_end = PREROLL_NONE;
+            /* Thumbnailers output the first picture after each seek, even if
+             * the seek happens while the ES output is still buffering */
+            if( DecoderIsThumbnailer( p_owner ) )
+                p_owner->b_first = true;
+            p_owner->wait_keyframe = false;
             continue;
         }
 
@@ -1979,6 +2052,9 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
     p_owner->pause_date = VLC_TICK_INVALID;
     p_owner->frames_countdown = 0;
 
+    p_owner->keyframes_only = false;
+    p_owner->wait_keyframe = false;
+
     p_owner->b_waiting = false;
     p_owner->b_first = true;
     p_owner->b_has_data = false;
@@ -1997,7 +2073,7 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
     /* decoder fifo */
-    p_owner->p_fifo = block_FifoNew();
+    p_owner->p_fifo = vlc_fifo_NewSingleConsumer();
     if( unlikely(p_owner->p_fifo == NULL) )
     {
         vlc_object_delete(p_dec);
@@ -2649,6 +2725,18 @@ void vlc_input_decoder_ChangeRate( vlc_input_decoder_t *owner, float rate )
     vlc_fifo_Unlock( owner->p_fifo );
 }
 
+void vlc_input_decoder_SetKeyframesOnly( vlc_input_decoder_t *owner,
+                                         bool keyframes_only )
+{
+    vlc_fifo_Lock( owner->p_fifo );
+    /* Predicted frames reference pictures that were never decoded, keep
+     * dropping them up to the next keyframe */
+    if( owner->keyframes_only && !keyframes_only )
+        owner->wait_keyframe = true;
+    owner->keyframes_only = keyframes_only;
+    vlc_fifo_Unlock( owner->p_fifo );
+}
+
 void vlc_input_decoder_ChangeDelay( vlc_input_decoder_t *owner, vlc_tick_t delay )
 {
     vlc_fifo_Lock( owner->p_fifo );
@@ -86,6 +86,18 @@ void vlc_input_decoder_ChangePause( vlc_input_decoder_t *, bool b_paused, vlc_ti
  */
 void vlc_input_decoder_ChangeRate( vlc_input_decoder_t *dec, float rate );
 
+/**
+ * Decodes only keyframes.
+ *
+ * Frames flagged as P or B frames are dropped before reaching the decoder
+ * module. Thumbnailing decoders already drop every frame once their
+ * thumbnail is output, up to the next seek.
+ * \param dec decoder
+ * \param keyframes_only true to drop predicted frames
+ */
+void vlc_input_decoder_SetKeyframesOnly( vlc_input_decoder_t *dec,
+                                         bool keyframes_only );
+
 /**
  * This function makes the decoder start waiting for a valid data block from its fifo.
  */
@@ -218,6 +218,7 @@ typedef struct
     vlc_tick_t  i_pts_jitter;
     int         i_cr_average;
     float       rate;
+    float       keyframes_rate; /* 0 to always decode every frame */
 
     /* */
     bool        b_paused;
@@ -930,6 +931,12 @@ static void EsOutChangePause(es_out_sys_t *p_sys, bool b_paused, vlc_tick_t i_da
     p_sys->i_pause_date = i_date;
 }
 
+static bool EsOutIsKeyframesOnly(es_out_sys_t *p_sys, const es_out_id_t *es)
+{
+    return es->fmt.i_cat == VIDEO_ES && p_sys->keyframes_rate > 0.f
+        && p_sys->rate >= p_sys->keyframes_rate;
+}
+
 static void EsOutChangeRate(es_out_sys_t *p_sys, float rate)
 {
     es_out_id_t *es;
@@ -939,7 +946,12 @@ static void EsOutChangeRate(es_out_sys_t *p_sys, float rate)
 
     foreach_es_then_es_slaves(es)
         if( es->p_dec != NULL )
+        {
             vlc_input_decoder_ChangeRate( es->p_dec, rate );
+            if( es->fmt.i_cat == VIDEO_ES )
+                vlc_input_decoder_SetKeyframesOnly( es->p_dec,
+                                                    EsOutIsKeyframesOnly(p_sys, es) );
+        }
 }
 
 static void EsOutChangePosition(es_out_sys_t *p_sys, bool b_flush,
@@ -2380,6 +2392,8 @@ static void EsOutCreateDecoder(es_out_sys_t *p_sys, es_out_id_t *p_es)
     if( dec != NULL )
     {
         vlc_input_decoder_ChangeRate( dec, p_sys->rate );
+        if( EsOutIsKeyframesOnly( p_sys, p_es ) )
+            vlc_input_decoder_SetKeyframesOnly( dec, true );
 
         if( unlikely( p_sys->b_paused ) ) /* Could happen during next-frame */
             vlc_input_decoder_ChangePause( dec, true, p_sys->i_pause_date );
@@ -2937,6 +2951,7 @@ static int EsOutSend(es_out_t *out, es_out_id_t *es, block_t *p_block )
     {
         vlc_tracer_TraceStreamDTS( tracer, "DEMUX", es->id.str_id, "OUT",
                             p_block->i_pts, p_block->i_dts);
+        vlc_tracer_TraceFrame( tracer, es->id.str_id, "demux", p_block->i_pts );
     }
 
     struct input_stats *stats = input_priv(p_input)->stats;
@@ -4038,6 +4053,10 @@ static int EsOutVaPrivControlLocked(es_out_sys_t *p_sys, input_source_t *source,
         }
         return ret;
     }
+    case ES_OUT_PRIV_SET_TIMESHIFT_DATE:
+    case ES_OUT_PRIV_GET_TIMESHIFT_WINDOW:
+        /* Only the timeshift es_out keeps a buffer to seek into */
+        return VLC_EGENERIC;
     default: vlc_assert_unreachable();
     }
 
@@ -4139,6 +4158,7 @@ input_EsOutNew(input_thread_t *p_input, input_source_t *main_source, float rate,
     p_sys->i_pause_date = -1;
 
     p_sys->rate = rate;
+    p_sys->keyframes_rate = var_InheritFloat( p_input, "keyframes-rate" );
 
     p_sys->b_buffering = true;
     p_sys->b_draining = false;
@@ -101,7 +101,14 @@ enum es_out_query_private_e
     ES_OUT_PRIV_SET_VBI_PAGE,                       /* arg1=unsigned res=can fail */
 
     /* Set VBI/Teletext menu transparent */
-    ES_OUT_PRIV_SET_VBI_TRANSPARENCY                /* arg1=bool res=can fail */
+    ES_OUT_PRIV_SET_VBI_TRANSPARENCY,               /* arg1=bool res=can fail */
+
+    /* Seek inside the timeshift buffer */
+    ES_OUT_PRIV_SET_TIMESHIFT_DATE,                 /* arg1=vlc_tick_t date res=can fail */
+
+    /* Get the dates of the oldest seek point, of the newest data, and of
+     * the data being played in the timeshift buffer */
+    ES_OUT_PRIV_GET_TIMESHIFT_WINDOW,               /* arg1=vlc_tick_t * arg2=vlc_tick_t * arg3=vlc_tick_t * res=can fail */
 };
 
 struct vlc_input_es_out;
@@ -319,6 +326,20 @@ es_out_SetVbiTransparency(struct vlc_input_es_out *out, vlc_es_id_t *id,
                               enabled);
 }
 
+static inline int
+es_out_SetTimeshiftDate(struct vlc_input_es_out *out, vlc_tick_t date)
+{
+    return es_out_PrivControl(out, ES_OUT_PRIV_SET_TIMESHIFT_DATE, date);
+}
+
+static inline int
+es_out_GetTimeshiftWindow(struct vlc_input_es_out *out, vlc_tick_t *start,
+                          vlc_tick_t *end, vlc_tick_t *current)
+{
+    return es_out_PrivControl(out, ES_OUT_PRIV_GET_TIMESHIFT_WINDOW, start,
+                              end, current);
+}
+
 struct vlc_input_es_out *
 input_EsOutNew(input_thread_t *, input_source_t *main_source, float rate,
                enum input_type input_type);
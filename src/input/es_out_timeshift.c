@@ -36,10 +36,16 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_arrays.h>
+#include <vlc_atomic.h>
 #include <vlc_fs.h>
+#include <vlc_list.h>
+#include <vlc_vector.h>
 #include <vlc_mouse.h>
 #include <vlc_es_out.h>
 #include <vlc_block.h>
@@ -95,7 +101,7 @@ typedef struct attribute_packed
     es_out_id_t *p_es;
     union{
         block_t *p_block;
-        int     i_offset;  /* We do not use file > INT_MAX */
+        uint64_t i_pos;     /* Payload position in the ring once stored */
     };
 } ts_cmd_send_t;
 
@@ -190,26 +196,70 @@ static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_send_t, header), "in
 static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_control_t, header), "invalid packing");
 static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_privcontrol_t, header), "invalid packing");
 
-typedef struct ts_storage_t ts_storage_t;
-struct ts_storage_t
+/* Fixed size buffer holding the payloads of the C_SEND commands. It is
+ * mapped from a temporary file, deleted as soon as possible, so that the
+ * kernel writes it back in the background instead of the input thread
+ * blocking on the disk. The
+ * payloads are handed to the decoders as views, which keep the ring alive
+ * and prevent the writer from overwriting them. */
+typedef struct
 {
-    ts_storage_t *p_next;
-
-    /* */
-#ifdef _WIN32
-    char    *psz_file;  /* Filename */
+    vlc_atomic_rc_t rc;
+    uint8_t        *p_base;
+    size_t          i_size;
+#if !defined (HAVE_MMAP) && defined (_WIN32)
+    HANDLE          h_file;
 #endif
-    size_t  i_file_max; /* Max size in bytes */
-    int64_t i_file_size;/* Current size in bytes */
-    FILE    *p_filew;   /* FILE handle for data writing */
-    FILE    *p_filer;   /* FILE handle for data reading */
 
-    /* */
-    uint8_t *p_cmd_r;
-    uint8_t *p_cmd_w;
-    uint8_t *p_cmd_buf;
-    size_t   i_cmd_buf;
-};
+    /* Lock for the following fields, views are released by the decoders */
+    vlc_mutex_t     lock;
+    struct vlc_list views;
+    struct vlc_list free_views;
+} ts_ring_t;
+
+typedef struct
+{
+    block_t         self;
+    ts_ring_t      *p_ring;
+    uint64_t        i_pos;
+    struct vlc_list node;
+} ts_ring_view_t;
+
+/* Commands from which playback can start again */
+typedef struct
+{
+    uint64_t   i_cmd;
+    vlc_tick_t i_date;
+} ts_index_entry_t;
+
+typedef struct VLC_VECTOR(ts_index_entry_t) ts_index_t;
+
+/* Command positions are absolute and never wrap, the ring offsets and the
+ * command slots are derived from them. */
+typedef struct
+{
+    vlc_object_t *p_obj;
+    ts_ring_t  *p_ring;
+    uint64_t    i_ring_w;       /* Next payload position */
+    uint64_t    i_ring_tail;    /* Oldest payload position still valid */
+
+    /* Circular array of i_cmd_alloc (a power of 2) commands */
+    ts_cmd_t   *p_cmd;
+    size_t      i_cmd_alloc;
+    uint64_t    i_cmd_first;    /* Oldest command stored */
+    uint64_t    i_cmd_r;        /* Next command to pop */
+    uint64_t    i_cmd_w;        /* Next command to push */
+    uint64_t    i_cmd_history;  /* Oldest command that can be replayed */
+    uint64_t    i_cmd_replay;   /* Commands before were already executed */
+    uint64_t    i_cmd_skip;     /* Payloads before are seeked over */
+
+    ts_index_t  index;
+    vlc_tick_t  i_keyframe_date;
+
+    vlc_tick_t  i_window;       /* Duration kept once played */
+    bool        b_lost;         /* Payloads overwritten before being read */
+    bool        b_overflow;     /* Payloads dropped as the ring was full */
+} ts_storage_t;
 
 typedef struct
 {
@@ -218,7 +268,8 @@ typedef struct
     input_thread_t *p_input;
     es_out_t       *p_tsout;
     struct vlc_input_es_out *p_out;
-    int64_t        i_tmp_size_max;
+    size_t         i_buffer_size;
+    vlc_tick_t     i_window;
     const char     *psz_tmp_path;
 
     /* Lock for all following fields */
@@ -240,8 +291,8 @@ typedef struct
     vlc_tick_t     i_buffering_delay;
 
     /* */
-    ts_storage_t   *p_storage_r;
-    ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage;
+    bool           b_seek;
 
     vlc_tick_t     i_cmd_delay;
 
@@ -258,7 +309,8 @@ struct es_out_timeshift
     struct vlc_input_es_out *p_out;
 
     /* Configuration */
-    int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    size_t         i_buffer_size;     /* Ring buffer size in bytes */
+    vlc_tick_t     i_window;          /* Played duration kept for seeking */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -287,22 +339,24 @@ static int          TsStart(struct es_out_timeshift *);
 static void         TsAutoStop( es_out_t * );
 
 static void         TsStop( ts_thread_t * );
-static void         TsPushCmd( ts_thread_t *, ts_cmd_t * );
-static int          TsPopCmdLocked( ts_thread_t *, ts_cmd_t *, bool b_flush );
+static int          TsPushCmd( ts_thread_t *, ts_cmd_t * );
+static int          TsPopCmdLocked( ts_thread_t *, ts_cmd_t * );
 static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, vlc_tick_t i_date );
 static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
+static int          TsSeek( ts_thread_t *, vlc_tick_t i_date );
+static int          TsGetWindow( ts_thread_t *, vlc_tick_t *pi_start, vlc_tick_t *pi_end, vlc_tick_t *pi_current );
 
 static void         *TsRun( void * );
 
-static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static ts_storage_t *TsStorageNew( vlc_object_t *, const char *psz_path, size_t i_size, vlc_tick_t i_window );
 static void         TsStorageDelete( ts_storage_t * );
-static void         TsStoragePack( ts_storage_t *p_storage );
-static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
-static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static int          TsStoragePushCmd( ts_storage_t *, ts_cmd_t *p_cmd );
+static int          TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd );
+static int          TsStorageSeek( ts_storage_t *, vlc_tick_t i_date, vlc_tick_t *pi_date );
+static int          TsStorageGetWindow( ts_storage_t *, vlc_tick_t *pi_start, vlc_tick_t *pi_end, vlc_tick_t *pi_current );
 
 static void CmdClean( ts_cmd_t * );
 
@@ -326,6 +380,7 @@ static int  CmdExecuteControl(struct es_out_timeshift *, ts_cmd_control_t *);
 static int  CmdExecutePrivControl(struct es_out_timeshift *, ts_cmd_privcontrol_t *);
 
 /* File helpers */
+#if defined (HAVE_MMAP) || defined (_WIN32)
 static int GetTmpFile( char **filename, const char *dirname )
 {
     if( dirname != NULL
@@ -352,6 +407,7 @@ static int GetTmpFile( char **filename, const char *dirname )
     free( *filename );
     return -1;
 }
+#endif
 
 /*****************************************************************************
  * Internal functions
@@ -420,9 +476,14 @@ static int Send( es_out_t *p_out, es_out_id_t *p_es, block_t *p_block )
 
     TsAutoStop( p_out );
 
+    /* Buffer from the start, so that seeking back does not need a pause */
+    if( !p_sys->b_delayed && p_sys->i_window > 0 &&
+        !input_CanPaceControl( p_sys->p_input ) && TsStart( p_sys ) )
+        p_sys->i_window = 0;
+
     CmdInitSend( &cmd, p_es, p_block );
     if( p_sys->b_delayed )
-        TsPushCmd( p_sys->p_ts, (ts_cmd_t *)&cmd );
+        i_ret = TsPushCmd( p_sys->p_ts, (ts_cmd_t *)&cmd );
     else
         i_ret = CmdExecuteSend(p_sys, &cmd) ;
 
@@ -622,6 +683,21 @@ ControlLockedSetRate(struct es_out_timeshift *p_sys,
     }
     return i_ret;
 }
+static int ControlLockedSetTimeshiftDate(struct es_out_timeshift *p_sys, vlc_tick_t i_date)
+{
+    if( !p_sys->b_delayed )
+        return VLC_EGENERIC;
+    return TsSeek( p_sys->p_ts, i_date );
+}
+static int ControlLockedGetTimeshiftWindow(struct es_out_timeshift *p_sys,
+                                           vlc_tick_t *pi_start,
+                                           vlc_tick_t *pi_end,
+                                           vlc_tick_t *pi_current)
+{
+    if( !p_sys->b_delayed )
+        return VLC_EGENERIC;
+    return TsGetWindow( p_sys->p_ts, pi_start, pi_end, pi_current );
+}
 static int ControlLockedSetFrameNext(struct es_out_timeshift *p_sys, input_source_t *in )
 {
     return es_out_in_PrivControl( p_sys->p_out, in, ES_OUT_PRIV_SET_FRAME_NEXT );
@@ -660,10 +736,7 @@ static int ControlLocked( es_out_t *p_out, input_source_t *in, int i_query,
         if( CmdInitControl( &cmd, in, i_query, args, p_sys->b_delayed ) )
             return VLC_EGENERIC;
         if( p_sys->b_delayed )
-        {
-            TsPushCmd( p_sys->p_ts, (ts_cmd_t *) &cmd );
-            return VLC_SUCCESS;
-        }
+            return TsPushCmd( p_sys->p_ts, (ts_cmd_t *) &cmd );
         return CmdExecuteControl(p_sys, &cmd);
     }
 
@@ -762,10 +835,7 @@ static int PrivControlLocked(struct vlc_input_es_out *p_tsout,
         if( CmdInitPrivControl( &cmd.privcontrol, in, i_query, args, p_sys->b_delayed ) )
             return VLC_EGENERIC;
         if( p_sys->b_delayed )
-        {
-            TsPushCmd( p_sys->p_ts, &cmd );
-            return VLC_SUCCESS;
-        }
+            return TsPushCmd( p_sys->p_ts, &cmd );
         return CmdExecutePrivControl(p_sys, &cmd.privcontrol);
     }
     case ES_OUT_PRIV_GET_WAKE_UP: /* TODO ? */
@@ -797,6 +867,18 @@ static int PrivControlLocked(struct vlc_input_es_out *p_tsout,
     {
         return ControlLockedSetFrameNext(p_sys, in);
     }
+    case ES_OUT_PRIV_SET_TIMESHIFT_DATE:
+    {
+        const vlc_tick_t i_date = va_arg( args, vlc_tick_t );
+        return ControlLockedSetTimeshiftDate(p_sys, i_date);
+    }
+    case ES_OUT_PRIV_GET_TIMESHIFT_WINDOW:
+    {
+        vlc_tick_t *pi_start = va_arg( args, vlc_tick_t * );
+        vlc_tick_t *pi_end = va_arg( args, vlc_tick_t * );
+        vlc_tick_t *pi_current = va_arg( args, vlc_tick_t * );
+        return ControlLockedGetTimeshiftWindow(p_sys, pi_start, pi_end, pi_current);
+    }
     case ES_OUT_PRIV_GET_GROUP_FORCED:
         return es_out_in_vaPrivControl( p_sys->p_out, in, i_query, args );
     /* Invalid queries for this es_out level */
@@ -876,13 +958,17 @@ input_EsOutTimeshiftNew(input_thread_t *p_input,
     TAB_INIT( p_sys->i_es, p_sys->pp_es );
 
     /* */
-    const int i_tmp_size_max = var_CreateGetInteger( p_input, "input-timeshift-granularity" );
-    if( i_tmp_size_max < 0 )
-        p_sys->i_tmp_size_max = 50*1024*1024;
+    const int64_t i_buffer_size = var_CreateGetInteger( p_input, "input-timeshift-size" );
+    if( i_buffer_size < 0 )
+        p_sys->i_buffer_size = SIZE_MAX > UINT32_MAX ? 1024*1024*1024 : 256*1024*1024;
     else
-        p_sys->i_tmp_size_max = __MAX( i_tmp_size_max, 1*1024*1024 );
-    msg_Dbg( p_input, "using timeshift granularity of %d MiB",
-             (int)p_sys->i_tmp_size_max/(1024*1024) );
+        p_sys->i_buffer_size = __MIN( (uint64_t)__MAX( i_buffer_size, 1*1024*1024 ),
+                                      SIZE_MAX / 2 );
+    msg_Dbg( p_input, "using timeshift buffer of %zu MiB",
+             p_sys->i_buffer_size/(1024*1024) );
+
+    const int64_t i_window = var_InheritInteger( p_input, "input-timeshift-window" );
+    p_sys->i_window = vlc_tick_from_sec( __MAX( i_window, 0 ) );
 
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32)
@@ -961,7 +1047,8 @@ static int TsStart(struct es_out_timeshift *p_sys)
     if( !p_ts )
         return VLC_EGENERIC;
 
-    p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
+    p_ts->i_buffer_size = p_sys->i_buffer_size;
+    p_ts->i_window = p_sys->i_window;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
     p_ts->p_input = p_sys->p_input;
     p_ts->ts = p_sys;
@@ -978,8 +1065,8 @@ static int TsStart(struct es_out_timeshift *p_sys)
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
-    p_ts->p_storage_r = NULL;
-    p_ts->p_storage_w = NULL;
+    p_ts->p_storage = NULL;
+    p_ts->b_seek = false;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts ) )
@@ -1015,84 +1102,51 @@ static void TsStop( ts_thread_t *p_ts )
     vlc_join( p_ts->thread, NULL );
 
     vlc_mutex_lock( &p_ts->lock );
-    for( ;; )
-    {
-        ts_cmd_t cmd;
-
-        if( TsPopCmdLocked( p_ts, &cmd, true ) )
-            break;
-
-        CmdClean( &cmd );
-    }
-    assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    if( p_ts->p_storage )
+        TsStorageDelete( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
 }
-static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
+static int TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
-    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+    if( !p_ts->p_storage )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
-
-        if( !p_storage )
+        p_ts->p_storage = TsStorageNew( VLC_OBJECT(p_ts->p_input), p_ts->psz_tmp_path,
+                                        p_ts->i_buffer_size, p_ts->i_window );
+        if( !p_ts->p_storage )
         {
             CmdClean( p_cmd );
             vlc_mutex_unlock( &p_ts->lock );
             /* TODO warn the user (but only once) */
-            return;
-        }
-
-        if( !p_ts->p_storage_w )
-        {
-            p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
-        }
-        else
-        {
-            TsStoragePack( p_ts->p_storage_w );
-            p_ts->p_storage_w->p_next = p_storage;
-            p_ts->p_storage_w = p_storage;
+            return VLC_EGENERIC;
         }
     }
 
-    /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
-
-    vlc_cond_signal( &p_ts->wait );
+    const int i_ret = TsStoragePushCmd( p_ts->p_storage, p_cmd );
+    if( i_ret == VLC_SUCCESS )
+        vlc_cond_signal( &p_ts->wait );
 
     vlc_mutex_unlock( &p_ts->lock );
+    return i_ret;
 }
-static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
+static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_assert( &p_ts->lock );
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+    if( TsStorageIsEmpty( p_ts->p_storage ) )
         return VLC_EGENERIC;
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
-
-    while( TsStorageIsEmpty( p_ts->p_storage_r ) )
-    {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
-        if( !p_next )
-            break;
-
-        TsStorageDelete( p_ts->p_storage_r );
-        p_ts->p_storage_r = p_next;
-    }
-
-    return VLC_SUCCESS;
+    return TsStoragePopCmd( p_ts->p_storage, p_cmd );
 }
 static bool TsHasCmd( ts_thread_t *p_ts )
 {
     bool b_cmd;
 
     vlc_mutex_lock( &p_ts->lock );
-    b_cmd = !TsStorageIsEmpty( p_ts->p_storage_r );
+    b_cmd = !TsStorageIsEmpty( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_cmd;
@@ -1102,9 +1156,11 @@ static bool TsIsUnused( ts_thread_t *p_ts )
     bool b_unused;
 
     vlc_mutex_lock( &p_ts->lock );
+    /* Keep running while played commands are kept for seeking back */
     b_unused = !p_ts->b_paused &&
                p_ts->rate == p_ts->rate_source &&
-               TsStorageIsEmpty( p_ts->p_storage_r );
+               p_ts->i_window == 0 &&
+               TsStorageIsEmpty( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_unused;
@@ -1158,6 +1214,45 @@ static int TsChangeRate( ts_thread_t *p_ts, float src_rate, float rate )
 
     return i_ret;
 }
+static int TsSeek( ts_thread_t *p_ts, vlc_tick_t i_date )
+{
+    int i_ret = VLC_EGENERIC;
+    vlc_tick_t i_seek_date;
+
+    vlc_mutex_lock( &p_ts->lock );
+    if( p_ts->p_storage )
+        i_ret = TsStorageSeek( p_ts->p_storage, i_date, &i_seek_date );
+    if( !i_ret )
+    {
+        const vlc_tick_t i_now = vlc_tick_now();
+
+        /* Schedule the seek point now */
+        p_ts->i_cmd_delay = i_now - i_seek_date;
+        p_ts->i_rate_date = -1;
+        p_ts->i_rate_delay = 0;
+        p_ts->i_buffering_delay = 0;
+        if( p_ts->b_paused )
+            p_ts->i_pause_date = i_now;
+
+        p_ts->b_seek = true;
+        vlc_cond_signal( &p_ts->wait );
+    }
+    vlc_mutex_unlock( &p_ts->lock );
+
+    return i_ret;
+}
+static int TsGetWindow( ts_thread_t *p_ts, vlc_tick_t *pi_start,
+                        vlc_tick_t *pi_end, vlc_tick_t *pi_current )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_ts->lock );
+    if( p_ts->p_storage )
+        i_ret = TsStorageGetWindow( p_ts->p_storage, pi_start, pi_end, pi_current );
+    vlc_mutex_unlock( &p_ts->lock );
+
+    return i_ret;
+}
 
 static void *TsRun( void *p_data )
 {
@@ -1172,11 +1267,23 @@ static void *TsRun( void *p_data )
         ts_cmd_t cmd;
         vlc_tick_t  i_deadline;
 
+        if( p_ts->b_seek )
+        {
+            p_ts->b_seek = false;
+            vlc_mutex_unlock( &p_ts->lock );
+
+            /* Drop what the decoders received before the seek */
+            es_out_in_Control( p_ts->p_out, NULL, ES_OUT_RESET_PCR );
+
+            vlc_mutex_lock( &p_ts->lock );
+            continue;
+        }
+
         /* Pop a command to execute */
         bool b_buffering = es_out_GetBuffering( p_ts->p_out );
 
         if( ( p_ts->b_paused && !b_buffering )
-         || TsPopCmdLocked( p_ts, &cmd, false ) )
+         || TsPopCmdLocked( p_ts, &cmd ) )
         {
             vlc_cond_wait( &p_ts->wait, &p_ts->lock );
             continue;
@@ -1233,16 +1340,17 @@ static void *TsRun( void *p_data )
          * reading  */
         if( vlc_sem_timedwait( &p_ts->done, i_deadline ) == 0 )
         {
-            CmdClean( &cmd );
+            if( cmd.header.i_type == C_SEND )
+                CmdCleanSend( &cmd.send );
             return NULL;
         }
 
-        /* Execute the command  */
+        /* Execute the command, the storage keeps owning everything but
+         * the payload */
         switch( cmd.header.i_type )
         {
         case C_ADD:
             CmdExecuteAdd(p_ts->ts, &cmd.add);
-            CmdCleanAdd( &cmd.add );
             break;
         case C_SEND:
             CmdExecuteSend(p_ts->ts, &cmd.send );
@@ -1250,11 +1358,9 @@ static void *TsRun( void *p_data )
             break;
         case C_CONTROL:
             CmdExecuteControl(p_ts->ts, &cmd.control);
-            CmdCleanControl( &cmd.control );
             break;
         case C_PRIVCONTROL:
             CmdExecutePrivControl(p_ts->ts, &cmd.privcontrol);
-            CmdCleanPrivControl( &cmd.privcontrol );
             break;
         case C_DEL:
             CmdExecuteDel(p_ts->ts, &cmd.del);
@@ -1272,207 +1378,561 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
-#define MAX_COMMAND_SIZE sizeof(ts_cmd_t)
-#define TS_STORAGE_COMMAND_PREALLOC 30000
+#define TS_STORAGE_COMMAND_PREALLOC 4096 /* Must be a power of 2 */
 
-static const size_t TsStorageSizeofCommand[] =
+/* Payload records: header, data, then zeroed padding for the decoders
+ * reading past the end of their input */
+typedef struct
 {
-    [C_ADD] = sizeof(ts_cmd_add_t),
-    [C_SEND] = sizeof(ts_cmd_send_t),
-    [C_DEL] = sizeof(ts_cmd_del_t),
-    [C_CONTROL] = sizeof(ts_cmd_control_t),
-    [C_PRIVCONTROL] = sizeof(ts_cmd_privcontrol_t)
-};
+    vlc_tick_t i_dts;
+    vlc_tick_t i_pts;
+    vlc_tick_t i_length;
+    uint32_t   i_flags;
+    unsigned   i_nb_samples;
+    size_t     i_buffer;
+} ts_payload_t;
+
+#define TS_PAYLOAD_ALIGN   32
+#define TS_PAYLOAD_PADDING 64
+#define TS_PAYLOAD_ALIGN_UP(x) (((x) + TS_PAYLOAD_ALIGN - 1) & ~(size_t)(TS_PAYLOAD_ALIGN - 1))
+#define TS_PAYLOAD_HEADER  TS_PAYLOAD_ALIGN_UP(sizeof(ts_payload_t))
+
+/* Seek points are keyframes, or regular commands for the sources that do
+ * not flag them */
+#define TS_INDEX_INTERVAL   VLC_TICK_FROM_SEC(1)
+#define TS_KEYFRAME_TIMEOUT VLC_TICK_FROM_SEC(10)
 
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+static ts_ring_t *TsRingNew( vlc_object_t *p_obj, const char *psz_tmp_path, size_t i_size )
 {
-    ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
-    if( unlikely(p_storage == NULL) )
+    ts_ring_t *p_ring = malloc( sizeof(*p_ring) );
+    if( unlikely(p_ring == NULL) )
         return NULL;
 
+#ifdef HAVE_MMAP
     char *psz_file;
     int fd = GetTmpFile( &psz_file, psz_tmp_path );
     if( fd == -1 )
     {
-        free( p_storage );
+        free( p_ring );
         return NULL;
     }
+    vlc_unlink( psz_file );
+    free( psz_file );
 
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
+    void *p_base = MAP_FAILED;
+    if( ftruncate( fd, i_size ) == 0 )
+        p_base = mmap( NULL, i_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0 );
+    vlc_close( fd );
+    if( p_base == MAP_FAILED )
     {
-        vlc_close( fd );
-        vlc_unlink( psz_file );
-        goto error;
+        msg_Err( p_obj, "cannot map the timeshift buffer: %s",
+                 vlc_strerror_c(errno) );
+        free( p_ring );
+        return NULL;
     }
+    p_ring->p_base = p_base;
+#elif defined (_WIN32)
+    /* The file cannot be deleted while it is open, let the system delete it
+     * once the ring is released */
+    char *psz_file;
+    int fd = GetTmpFile( &psz_file, psz_tmp_path );
+    if( fd == -1 )
+    {
+        free( p_ring );
+        return NULL;
+    }
+    vlc_close( fd );
 
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
+    HANDLE h_file = INVALID_HANDLE_VALUE;
+    wchar_t *wpath = ToWide( psz_file );
+    if( likely(wpath != NULL) )
+    {
+        h_file = CreateFileW( wpath, GENERIC_READ|GENERIC_WRITE, 0, NULL,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_TEMPORARY|FILE_FLAG_DELETE_ON_CLOSE,
+                              NULL );
+        free( wpath );
+    }
+    if( h_file == INVALID_HANDLE_VALUE )
     {
-        fclose( p_storage->p_filew );
+        msg_Err( p_obj, "cannot open the timeshift buffer file %s", psz_file );
         vlc_unlink( psz_file );
-        goto error;
+        free( psz_file );
+        free( p_ring );
+        return NULL;
     }
-
-#ifndef _WIN32
-    vlc_unlink( psz_file );
     free( psz_file );
+
+    void *p_base = NULL;
+    const uint64_t i_map_size = i_size;
+    HANDLE h_map = CreateFileMappingW( h_file, NULL, PAGE_READWRITE,
+                                       i_map_size >> 32,
+                                       i_map_size & 0xffffffff, NULL );
+    if( h_map != NULL )
+    {
+        p_base = MapViewOfFile( h_map, FILE_MAP_ALL_ACCESS, 0, 0, i_size );
+        CloseHandle( h_map );
+    }
+    if( p_base == NULL )
+    {
+        msg_Err( p_obj, "cannot map the timeshift buffer (error %lu)",
+                 GetLastError() );
+        CloseHandle( h_file );
+        free( p_ring );
+        return NULL;
+    }
+    p_ring->p_base = p_base;
+    p_ring->h_file = h_file;
 #else
-    p_storage->psz_file = psz_file;
+    VLC_UNUSED(psz_tmp_path);
+    p_ring->p_base = malloc( i_size );
+    if( p_ring->p_base == NULL )
+    {
+        msg_Err( p_obj, "cannot allocate the timeshift buffer" );
+        free( p_ring );
+        return NULL;
+    }
 #endif
-    p_storage->p_next = NULL;
+    p_ring->i_size = i_size;
+    vlc_atomic_rc_init( &p_ring->rc );
+    vlc_mutex_init( &p_ring->lock );
+    vlc_list_init( &p_ring->views );
+    vlc_list_init( &p_ring->free_views );
+    return p_ring;
+}
 
-    /* */
-    p_storage->i_file_max = i_tmp_size_max;
-    p_storage->i_file_size = 0;
+static void TsRingRelease( ts_ring_t *p_ring )
+{
+    if( !vlc_atomic_rc_dec( &p_ring->rc ) )
+        return;
 
-    /* */
-    p_storage->p_cmd_buf = vlc_alloc( TS_STORAGE_COMMAND_PREALLOC, MAX_COMMAND_SIZE );
-    p_storage->i_cmd_buf = TS_STORAGE_COMMAND_PREALLOC * MAX_COMMAND_SIZE;
-    p_storage->p_cmd_w = p_storage->p_cmd_buf;
-    p_storage->p_cmd_r = p_storage->p_cmd_buf;
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
+    assert( vlc_list_is_empty( &p_ring->views ) );
+    ts_ring_view_t *p_view;
+    vlc_list_foreach( p_view, &p_ring->free_views, node )
+        free( p_view );
+#ifdef HAVE_MMAP
+    munmap( p_ring->p_base, p_ring->i_size );
+#elif defined (_WIN32)
+    UnmapViewOfFile( p_ring->p_base );
+    CloseHandle( p_ring->h_file );
+#else
+    free( p_ring->p_base );
+#endif
+    free( p_ring );
+}
 
-    if( !p_storage->p_cmd_buf )
+static void TsRingViewRelease( block_t *p_block )
+{
+    ts_ring_view_t *p_view = container_of( p_block, ts_ring_view_t, self );
+    ts_ring_t *p_ring = p_view->p_ring;
+
+    vlc_mutex_lock( &p_ring->lock );
+    vlc_list_remove( &p_view->node );
+    vlc_list_append( &p_view->node, &p_ring->free_views );
+    vlc_mutex_unlock( &p_ring->lock );
+
+    TsRingRelease( p_ring );
+}
+
+static const struct vlc_frame_callbacks ts_ring_view_cbs =
+{
+    TsRingViewRelease,
+};
+
+static block_t *TsRingView( ts_ring_t *p_ring, uint64_t i_pos )
+{
+    uint8_t *p_record = &p_ring->p_base[i_pos % p_ring->i_size];
+    const ts_payload_t *p_payload = (const ts_payload_t *)p_record;
+
+    vlc_mutex_lock( &p_ring->lock );
+    ts_ring_view_t *p_view =
+        vlc_list_first_entry_or_null( &p_ring->free_views, ts_ring_view_t, node );
+    if( p_view != NULL )
+        vlc_list_remove( &p_view->node );
+    else
+    {
+        p_view = malloc( sizeof(*p_view) );
+        if( unlikely(p_view == NULL) )
+        {
+            vlc_mutex_unlock( &p_ring->lock );
+            return NULL;
+        }
+    }
+    vlc_list_append( &p_view->node, &p_ring->views );
+    vlc_mutex_unlock( &p_ring->lock );
+
+    vlc_atomic_rc_inc( &p_ring->rc );
+    p_view->p_ring = p_ring;
+    p_view->i_pos = i_pos;
+
+    block_t *p_block = &p_view->self;
+    block_Init( p_block, &ts_ring_view_cbs, p_record + TS_PAYLOAD_HEADER,
+                p_payload->i_buffer + TS_PAYLOAD_PADDING );
+    p_block->i_buffer     = p_payload->i_buffer;
+    p_block->i_dts        = p_payload->i_dts;
+    p_block->i_pts        = p_payload->i_pts;
+    p_block->i_length     = p_payload->i_length;
+    p_block->i_flags      = p_payload->i_flags;
+    p_block->i_nb_samples = p_payload->i_nb_samples;
+    return p_block;
+}
+
+/* Returns whether payloads are still in use, and the oldest one */
+static bool TsRingGetPinned( ts_ring_t *p_ring, uint64_t *pi_pos )
+{
+    bool b_pinned = false;
+    ts_ring_view_t *p_view;
+
+    vlc_mutex_lock( &p_ring->lock );
+    vlc_list_foreach( p_view, &p_ring->views, node )
+    {
+        if( !b_pinned || p_view->i_pos < *pi_pos )
+            *pi_pos = p_view->i_pos;
+        b_pinned = true;
+    }
+    vlc_mutex_unlock( &p_ring->lock );
+
+    return b_pinned;
+}
+
+static inline ts_cmd_t *TsStorageCmd( ts_storage_t *p_storage, uint64_t i_cmd )
+{
+    return &p_storage->p_cmd[i_cmd & (p_storage->i_cmd_alloc - 1)];
+}
+
+static ts_storage_t *TsStorageNew( vlc_object_t *p_obj, const char *psz_tmp_path,
+                                   size_t i_size, vlc_tick_t i_window )
+{
+    ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
+    if( unlikely(p_storage == NULL) )
+        return NULL;
+
+    p_storage->p_cmd = vlc_alloc( TS_STORAGE_COMMAND_PREALLOC, sizeof(ts_cmd_t) );
+    if( unlikely(p_storage->p_cmd == NULL) )
     {
-        TsStorageDelete( p_storage );
+        free( p_storage );
         return NULL;
     }
+
+    p_storage->p_ring = TsRingNew( p_obj, psz_tmp_path, i_size );
+    if( p_storage->p_ring == NULL )
+    {
+        free( p_storage->p_cmd );
+        free( p_storage );
+        return NULL;
+    }
+    p_storage->i_ring_w = 0;
+    p_storage->i_ring_tail = 0;
+
+    p_storage->i_cmd_alloc = TS_STORAGE_COMMAND_PREALLOC;
+    p_storage->i_cmd_first = 0;
+    p_storage->i_cmd_r = 0;
+    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_history = 0;
+    p_storage->i_cmd_replay = 0;
+    p_storage->i_cmd_skip = 0;
+
+    vlc_vector_init( &p_storage->index );
+    p_storage->i_keyframe_date = VLC_TICK_INVALID;
+
+    p_storage->p_obj = p_obj;
+    p_storage->i_window = i_window;
+    p_storage->b_lost = false;
+    p_storage->b_overflow = false;
     return p_storage;
-error:
-    free( psz_file );
-    free( p_storage );
-    return NULL;
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
 {
-    while( p_storage->p_cmd_r < p_storage->p_cmd_w )
+    for( uint64_t i = p_storage->i_cmd_first; i < p_storage->i_cmd_w; i++ )
     {
-        ts_cmd_t cmd;
+        ts_cmd_t *p_cmd = TsStorageCmd( p_storage, i );
 
-        TsStoragePopCmd( p_storage, &cmd, true );
-
-        CmdClean( &cmd );
+        /* Stored payloads are owned by the ring */
+        if( p_cmd->header.i_type != C_SEND )
+            CmdClean( p_cmd );
     }
-    free( p_storage->p_cmd_buf );
+    free( p_storage->p_cmd );
+    vlc_vector_destroy( &p_storage->index );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
-#ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
-    free( p_storage->psz_file );
-#endif
+    TsRingRelease( p_storage->p_ring );
     free( p_storage );
 }
 
-static void TsStoragePack( ts_storage_t *p_storage )
+static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
-    /* Try to release a bit of memory */
-    if( (size_t)(p_storage->p_cmd_w - p_storage->p_cmd_buf) == p_storage->i_cmd_buf )
-        return;
+    return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
+}
+
+static int TsStorageGrow( ts_storage_t *p_storage )
+{
+    const size_t i_alloc = p_storage->i_cmd_alloc * 2;
+    ts_cmd_t *p_cmd = vlc_alloc( i_alloc, sizeof(*p_cmd) );
+    if( unlikely(p_cmd == NULL) )
+        return VLC_ENOMEM;
+
+    for( uint64_t i = p_storage->i_cmd_first; i < p_storage->i_cmd_w; i++ )
+        p_cmd[i & (i_alloc - 1)] = *TsStorageCmd( p_storage, i );
+
+    free( p_storage->p_cmd );
+    p_storage->p_cmd = p_cmd;
+    p_storage->i_cmd_alloc = i_alloc;
+    return VLC_SUCCESS;
+}
+
+/* Forgets the commands that cannot be popped nor replayed anymore */
+static void TsStorageTrim( ts_storage_t *p_storage )
+{
+    const uint64_t i_read = p_storage->i_cmd_r;
+    vlc_tick_t i_oldest = VLC_TICK_MAX;
+    if( p_storage->i_window > 0 && p_storage->i_cmd_w > p_storage->i_cmd_first )
+        i_oldest = TsStorageCmd( p_storage, p_storage->i_cmd_w - 1 )->header.i_date
+                 - p_storage->i_window;
+
+    size_t i_drop = 0;
+    while( i_drop < p_storage->index.size )
+    {
+        const ts_index_entry_t *p_entry = &p_storage->index.data[i_drop];
+
+        if( p_entry->i_cmd >= p_storage->i_cmd_history &&
+            TsStorageCmd( p_storage, p_entry->i_cmd )->send.i_pos >= p_storage->i_ring_tail &&
+            ( p_entry->i_cmd >= i_read || p_entry->i_date >= i_oldest ) )
+            break;
+        i_drop++;
+    }
+    if( i_drop > 0 )
+        vlc_vector_remove_slice( &p_storage->index, 0, i_drop );
 
-    size_t i_realloc = p_storage->p_cmd_w - p_storage->p_cmd_buf;
-    uint8_t *p_realloc = realloc( p_storage->p_cmd_buf, i_realloc );
-    if( p_realloc )
+    /* Keep the last popped command, the timeshift thread may be executing
+     * it without holding the lock */
+    uint64_t i_first = i_read > 0 ? i_read - 1 : 0;
+    if( p_storage->index.size > 0 && p_storage->index.data[0].i_cmd < i_first )
+        i_first = p_storage->index.data[0].i_cmd;
+
+    for( ; p_storage->i_cmd_first < i_first; p_storage->i_cmd_first++ )
     {
-        p_storage->p_cmd_r = p_realloc + (p_storage->p_cmd_r - p_storage->p_cmd_buf);
-        p_storage->p_cmd_w = p_realloc + i_realloc;
-        p_storage->i_cmd_buf = i_realloc;
-        p_storage->p_cmd_buf = p_realloc;
+        ts_cmd_t *p_cmd = TsStorageCmd( p_storage, p_storage->i_cmd_first );
+        if( p_cmd->header.i_type != C_SEND )
+            CmdClean( p_cmd );
     }
 }
 
-static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
+static int TsStorageWritePayload( ts_storage_t *p_storage, const block_t *p_block,
+                                  uint64_t *pi_pos )
 {
-    if( p_cmd && p_cmd->header.i_type == C_SEND && p_storage->p_cmd_w )
+    ts_ring_t *p_ring = p_storage->p_ring;
+    const size_t i_record = TS_PAYLOAD_HEADER +
+                            TS_PAYLOAD_ALIGN_UP(p_block->i_buffer + TS_PAYLOAD_PADDING);
+    if( i_record > p_ring->i_size / 2 )
+        return VLC_EGENERIC;
+
+    /* Records are contiguous, wrap early if the end of the ring is too short */
+    uint64_t i_pos = p_storage->i_ring_w;
+    const size_t i_offset = i_pos % p_ring->i_size;
+    if( i_offset + i_record > p_ring->i_size )
+        i_pos += p_ring->i_size - i_offset;
+
+    /* Overwrite the oldest payloads, but not the ones the decoders hold */
+    if( i_pos + i_record > p_storage->i_ring_tail + p_ring->i_size )
     {
-        size_t i_size = sizeof(*p_cmd->send.p_block) + p_cmd->send.p_block->i_buffer;
+        const uint64_t i_tail = i_pos + i_record - p_ring->i_size;
+        uint64_t i_pinned;
 
-        if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
-            return true;
+        if( TsRingGetPinned( p_ring, &i_pinned ) && i_pinned < i_tail )
+            return VLC_ENOMEM;
+        p_storage->i_ring_tail = i_tail;
     }
-    return (size_t)(p_storage->p_cmd_w - p_storage->p_cmd_buf) > p_storage->i_cmd_buf - MAX_COMMAND_SIZE;
+
+    uint8_t *p_record = &p_ring->p_base[i_pos % p_ring->i_size];
+    /* Let the decoders know about the payloads dropped before */
+    const ts_payload_t payload =
+    {
+        .i_dts = p_block->i_dts,
+        .i_pts = p_block->i_pts,
+        .i_length = p_block->i_length,
+        .i_flags = p_block->i_flags |
+                   (p_storage->b_overflow ? BLOCK_FLAG_DISCONTINUITY : 0),
+        .i_nb_samples = p_block->i_nb_samples,
+        .i_buffer = p_block->i_buffer,
+    };
+    memcpy( p_record, &payload, sizeof(payload) );
+    if( p_block->i_buffer > 0 )
+        memcpy( &p_record[TS_PAYLOAD_HEADER], p_block->p_buffer, p_block->i_buffer );
+    memset( &p_record[TS_PAYLOAD_HEADER + p_block->i_buffer], 0, TS_PAYLOAD_PADDING );
+
+    p_storage->i_ring_w = i_pos + i_record;
+    *pi_pos = i_pos;
+    return VLC_SUCCESS;
 }
 
-static bool TsStorageIsEmpty( ts_storage_t *p_storage )
+static void TsStorageIndex( ts_storage_t *p_storage, const block_t *p_block,
+                            uint64_t i_cmd, vlc_tick_t i_date )
 {
-    return !p_storage || p_storage->p_cmd_r >= p_storage->p_cmd_w;
+    const ts_index_t *p_index = &p_storage->index;
+
+    if( p_block->i_flags & BLOCK_FLAG_TYPE_I )
+        p_storage->i_keyframe_date = i_date;
+    else if( i_date - p_storage->i_keyframe_date < TS_KEYFRAME_TIMEOUT ||
+             ( p_index->size > 0 &&
+               i_date - p_index->data[p_index->size - 1].i_date < TS_INDEX_INTERVAL ) )
+        return;
+
+    const ts_index_entry_t entry = { .i_cmd = i_cmd, .i_date = i_date };
+    /* Not fatal, there will only be fewer seek points */
+    (void)vlc_vector_push( &p_storage->index, entry );
 }
 
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static int TsStoragePushCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd )
 {
-    assert( !TsStorageIsFull( p_storage, p_cmd ) );
-    ts_cmd_t cmd;
-    memcpy(&cmd, p_cmd, TsStorageSizeofCommand[p_cmd->header.i_type]);
+    if( p_storage->i_cmd_w - p_storage->i_cmd_first == p_storage->i_cmd_alloc &&
+        TsStorageGrow( p_storage ) )
+        goto error;
 
-    if( cmd.header.i_type == C_SEND )
+    if( p_cmd->header.i_type == C_SEND )
     {
-        block_t *p_block = cmd.send.p_block;
+        block_t *p_block = p_cmd->send.p_block;
+        uint64_t i_pos;
 
-        cmd.send.p_block = NULL;
-        cmd.send.i_offset = ftell( p_storage->p_filew );
-
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
-        {
-            block_Release( p_block );
-            return;
-        }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
+        int i_ret = TsStorageWritePayload( p_storage, p_block, &i_pos );
+        if( i_ret == VLC_ENOMEM )
         {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
+            /* The oldest payloads are still held by the decoders */
+            if( !p_storage->b_overflow )
+                msg_Warn( p_storage->p_obj, "timeshift buffer full, "
+                          "dropping data until it is read" );
+            p_storage->b_overflow = true;
+            CmdClean( p_cmd );
+            return VLC_ENOMEM;
         }
-        p_storage->i_file_size += p_block->i_buffer;
-        block_Release( p_block );
+        if( i_ret != VLC_SUCCESS )
+            goto error;
+        p_storage->b_overflow = false;
 
-        if( b_flush )
-            fflush( p_storage->p_filew );
+        TsStorageIndex( p_storage, p_block, p_storage->i_cmd_w, p_cmd->header.i_date );
+        block_Release( p_block );
+        p_cmd->send.i_pos = i_pos;
     }
-    size_t i_cmdsize = TsStorageSizeofCommand[ cmd.header.i_type ];
-    memcpy( p_storage->p_cmd_w, &cmd, i_cmdsize );
-    p_storage->p_cmd_w += i_cmdsize;
+
+    *TsStorageCmd( p_storage, p_storage->i_cmd_w++ ) = *p_cmd;
+
+    TsStorageTrim( p_storage );
+    return VLC_SUCCESS;
+
+error:
+    CmdClean( p_cmd );
+    return VLC_EGENERIC;
 }
 
-static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
+/* Only the data and the clock are fed again when replaying commands */
+static bool CmdIsReplayable( const ts_cmd_t *p_cmd )
 {
-    assert( !TsStorageIsEmpty( p_storage ) );
-
-    p_cmd->header.i_type = p_storage->p_cmd_r[0];
-    size_t i_cmdsize = TsStorageSizeofCommand[ p_cmd->header.i_type ];
-    memcpy(p_cmd, p_storage->p_cmd_r, i_cmdsize);
-    p_storage->p_cmd_r += i_cmdsize;
+    switch( p_cmd->header.i_type )
+    {
+    case C_SEND:
+        return true;
+    case C_CONTROL:
+        return p_cmd->control.i_query == ES_OUT_SET_PCR ||
+               p_cmd->control.i_query == ES_OUT_SET_GROUP_PCR ||
+               p_cmd->control.i_query == ES_OUT_SET_NEXT_DISPLAY_TIME;
+    case C_PRIVCONTROL:
+        return p_cmd->privcontrol.i_query == ES_OUT_PRIV_SET_TIMES;
+    default:
+        return false;
+    }
+}
 
-    if( p_cmd->header.i_type == C_SEND )
+static int TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd )
+{
+    while( p_storage->i_cmd_r < p_storage->i_cmd_w )
     {
-        block_t block;
+        const uint64_t i_cmd = p_storage->i_cmd_r++;
+        const ts_cmd_t *p_stored = TsStorageCmd( p_storage, i_cmd );
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
+        if( i_cmd < p_storage->i_cmd_replay && !CmdIsReplayable( p_stored ) )
+            continue;
+
+        *p_cmd = *p_stored;
+        if( p_cmd->header.i_type == C_SEND )
         {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
+            const uint64_t i_pos = p_stored->send.i_pos;
+
+            /* Overwritten while waiting for too long */
+            if( i_pos < p_storage->i_ring_tail )
             {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+                p_storage->b_lost = true;
+                continue;
+            }
+            if( i_cmd < p_storage->i_cmd_skip )
+                continue;
+
+            block_t *p_block = TsRingView( p_storage->p_ring, i_pos );
+            if( unlikely(p_block == NULL) )
+                continue;
+            if( p_storage->b_lost )
+            {
+                p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+                p_storage->b_lost = false;
             }
             p_cmd->send.p_block = p_block;
         }
-        else
+        else if( p_cmd->header.i_type == C_ADD || p_cmd->header.i_type == C_DEL )
         {
-            //perror( "TsStoragePopCmd" );
-            p_cmd->send.p_block = block_Alloc( 1 );
+            /* Older commands may refer to ES that do not exist anymore */
+            p_storage->i_cmd_history = p_storage->i_cmd_r;
         }
+
+        TsStorageTrim( p_storage );
+        return VLC_SUCCESS;
     }
+    return VLC_EGENERIC;
+}
+
+/* Moves the read position to the last seek point before the given date */
+static int TsStorageSeek( ts_storage_t *p_storage, vlc_tick_t i_date,
+                          vlc_tick_t *pi_date )
+{
+    const ts_index_t *p_index = &p_storage->index;
+    if( p_index->size == 0 )
+        return VLC_EGENERIC;
+
+    size_t i_low = 0, i_high = p_index->size;
+    while( i_high - i_low > 1 )
+    {
+        const size_t i_mid = (i_low + i_high) / 2;
+        if( p_index->data[i_mid].i_date <= i_date )
+            i_low = i_mid;
+        else
+            i_high = i_mid;
+    }
+
+    const ts_index_entry_t *p_entry = &p_index->data[i_low];
+    if( p_entry->i_cmd < p_storage->i_cmd_r )
+    {
+        p_storage->i_cmd_replay = __MAX( p_storage->i_cmd_replay, p_storage->i_cmd_r );
+        p_storage->i_cmd_r = p_entry->i_cmd;
+    }
+    /* Commands up to the seek point are still executed, without the data */
+    p_storage->i_cmd_skip = p_entry->i_cmd;
+    *pi_date = p_entry->i_date;
+
+    TsStorageTrim( p_storage );
+    return VLC_SUCCESS;
+}
+
+/* Returns the reception dates of the oldest seek point, of the newest
+ * command, and of the next command to play */
+static int TsStorageGetWindow( ts_storage_t *p_storage, vlc_tick_t *pi_start,
+                               vlc_tick_t *pi_end, vlc_tick_t *pi_current )
+{
+    if( p_storage->index.size == 0 )
+        return VLC_EGENERIC;
+
+    *pi_end = TsStorageCmd( p_storage, p_storage->i_cmd_w - 1 )->header.i_date;
+    *pi_current = *pi_end;
+    if( p_storage->i_cmd_r < p_storage->i_cmd_w )
+        *pi_current = TsStorageCmd( p_storage, p_storage->i_cmd_r )->header.i_date;
+    *pi_start = __MIN( p_storage->index.data[0].i_date, *pi_current );
+    return VLC_SUCCESS;
 }
 
 /*****************************************************************************
@@ -154,6 +154,15 @@ static inline void input_SendEventCache(input_thread_t *p_input, double f_level)
     });
 }
 
+static inline void input_SendEventTimeshift(input_thread_t *p_input,
+                                            vlc_tick_t length, vlc_tick_t delay)
+{
+    input_SendEvent(p_input, &(struct vlc_input_event) {
+        .type = INPUT_EVENT_TIMESHIFT,
+        .timeshift = { length, delay }
+    });
+}
+
 static inline void input_SendEventMeta(input_thread_t *p_input)
 {
     input_SendEvent(p_input, &(struct vlc_input_event) {
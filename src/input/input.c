@@ -68,6 +68,7 @@ static void             Destroy ( input_thread_t *p_input );
 static  int             Init    ( input_thread_t *p_input );
 static void             End     ( input_thread_t *p_input );
 static void             MainLoop( input_thread_t *p_input, bool b_interactive );
+static void             InitPrograms( input_thread_t *p_input );
 
 static inline int ControlPop( input_thread_t *, int *, input_control_param_t *, vlc_tick_t i_deadline, bool b_postpone_seek );
 static int ControlPopEarly(input_thread_t *input, int *type,
@@ -140,6 +141,17 @@ int input_Start( input_thread_t *p_input )
     return VLC_SUCCESS;
 }
 
+void input_StartPrepared( input_thread_t *p_input )
+{
+    input_thread_private_t *priv = input_priv(p_input);
+
+    vlc_mutex_lock( &priv->lock_control );
+    assert( priv->b_preparing );
+    priv->b_preparing = false;
+    vlc_cond_signal( &priv->wait_control );
+    vlc_mutex_unlock( &priv->lock_control );
+}
+
 /**
  * Request a running input thread to stop and die
  *
@@ -268,8 +280,11 @@ input_thread_t * input_Create( vlc_object_t *p_parent, input_item_t *p_item,
     priv->cbs_data = cfg->cbs_data;
     priv->type = cfg->type;
     priv->preparse_subitems = cfg->preparsing.subitems;
+    priv->b_preparing = priv->b_outputs_deferred = cfg->prepare;
     priv->i_start = 0;
     priv->i_stop  = 0;
+    priv->i_timeshift_length = 0;
+    priv->i_timeshift_delay = 0;
     priv->i_title_offset = input_priv(p_input)->i_seekpoint_offset = 0;
     priv->i_state = INIT_S;
     priv->is_running = false;
@@ -322,7 +337,8 @@ input_thread_t * input_Create( vlc_object_t *p_parent, input_item_t *p_item,
         priv->p_resource = input_resource_Hold( cfg->resource );
     else
         priv->p_resource = input_resource_New( VLC_OBJECT( p_input ) );
-    input_resource_SetInput( priv->p_resource, p_input );
+    if( !priv->b_outputs_deferred )
+        input_resource_SetInput( priv->p_resource, p_input );
 
     /* Init control buffer */
     vlc_mutex_init( &priv->lock_control );
@@ -400,6 +416,28 @@ static void Destroy(input_thread_t *input)
  * This is the "normal" thread that spawns the input processing chain,
  * reads the stream, cleans up and waits
  *****************************************************************************/
+/* Returns false if the input was stopped before being allowed to play */
+static bool WaitPrepared( input_thread_t *p_input )
+{
+    input_thread_private_t *priv = input_priv(p_input);
+
+    vlc_mutex_lock( &priv->lock_control );
+    while( priv->b_preparing && !priv->is_stopped )
+        vlc_cond_wait( &priv->wait_control, &priv->lock_control );
+    const bool b_play = !priv->is_stopped;
+    vlc_mutex_unlock( &priv->lock_control );
+
+    if( b_play && priv->b_outputs_deferred )
+    {
+        /* The previous input has released the outputs, the decoders can be
+         * created and request them */
+        input_resource_SetInput( priv->p_resource, p_input );
+        priv->b_outputs_deferred = false;
+        InitPrograms( p_input );
+    }
+    return b_play;
+}
+
 static void *Run( void *data )
 {
     input_thread_private_t *priv = data;
@@ -411,7 +449,8 @@ static void *Run( void *data )
 
     if( !Init( p_input ) )
     {
-        MainLoop( p_input, true ); /* FIXME it can be wrong (like with VLM) */
+        if( WaitPrepared( p_input ) )
+            MainLoop( p_input, true ); /* FIXME it can be wrong (like with VLM) */
 
         /* Clean up */
         End( p_input );
@@ -596,11 +635,33 @@ static void InputSourceStatistics(input_source_t *source, input_item_t *item,
 /**
  * Update timing infos and statistics.
  */
+static void UpdateTimeshift( input_thread_t *p_input )
+{
+    input_thread_private_t *priv = input_priv(p_input);
+    vlc_tick_t i_start, i_end, i_current;
+    vlc_tick_t i_length = 0, i_delay = 0;
+
+    if( !es_out_GetTimeshiftWindow( priv->p_es_out, &i_start, &i_end,
+                                    &i_current ) )
+    {
+        i_length = i_end - i_start;
+        i_delay = i_end - i_current;
+    }
+
+    if( i_length == priv->i_timeshift_length &&
+        i_delay == priv->i_timeshift_delay )
+        return;
+    priv->i_timeshift_length = i_length;
+    priv->i_timeshift_delay = i_delay;
+    input_SendEventTimeshift( p_input, i_length, i_delay );
+}
+
 static void MainLoopStatistics( input_thread_t *p_input )
 {
     input_thread_private_t *priv = input_priv(p_input);
 
     InputSourceStatistics( priv->master, priv->p_item, priv->p_es_out );
+    UpdateTimeshift( p_input );
 
     for (size_t i = 0; i < priv->i_slave; i++)
     {
@@ -1347,7 +1408,9 @@ static int Init( input_thread_t * p_input )
         StartTitle( p_input );
         SetSubtitlesOptions( p_input );
         LoadSlaves( p_input );
-        InitPrograms( p_input );
+        /* No track is selected while prepared, see WaitPrepared() */
+        if( !priv->b_outputs_deferred )
+            InitPrograms( p_input );
 
         double f_rate = var_GetFloat( p_input, "rate" );
         if( f_rate != 0.0 && f_rate != 1.0 )
@@ -1403,7 +1466,8 @@ error:
         if( input_priv(p_input)->p_sout )
             input_resource_PutSout( input_priv(p_input)->p_resource,
                                     input_priv(p_input)->p_sout );
-        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+        if( !input_priv(p_input)->b_outputs_deferred )
+            input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
         if( input_priv(p_input)->p_resource )
         {
             input_resource_Release( input_priv(p_input)->p_resource );
@@ -1474,7 +1538,8 @@ static void End( input_thread_t * p_input )
     /* */
     input_resource_PutSout( input_priv(p_input)->p_resource,
                             input_priv(p_input)->p_sout );
-    input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+    if( !input_priv(p_input)->b_outputs_deferred )
+        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
     if( input_priv(p_input)->p_resource )
     {
         input_resource_Release( input_priv(p_input)->p_resource );
@@ -2383,6 +2448,27 @@ static bool Control( input_thread_t *p_input,
                                        param.vbi_transparency.enabled );
             break;
 
+        case INPUT_CONTROL_SET_TIMESHIFT:
+        {
+            vlc_tick_t i_start, i_end, i_current;
+            if( es_out_GetTimeshiftWindow( priv->p_es_out, &i_start, &i_end,
+                                           &i_current ) )
+            {
+                msg_Err( p_input, "no timeshift window to seek into" );
+                break;
+            }
+
+            vlc_tick_t i_date = __MAX( i_end - param.time.i_val, i_start );
+            if( es_out_SetTimeshiftDate( priv->p_es_out, i_date ) )
+            {
+                msg_Err( p_input, "timeshift seek failed" );
+                break;
+            }
+            UpdateTimeshift( p_input );
+            b_force_update = true;
+            break;
+        }
+
         case INPUT_CONTROL_NAV_ACTIVATE:
         case INPUT_CONTROL_NAV_UP:
         case INPUT_CONTROL_NAV_DOWN:
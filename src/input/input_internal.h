@@ -153,6 +153,9 @@ typedef enum input_event_type_e
 
     /* Mouse event */
     INPUT_EVENT_MOUSE_LEFT,
+
+    /* The timeshift window or the delay behind live has changed */
+    INPUT_EVENT_TIMESHIFT,
 } input_event_type_e;
 
 #define VLC_INPUT_CAPABILITIES_SEEKABLE (1<<0)
@@ -258,6 +261,11 @@ struct vlc_input_event_signal {
     float strength;
 };
 
+struct vlc_input_event_timeshift {
+    vlc_tick_t length; /* 0 if there is nothing to seek into */
+    vlc_tick_t delay; /* behind the newest received data */
+};
+
 struct vlc_input_event_vout
 {
     enum {
@@ -328,6 +336,8 @@ struct vlc_input_event
         struct vlc_input_event_attachments attachments;
         /* INPUT_EVENT_NAV_FAILED */
         int nav_type;
+        /* INPUT_EVENT_TIMESHIFT */
+        struct vlc_input_event_timeshift timeshift;
     };
 };
 
@@ -355,6 +365,10 @@ struct vlc_input_thread_cfg
         bool subitems;
     } preparsing;
     bool interact;
+    /* Stop before playback: the media is opened and probed, then the input
+     * waits for input_StartPrepared() before selecting tracks, so that no
+     * decoder nor output is created */
+    bool prepare;
 };
 /**
  * Create a new input_thread_t.
@@ -373,6 +387,13 @@ input_thread_t * input_Create( vlc_object_t *p_parent, input_item_t *item,
 
 int input_Start( input_thread_t * );
 
+/**
+ * Let an input created with the prepare flag play
+ *
+ * It must have been started with input_Start() first.
+ */
+void input_StartPrepared( input_thread_t * );
+
 void input_Stop( input_thread_t * );
 
 void input_Close( input_thread_t * );
@@ -469,6 +490,8 @@ typedef struct input_thread_private_t
     int         i_state;
     bool        is_running;
     bool        is_stopped;
+    bool        b_preparing; /* waiting for input_StartPrepared() */
+    bool        b_outputs_deferred; /* prepared, owns no resource nor decoder */
     bool        b_recording;
     float       rate;
 
@@ -476,6 +499,10 @@ typedef struct input_thread_private_t
     vlc_tick_t  i_start;    /* :start-time,0 by default */
     vlc_tick_t  i_stop;     /* :stop-time, 0 if none */
 
+    /* Timeshift window, as last reported */
+    vlc_tick_t  i_timeshift_length;
+    vlc_tick_t  i_timeshift_delay;
+
     /* Delays */
     bool        b_low_delay;
     vlc_tick_t  i_jitter_max;
@@ -587,6 +614,8 @@ enum input_control_e
 
     INPUT_CONTROL_SET_VBI_PAGE,
     INPUT_CONTROL_SET_VBI_TRANSPARENCY,
+
+    INPUT_CONTROL_SET_TIMESHIFT,    // delay behind live, in param.time.i_val
 };
 
 /* Internal helpers */
@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include <vlc_common.h>
+#include <vlc_frame.h>
 #include "input/input_internal.h"
 
 /**
@@ -111,6 +112,12 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+
+    /* Frame cache */
+    struct vlc_frame_cache_stats cache;
+    vlc_frame_cache_GetStats(&cache);
+    st->i_frame_cache_hits = cache.hits;
+    st->i_frame_cache_misses = cache.misses;
 }
 
 /** Update a counter element with new values
@@ -0,0 +1,258 @@
+/*****************************************************************************
+ * timeshift.c: test for the timeshift storage ring
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#undef NDEBUG
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* The storage is private to the timeshift es_out */
+#include "../es_out_timeshift.c"
+
+#include "../../libvlc.h"
+
+const char vlc_module_name[] = "test_timeshift";
+
+/* Only used by the timeshift thread and the stored commands */
+bool input_CanPaceControl(input_thread_t *input)
+{
+    (void) input;
+    return true;
+}
+
+int input_ControlPush(input_thread_t *input, int type,
+                      const input_control_param_t *param)
+{
+    (void) input; (void) type; (void) param;
+    return VLC_SUCCESS;
+}
+
+input_source_t *input_source_Hold(input_source_t *in)
+{
+    return in;
+}
+
+void input_source_Release(input_source_t *in)
+{
+    (void) in;
+}
+
+#define RING_SIZE (64 * 1024)
+
+static es_out_id_t es;
+
+/* Payloads are identified by their dts and filled from it, their sizes
+ * vary so that records do not line up with the end of the ring */
+static size_t PayloadSize(unsigned i)
+{
+    return 500 + (i * 997) % 3000;
+}
+
+static int Push(ts_storage_t *storage, unsigned i, bool keyframe)
+{
+    block_t *block = block_Alloc(PayloadSize(i));
+    assert(block != NULL);
+    memset(block->p_buffer, i & 0xff, block->i_buffer);
+    block->i_dts = block->i_pts = VLC_TICK_0 + i;
+    block->i_length = 1;
+    if (keyframe)
+        block->i_flags |= BLOCK_FLAG_TYPE_I;
+
+    ts_cmd_t cmd;
+    CmdInitSend(&cmd.send, &es, block);
+    return TsStoragePushCmd(storage, &cmd);
+}
+
+/* Returns the payload identifier, or -1 if there is nothing to pop */
+static int Pop(ts_storage_t *storage, block_t **pp_block)
+{
+    ts_cmd_t cmd;
+    if (TsStoragePopCmd(storage, &cmd) != VLC_SUCCESS)
+        return -1;
+    assert(cmd.header.i_type == C_SEND);
+    assert(cmd.send.p_es == &es);
+
+    block_t *block = cmd.send.p_block;
+    assert(block != NULL);
+    const unsigned i = block->i_dts - VLC_TICK_0;
+    assert(block->i_pts == block->i_dts);
+    assert(block->i_buffer == PayloadSize(i));
+    for (size_t j = 0; j < block->i_buffer; j++)
+        assert(block->p_buffer[j] == (i & 0xff));
+    /* Zeroed padding for the decoders */
+    for (size_t j = 0; j < TS_PAYLOAD_PADDING; j++)
+        assert(block->p_buffer[block->i_buffer + j] == 0);
+
+    if (pp_block != NULL)
+        *pp_block = block;
+    else
+        block_Release(block);
+    return i;
+}
+
+/* Payloads read as they arrive survive many turns of the ring */
+static void test_wrap(vlc_object_t *obj)
+{
+    ts_storage_t *storage = TsStorageNew(obj, NULL, RING_SIZE, 0);
+    assert(storage != NULL);
+
+    size_t total = 0;
+    for (unsigned i = 0; total < 8 * RING_SIZE; i++)
+    {
+        assert(Push(storage, i, i % 10 == 0) == VLC_SUCCESS);
+        /* Keep a few payloads queued */
+        if (i < 4)
+            continue;
+
+        block_t *block;
+        const unsigned popped = i - 4;
+        assert(Pop(storage, &block) == (int) popped);
+        assert(!(block->i_flags & BLOCK_FLAG_DISCONTINUITY));
+        assert(!!(block->i_flags & BLOCK_FLAG_TYPE_I) == (popped % 10 == 0));
+        block_Release(block);
+        total += PayloadSize(i);
+    }
+    assert(storage->i_ring_w > 8 * RING_SIZE);
+
+    for (int i = 0; i < 4; i++)
+        assert(Pop(storage, NULL) >= 0);
+    assert(TsStorageIsEmpty(storage));
+    assert(Pop(storage, NULL) == -1);
+
+    TsStorageDelete(storage);
+}
+
+/* Payloads not read in time are overwritten, the next one read flags the
+ * gap */
+static void test_lost(vlc_object_t *obj)
+{
+    ts_storage_t *storage = TsStorageNew(obj, NULL, RING_SIZE, 0);
+    assert(storage != NULL);
+
+    size_t total = 0;
+    unsigned count = 0;
+    for (; total < 2 * RING_SIZE; count++)
+    {
+        assert(Push(storage, count, false) == VLC_SUCCESS);
+        total += PayloadSize(count);
+    }
+
+    block_t *block;
+    int first = Pop(storage, &block);
+    assert(first > 0);
+    assert(block->i_flags & BLOCK_FLAG_DISCONTINUITY);
+    block_Release(block);
+
+    /* The remaining ones are read in order */
+    for (unsigned i = first + 1; i < count; i++)
+    {
+        assert(Pop(storage, &block) == (int) i);
+        assert(!(block->i_flags & BLOCK_FLAG_DISCONTINUITY));
+        block_Release(block);
+    }
+    assert(TsStorageIsEmpty(storage));
+
+    TsStorageDelete(storage);
+}
+
+/* Payloads held by the decoders are never overwritten: new data is dropped
+ * until they are released, and the next payload stored flags the gap */
+static void test_full(vlc_object_t *obj)
+{
+    ts_storage_t *storage = TsStorageNew(obj, NULL, RING_SIZE, 0);
+    assert(storage != NULL);
+
+    assert(Push(storage, 0, true) == VLC_SUCCESS);
+    block_t *held;
+    assert(Pop(storage, &held) == 0);
+
+    unsigned count = 1;
+    int ret;
+    while ((ret = Push(storage, count, false)) == VLC_SUCCESS)
+    {
+        count++;
+        assert(count < RING_SIZE);
+    }
+    assert(ret == VLC_ENOMEM);
+    const unsigned dropped = count;
+    assert(storage->b_overflow);
+    /* Still held, still dropped */
+    assert(Push(storage, dropped + 1, false) == VLC_ENOMEM);
+
+    /* The held payload was not overwritten */
+    assert(held->i_dts == VLC_TICK_0);
+    for (size_t j = 0; j < held->i_buffer; j++)
+        assert(held->p_buffer[j] == 0);
+    block_Release(held);
+
+    const unsigned next = dropped + 2;
+    assert(Push(storage, next, false) == VLC_SUCCESS);
+    assert(!storage->b_overflow);
+
+    /* The payloads stored before are read in order, the ones overwritten
+     * to make room for the next one are skipped */
+    int prev = 0;
+    block_t *block;
+    int i;
+    while ((i = Pop(storage, &block)) >= 0)
+    {
+        assert(i > prev);
+        assert(i < (int) dropped || i == (int) next);
+        if (i == (int) next)
+            assert(block->i_flags & BLOCK_FLAG_DISCONTINUITY);
+        prev = i;
+        block_Release(block);
+    }
+    assert(prev == (int) next);
+
+    TsStorageDelete(storage);
+}
+
+static void LogText(void *opaque, int type, const vlc_log_t *meta,
+                    const char *format, va_list ap)
+{
+    (void)opaque; (void)type; (void)meta;
+
+    flockfile(stderr);
+    vfprintf(stderr, format, ap);
+    putc_unlocked('\n', stderr);
+    funlockfile(stderr);
+}
+
+static const struct vlc_logger_operations test_logger_operations = {
+    .log = LogText,
+};
+
+int main(void)
+{
+    struct vlc_logger logger = { .ops = &test_logger_operations };
+    libvlc_priv_t *libvlc = (vlc_object_create)(NULL, sizeof(*libvlc));
+    assert(libvlc != NULL);
+    vlc_object_t *root = &libvlc->public_data.obj;
+    root->logger = &logger;
+
+    test_wrap(root);
+    test_lost(root);
+    test_full(root);
+
+    vlc_object_delete(root);
+    return 0;
+}
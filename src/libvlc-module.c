@@ -732,6 +732,12 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_RATE_LONGTEXT N_( \
     "This defines the playback speed (nominal speed is 1.0)." )
 
+#define INPUT_KEYFRAMES_RATE_TEXT N_("Keyframes only speed")
+#define INPUT_KEYFRAMES_RATE_LONGTEXT N_( \
+    "From this playback speed, only the keyframes of the video are decoded " \
+    "and displayed. This keeps fast forward smooth on streams that are too " \
+    "costly to decode entirely (0 to always decode every frame)." )
+
 #define INPUT_LIST_TEXT N_("Input list")
 #define INPUT_LIST_LONGTEXT N_( \
     "You can give a comma-separated list " \
@@ -783,10 +789,15 @@ static const char* const ppsz_restore_playback_desc[] = {
 #define INPUT_TIMESHIFT_PATH_LONGTEXT N_( \
     "Directory used to store the timeshift temporary files." )
 
-#define INPUT_TIMESHIFT_GRANULARITY_TEXT N_("Timeshift granularity")
-#define INPUT_TIMESHIFT_GRANULARITY_LONGTEXT N_( \
-    "This is the maximum size in bytes of the temporary files " \
-    "that will be used to store the timeshifted streams." )
+#define INPUT_TIMESHIFT_SIZE_TEXT N_("Timeshift buffer size")
+#define INPUT_TIMESHIFT_SIZE_LONGTEXT N_( \
+    "This is the size in bytes of the temporary file that will be " \
+    "used as a ring buffer to store the timeshifted streams." )
+
+#define INPUT_TIMESHIFT_WINDOW_TEXT N_("Timeshift window")
+#define INPUT_TIMESHIFT_WINDOW_LONGTEXT N_( \
+    "Duration in seconds of already played content kept in the " \
+    "timeshift buffer, so that it can be seeked back to (0 keeps nothing)." )
 
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
@@ -937,6 +948,13 @@ static const char* const ppsz_restore_playback_desc[] = {
     "However allocation of port numbers below 1025 is usually restricted " \
     "by the operating system." )
 
+#define HTTP_THREADS_TEXT N_( "HTTP server threads" )
+#define HTTP_THREADS_LONGTEXT N_( \
+    "Number of threads serving the HTTP and HTTPS server connections. " \
+    "Connections are spread among them, and requests for distinct URLs are " \
+    "then handled concurrently. The default, a single thread, serves all " \
+    "clients in turn, as before: set more threads to serve many clients." )
+
 #define HTTPS_PORT_TEXT N_( "HTTPS server port" )
 #define HTTPS_PORT_LONGTEXT N_( \
     "The HTTPS server will listen on this TCP port. " \
@@ -1135,6 +1153,14 @@ static const char* const ppsz_restore_playback_desc[] = {
     "Scan plugin directories for new plugins at startup. " \
     "This increases the startup time of VLC.")
 
+#define FRAME_CACHE_TEXT N_("Cache data frames")
+#define FRAME_CACHE_LONGTEXT N_( \
+    "Recycle small and medium data buffers instead of returning them to " \
+    "the system allocator. This reduces allocator contention between the " \
+    "input, decoder and stream output threads at the cost of some memory. " \
+    "The cache is shared by the whole process: it is used as long as one " \
+    "instance enables it." )
+
 #define KEYSTORE_TEXT N_("Preferred keystore list")
 #define KEYSTORE_LONGTEXT N_( \
     "List of keystores that VLC will use in priority." )
@@ -1216,6 +1242,13 @@ static const char *const clock_sources_text[] = {
 #define PREPARSE_TIMEOUT_LONGTEXT N_( \
     "Maximum time allowed to preparse an item, in milliseconds" )
 
+#define PREPARSE_CACHE_TEXT N_( "Preparsing cache" )
+#define PREPARSE_CACHE_LONGTEXT N_( \
+    "Keep the results of preparsing local files, and reuse them as long as " \
+    "the size and modification time of the files do not change. Files " \
+    "with attachments are always parsed again. The oldest results are " \
+    "discarded once the cache grows above 32 MiB." )
+
 #define PREPARSE_THREADS_TEXT N_( "Preparsing threads" )
 #define PREPARSE_THREADS_LONGTEXT N_( \
     "Maximum number of threads used to preparse items" )
@@ -1284,6 +1317,14 @@ static const char *const psz_recursive_list_text[] = {
 #define SP_LONGTEXT N_( \
     "Pause each item in the playlist on the first frame." )
 
+#define PREPARE_NEXT_TEXT N_("Open the next item ahead (ms)")
+#define PREPARE_NEXT_LONGTEXT N_( \
+    "Open and probe the next playlist item this long before the end of " \
+    "the current one, to shorten the transition. Its decoders are only " \
+    "created once the current item has ended, and reuse the same audio " \
+    "and video outputs, so the transition is shorter but not gapless. " \
+    "0 disables it." )
+
 #define AUTOSTART_TEXT N_( "Auto start" )
 #define AUTOSTART_LONGTEXT N_( "Automatically start playing the playlist " \
                 "content once it's loaded." )
@@ -1909,6 +1950,10 @@ vlc_module_begin ()
         change_safe ()
     add_float( "rate", 1.,
                INPUT_RATE_TEXT, INPUT_RATE_LONGTEXT )
+    add_float( "keyframes-rate", 8.,
+               INPUT_KEYFRAMES_RATE_TEXT, INPUT_KEYFRAMES_RATE_LONGTEXT )
+        change_float_range( 0., INPUT_RATE_MAX )
+        change_safe ()
 
     add_string( "input-list", NULL,
                  INPUT_LIST_TEXT, INPUT_LIST_LONGTEXT )
@@ -1945,6 +1990,9 @@ vlc_module_begin ()
         change_integer_range( 1, 65535 )
     add_integer( "https-port", 8443, HTTPS_PORT_TEXT, HTTPS_PORT_LONGTEXT )
         change_integer_range( 1, 65535 )
+    add_integer( "http-threads", 1, HTTP_THREADS_TEXT,
+                 HTTP_THREADS_LONGTEXT )
+        change_integer_range( 1, 64 )
     add_string( "rtsp-host", NULL, RTSP_HOST_TEXT, RTSP_HOST_LONGTEXT )
     add_integer( "rtsp-port", 554, RTSP_PORT_TEXT, RTSP_PORT_LONGTEXT )
         change_integer_range( 1, 65535 )
@@ -2036,8 +2084,12 @@ vlc_module_begin ()
 
     add_directory("input-timeshift-path", NULL,
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
-    add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
-                 INPUT_TIMESHIFT_GRANULARITY_LONGTEXT )
+    add_obsolete_integer( "input-timeshift-granularity" ) /* since 4.0.0 */
+    add_integer( "input-timeshift-size", -1, INPUT_TIMESHIFT_SIZE_TEXT,
+                 INPUT_TIMESHIFT_SIZE_LONGTEXT )
+    add_integer( "input-timeshift-window", 0, INPUT_TIMESHIFT_WINDOW_TEXT,
+                 INPUT_TIMESHIFT_WINDOW_LONGTEXT )
+        change_integer_range( 0, 24 * 3600 )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT )
 
@@ -2127,6 +2179,8 @@ vlc_module_begin ()
 
     set_section( N_("Performance options"), NULL )
 
+    add_bool( "frame-cache", false, FRAME_CACHE_TEXT, FRAME_CACHE_LONGTEXT )
+
 #if defined (LIBVLC_USE_PTHREAD)
     add_obsolete_bool( "rt-priority" ) /* since 4.0.0 */
     add_obsolete_integer( "rt-offset" ) /* since 4.0.0 */
@@ -2164,6 +2218,8 @@ vlc_module_begin ()
     add_bool( "play-and-pause", false, PAP_TEXT, PAP_LONGTEXT )
         change_safe()
     add_bool( "start-paused", false, SP_TEXT, SP_LONGTEXT )
+    add_integer( "prepare-next", 0, PREPARE_NEXT_TEXT, PREPARE_NEXT_LONGTEXT )
+        change_integer_range( 0, 60000 )
     add_bool( "playlist-autostart", true,
               AUTOSTART_TEXT, AUTOSTART_LONGTEXT )
     add_bool( "playlist-cork", true, CORK_TEXT, CORK_LONGTEXT )
@@ -2195,6 +2251,9 @@ vlc_module_begin ()
     add_integer( "preparse-threads", 1, PREPARSE_THREADS_TEXT,
                  PREPARSE_THREADS_LONGTEXT )
 
+    add_bool( "preparse-cache", false, PREPARSE_CACHE_TEXT,
+              PREPARSE_CACHE_LONGTEXT )
+
     add_integer( "fetch-art-threads", 1, FETCH_ART_THREADS_TEXT,
                  FETCH_ART_THREADS_LONGTEXT )
 
@@ -96,6 +96,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv->main_playlist = NULL;
     priv->p_vlm = NULL;
     priv->media_source_provider = NULL;
+    priv->frame_cache = false;
 
     vlc_ExitInit( &priv->exit );
 
@@ -182,6 +183,11 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
 
     vlc_LogInit(p_libvlc);
 
+    /* The cache is shared by all the instances of the process */
+    priv->frame_cache = var_InheritBool(p_libvlc, "frame-cache");
+    if (priv->frame_cache)
+        vlc_frame_cache_Hold();
+
     char *tracer_name = var_InheritString(p_libvlc, "tracer");
     priv->tracer = vlc_tracer_Create(VLC_OBJECT(p_libvlc), tracer_name);
     free(tracer_name);
@@ -383,6 +389,8 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     vlc_LogDestroy(p_libvlc->obj.logger);
     if (priv->tracer != NULL)
         vlc_tracer_Destroy(priv->tracer);
+    if (priv->frame_cache)
+        vlc_frame_cache_Release();
     /* Free module bank. It is refcounted, so we call this each time  */
     module_EndBank (true);
 #if defined(_WIN32) || defined(__OS2__)
@@ -62,6 +62,12 @@ typedef struct vlc_tracer vlc_tracer_t;
 int vlc_LogPreinit(libvlc_int_t *) VLC_USED;
 void vlc_LogInit(libvlc_int_t *);
 
+/*
+ * Frames
+ */
+void vlc_frame_cache_Hold(void);
+void vlc_frame_cache_Release(void);
+
 /*
  * LibVLC exit event handling
  */
@@ -187,6 +193,7 @@ typedef struct libvlc_priv_t
     vlc_actions_t *actions; ///< Hotkeys handler
     struct vlc_medialibrary_t *p_media_library; ///< Media library instance
     struct vlc_tracer *tracer; ///< Tracer callbacks
+    bool frame_cache; ///< Whether the frame cache is held
 
     /* Exit callback */
     vlc_exit_t       exit;
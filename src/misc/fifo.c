@@ -40,6 +40,7 @@ struct vlc_fifo_t
     vlc_queue_t         q;
     size_t              i_depth;
     size_t              i_size;
+    bool                single_consumer;
 };
 
 static_assert (offsetof (block_fifo_t, q) == 0, "Problems in <vlc_block.h>");
@@ -61,6 +62,24 @@ size_t vlc_fifo_GetBytes(const block_fifo_t *fifo)
     return fifo->i_size;
 }
 
+/**
+ * Appends a block chain without signaling the queue.
+ *
+ * This is vlc_queue_EnqueueUnlocked() minus the wake-up.
+ */
+static void vlc_fifo_Append(block_fifo_t *fifo, block_t *block)
+{
+    vlc_queue_t *q = &fifo->q;
+    block_t **lastp = &block->p_next;
+
+    assert(block != NULL);
+    while (*lastp != NULL)
+        lastp = &(*lastp)->p_next;
+
+    memcpy(q->lastp, &block, sizeof (block));
+    q->lastp = (struct vlc_queue_entry **)lastp;
+}
+
 void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
 {
     for (block_t *b = block; b != NULL; b = b->p_next) {
@@ -68,7 +87,23 @@ void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
         fifo->i_size += b->i_buffer;
     }
 
-    vlc_queue_EnqueueUnlocked(&fifo->q, block);
+    if (!fifo->single_consumer)
+    {
+        vlc_queue_EnqueueUnlocked(&fifo->q, block);
+        return;
+    }
+
+    vlc_mutex_assert(&fifo->q.lock);
+    if (block == NULL)
+        return;
+
+    /* The only consumer cannot be waiting for data if some was pending
+     * already: only wake it up on the empty to non-empty transition. */
+    bool was_empty = vlc_queue_IsEmpty(&fifo->q);
+
+    vlc_fifo_Append(fifo, block);
+    if (was_empty)
+        vlc_queue_Signal(&fifo->q);
 }
 
 block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
@@ -92,7 +127,7 @@ block_t *vlc_fifo_DequeueAllUnlocked(block_fifo_t *fifo)
     return vlc_queue_DequeueAllUnlocked(&fifo->q);
 }
 
-block_fifo_t *vlc_fifo_New( void )
+static block_fifo_t *vlc_fifo_Create(bool single_consumer)
 {
     block_fifo_t *p_fifo = malloc( sizeof( block_fifo_t ) );
 
@@ -100,11 +135,22 @@ block_fifo_t *vlc_fifo_New( void )
         vlc_queue_Init(&p_fifo->q, offsetof (block_t, p_next));
         p_fifo->i_depth = 0;
         p_fifo->i_size = 0;
+        p_fifo->single_consumer = single_consumer;
     }
 
     return p_fifo;
 }
 
+block_fifo_t *vlc_fifo_New( void )
+{
+    return vlc_fifo_Create(false);
+}
+
+block_fifo_t *vlc_fifo_NewSingleConsumer( void )
+{
+    return vlc_fifo_Create(true);
+}
+
 void vlc_fifo_Delete( block_fifo_t *p_fifo )
 {
     vlc_fifo_Empty(p_fifo);
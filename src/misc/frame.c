@@ -40,6 +40,7 @@
 #include <vlc_fs.h>
 
 #include <vlc_ancillary.h>
+#include "../libvlc.h"
 
 #ifndef NDEBUG
 static void vlc_frame_Check (vlc_frame_t *frame)
@@ -116,6 +117,313 @@ vlc_frame_t *vlc_frame_Init(vlc_frame_t *restrict f, const struct vlc_frame_call
 # define VLC_FRAME_PADDING      32 /* Avoid <= 32 bytes reallocs */
 #endif
 
+/*
+ * Frame cache
+ *
+ * Small and medium frames are recycled through size classes instead of going
+ * back to the heap allocator on every release. Each thread keeps a short free
+ * list per class; overflows and refills move half a list at once to and from
+ * a bounded global list, so that frames released by a different thread than
+ * the one that allocated them are still recycled.
+ */
+static const struct
+{
+    size_t size; /**< largest payload served by the class */
+    unsigned local_max; /**< frames kept by each thread */
+    unsigned global_max; /**< frames kept in the shared list */
+} vlc_frame_classes[] = {
+    {   256, 64, 1024 }, /* TS packets, small ES packets */
+    {  1536, 32,  512 }, /* UDP/RTP datagrams */
+    {  4096, 16,  256 },
+    { 16384,  8,   64 },
+    { 65536,  4,   32 }, /* PES, compressed video frames */
+};
+
+#define VLC_FRAME_CLASSES ARRAY_SIZE(vlc_frame_classes)
+
+struct vlc_frame_cached
+{
+    vlc_frame_t self;
+    unsigned class;
+};
+
+struct vlc_frame_list
+{
+    vlc_frame_t *first;
+    unsigned count;
+};
+
+struct vlc_frame_tcache
+{
+    struct vlc_frame_list lists[VLC_FRAME_CLASSES];
+    uint64_t hits;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct vlc_frame_list lists[VLC_FRAME_CLASSES];
+    struct vlc_frame_cache_stats stats;
+} vlc_frame_cache = { .lock = VLC_STATIC_MUTEX };
+
+static atomic_uint vlc_frame_cache_users = 0;
+static vlc_once_t vlc_frame_cache_once = VLC_STATIC_ONCE;
+static vlc_threadvar_t vlc_frame_cache_key;
+static bool vlc_frame_cache_usable;
+
+static void vlc_frame_cached_Free(vlc_frame_t *frame)
+{
+    struct vlc_frame_cached *cf =
+        container_of(frame, struct vlc_frame_cached, self);
+
+    free(frame->p_start);
+    free(cf);
+}
+
+/** Moves up to count frames from src to dst. */
+static void vlc_frame_list_Move(struct vlc_frame_list *restrict dst,
+                                struct vlc_frame_list *restrict src,
+                                unsigned count)
+{
+    while (count > 0 && src->first != NULL)
+    {
+        vlc_frame_t *frame = src->first;
+
+        src->first = frame->p_next;
+        src->count--;
+        frame->p_next = dst->first;
+        dst->first = frame;
+        dst->count++;
+        count--;
+    }
+}
+
+/** Hands frames of a thread list over to the shared list. */
+static void vlc_frame_cache_Spill(struct vlc_frame_tcache *tc, unsigned class,
+                                  unsigned count)
+{
+    struct vlc_frame_list *local = &tc->lists[class];
+    struct vlc_frame_list *global = &vlc_frame_cache.lists[class];
+    struct vlc_frame_list dropped = { NULL, 0 };
+
+    vlc_mutex_lock(&vlc_frame_cache.lock);
+    unsigned room = vlc_frame_classes[class].global_max - global->count;
+    if (room > count)
+        room = count;
+    vlc_frame_list_Move(global, local, room);
+    vlc_frame_list_Move(&dropped, local, count - room);
+    vlc_frame_cache.stats.recycled += room;
+    vlc_frame_cache.stats.dropped += dropped.count;
+    vlc_frame_cache.stats.hits += tc->hits;
+    tc->hits = 0;
+    vlc_mutex_unlock(&vlc_frame_cache.lock);
+
+    while (dropped.first != NULL)
+    {
+        vlc_frame_t *frame = dropped.first;
+
+        dropped.first = frame->p_next;
+        vlc_frame_cached_Free(frame);
+    }
+}
+
+static void vlc_frame_tcache_Destroy(void *data)
+{
+    struct vlc_frame_tcache *tc = data;
+
+    for (unsigned i = 0; i < VLC_FRAME_CLASSES; i++)
+        vlc_frame_cache_Spill(tc, i, tc->lists[i].count);
+    free(tc);
+}
+
+static void vlc_frame_cache_Init(void *data)
+{
+    (void) data;
+    vlc_frame_cache_usable =
+        vlc_threadvar_create(&vlc_frame_cache_key,
+                             vlc_frame_tcache_Destroy) == 0;
+}
+
+static struct vlc_frame_tcache *vlc_frame_tcache_Get(void)
+{
+    vlc_once(&vlc_frame_cache_once, vlc_frame_cache_Init, NULL);
+    if (unlikely(!vlc_frame_cache_usable))
+        return NULL;
+
+    struct vlc_frame_tcache *tc = vlc_threadvar_get(vlc_frame_cache_key);
+    if (tc == NULL)
+    {
+        tc = calloc(1, sizeof (*tc));
+        if (unlikely(tc == NULL))
+            return NULL;
+        if (unlikely(vlc_threadvar_set(vlc_frame_cache_key, tc)))
+        {
+            free(tc);
+            return NULL;
+        }
+    }
+    return tc;
+}
+
+static bool vlc_frame_cache_IsEnabled(void)
+{
+    return atomic_load_explicit(&vlc_frame_cache_users,
+                                memory_order_relaxed) != 0;
+}
+
+static void vlc_frame_cached_Release(vlc_frame_t *frame)
+{
+    struct vlc_frame_cached *cf =
+        container_of(frame, struct vlc_frame_cached, self);
+    struct vlc_frame_tcache *tc = NULL;
+
+    if (vlc_frame_cache_IsEnabled())
+        tc = vlc_frame_tcache_Get();
+    if (tc == NULL)
+    {
+        vlc_frame_cached_Free(frame);
+        return;
+    }
+
+    unsigned class = cf->class;
+    struct vlc_frame_list *local = &tc->lists[class];
+    unsigned max = vlc_frame_classes[class].local_max;
+
+    if (local->count >= max)
+        vlc_frame_cache_Spill(tc, class, max / 2);
+
+    frame->p_next = local->first;
+    local->first = frame;
+    local->count++;
+}
+
+static const struct vlc_frame_callbacks vlc_frame_cached_cbs =
+{
+    vlc_frame_cached_Release,
+};
+
+static vlc_frame_t *vlc_frame_cached_New(unsigned class)
+{
+    struct vlc_frame_cached *cf = malloc(sizeof (*cf));
+    if (unlikely(cf == NULL))
+        return NULL;
+
+    /* Class sizes are multiples of the alignment */
+    size_t capacity = (2 * VLC_FRAME_PADDING) + vlc_frame_classes[class].size;
+    unsigned char *buf;
+#ifdef HAVE_ALIGNED_ALLOC
+    buf = aligned_alloc(VLC_FRAME_ALIGN, capacity);
+#else
+    capacity += VLC_FRAME_ALIGN;
+    buf = malloc(capacity);
+#endif
+    if (unlikely(buf == NULL))
+    {
+        free(cf);
+        return NULL;
+    }
+
+    cf->class = class;
+    return vlc_frame_Init(&cf->self, &vlc_frame_cached_cbs, buf, capacity);
+}
+
+/**
+ * Takes a frame out of the cache, or allocates one for the cache.
+ *
+ * @return a frame, or NULL if the size is not cacheable or on error
+ */
+static vlc_frame_t *vlc_frame_cache_Alloc(size_t size)
+{
+    unsigned class = 0;
+
+    while (vlc_frame_classes[class].size < size)
+        if (++class >= VLC_FRAME_CLASSES)
+            return NULL;
+
+    struct vlc_frame_tcache *tc = vlc_frame_tcache_Get();
+    if (unlikely(tc == NULL))
+        return NULL;
+
+    struct vlc_frame_list *local = &tc->lists[class];
+
+    if (local->first == NULL)
+    {
+        vlc_mutex_lock(&vlc_frame_cache.lock);
+        vlc_frame_list_Move(local, &vlc_frame_cache.lists[class],
+                            vlc_frame_classes[class].local_max / 2);
+        if (local->first == NULL)
+            vlc_frame_cache.stats.misses++;
+        vlc_frame_cache.stats.hits += tc->hits;
+        tc->hits = 0;
+        vlc_mutex_unlock(&vlc_frame_cache.lock);
+    }
+
+    vlc_frame_t *frame = local->first;
+    if (frame != NULL)
+    {
+        local->first = frame->p_next;
+        local->count--;
+        tc->hits++;
+        vlc_frame_Init(frame, &vlc_frame_cached_cbs, frame->p_start,
+                       frame->i_size);
+    }
+    else
+    {
+        frame = vlc_frame_cached_New(class);
+        if (unlikely(frame == NULL))
+            return NULL;
+    }
+
+    unsigned char *buf = frame->p_start;
+#ifndef HAVE_ALIGNED_ALLOC
+    /* Alignment */
+    buf += (-(uintptr_t)(void *)buf) % (uintptr_t)VLC_FRAME_ALIGN;
+#endif
+    /* Header reserve */
+    frame->p_buffer = buf + VLC_FRAME_PADDING;
+    frame->i_buffer = size;
+    return frame;
+}
+
+void vlc_frame_cache_Hold(void)
+{
+    atomic_fetch_add_explicit(&vlc_frame_cache_users, 1, memory_order_relaxed);
+}
+
+void vlc_frame_cache_Release(void)
+{
+    unsigned users = atomic_fetch_sub_explicit(&vlc_frame_cache_users, 1,
+                                               memory_order_relaxed);
+    assert(users > 0);
+    if (users > 1)
+        return;
+
+    /* The shared lists are freed with the last user. Frames that are still
+     * in thread lists are freed when their thread exits. */
+    struct vlc_frame_list dropped = { NULL, 0 };
+
+    vlc_mutex_lock(&vlc_frame_cache.lock);
+    for (unsigned i = 0; i < VLC_FRAME_CLASSES; i++)
+        vlc_frame_list_Move(&dropped, &vlc_frame_cache.lists[i],
+                            vlc_frame_cache.lists[i].count);
+    vlc_mutex_unlock(&vlc_frame_cache.lock);
+
+    while (dropped.first != NULL)
+    {
+        vlc_frame_t *frame = dropped.first;
+
+        dropped.first = frame->p_next;
+        vlc_frame_cached_Free(frame);
+    }
+}
+
+void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *stats)
+{
+    vlc_mutex_lock(&vlc_frame_cache.lock);
+    *stats = vlc_frame_cache.stats;
+    vlc_mutex_unlock(&vlc_frame_cache.lock);
+}
+
 vlc_frame_t *vlc_frame_Alloc (size_t size)
 {
     if (unlikely(size >> 28))
@@ -127,6 +435,13 @@ vlc_frame_t *vlc_frame_Alloc (size_t size)
     static_assert ((VLC_FRAME_PADDING % VLC_FRAME_ALIGN) == 0,
                    "VLC_FRAME_PADDING must be a multiple of VLC_FRAME_ALIGN");
 
+    if (vlc_frame_cache_IsEnabled())
+    {
+        vlc_frame_t *f = vlc_frame_cache_Alloc(size);
+        if (f != NULL)
+            return f;
+    }
+
     /* 2 * VLC_FRAME_PADDING: pre + post padding */
     size_t capacity = (2 * VLC_FRAME_PADDING) + size;
     unsigned char *buf;
@@ -166,6 +481,106 @@ void vlc_frame_Release(vlc_frame_t *frame)
     frame->cbs->free(frame);
 }
 
+struct vlc_frame_payload
+{
+    vlc_atomic_rc_t rc;
+    vlc_frame_t *owner; /**< frame owning the buffer */
+};
+
+struct vlc_frame_shared
+{
+    vlc_frame_t self;
+    struct vlc_frame_payload *payload;
+};
+
+static void vlc_frame_shared_Release(vlc_frame_t *frame)
+{
+    struct vlc_frame_shared *sf = container_of(frame, struct vlc_frame_shared,
+                                               self);
+    struct vlc_frame_payload *payload = sf->payload;
+
+    if (vlc_atomic_rc_dec(&payload->rc))
+    {
+        vlc_frame_Release(payload->owner);
+        free(payload);
+    }
+    free(sf);
+}
+
+static const struct vlc_frame_callbacks vlc_frame_shared_cbs =
+{
+    vlc_frame_shared_Release,
+};
+
+static vlc_frame_t *vlc_frame_shared_New(struct vlc_frame_payload *payload,
+                                         const vlc_frame_t *src)
+{
+    struct vlc_frame_shared *sf = malloc(sizeof (*sf));
+    if (unlikely(sf == NULL))
+        return NULL;
+
+    sf->payload = payload;
+
+    vlc_frame_t *frame = &sf->self;
+    vlc_frame_Init(frame, &vlc_frame_shared_cbs, src->p_start, src->i_size);
+    frame->p_buffer = src->p_buffer;
+    frame->i_buffer = src->i_buffer;
+    vlc_frame_CopyProperties(frame, src);
+    return frame;
+}
+
+bool vlc_frame_IsShared(const vlc_frame_t *frame)
+{
+    if (frame->cbs != &vlc_frame_shared_cbs)
+        return false;
+
+    const struct vlc_frame_shared *sf =
+        container_of(frame, const struct vlc_frame_shared, self);
+    return vlc_atomic_rc_get(&sf->payload->rc) > 1;
+}
+
+vlc_frame_t *vlc_frame_Shareable(vlc_frame_t *frame)
+{
+    if (frame->cbs == &vlc_frame_shared_cbs)
+        return frame;
+
+    struct vlc_frame_payload *payload = malloc(sizeof (*payload));
+    if (unlikely(payload == NULL))
+    {
+        vlc_frame_Release(frame);
+        return NULL;
+    }
+    vlc_atomic_rc_init(&payload->rc);
+    payload->owner = frame;
+
+    vlc_frame_t *shared = vlc_frame_shared_New(payload, frame);
+    if (unlikely(shared == NULL))
+    {
+        vlc_frame_Release(frame);
+        free(payload);
+        return NULL;
+    }
+
+    shared->p_next = frame->p_next;
+    frame->p_next = NULL;
+    return shared;
+}
+
+vlc_frame_t *vlc_frame_Share(const vlc_frame_t *frame)
+{
+    assert(frame->cbs == &vlc_frame_shared_cbs);
+
+    const struct vlc_frame_shared *sf =
+        container_of(frame, const struct vlc_frame_shared, self);
+
+    vlc_atomic_rc_inc(&sf->payload->rc);
+
+    vlc_frame_t *shared = vlc_frame_shared_New(sf->payload, frame);
+    if (unlikely(shared == NULL))
+        vlc_atomic_rc_dec(&sf->payload->rc); /* cannot be the last one */
+    return shared;
+}
+
 static vlc_frame_t *vlc_frame_ReallocDup( vlc_frame_t *frame, ssize_t i_prebody, size_t requested )
 {
     vlc_frame_t *p_rea = vlc_frame_Alloc( requested );
@@ -216,6 +631,17 @@ vlc_frame_t *vlc_frame_TryRealloc (vlc_frame_t *frame, ssize_t i_prebody, size_t
 
     size_t requested = i_prebody + i_body;
 
+    /* Shared payloads are read-only: copy on growth */
+    if( unlikely(vlc_frame_IsShared( frame )) )
+    {
+        if( i_prebody == 0 && i_body <= frame->i_buffer )
+        {
+            frame->i_buffer = i_body;
+            return frame;
+        }
+        return vlc_frame_ReallocDup( frame, i_prebody, requested );
+    }
+
     if( frame->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
         if( requested <= frame->i_size )
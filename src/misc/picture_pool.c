@@ -35,19 +35,23 @@
 #include <vlc_threads.h>
 #include <vlc_picture_pool.h>
 #include <vlc_atomic.h>
-#include <vlc_list.h>
 #include "picture.h"
 
 #define POOL_MAX 256
 
+#define POOL_WORD_BITS (sizeof (unsigned long long) * CHAR_BIT)
+#define POOL_WORDS ((POOL_MAX + POOL_WORD_BITS - 1) / POOL_WORD_BITS)
+
 struct picture_pool_t {
+    /* Only used to park picture_pool_Wait() callers */
     vlc_mutex_t lock;
     vlc_cond_t  wait;
+    atomic_uint waiters;
 
     vlc_atomic_rc_t    refs;
-    bool released;
-    struct vlc_list inuse_list;
-    struct vlc_list available_list;
+    unsigned picture_count;
+    atomic_ullong available[POOL_WORDS]; /* bitmap of available pictures */
+    picture_t *picture[];
 };
 
 static void picture_pool_Destroy(picture_pool_t *pool)
@@ -55,33 +59,40 @@ static void picture_pool_Destroy(picture_pool_t *pool)
     if (!vlc_atomic_rc_dec(&pool->refs))
         return;
 
-    assert(vlc_list_is_empty(&pool->inuse_list));
-    assert(vlc_list_is_empty(&pool->available_list));
-
+    assert(atomic_load_explicit(&pool->waiters, memory_order_relaxed) == 0);
     free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
+    /* In-use pictures are kept alive by their clones. Their availability
+     * bits may still be set when the clones are released, but nothing
+     * can take them from the pool anymore. */
+    for (unsigned i = 0; i < pool->picture_count; i++)
+        picture_Release(pool->picture[i]);
+    picture_pool_Destroy(pool);
+}
 
-    /* Release pictures from both available and in-use lists */
-    for (size_t i = 0; i < 2; ++i)
-    {
-        struct vlc_list *list = i == 0 ? &pool->available_list : &pool->inuse_list;
+/**
+ * Marks a picture as available again and wakes up a waiter if any.
+ */
+static void picture_pool_PutBack(picture_pool_t *pool, unsigned index)
+{
+    unsigned long long bit = 1ULL << (index % POOL_WORD_BITS);
 
-        picture_priv_t *priv;
-        vlc_list_foreach(priv, list, pool_node)
-        {
-            assert(priv->pool == pool);
-            vlc_list_remove(&priv->pool_node);
-            picture_Release(&priv->picture);
-        }
+    /* Sequentially consistent with the waiters count in picture_pool_Wait():
+     * either the waiter sees the picture, or this sees the waiter. */
+    unsigned long long prev =
+        atomic_fetch_or(&pool->available[index / POOL_WORD_BITS], bit);
+    assert(!(prev & bit));
+    (void) prev;
+
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
     }
-    /* Prevent in-use cloned pictures to be added back to lists */
-    pool->released = true;
-    vlc_mutex_unlock(&pool->lock);
-    picture_pool_Destroy(pool);
 }
 
 static void picture_pool_ReleaseClone(picture_t *clone)
@@ -95,16 +106,7 @@ static void picture_pool_ReleaseClone(picture_t *clone)
     picture_pool_t *pool = original_priv->pool;
     assert(pool != NULL);
 
-    vlc_mutex_lock(&pool->lock);
-
-    if (!pool->released)
-    {
-        vlc_list_remove(&original_priv->pool_node);
-        vlc_list_append(&original_priv->pool_node, &pool->available_list);
-        vlc_cond_signal(&pool->wait);
-    }
-
-    vlc_mutex_unlock(&pool->lock);
+    picture_pool_PutBack(pool, original_priv->pool_index);
 
     picture_Release(original);
 
@@ -119,6 +121,9 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
     if (clone != NULL) {
         assert(!picture_HasChainedPics(clone));
         vlc_atomic_rc_inc(&pool->refs);
+    } else {
+        picture_priv_t *priv = container_of(picture, picture_priv_t, picture);
+        picture_pool_PutBack(pool, priv->pool_index);
     }
     return clone;
 }
@@ -126,26 +131,34 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
 static void picture_pool_AppendPic(picture_pool_t *pool, picture_t *pic)
 {
     picture_priv_t *priv = container_of(pic, picture_priv_t, picture);
+    unsigned index = pool->picture_count++;
+
     assert(priv->pool == NULL);
-    vlc_list_append(&priv->pool_node, &pool->available_list);
+    assert(index < POOL_MAX);
     priv->pool = pool;
+    priv->pool_index = index;
+    pool->picture[index] = pic;
+    atomic_fetch_or_explicit(&pool->available[index / POOL_WORD_BITS],
+                             1ULL << (index % POOL_WORD_BITS),
+                             memory_order_relaxed);
 }
 
 static picture_pool_t *
-picture_pool_NewCommon(void)
+picture_pool_NewCommon(unsigned count)
 {
-    picture_pool_t *pool = malloc(sizeof(*pool));
+    picture_pool_t *pool = malloc(sizeof (*pool)
+                                  + count * sizeof (pool->picture[0]));
 
     if (unlikely(pool == NULL))
         return NULL;
 
-    vlc_list_init(&pool->inuse_list);
-    vlc_list_init(&pool->available_list);
-
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
+    atomic_init(&pool->waiters, 0);
     vlc_atomic_rc_init(&pool->refs);
-    pool->released = false;
+    pool->picture_count = 0;
+    for (size_t i = 0; i < POOL_WORDS; i++)
+        atomic_init(&pool->available[i], 0);
 
     return pool;
 }
@@ -155,7 +168,7 @@ picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
     if (unlikely(count > POOL_MAX))
         return NULL;
 
-    picture_pool_t *pool = picture_pool_NewCommon();
+    picture_pool_t *pool = picture_pool_NewCommon(count);
     if (unlikely(pool == NULL))
         return NULL;
 
@@ -172,7 +185,7 @@ picture_pool_t *picture_pool_NewFromFormat(const video_format_t *fmt,
     if (unlikely(count > POOL_MAX))
         return NULL;
 
-    picture_pool_t *pool = picture_pool_NewCommon();
+    picture_pool_t *pool = picture_pool_NewCommon(count);
     if (unlikely(pool == NULL))
         return NULL;
 
@@ -190,51 +203,59 @@ picture_pool_t *picture_pool_NewFromFormat(const video_format_t *fmt,
     return pool;
 }
 
-static picture_t *picture_pool_GetAvailableLocked(picture_pool_t *pool)
+/**
+ * Takes an available picture without locking.
+ *
+ * @return the original picture, or NULL if none is available
+ */
+static picture_t *picture_pool_TryTake(picture_pool_t *pool)
 {
-    picture_priv_t *priv = vlc_list_first_entry_or_null(&pool->available_list,
-                                                        picture_priv_t,
-                                                        pool_node);
-    assert(priv != NULL);
+    size_t words = (pool->picture_count + POOL_WORD_BITS - 1) / POOL_WORD_BITS;
 
-    assert(priv->pool == pool);
+    for (size_t i = 0; i < words; i++)
+    {
+        atomic_ullong *word = &pool->available[i];
+        unsigned long long mask = atomic_load(word);
 
-    vlc_list_remove(&priv->pool_node);
-    vlc_list_append(&priv->pool_node, &pool->inuse_list);
+        while (mask != 0)
+        {
+            unsigned bit = stdc_trailing_zeros(mask);
 
-    return &priv->picture;
+            if (atomic_compare_exchange_weak(word, &mask,
+                                             mask & ~(1ULL << bit)))
+                return pool->picture[i * POOL_WORD_BITS + bit];
+        }
+    }
+    return NULL;
 }
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-
-    vlc_mutex_lock(&pool->lock);
     assert(vlc_atomic_rc_get(&pool->refs) > 0);
 
-    if (vlc_list_is_empty(&pool->available_list))
-    {
-        vlc_mutex_unlock(&pool->lock);
+    picture_t *pic = picture_pool_TryTake(pool);
+    if (pic == NULL)
         return NULL;
-    }
-
-    picture_t *pic = picture_pool_GetAvailableLocked(pool);
-
-    vlc_mutex_unlock(&pool->lock);
 
     return picture_pool_ClonePicture(pool, pic);
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
     assert(vlc_atomic_rc_get(&pool->refs) > 0);
 
-    while (vlc_list_is_empty(&pool->available_list))
-        vlc_cond_wait(&pool->wait, &pool->lock);
+    picture_t *pic = picture_pool_TryTake(pool);
+    if (pic == NULL)
+    {
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
 
-    picture_t *pic = picture_pool_GetAvailableLocked(pool);
+        while ((pic = picture_pool_TryTake(pool)) == NULL)
+            vlc_cond_wait(&pool->wait, &pool->lock);
 
-    vlc_mutex_unlock(&pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
+    }
 
     return picture_pool_ClonePicture(pool, pic);
 }
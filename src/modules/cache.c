@@ -208,9 +208,8 @@ static int vlc_cache_load_config(struct vlc_param *param, block_t *file)
         for (unsigned i = 0; i < cfg->list_count; i++)
         {
             LOAD_STRING (cfg->list.psz[i]);
-            if (cfg->list.psz[i] == NULL /* NULL -> empty string */
-             && (cfg->list.psz[i] = calloc (1, 1)) == NULL)
-                goto error;
+            if (cfg->list.psz[i] == NULL) /* NULL -> empty string */
+                cfg->list.psz[i] = "";
         }
     }
     else
@@ -234,13 +233,18 @@ static int vlc_cache_load_config(struct vlc_param *param, block_t *file)
         LOAD_ARRAY(cfg->list.i, cfg->list_count);
     }
 
+    if (cfg->list_count == 0)
+    {
+        cfg->list_text = NULL;
+        return 0;
+    }
+
     cfg->list_text = xmalloc (cfg->list_count * sizeof (char *));
     for (unsigned i = 0; i < cfg->list_count; i++)
     {
         LOAD_STRING (cfg->list_text[i]);
-        if (cfg->list_text[i] == NULL /* NULL -> empty string */
-         && (cfg->list_text[i] = calloc (1, 1)) == NULL)
-            goto error;
+        if (cfg->list_text[i] == NULL) /* NULL -> empty string */
+            cfg->list_text[i] = "";
     }
 
     return 0;
@@ -307,7 +311,7 @@ static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
     LOAD_IMMEDIATE(module->i_shortcuts);
     if (module->i_shortcuts > MODULE_SHORTCUT_MAX)
         goto error;
-    else
+    else if (module->i_shortcuts > 0)
     {
         module->pp_shortcuts =
             xmalloc (sizeof (*module->pp_shortcuts) * module->i_shortcuts);
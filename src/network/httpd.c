@@ -32,6 +32,7 @@
 #include <vlc_threads.h>
 #include <vlc_poll.h>
 #include <vlc_httpd.h>
+#include <vlc_interrupt.h>
 
 #include <assert.h>
 
@@ -73,7 +74,19 @@
 static void httpd_ClientDestroy(httpd_client_t *cl);
 static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
 
-/* each host run in his own thread */
+/* each host runs its own threads, each serving a share of the clients */
+struct httpd_worker
+{
+    httpd_host_t *host;
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    /* raised to query the deferred clients again */
+    vlc_interrupt_t *wakeup;
+
+    size_t client_count;
+    struct vlc_list clients;
+};
+
 struct httpd_host_t
 {
     struct vlc_object_t obj;
@@ -87,7 +100,8 @@ struct httpd_host_t
     unsigned     nfd;
     unsigned     port;
 
-    vlc_thread_t thread;
+    struct httpd_worker *workers;
+    unsigned worker_count;
     vlc_mutex_t lock;
 
     /* all registered url (becarefull that 2 httpd_url_t could point at the same url)
@@ -96,8 +110,6 @@ struct httpd_host_t
      * */
     struct vlc_list urls;
 
-    size_t client_count;
-    struct vlc_list clients;
     unsigned timeout_sec;
 
     /* TLS data */
@@ -132,6 +144,7 @@ enum
     HTTPD_CLIENT_SEND_DONE,
 
     HTTPD_CLIENT_WAITING,
+    HTTPD_CLIENT_DEFERRED,
 
     HTTPD_CLIENT_DEAD,
 
@@ -147,15 +160,26 @@ struct httpd_client_t
     struct vlc_list node;
 
     bool    b_stream_mode;
+    bool    b_deferred;
     uint8_t i_state;
 
+    /* index in the last poll set, or -1 if not polled */
+    int     i_pollfd;
+    /* socket reported ready, or I/O state unknown */
+    bool    b_ready;
+
     vlc_tick_t i_timeout_date;
+    /* answer deadline of a deferred query */
+    vlc_tick_t i_defer_date;
 
     /* buffer for reading header */
     int     i_buffer_size;
     int     i_buffer;
     uint8_t *p_buffer;
 
+    /* shared answer body being sent */
+    block_t *p_body_chain;
+
     /*
      * If waiting for a keyframe, this is the position (in bytes) of the
      * last keyframe the stream saw before this client connected.
@@ -914,12 +938,14 @@ void httpd_StreamDelete(httpd_stream_t *stream)
 static void* httpd_HostThread(void *);
 static httpd_host_t *httpd_HostCreate(vlc_object_t *, const char *,
                                       const char *, vlc_tls_server_t *,
-                                      unsigned);
+                                      unsigned, unsigned);
 
 /* create a new host */
 httpd_host_t *vlc_http_HostNew(vlc_object_t *p_this)
 {
-    return httpd_HostCreate(p_this, "http-host", "http-port", NULL, 10);
+    unsigned threads = var_InheritInteger(p_this, "http-threads");
+    return httpd_HostCreate(p_this, "http-host", "http-port", NULL, 10,
+                            threads);
 }
 
 httpd_host_t *vlc_https_HostNew(vlc_object_t *obj)
@@ -943,13 +969,15 @@ httpd_host_t *vlc_https_HostNew(vlc_object_t *obj)
     free(key);
     free(cert);
 
-    return httpd_HostCreate(obj, "http-host", "https-port", tls, 10);
+    unsigned threads = var_InheritInteger(obj, "http-threads");
+    return httpd_HostCreate(obj, "http-host", "https-port", tls, 10, threads);
 }
 
 httpd_host_t *vlc_rtsp_HostNew(vlc_object_t *p_this)
 {
     unsigned timeout = var_InheritInteger(p_this, "rtsp-timeout");
-    return httpd_HostCreate(p_this, "rtsp-host", "rtsp-port", NULL, timeout);
+    /* RTSP sessions are not meant to be handled concurrently */
+    return httpd_HostCreate(p_this, "rtsp-host", "rtsp-port", NULL, timeout, 1);
 }
 
 static struct httpd
@@ -962,7 +990,8 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
                                        const char *hostvar,
                                        const char *portvar,
                                        vlc_tls_server_t *p_tls,
-                                       unsigned timeout_sec)
+                                       unsigned timeout_sec,
+                                       unsigned worker_count)
 {
     httpd_host_t *host;
     unsigned port = var_InheritInteger(p_this, portvar);
@@ -993,6 +1022,8 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
 
     vlc_mutex_init(&host->lock);
     atomic_init(&host->ref, 1);
+    host->workers = NULL;
+    host->worker_count = 0;
 
     char *hostname = var_InheritString(p_this, hostvar);
 
@@ -1007,15 +1038,32 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
 
     host->port     = port;
     vlc_list_init(&host->urls);
-    host->client_count = 0;
-    vlc_list_init(&host->clients);
     host->timeout_sec = timeout_sec;
     host->p_tls    = p_tls;
 
-    /* create the thread */
-    if (vlc_clone(&host->thread, httpd_HostThread, host)) {
-        msg_Err(p_this, "cannot spawn http host thread");
+    /* create the threads: they all wait for new connections on the
+     * listening sockets, so clients get spread among them */
+    host->workers = vlc_alloc(worker_count, sizeof (*host->workers));
+    if (unlikely(host->workers == NULL))
         goto error;
+
+    for (; host->worker_count < worker_count; host->worker_count++) {
+        struct httpd_worker *worker = &host->workers[host->worker_count];
+
+        worker->host = host;
+        vlc_mutex_init(&worker->lock);
+        worker->client_count = 0;
+        vlc_list_init(&worker->clients);
+
+        worker->wakeup = vlc_interrupt_create();
+        if (unlikely(worker->wakeup == NULL))
+            goto error;
+
+        if (vlc_clone(&worker->thread, httpd_HostThread, worker)) {
+            msg_Err(p_this, "cannot spawn http host thread");
+            vlc_interrupt_destroy(worker->wakeup);
+            goto error;
+        }
     }
 
     /* now add it to httpd */
@@ -1028,6 +1076,13 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+        atomic_store_explicit(&host->ref, 0, memory_order_relaxed);
+        for (unsigned i = 0; i < host->worker_count; i++) {
+            vlc_cancel(host->workers[i].thread);
+            vlc_join(host->workers[i].thread, NULL);
+            vlc_interrupt_destroy(host->workers[i].wakeup);
+        }
+        free(host->workers);
         net_ListenClose(host->fds);
         vlc_object_delete(host);
     }
@@ -1051,15 +1106,21 @@ void httpd_HostDelete(httpd_host_t *host)
     }
 
     vlc_list_remove(&host->node);
-    vlc_cancel(host->thread);
-    vlc_join(host->thread, NULL);
+    for (unsigned i = 0; i < host->worker_count; i++)
+        vlc_cancel(host->workers[i].thread);
+    for (unsigned i = 0; i < host->worker_count; i++)
+        vlc_join(host->workers[i].thread, NULL);
 
     msg_Dbg(host, "HTTP host removed");
 
-    vlc_list_foreach(client, &host->clients, node) {
-        msg_Warn(host, "client still connected");
-        httpd_ClientDestroy(client);
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        vlc_list_foreach(client, &host->workers[i].clients, node) {
+            msg_Warn(host, "client still connected");
+            httpd_ClientDestroy(client);
+        }
+        vlc_interrupt_destroy(host->workers[i].wakeup);
     }
+    free(host->workers);
 
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
@@ -1148,22 +1209,39 @@ void httpd_UrlDelete(httpd_url_t *url)
 
     vlc_mutex_lock(&host->lock);
     vlc_list_remove(&url->node);
+    vlc_mutex_unlock(&host->lock);
+
+    /* Workers hold their lock while handling their clients, so once it is
+     * acquired, none of them can be using the url anymore. */
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        struct httpd_worker *worker = &host->workers[i];
+
+        vlc_mutex_lock(&worker->lock);
+        vlc_list_foreach(client, &worker->clients, node) {
+            if (client->url != url)
+                continue;
+
+            /* TODO complete it */
+            msg_Warn(host, "force closing connections");
+            worker->client_count--;
+            httpd_ClientDestroy(client);
+        }
+        vlc_mutex_unlock(&worker->lock);
+    }
 
     free(url->psz_url);
     free(url->psz_user);
     free(url->psz_password);
+    free(url);
+}
 
-    vlc_list_foreach(client, &host->clients, node) {
-        if (client->url != url)
-            continue;
+void httpd_UrlWakeUp(httpd_url_t *url)
+{
+    httpd_host_t *host = url->host;
 
-        /* TODO complete it */
-        msg_Warn(host, "force closing connections");
-        host->client_count--;
-        httpd_ClientDestroy(client);
-    }
-    free(url);
-    vlc_mutex_unlock(&host->lock);
+    /* Clients are not tracked per url: query all the deferred ones again */
+    for (unsigned i = 0; i < host->worker_count; i++)
+        vlc_interrupt_raise(host->workers[i].wakeup);
 }
 
 static void httpd_MsgInit(httpd_message_t *msg)
@@ -1184,6 +1262,7 @@ static void httpd_MsgInit(httpd_message_t *msg)
     msg->i_body_offset = 0;
     msg->i_body        = 0;
     msg->p_body        = NULL;
+    msg->p_body_chain  = NULL;
 }
 
 static void httpd_MsgClean(httpd_message_t *msg)
@@ -1196,6 +1275,7 @@ static void httpd_MsgClean(httpd_message_t *msg)
     }
     free(msg->p_headers);
     free(msg->p_body);
+    block_ChainRelease(msg->p_body_chain);
     httpd_MsgInit(msg);
 }
 
@@ -1235,6 +1315,13 @@ void httpd_MsgAdd(httpd_message_t *msg, const char *name, const char *psz_value,
     msg->i_headers++;
 }
 
+void httpd_ClientDefer(httpd_client_t *cl, vlc_tick_t timeout)
+{
+    if (cl->i_defer_date == VLC_TICK_INVALID)
+        cl->i_defer_date = vlc_tick_now() + timeout;
+    cl->b_deferred = true;
+}
+
 char* httpd_ClientIP(const httpd_client_t *cl, char *ip, int *port)
 {
     return net_GetPeerAddress(vlc_tls_GetFD(cl->sock), ip, port) ? NULL : ip;
@@ -1252,6 +1339,7 @@ static void httpd_ClientDestroy(httpd_client_t *cl)
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
 
+    block_ChainRelease(cl->p_body_chain);
     free(cl->p_buffer);
     free(cl);
 }
@@ -1265,11 +1353,16 @@ static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock)
     cl->sock    = sock;
     cl->url     = NULL;
     cl->i_state = HTTPD_CLIENT_RECEIVING;
+    cl->i_pollfd = -1;
+    cl->b_ready = true;
     cl->i_buffer_size = HTTPD_CL_BUFSIZE;
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc(cl->i_buffer_size);
+    cl->p_body_chain = NULL;
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->b_deferred = false;
+    cl->i_defer_date = VLC_TICK_INVALID;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1600,10 +1693,52 @@ static int httpd_ClientRecv(httpd_client_t *cl)
     return 0;
 }
 
+static int httpd_ClientSendChain(httpd_client_t *cl)
+{
+    /* gather as many blocks as possible in a single system call */
+    struct iovec iov[16];
+    unsigned count = 0;
+    for (const block_t *b = cl->p_body_chain;
+         b != NULL && count < ARRAY_SIZE(iov); b = b->p_next) {
+        iov[count].iov_base = b->p_buffer;
+        iov[count].iov_len = b->i_buffer;
+        count++;
+    }
+
+    ssize_t i_len = cl->sock->ops->writev(cl->sock, iov, count);
+    if (i_len < 0) {
+#if defined(_WIN32)
+        if (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+        if (errno == EAGAIN)
+#endif
+            return -1;
+
+        cl->i_state = HTTPD_CLIENT_DEAD;
+        return 0;
+    }
+
+    block_t *b;
+    while ((b = cl->p_body_chain) != NULL && (size_t)i_len >= b->i_buffer) {
+        i_len -= b->i_buffer;
+        cl->p_body_chain = b->p_next;
+        block_Release(b);
+    }
+    if (b != NULL) {
+        b->p_buffer += i_len;
+        b->i_buffer -= i_len;
+    } else
+        cl->i_state = HTTPD_CLIENT_SEND_DONE;
+    return 0;
+}
+
 static int httpd_ClientSend(httpd_client_t *cl)
 {
     int i_len;
 
+    if (cl->p_body_chain != NULL)
+        return httpd_ClientSendChain(cl);
+
     if (cl->i_buffer < 0) {
         /* We need to create the header */
         int i_size = 0;
@@ -1673,6 +1808,10 @@ static int httpd_ClientSend(httpd_client_t *cl)
 
             cl->answer.i_body = 0;
             cl->answer.p_body = NULL;
+        } else if (cl->answer.p_body_chain != NULL) {
+            /* send the shared body data */
+            cl->p_body_chain = cl->answer.p_body_chain;
+            cl->answer.p_body_chain = NULL;
         } else /* send finished */
             cl->i_state = HTTPD_CLIENT_SEND_DONE;
     }
@@ -1730,9 +1869,12 @@ auth_failed:
     return false;
 }
 
-static void httpdLoop(httpd_host_t *host)
+static void httpdLoop(struct httpd_worker *worker)
 {
-    struct pollfd ufd[host->nfd + host->client_count];
+    httpd_host_t *host = worker->host;
+
+    vlc_mutex_lock(&worker->lock);
+    struct pollfd ufd[host->nfd + worker->client_count];
     unsigned nfd;
     for (nfd = 0; nfd < host->nfd; nfd++) {
         ufd[nfd].fd = host->fds[nfd];
@@ -1740,22 +1882,26 @@ static void httpdLoop(httpd_host_t *host)
         ufd[nfd].revents = 0;
     }
 
-    vlc_mutex_lock(&host->lock);
     /* add all socket that should be read/write and close dead connection */
     vlc_tick_t now = vlc_tick_now();
     int delay = -1;
     httpd_client_t *cl;
 
     int canc = vlc_savecancel();
-    vlc_list_foreach(cl, &host->clients, node) {
+    vlc_list_foreach(cl, &worker->clients, node) {
         int val = -1;
 
+        /* Only try I/O on sockets that were reported ready, rather than
+         * on every client of the host. TLS sessions may hold buffered data
+         * that poll() cannot see, so they are always tried. */
         switch (cl->i_state) {
             case HTTPD_CLIENT_RECEIVING:
-                val = httpd_ClientRecv(cl);
+                if (cl->b_ready || host->p_tls != NULL)
+                    val = httpd_ClientRecv(cl);
                 break;
             case HTTPD_CLIENT_SENDING:
-                val = httpd_ClientSend(cl);
+                if (cl->b_ready || host->p_tls != NULL)
+                    val = httpd_ClientSend(cl);
                 break;
             case HTTPD_CLIENT_TLS_HS_IN:
             case HTTPD_CLIENT_TLS_HS_OUT:
@@ -1763,9 +1909,11 @@ static void httpdLoop(httpd_host_t *host)
                 break;
         }
 
+        /* deferred clients are bounded by their own deadline */
         if (cl->i_state == HTTPD_CLIENT_DEAD
-         || (host->timeout_sec > 0 && cl->i_timeout_date < now)) {
-            host->client_count--;
+         || (host->timeout_sec > 0 && cl->i_state != HTTPD_CLIENT_DEFERRED
+          && cl->i_timeout_date < now)) {
+            worker->client_count--;
             httpd_ClientDestroy(cl);
             continue;
         }
@@ -1872,25 +2020,32 @@ static void httpdLoop(httpd_host_t *host)
                         break;
 
                     default: {
-                        httpd_url_t *url;
+                        httpd_url_t *url, *found = NULL;
                         bool b_auth_failed = false;
 
-                        /* Search the url and trigger callbacks */
-                        vlc_list_foreach(url, &host->urls, node) {
-                            if (strcmp(url->psz_url, query->psz_url))
-                                continue;
-
-                            if (answer) {
-                                b_auth_failed = !httpdAuthOk(url->psz_user,
-                                   url->psz_password,
-                                   httpd_MsgGet(query, "Authorization")); /* BASIC id */
-                                if (b_auth_failed)
-                                   break;
+                        /* Search the url, urls are unique per host */
+                        vlc_mutex_lock(&host->lock);
+                        vlc_list_foreach(url, &host->urls, node)
+                            if (!strcmp(url->psz_url, query->psz_url)) {
+                                found = url;
+                                break;
                             }
+                        vlc_mutex_unlock(&host->lock);
+
+                        /* Trigger callbacks without the host lock, so that
+                         * other workers can handle other urls meanwhile. The
+                         * url cannot be deleted while the worker lock is held,
+                         * and its own lock serializes its callbacks. */
+                        url = found;
+                        cl->i_defer_date = VLC_TICK_INVALID;
+                        if (url != NULL && answer) {
+                            b_auth_failed = !httpdAuthOk(url->psz_user,
+                               url->psz_password,
+                               httpd_MsgGet(query, "Authorization")); /* BASIC id */
+                        }
 
-                            if (httpd_UrlCatchCall(url, cl))
-                                continue;
-
+                        if (url != NULL && !b_auth_failed
+                         && !httpd_UrlCatchCall(url, cl)) {
                             if (answer->i_proto == HTTPD_PROTO_NONE)
                                 cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
                             else
@@ -1926,7 +2081,8 @@ static void httpdLoop(httpd_host_t *host)
                                 httpd_MsgAdd(answer, "Connection", "close");
                         }
 
-                        cl->i_state = HTTPD_CLIENT_SENDING;
+                        cl->i_state = cl->b_deferred ? HTTPD_CLIENT_DEFERRED
+                                                     : HTTPD_CLIENT_SENDING;
                     }
                 }
                 break;
@@ -1976,6 +2132,36 @@ static void httpdLoop(httpd_host_t *host)
                 }
                 break;
 
+            case HTTPD_CLIENT_DEFERRED:
+                /* query the url again, the answer may be ready by now */
+                httpd_MsgClean(&cl->answer);
+                cl->b_deferred = false;
+                httpd_UrlCatchCall(cl->url, cl);
+                if (cl->b_deferred && cl->i_defer_date <= now) {
+                    /* not available in time */
+                    httpd_message_t *answer = &cl->answer;
+
+                    httpd_MsgClean(answer);
+                    cl->b_deferred = false;
+                    answer->i_proto  = cl->query.i_proto;
+                    answer->i_type   = HTTPD_MSG_ANSWER;
+                    answer->i_version= 0;
+                    answer->i_status = 503;
+
+                    char *p;
+                    answer->i_body = httpd_HtmlError (&p, 503,
+                            cl->query.psz_url);
+                    answer->p_body = (uint8_t *)p;
+                    httpd_MsgAdd(answer, "Content-Length", "%zu", answer->i_body);
+                    httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
+                }
+                if (!cl->b_deferred) {
+                    cl->i_buffer = -1;
+                    cl->i_timeout_date = now + VLC_TICK_FROM_SEC(host->timeout_sec);
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                }
+                break;
+
             case HTTPD_CLIENT_WAITING: {
                 int64_t i_offset = cl->answer.i_body_offset;
                 int i_msg = cl->query.i_type;
@@ -2000,26 +2186,42 @@ static void httpdLoop(httpd_host_t *host)
         pufd->fd = vlc_tls_GetPollFD(cl->sock, &pufd->events);
 
         if (pufd->events != 0)
-            nfd++;
-        /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-        else if (delay != 0)
-            delay = 20;
+            cl->i_pollfd = nfd++;
+        else {
+            cl->i_pollfd = -1;
+            if (cl->i_state == HTTPD_CLIENT_DEFERRED) {
+                /* woken up by httpd_UrlWakeUp(), or at the deadline */
+                vlc_tick_t left = cl->i_defer_date - now;
+                int ms = left > 0 ? MS_FROM_VLC_TICK(left) + 1 : 0;
+                if (delay < 0 || ms < delay)
+                    delay = ms;
+            }
+            /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
+            else if (delay < 0 || delay > 20)
+                delay = 20;
+        }
     }
-    vlc_mutex_unlock(&host->lock);
+    vlc_mutex_unlock(&worker->lock);
     vlc_restorecancel(canc);
 
-    while (poll(ufd, nfd, delay) < 0)
+    /* Only the poll is interruptible, not the url callbacks */
+    vlc_interrupt_t *oldctx = vlc_interrupt_set(worker->wakeup);
+    if (vlc_poll_i11e(ufd, nfd, delay) < 0 && errno != EINTR)
     {
-        if (errno != EINTR)
-            msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+        msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+        for (unsigned i = 0; i < nfd; i++)
+            ufd[i].revents = 0;
     }
+    vlc_interrupt_set(oldctx);
 
     canc = vlc_savecancel();
-    vlc_mutex_lock(&host->lock);
+    vlc_mutex_lock(&worker->lock);
 
-    /* Handle client sockets */
+    /* Handle client sockets: clients destroyed in the meantime are gone
+     * from the list, the others still match their poll set entry */
     now = vlc_tick_now();
-    nfd = host->nfd;
+    vlc_list_foreach(cl, &worker->clients, node)
+        cl->b_ready = cl->i_pollfd < 0 || ufd[cl->i_pollfd].revents != 0;
 
     /* Handle server sockets (accept new connections) */
     for (nfd = 0; nfd < host->nfd; nfd++) {
@@ -2070,11 +2272,11 @@ static void httpdLoop(httpd_host_t *host)
             cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
 
         cl->i_timeout_date = now + VLC_TICK_FROM_SEC(host->timeout_sec);
-        host->client_count++;
-        vlc_list_append(&cl->node, &host->clients);
+        worker->client_count++;
+        vlc_list_append(&cl->node, &worker->clients);
     }
 
-    vlc_mutex_unlock(&host->lock);
+    vlc_mutex_unlock(&worker->lock);
     vlc_restorecancel(canc);
 }
 
@@ -2082,10 +2284,10 @@ static void* httpd_HostThread(void *data)
 {
     vlc_thread_set_name("vlc-httpd");
 
-    httpd_host_t *host = data;
+    struct httpd_worker *worker = data;
 
-    while (atomic_load_explicit(&host->ref, memory_order_relaxed) > 0)
-        httpdLoop(host);
+    while (atomic_load_explicit(&worker->host->ref, memory_order_relaxed) > 0)
+        httpdLoop(worker);
     return NULL;
 }
 
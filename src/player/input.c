@@ -98,6 +98,21 @@ vlc_player_input_UpdateTime(struct vlc_player_input *input)
 int
 vlc_player_input_Start(struct vlc_player_input *input)
 {
+    if (input->prepared)
+    {
+        /* The thread is already running, waiting to play */
+        assert(!input->silent);
+        input_StartPrepared(input->thread);
+        input->prepared = false;
+        input->started = true;
+        vlc_player_input_HandleState(input, VLC_PLAYER_STATE_STARTED,
+                                     VLC_TICK_INVALID);
+        if (input->playing)
+            vlc_player_input_HandleState(input, VLC_PLAYER_STATE_PLAYING,
+                                         vlc_tick_now());
+        return VLC_SUCCESS;
+    }
+
     int ret = input_Start(input->thread);
     if (ret != VLC_SUCCESS)
         return ret;
@@ -116,6 +131,32 @@ vlc_player_assert_seek_params(enum vlc_player_seek_speed speed,
     (void) speed; (void) whence;
 }
 
+static bool
+vlc_player_input_HasTimeshift(struct vlc_player_input *input)
+{
+    /* Seek requests go to the timeshift only when the media can't seek */
+    return !(input->capabilities & VLC_INPUT_CAPABILITIES_SEEKABLE)
+        && input->timeshift.length > 0;
+}
+
+void
+vlc_player_input_SeekTimeshift(struct vlc_player_input *input,
+                               vlc_tick_t delay)
+{
+    if (delay < 0)
+        delay = 0;
+    else if (delay > input->timeshift.length)
+        delay = input->timeshift.length;
+
+    int ret = input_ControlPush(input->thread, INPUT_CONTROL_SET_TIMESHIFT,
+        &(input_control_param_t) {
+            .time.i_val = delay,
+    });
+
+    if (ret == VLC_SUCCESS)
+        input->timeshift.delay = delay;
+}
+
 void
 vlc_player_input_SeekByPos(struct vlc_player_input *input, double position,
                            enum vlc_player_seek_speed speed,
@@ -124,6 +165,17 @@ vlc_player_input_SeekByPos(struct vlc_player_input *input, double position,
     vlc_player_t *player = input->player;
     vlc_player_assert_seek_params(speed, whence);
 
+    if (vlc_player_input_HasTimeshift(input))
+    {
+        vlc_tick_t length = input->timeshift.length;
+        if (whence == VLC_PLAYER_WHENCE_ABSOLUTE)
+            vlc_player_input_SeekTimeshift(input, (1. - position) * length);
+        else
+            vlc_player_input_SeekTimeshift(input, input->timeshift.delay
+                                                  - position * length);
+        return;
+    }
+
     if (whence != VLC_PLAYER_WHENCE_ABSOLUTE)
         position += vlc_player_input_GetPos(input, true, vlc_tick_now());
 
@@ -152,6 +204,17 @@ vlc_player_input_SeekByTime(struct vlc_player_input *input, vlc_tick_t time,
     vlc_player_t *player = input->player;
     vlc_player_assert_seek_params(speed, whence);
 
+    if (vlc_player_input_HasTimeshift(input))
+    {
+        if (whence == VLC_PLAYER_WHENCE_ABSOLUTE)
+            vlc_player_input_SeekTimeshift(input,
+                                           input->timeshift.length - time);
+        else
+            vlc_player_input_SeekTimeshift(input,
+                                           input->timeshift.delay - time);
+        return;
+    }
+
     if (whence != VLC_PLAYER_WHENCE_ABSOLUTE)
         time += vlc_player_input_GetTime(input, true, vlc_tick_now());
 
@@ -372,7 +435,6 @@ static void
 vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
                                     const struct vlc_input_event_program *ev)
 {
-    vlc_player_t *player = input->player;
     struct vlc_player_program *prgm;
     vlc_player_program_vector *vec = &input->program_vector;
 
@@ -388,8 +450,8 @@ vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
                 vlc_player_program_Delete(prgm);
                 break;
             }
-            vlc_player_SendEvent(player, on_program_list_changed,
-                                 VLC_PLAYER_LIST_ADDED, prgm);
+            vlc_player_input_SendEvent(input, on_program_list_changed,
+                                       VLC_PLAYER_LIST_ADDED, prgm);
             break;
         case VLC_INPUT_PROGRAM_DELETED:
         {
@@ -397,8 +459,8 @@ vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
             prgm = vlc_player_program_vector_FindById(vec, ev->id, &idx);
             if (prgm)
             {
-                vlc_player_SendEvent(player, on_program_list_changed,
-                                     VLC_PLAYER_LIST_REMOVED, prgm);
+                vlc_player_input_SendEvent(input, on_program_list_changed,
+                                           VLC_PLAYER_LIST_REMOVED, prgm);
                 vlc_vector_remove(vec, idx);
                 vlc_player_program_Delete(prgm);
             }
@@ -416,8 +478,8 @@ vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
             }
             else
                 prgm->scrambled = ev->scrambled;
-            vlc_player_SendEvent(player, on_program_list_changed,
-                                 VLC_PLAYER_LIST_UPDATED, prgm);
+            vlc_player_input_SendEvent(input, on_program_list_changed,
+                                       VLC_PLAYER_LIST_UPDATED, prgm);
             break;
         case VLC_INPUT_PROGRAM_SELECTED:
         {
@@ -444,8 +506,8 @@ vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
                 }
             }
             if (unselected_id != -1 || selected_id != -1)
-                vlc_player_SendEvent(player, on_program_selection_changed,
-                                     unselected_id, selected_id);
+                vlc_player_input_SendEvent(input, on_program_selection_changed,
+                                           unselected_id, selected_id);
             break;
         }
         default:
@@ -483,7 +545,6 @@ vlc_player_input_HandleTeletextMenu(struct vlc_player_input *input,
                                     const struct vlc_input_event_es *ev,
                                     const struct vlc_player_track_priv *trackpriv)
 {
-    vlc_player_t *player = input->player;
     if (ev->fmt->i_cat != SPU_ES ||
         ev->fmt->i_codec != VLC_CODEC_TELETEXT)
         return;
@@ -494,7 +555,8 @@ vlc_player_input_HandleTeletextMenu(struct vlc_player_input *input,
             if (!input->teletext_source)
             {
                 input->teletext_source = trackpriv;
-                vlc_player_SendEvent(player, on_teletext_menu_changed, true);
+                vlc_player_input_SendEvent(input, on_teletext_menu_changed,
+                                           true);
             }
             break;
         }
@@ -512,22 +574,24 @@ vlc_player_input_HandleTeletextMenu(struct vlc_player_input *input,
                     if (input->teletext_enabled)
                     {
                         input->teletext_enabled = false;
-                        vlc_player_SendEvent(player, on_teletext_enabled_changed, false);
+                        vlc_player_input_SendEvent(input, on_teletext_enabled_changed,
+                                                   false);
                     }
-                    vlc_player_SendEvent(player, on_teletext_menu_changed, false);
+                    vlc_player_input_SendEvent(input, on_teletext_menu_changed,
+                                               false);
                 }
                 else /* another teletext ES was reselected */
                 {
                     if (input->teletext_source->t.selected != input->teletext_enabled)
                     {
                         input->teletext_enabled = input->teletext_source->t.selected;
-                        vlc_player_SendEvent(player, on_teletext_enabled_changed,
-                                             input->teletext_source->t.selected);
+                        vlc_player_input_SendEvent(input, on_teletext_enabled_changed,
+                                                   input->teletext_source->t.selected);
                     }
                     input->teletext_page =
                             vlc_player_input_TeletextUserPage(input->teletext_source);
-                    vlc_player_SendEvent(player, on_teletext_page_changed,
-                                         input->teletext_page);
+                    vlc_player_input_SendEvent(input, on_teletext_page_changed,
+                                               input->teletext_page);
                 }
             }
             break;
@@ -541,9 +605,10 @@ vlc_player_input_HandleTeletextMenu(struct vlc_player_input *input,
                 input->teletext_source = trackpriv;
                 input->teletext_enabled = true;
                 input->teletext_page = vlc_player_input_TeletextUserPage(trackpriv);
-                vlc_player_SendEvent(player, on_teletext_enabled_changed, true);
-                vlc_player_SendEvent(player, on_teletext_page_changed,
-                                     input->teletext_page);
+                vlc_player_input_SendEvent(input, on_teletext_enabled_changed,
+                                           true);
+                vlc_player_input_SendEvent(input, on_teletext_page_changed,
+                                           input->teletext_page);
             }
             break;
         }
@@ -559,16 +624,18 @@ vlc_player_input_HandleTeletextMenu(struct vlc_player_input *input,
                     if (!input->teletext_enabled)
                     {
                         input->teletext_enabled = true;
-                        vlc_player_SendEvent(player, on_teletext_enabled_changed, true);
+                        vlc_player_input_SendEvent(input, on_teletext_enabled_changed,
+                                                   true);
                     }
                     input->teletext_page = vlc_player_input_TeletextUserPage(other);
-                    vlc_player_SendEvent(player, on_teletext_page_changed,
-                                         input->teletext_page);
+                    vlc_player_input_SendEvent(input, on_teletext_page_changed,
+                                               input->teletext_page);
                 }
                 else
                 {
                     input->teletext_enabled = false;
-                    vlc_player_SendEvent(player, on_teletext_enabled_changed, false);
+                    vlc_player_input_SendEvent(input, on_teletext_enabled_changed,
+                                               false);
                 }
             }
             break;
@@ -606,8 +673,8 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
                 vlc_player_track_priv_Delete(trackpriv);
                 break;
             }
-            vlc_player_SendEvent(player, on_track_list_changed,
-                                 VLC_PLAYER_LIST_ADDED, &trackpriv->t);
+            vlc_player_input_SendEvent(input, on_track_list_changed,
+                                       VLC_PLAYER_LIST_ADDED, &trackpriv->t);
             vlc_player_input_HandleTeletextMenu(input, ev, trackpriv);
             break;
         case VLC_INPUT_ES_DELETED:
@@ -617,8 +684,9 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
             if (trackpriv)
             {
                 vlc_player_input_HandleTeletextMenu(input, ev, trackpriv);
-                vlc_player_SendEvent(player, on_track_list_changed,
-                                     VLC_PLAYER_LIST_REMOVED, &trackpriv->t);
+                vlc_player_input_SendEvent(input, on_track_list_changed,
+                                           VLC_PLAYER_LIST_REMOVED,
+                                           &trackpriv->t);
                 vlc_vector_remove(vec, idx);
                 vlc_player_track_priv_Delete(trackpriv);
             }
@@ -630,8 +698,8 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
                 break;
             if (vlc_player_track_priv_Update(trackpriv, ev->title, ev->fmt) != 0)
                 break;
-            vlc_player_SendEvent(player, on_track_list_changed,
-                                 VLC_PLAYER_LIST_UPDATED, &trackpriv->t);
+            vlc_player_input_SendEvent(input, on_track_list_changed,
+                                       VLC_PLAYER_LIST_UPDATED, &trackpriv->t);
             vlc_player_input_HandleTeletextMenu(input, ev, trackpriv);
             break;
         case VLC_INPUT_ES_SELECTED:
@@ -641,8 +709,8 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
                 trackpriv->t.selected = true;
                 trackpriv->selected_by_user = ev->forced;
                 trackpriv->vout_order = ev->vout_order;
-                vlc_player_SendEvent(player, on_track_selection_changed,
-                                     NULL, trackpriv->t.es_id);
+                vlc_player_input_SendEvent(input, on_track_selection_changed,
+                                           NULL, trackpriv->t.es_id);
                 vlc_player_input_HandleTeletextMenu(input, ev, trackpriv);
             }
             break;
@@ -653,8 +721,8 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
                 vlc_player_RemoveTimerSource(player, ev->id);
                 trackpriv->t.selected = false;
                 trackpriv->selected_by_user = false;
-                vlc_player_SendEvent(player, on_track_selection_changed,
-                                     trackpriv->t.es_id, NULL);
+                vlc_player_input_SendEvent(input, on_track_selection_changed,
+                                           trackpriv->t.es_id, NULL);
                 vlc_player_input_HandleTeletextMenu(input, ev, trackpriv);
             }
             break;
@@ -667,7 +735,6 @@ static void
 vlc_player_input_HandleTitleEvent(struct vlc_player_input *input,
                                   const struct vlc_input_event_title *ev)
 {
-    vlc_player_t *player = input->player;
     switch (ev->action)
     {
         case VLC_INPUT_TITLE_NEW_LIST:
@@ -682,15 +749,19 @@ vlc_player_input_HandleTitleEvent(struct vlc_player_input *input,
             input->titles =
                 vlc_player_title_list_Create(ev->list.array, ev->list.count,
                                              title_offset, chapter_offset);
-            vlc_player_SendEvent(player, on_titles_changed, input->titles);
+            vlc_player_input_SendEvent(input, on_titles_changed, input->titles);
             if (input->titles)
             {
-                vlc_player_SendEvent(player, on_title_selection_changed,
-                                     &input->titles->array[0], 0);
+                vlc_player_input_SendEvent(input, on_title_selection_changed,
+                                           &input->titles->array[0], 0);
                 if (input->ml.restore == VLC_RESTOREPOINT_TITLE &&
                     (size_t)input->ml.states.current_title < ev->list.count)
                 {
-                    vlc_player_SelectTitleIdx(player, input->ml.states.current_title);
+                    /* Not the current input yet if prepared ahead of time */
+                    const int title = input->ml.states.current_title;
+                    input_ControlPushHelper(input->thread,
+                                            INPUT_CONTROL_SET_TITLE,
+                                            &(vlc_value_t){ .i_int = title });
                 }
                 input->ml.restore = VLC_RESTOREPOINT_POSITION;
             }
@@ -702,9 +773,9 @@ vlc_player_input_HandleTitleEvent(struct vlc_player_input *input,
                 return; /* a previous VLC_INPUT_TITLE_NEW_LIST failed */
             assert(ev->selected_idx < input->titles->count);
             input->title_selected = ev->selected_idx;
-            vlc_player_SendEvent(player, on_title_selection_changed,
-                                 &input->titles->array[input->title_selected],
-                                 input->title_selected);
+            vlc_player_input_SendEvent(input, on_title_selection_changed,
+                                       &input->titles->array[input->title_selected],
+                                       input->title_selected);
             if (input->ml.restore == VLC_RESTOREPOINT_POSITION &&
                 input->ml.states.current_title >= 0 &&
                 (size_t)input->ml.states.current_title == ev->selected_idx &&
@@ -726,7 +797,6 @@ static void
 vlc_player_input_HandleChapterEvent(struct vlc_player_input *input,
                                     const struct vlc_input_event_chapter *ev)
 {
-    vlc_player_t *player = input->player;
     if (!input->titles || ev->title < 0 || ev->seekpoint < 0)
         return; /* a previous VLC_INPUT_TITLE_NEW_LIST failed */
 
@@ -740,8 +810,8 @@ vlc_player_input_HandleChapterEvent(struct vlc_player_input *input,
     input->chapter_selected = ev->seekpoint;
 
     const struct vlc_player_chapter *chapter = &title->chapters[ev->seekpoint];
-    vlc_player_SendEvent(player, on_chapter_selection_changed, title, ev->title,
-                         chapter, ev->seekpoint);
+    vlc_player_input_SendEvent(input, on_chapter_selection_changed, title,
+                               ev->title, chapter, ev->seekpoint);
 }
 
 static void
@@ -870,6 +940,109 @@ vlc_player_input_MouseFallback(struct vlc_player_input *input)
     vlc_player_TogglePause(player);
 }
 
+static bool
+vlc_player_input_HandleSilentEvent(struct vlc_player_input *input,
+                                   const struct vlc_input_event *event)
+{
+    vlc_player_t *player = input->player;
+    bool handled = true;
+
+    /* Track the input state without changing the player state, it is not the
+     * current input yet. The handlers shared with the current input don't
+     * notify the listeners of a silent input. */
+    switch (event->type)
+    {
+        case INPUT_EVENT_STATE:
+            if (event->state.value == PLAYING_S)
+                input->playing = true;
+            break;
+        case INPUT_EVENT_CAPABILITIES:
+            input->capabilities = event->capabilities;
+            break;
+        case INPUT_EVENT_TIMES:
+            input->length = input_GetItemDuration(input->thread,
+                                                  event->times.length);
+            break;
+        case INPUT_EVENT_PROGRAM:
+            vlc_player_input_HandleProgramEvent(input, &event->program);
+            break;
+        case INPUT_EVENT_ES:
+            vlc_player_input_HandleEsEvent(input, &event->es);
+            break;
+        case INPUT_EVENT_TITLE:
+            vlc_player_input_HandleTitleEvent(input, &event->title);
+            break;
+        case INPUT_EVENT_CHAPTER:
+            vlc_player_input_HandleChapterEvent(input, &event->chapter);
+            break;
+        case INPUT_EVENT_SIGNAL:
+            input->signal_quality = event->signal.quality;
+            input->signal_strength = event->signal.strength;
+            break;
+        case INPUT_EVENT_DEAD:
+            /* Failed to open, or discarded */
+            if (player->next_input == input)
+                player->next_input = NULL;
+            vlc_player_destructor_AddJoinableInput(player, input);
+            break;
+        default:
+            handled = false;
+            break;
+    }
+    return handled;
+}
+
+void
+vlc_player_input_SendPreparedEvents(struct vlc_player_input *input)
+{
+    vlc_player_t *player = input->player;
+
+    /* Replay what the listeners missed while the input was silent */
+    if (input->capabilities != 0)
+        vlc_player_SendEvent(player, on_capabilities_changed, 0,
+                             input->capabilities);
+    if (input->length != VLC_TICK_INVALID)
+        vlc_player_SendEvent(player, on_length_changed, input->length);
+
+    if (input->titles)
+    {
+        vlc_player_SendEvent(player, on_titles_changed, input->titles);
+        vlc_player_SendEvent(player, on_title_selection_changed,
+                             &input->titles->array[input->title_selected],
+                             input->title_selected);
+    }
+
+    struct vlc_player_program *prgm;
+    vlc_vector_foreach(prgm, &input->program_vector)
+    {
+        vlc_player_SendEvent(player, on_program_list_changed,
+                             VLC_PLAYER_LIST_ADDED, prgm);
+        if (prgm->selected)
+            vlc_player_SendEvent(player, on_program_selection_changed,
+                                 -1, prgm->group_id);
+    }
+
+    vlc_player_track_vector *vecs[] = {
+        &input->video_track_vector, &input->audio_track_vector,
+        &input->spu_track_vector,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(vecs); ++i)
+    {
+        struct vlc_player_track_priv *trackpriv;
+        vlc_vector_foreach(trackpriv, vecs[i])
+        {
+            vlc_player_SendEvent(player, on_track_list_changed,
+                                 VLC_PLAYER_LIST_ADDED, &trackpriv->t);
+            if (trackpriv->t.selected)
+                vlc_player_SendEvent(player, on_track_selection_changed,
+                                     NULL, trackpriv->t.es_id);
+        }
+    }
+
+    if (input->teletext_source)
+        vlc_player_SendEvent(player, on_teletext_menu_changed, true);
+}
+
 static bool
 input_thread_Events(input_thread_t *input_thread,
                     const struct vlc_input_event *event, void *user_data)
@@ -911,6 +1084,13 @@ input_thread_Events(input_thread_t *input_thread,
 
     vlc_mutex_lock(&player->lock);
 
+    if (input->silent)
+    {
+        handled = vlc_player_input_HandleSilentEvent(input, event);
+        vlc_mutex_unlock(&player->lock);
+        return handled;
+    }
+
     switch (event->type)
     {
         case INPUT_EVENT_STATE:
@@ -973,6 +1153,9 @@ input_thread_Events(input_thread_t *input_thread,
                 };
                 vlc_player_UpdateTimer(player, NULL, false, &point,
                                        input->normal_time, 0, 0, priv->i_start);
+
+                if (input == player->input)
+                    vlc_player_PrepareNextMedia(player);
             }
             break;
         }
@@ -1010,6 +1193,13 @@ input_thread_Events(input_thread_t *input_thread,
             input->cache = event->cache;
             vlc_player_SendEvent(player, on_buffering_changed, event->cache);
             break;
+        case INPUT_EVENT_TIMESHIFT:
+            input->timeshift.length = event->timeshift.length;
+            input->timeshift.delay = event->timeshift.delay;
+            vlc_player_SendEvent(player, on_timeshift_changed,
+                                 input->timeshift.length,
+                                 input->timeshift.delay);
+            break;
         case INPUT_EVENT_VOUT:
             vlc_player_input_HandleVoutEvent(input, &event->vout);
             break;
@@ -1105,7 +1295,7 @@ vlc_player_input_GetSelectedTrackStringIds(struct vlc_player_input *input,
 }
 
 struct vlc_player_input *
-vlc_player_input_New(vlc_player_t *player, input_item_t *item)
+vlc_player_input_New(vlc_player_t *player, input_item_t *item, bool prepare)
 {
     struct vlc_player_input *input = malloc(sizeof(*input));
     if (!input)
@@ -1113,6 +1303,7 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
 
     input->player = player;
     input->started = false;
+    input->prepared = input->silent = prepare;
     input->playing = false;
 
     input->state = VLC_PLAYER_STATE_STOPPED;
@@ -1127,6 +1318,7 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
     input->recording = false;
 
     input->cache = 0.f;
+    input->timeshift.length = input->timeshift.delay = 0;
     input->signal_quality = input->signal_strength = -1.f;
 
     memset(&input->stats, 0, sizeof(input->stats));
@@ -1169,6 +1361,7 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
         .renderer = player->renderer,
         .cbs = &cbs,
         .cbs_data = input,
+        .prepare = prepare,
     };
 
     input->thread = input_Create(player, item, &cfg);
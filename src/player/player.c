@@ -52,6 +52,71 @@ static_assert(VLC_PLAYER_TITLE_MENU == INPUT_TITLE_MENU &&
 #define vlc_player_foreach_inputs(it) \
     for (struct vlc_player_input *it = player->input; it != NULL; it = NULL)
 
+static void
+vlc_player_DiscardNextInput(vlc_player_t *player)
+{
+    struct vlc_player_input *input = player->next_input;
+    if (input == NULL)
+        return;
+    player->next_input = NULL;
+
+    /* It stays silent until the destructor joins it */
+    input_Stop(input->thread);
+    vlc_player_destructor_AddStoppingInput(player, input);
+}
+
+void
+vlc_player_PrepareNextMedia(vlc_player_t *player)
+{
+    struct vlc_player_input *input = player->input;
+
+    if (!player->started || player->next_media == NULL || player->next_prepared
+     || input == NULL || input->length == VLC_TICK_INVALID
+     || input->time == VLC_TICK_INVALID)
+        return;
+
+    vlc_tick_t ahead =
+        VLC_TICK_FROM_MS(var_InheritInteger(player, "prepare-next"));
+    if (ahead == 0 || input->length - input->time > ahead)
+        return;
+
+    /* Only try once per next media */
+    player->next_prepared = true;
+
+    /* A stream output chain can't be shared by two inputs */
+    char *sout = var_InheritString(player, "sout");
+    if (sout != NULL)
+    {
+        free(sout);
+        return;
+    }
+
+    /* Tracks string ids are only remembered for the current media */
+    char *string_ids[] = {
+        player->video_string_ids, player->audio_string_ids,
+        player->sub_string_ids,
+    };
+    player->video_string_ids = player->audio_string_ids =
+    player->sub_string_ids = NULL;
+
+    struct vlc_player_input *next =
+        vlc_player_input_New(player, player->next_media, true);
+
+    player->video_string_ids = string_ids[0];
+    player->audio_string_ids = string_ids[1];
+    player->sub_string_ids = string_ids[2];
+
+    if (next == NULL)
+        return;
+
+    if (input_Start(next->thread) != VLC_SUCCESS)
+    {
+        vlc_player_destructor_AddJoinableInput(player, next);
+        return;
+    }
+    player->next_input = next;
+}
+
 int
 vlc_player_OpenNextMedia(vlc_player_t *player)
 {
@@ -65,6 +130,7 @@ vlc_player_OpenNextMedia(vlc_player_t *player)
     player->sub_string_ids = NULL;
 
     int ret = VLC_SUCCESS;
+    bool prepared = false;
     if (player->releasing_media)
     {
         assert(player->media);
@@ -81,9 +147,23 @@ vlc_player_OpenNextMedia(vlc_player_t *player)
             input_item_Release(player->media);
         player->media = player->next_media;
         player->next_media = NULL;
+        player->next_prepared = false;
 
-        struct vlc_player_input *input = player->input =
-            vlc_player_input_New(player, player->media);
+        struct vlc_player_input *input = player->next_input;
+        if (input != NULL && input_GetItem(input->thread) == player->media)
+        {
+            /* Opened ahead of time, it only has to be started */
+            player->next_input = NULL;
+            input->silent = false;
+            player->input = input;
+            prepared = true;
+        }
+        else
+        {
+            vlc_player_DiscardNextInput(player);
+            input = player->input =
+                vlc_player_input_New(player, player->media, false);
+        }
         if (!input)
         {
             input_item_Release(player->media);
@@ -92,6 +172,8 @@ vlc_player_OpenNextMedia(vlc_player_t *player)
         }
     }
     vlc_player_SendEvent(player, on_current_media_changed, player->media);
+    if (prepared)
+        vlc_player_input_SendPreparedEvents(player->input);
     if (player->input && player->input->ml.delay_restore)
     {
         vlc_player_SendEvent(player, on_playback_restore_queried);
@@ -172,11 +254,35 @@ vlc_player_destructor_AddJoinableInput(vlc_player_t *player,
     vlc_player_destructor_AddInput(player, input);
 }
 
+static bool vlc_player_destructor_IsListEmpty(struct vlc_list *list,
+                                              bool all)
+{
+    struct vlc_player_input *input;
+    vlc_list_foreach(input, list, node)
+    {
+        if (all || !input->silent)
+            return false;
+    }
+    return true;
+}
+
+/* Inputs prepared for a next media that was not played never owned the
+ * outputs: the next media doesn't have to wait for them to be stopped. */
+static bool vlc_player_destructor_HasInputs(vlc_player_t *player, bool all)
+{
+    struct vlc_list *lists[] = {
+        &player->destructor.inputs, &player->destructor.stopping_inputs,
+        &player->destructor.joinable_inputs,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(lists); ++i)
+        if (!vlc_player_destructor_IsListEmpty(lists[i], all))
+            return true;
+    return false;
+}
+
 static bool vlc_player_destructor_IsEmpty(vlc_player_t *player)
 {
-    return vlc_list_is_empty(&player->destructor.inputs)
-        && vlc_list_is_empty(&player->destructor.stopping_inputs)
-        && vlc_list_is_empty(&player->destructor.joinable_inputs);
+    return !vlc_player_destructor_HasInputs(player, false);
 }
 
 static void *
@@ -191,7 +297,7 @@ vlc_player_destructor_Thread(void *data)
     /* Terminate this thread when the player is deleting (vlc_player_Delete()
      * was called) and when all input_thread_t all stopped and released. */
     while (!player->deleting
-        || !vlc_player_destructor_IsEmpty(player))
+        || vlc_player_destructor_HasInputs(player, true))
     {
         /* Wait for an input to stop or close. No while loop here since we want
          * to leave this code path when the player is deleting. */
@@ -219,6 +325,19 @@ vlc_player_destructor_Thread(void *data)
             !vlc_list_is_empty(&player->destructor.joinable_inputs);
         vlc_list_foreach(input, &player->destructor.joinable_inputs, node)
         {
+            if (input->silent)
+            {
+                /* Prepared for a next media that was not played */
+                if (input->titles)
+                {
+                    vlc_player_title_list_Release(input->titles);
+                    input->titles = NULL;
+                }
+                vlc_list_remove(&input->node);
+                vlc_player_input_Delete(input);
+                continue;
+            }
+
             vlc_player_UpdateMLStates(player, input);
 
             keep_sout = var_GetBool(input->thread, "sout-keep");
@@ -998,6 +1117,8 @@ static void
 vlc_player_InvalidateNextMedia(vlc_player_t *player)
 {
     vlc_player_assert_locked(player);
+    vlc_player_DiscardNextInput(player);
+    player->next_prepared = false;
     if (player->next_media)
     {
         input_item_Release(player->next_media);
@@ -1054,6 +1175,12 @@ vlc_player_SetNextMedia(vlc_player_t *player, input_item_t *media)
     /* Order is important, hold the new media before releasing the old one */
     input_item_t *next_media = media != NULL ? input_item_Hold(media) : NULL;
 
+    if (player->next_media != media)
+    {
+        vlc_player_DiscardNextInput(player);
+        player->next_prepared = false;
+    }
+
     if (player->next_media != NULL)
         input_item_Release(player->next_media);
 
@@ -1196,7 +1323,7 @@ vlc_player_Start(vlc_player_t *player)
     if (!player->input)
     {
         /* Possible if the player was stopped by the user */
-        player->input = vlc_player_input_New(player, player->media);
+        player->input = vlc_player_input_New(player, player->media, false);
 
         if (!player->input)
             return VLC_ENOMEM;
@@ -1858,6 +1985,30 @@ vlc_player_GetSignal(vlc_player_t *player, float *quality, float *strength)
     return VLC_EGENERIC;
 }
 
+int
+vlc_player_GetTimeshiftWindow(vlc_player_t *player, vlc_tick_t *length,
+                              vlc_tick_t *delay)
+{
+    assert(length && delay);
+    struct vlc_player_input *input = vlc_player_get_input_locked(player);
+
+    if (input && input->timeshift.length > 0)
+    {
+        *length = input->timeshift.length;
+        *delay = input->timeshift.delay;
+        return VLC_SUCCESS;
+    }
+    return VLC_EGENERIC;
+}
+
+void
+vlc_player_SeekTimeshift(vlc_player_t *player, vlc_tick_t delay)
+{
+    struct vlc_player_input *input = vlc_player_get_input_locked(player);
+    if (input != NULL && input->timeshift.length > 0)
+        vlc_player_input_SeekTimeshift(input, delay);
+}
+
 const struct input_stats_t *
 vlc_player_GetStatistics(vlc_player_t *player)
 {
@@ -1944,6 +2095,7 @@ vlc_player_Delete(vlc_player_t *player)
         vlc_player_destructor_AddInput(player, player->input);
         player->input = NULL;
     }
+    vlc_player_DiscardNextInput(player);
 
     player->deleting = true;
     vlc_cond_signal(&player->destructor.wait);
@@ -2016,6 +2168,8 @@ vlc_player_New(vlc_object_t *parent, enum vlc_player_lock_type lock_type)
 
     player->releasing_media = false;
     player->next_media = NULL;
+    player->next_input = NULL;
+    player->next_prepared = false;
 
     player->video_string_ids = player->audio_string_ids =
     player->sub_string_ids = NULL;
@@ -59,6 +59,12 @@ struct vlc_player_input
     vlc_player_t *player;
     bool started;
 
+    /* Opened ahead of time for the next media: the thread waits before
+     * playback and the events are not forwarded to the listeners until the
+     * input becomes the current one. */
+    bool prepared;
+    bool silent;
+
     /* Monitor the OPENING_S -> PLAYING_S transition. */
     bool playing;
 
@@ -80,6 +86,11 @@ struct vlc_player_input
     float signal_strength;
     float cache;
 
+    struct {
+        vlc_tick_t length;
+        vlc_tick_t delay;
+    } timeshift;
+
     struct input_stats_t stats;
 
     vlc_tick_t cat_delays[DATA_ES];
@@ -259,6 +270,8 @@ struct vlc_player_t
 
     bool releasing_media;
     input_item_t *next_media;
+    struct vlc_player_input *next_input; /* prepared for next_media */
+    bool next_prepared; /* preparing next_media was already tried */
 
     char *video_string_ids;
     char *audio_string_ids;
@@ -323,6 +336,13 @@ vlc_player_get_input_locked(vlc_player_t *player)
     } \
 } while(0)
 
+/* The events of an input prepared ahead of time are only sent once it
+ * becomes the current one, see vlc_player_input_SendPreparedEvents() */
+#define vlc_player_input_SendEvent(input, event, ...) do { \
+    if (!(input)->silent) \
+        vlc_player_SendEvent((input)->player, event, ##__VA_ARGS__); \
+} while(0)
+
 static inline const char *
 es_format_category_to_string(enum es_format_category_e cat)
 {
@@ -345,6 +365,9 @@ vlc_player_GetObject(vlc_player_t *player);
 int
 vlc_player_OpenNextMedia(vlc_player_t *player);
 
+void
+vlc_player_PrepareNextMedia(vlc_player_t *player);
+
 void
 vlc_player_destructor_AddStoppingInput(vlc_player_t *player,
                                        struct vlc_player_input *input);
@@ -419,7 +442,7 @@ vlc_player_input_FindTrackById(struct vlc_player_input *input, vlc_es_id_t *id,
                                size_t *idx);
 
 struct vlc_player_input *
-vlc_player_input_New(vlc_player_t *player, input_item_t *item);
+vlc_player_input_New(vlc_player_t *player, input_item_t *item, bool prepare);
 
 void
 vlc_player_input_Delete(struct vlc_player_input *input);
@@ -444,6 +467,9 @@ vlc_player_input_GetPos(struct vlc_player_input *input, bool seeking,
 int
 vlc_player_input_Start(struct vlc_player_input *input);
 
+void
+vlc_player_input_SendPreparedEvents(struct vlc_player_input *input);
+
 void
 vlc_player_input_SeekByPos(struct vlc_player_input *input, double position,
                            enum vlc_player_seek_speed speed,
@@ -454,6 +480,10 @@ vlc_player_input_SeekByTime(struct vlc_player_input *input, vlc_tick_t time,
                             enum vlc_player_seek_speed speed,
                             enum vlc_player_whence whence);
 
+void
+vlc_player_input_SeekTimeshift(struct vlc_player_input *input,
+                               vlc_tick_t delay);
+
 void
 vlc_player_input_UpdateViewpoint(struct vlc_player_input *input,
                                  const vlc_viewpoint_t *viewpoint,
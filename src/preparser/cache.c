@@ -0,0 +1,672 @@
+/*****************************************************************************
+ * cache.c : Preparsing results cache
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_input_item.h>
+#include <vlc_meta.h>
+#include <vlc_fs.h>
+#include <vlc_strings.h>
+#include <vlc_url.h>
+#include <vlc_hash.h>
+#include <vlc_memstream.h>
+#include <vlc_vector.h>
+
+#include "input/item.h"
+#include "cache.h"
+
+/* An entry is named after the hash of the item URI. It holds the URI and the
+ * size and modification time of the file when it was parsed, followed by the
+ * duration, the meta data and the tracks. Integers are stored in host order,
+ * the cache is not meant to be shared between machines. The version must be
+ * bumped when the stored fields change. */
+static const char CACHE_MAGIC[] = "VLC preparsed 2\n";
+/* Entries saved by builds with other meta types or track formats are
+ * ignored */
+static const int64_t cache_layout[] = {
+    VLC_META_TYPE_COUNT,
+    sizeof(es_format_t),
+    sizeof(audio_format_t),
+    sizeof(video_format_t),
+    sizeof(subs_format_t),
+};
+#define CACHE_ENTRY_MAX_SIZE (1 << 20)
+/* The oldest entries are evicted above this size, down to 3/4 of it */
+#define CACHE_MAX_SIZE (32 << 20)
+/* Temporary files older than this were left by interrupted saves */
+#define CACHE_TMP_MAX_AGE 3600
+
+struct cache_key
+{
+    char *psz_uri;
+    char *psz_dir;
+    char *psz_entry;
+    int64_t i_size;
+    int64_t i_mtime;
+    int64_t i_mtime_nsec;
+};
+
+static void CacheKeyClean( struct cache_key *p_key )
+{
+    free( p_key->psz_uri );
+    free( p_key->psz_dir );
+    free( p_key->psz_entry );
+}
+
+static char *CacheGetDir( void )
+{
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( unlikely(psz_cachedir == NULL) )
+        return NULL;
+
+    char *psz_dir;
+    if( asprintf( &psz_dir, "%s" DIR_SEP "preparsed", psz_cachedir ) == -1 )
+        psz_dir = NULL;
+    free( psz_cachedir );
+    return psz_dir;
+}
+
+/* Files rewritten within the same second only differ by the nanoseconds */
+static int64_t StatMtimeNsec( const struct stat *st )
+{
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    VLC_UNUSED(st);
+    return 0;
+#endif
+}
+
+static int CacheGetKey( input_item_t *p_item, struct cache_key *p_key )
+{
+    vlc_mutex_lock( &p_item->lock );
+    char *psz_uri = p_item->psz_uri ? strdup( p_item->psz_uri ) : NULL;
+    vlc_mutex_unlock( &p_item->lock );
+    if( psz_uri == NULL )
+        return VLC_EGENERIC;
+
+    /* Only local files can be identified without opening them */
+    char *psz_path = vlc_uri2path( psz_uri );
+    struct stat st;
+    if( psz_path == NULL || vlc_stat( psz_path, &st ) != 0
+     || !S_ISREG( st.st_mode ) )
+    {
+        free( psz_path );
+        free( psz_uri );
+        return VLC_EGENERIC;
+    }
+    free( psz_path );
+
+    char psz_hash[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hash_md5_t md5;
+    vlc_hash_md5_Init( &md5 );
+    vlc_hash_md5_Update( &md5, psz_uri, strlen( psz_uri ) );
+    vlc_hash_FinishHex( &md5, psz_hash );
+
+    p_key->psz_uri = psz_uri;
+    p_key->psz_entry = NULL;
+    p_key->psz_dir = CacheGetDir();
+    if( p_key->psz_dir != NULL
+     && asprintf( &p_key->psz_entry, "%s" DIR_SEP "%s",
+                  p_key->psz_dir, psz_hash ) == -1 )
+        p_key->psz_entry = NULL;
+
+    if( unlikely(p_key->psz_entry == NULL) )
+    {
+        CacheKeyClean( p_key );
+        return VLC_ENOMEM;
+    }
+
+    p_key->i_size = st.st_size;
+    p_key->i_mtime = st.st_mtime;
+    p_key->i_mtime_nsec = StatMtimeNsec( &st );
+    return VLC_SUCCESS;
+}
+
+/* */
+static void WriteInt( struct vlc_memstream *ms, int64_t i )
+{
+    vlc_memstream_write( ms, &i, sizeof(i) );
+}
+
+static void WriteString( struct vlc_memstream *ms, const char *psz )
+{
+    if( psz == NULL )
+    {
+        WriteInt( ms, -1 );
+        return;
+    }
+    size_t i_len = strlen( psz );
+    WriteInt( ms, i_len );
+    vlc_memstream_write( ms, psz, i_len );
+}
+
+static void WriteEs( struct vlc_memstream *ms,
+                     const struct input_item_es *p_item_es )
+{
+    const es_format_t *fmt = &p_item_es->es;
+
+    WriteString( ms, p_item_es->id );
+    WriteInt( ms, p_item_es->id_stable );
+    WriteInt( ms, fmt->i_cat );
+    WriteInt( ms, fmt->i_codec );
+    WriteInt( ms, fmt->i_original_fourcc );
+    WriteInt( ms, fmt->i_id );
+    WriteInt( ms, fmt->i_group );
+    WriteInt( ms, fmt->i_priority );
+    WriteString( ms, fmt->psz_language );
+    WriteString( ms, fmt->psz_description );
+    WriteInt( ms, fmt->i_bitrate );
+    WriteInt( ms, fmt->i_profile );
+    WriteInt( ms, fmt->i_level );
+
+    switch( fmt->i_cat )
+    {
+        case AUDIO_ES:
+            WriteInt( ms, fmt->audio.i_format );
+            WriteInt( ms, fmt->audio.i_rate );
+            WriteInt( ms, fmt->audio.i_physical_channels );
+            WriteInt( ms, fmt->audio.i_chan_mode );
+            WriteInt( ms, fmt->audio.i_channels );
+            WriteInt( ms, fmt->audio.i_bitspersample );
+            break;
+        case VIDEO_ES:
+            WriteInt( ms, fmt->video.i_chroma );
+            WriteInt( ms, fmt->video.i_width );
+            WriteInt( ms, fmt->video.i_height );
+            WriteInt( ms, fmt->video.i_x_offset );
+            WriteInt( ms, fmt->video.i_y_offset );
+            WriteInt( ms, fmt->video.i_visible_width );
+            WriteInt( ms, fmt->video.i_visible_height );
+            WriteInt( ms, fmt->video.i_sar_num );
+            WriteInt( ms, fmt->video.i_sar_den );
+            WriteInt( ms, fmt->video.i_frame_rate );
+            WriteInt( ms, fmt->video.i_frame_rate_base );
+            WriteInt( ms, fmt->video.orientation );
+            WriteInt( ms, fmt->video.primaries );
+            WriteInt( ms, fmt->video.transfer );
+            WriteInt( ms, fmt->video.space );
+            WriteInt( ms, fmt->video.color_range );
+            WriteInt( ms, fmt->video.multiview_mode );
+            WriteInt( ms, fmt->video.projection_mode );
+            break;
+        case SPU_ES:
+            WriteString( ms, fmt->subs.psz_encoding );
+            break;
+        default:
+            break;
+    }
+}
+
+/* */
+struct cache_reader
+{
+    const uint8_t *p_data;
+    size_t i_data;
+    bool b_error;
+};
+
+static int64_t ReadInt( struct cache_reader *r )
+{
+    int64_t i;
+    if( r->i_data < sizeof(i) )
+    {
+        r->b_error = true;
+        return 0;
+    }
+    memcpy( &i, r->p_data, sizeof(i) );
+    r->p_data += sizeof(i);
+    r->i_data -= sizeof(i);
+    return i;
+}
+
+static char *ReadString( struct cache_reader *r )
+{
+    int64_t i_len = ReadInt( r );
+    if( r->b_error || i_len == -1 )
+        return NULL;
+    if( i_len < 0 || (uint64_t) i_len > r->i_data )
+    {
+        r->b_error = true;
+        return NULL;
+    }
+
+    char *psz = strndup( (const char *) r->p_data, i_len );
+    if( unlikely(psz == NULL) )
+        r->b_error = true;
+    r->p_data += i_len;
+    r->i_data -= i_len;
+    return psz;
+}
+
+static void ReadEs( struct cache_reader *r, struct input_item_es *p_item_es )
+{
+    es_format_t *fmt = &p_item_es->es;
+
+    p_item_es->id = ReadString( r );
+    p_item_es->id_stable = ReadInt( r );
+
+    enum es_format_category_e i_cat = ReadInt( r );
+    es_format_Init( fmt, i_cat, ReadInt( r ) );
+    fmt->i_original_fourcc = ReadInt( r );
+    fmt->i_id = ReadInt( r );
+    fmt->i_group = ReadInt( r );
+    fmt->i_priority = ReadInt( r );
+    fmt->psz_language = ReadString( r );
+    fmt->psz_description = ReadString( r );
+    fmt->i_bitrate = ReadInt( r );
+    fmt->i_profile = ReadInt( r );
+    fmt->i_level = ReadInt( r );
+
+    switch( i_cat )
+    {
+        case AUDIO_ES:
+            fmt->audio.i_format = ReadInt( r );
+            fmt->audio.i_rate = ReadInt( r );
+            fmt->audio.i_physical_channels = ReadInt( r );
+            fmt->audio.i_chan_mode = ReadInt( r );
+            fmt->audio.i_channels = ReadInt( r );
+            fmt->audio.i_bitspersample = ReadInt( r );
+            break;
+        case VIDEO_ES:
+            fmt->video.i_chroma = ReadInt( r );
+            fmt->video.i_width = ReadInt( r );
+            fmt->video.i_height = ReadInt( r );
+            fmt->video.i_x_offset = ReadInt( r );
+            fmt->video.i_y_offset = ReadInt( r );
+            fmt->video.i_visible_width = ReadInt( r );
+            fmt->video.i_visible_height = ReadInt( r );
+            fmt->video.i_sar_num = ReadInt( r );
+            fmt->video.i_sar_den = ReadInt( r );
+            fmt->video.i_frame_rate = ReadInt( r );
+            fmt->video.i_frame_rate_base = ReadInt( r );
+            fmt->video.orientation = ReadInt( r );
+            fmt->video.primaries = ReadInt( r );
+            fmt->video.transfer = ReadInt( r );
+            fmt->video.space = ReadInt( r );
+            fmt->video.color_range = ReadInt( r );
+            fmt->video.multiview_mode = ReadInt( r );
+            fmt->video.projection_mode = ReadInt( r );
+            break;
+        case SPU_ES:
+            fmt->subs.psz_encoding = ReadString( r );
+            break;
+        default:
+            break;
+    }
+
+    if( p_item_es->id == NULL )
+        r->b_error = true;
+}
+
+static void *CacheReadEntry( const char *psz_entry, size_t *pi_size )
+{
+    FILE *f = vlc_fopen( psz_entry, "rb" );
+    if( f == NULL )
+        return NULL;
+
+    void *p_data = NULL;
+    struct stat st;
+    if( fstat( fileno( f ), &st ) == 0 && st.st_size > 0
+     && st.st_size <= CACHE_ENTRY_MAX_SIZE )
+    {
+        p_data = malloc( st.st_size );
+        if( p_data != NULL && fread( p_data, 1, st.st_size, f ) != (size_t) st.st_size )
+        {
+            free( p_data );
+            p_data = NULL;
+        }
+        *pi_size = st.st_size;
+    }
+    fclose( f );
+    return p_data;
+}
+
+/* */
+int input_FindPreparsedInCache( vlc_object_t *obj, input_item_t *p_item )
+{
+    struct cache_key key;
+    if( CacheGetKey( p_item, &key ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    size_t i_data;
+    uint8_t *p_data = CacheReadEntry( key.psz_entry, &i_data );
+    if( p_data == NULL )
+    {
+        CacheKeyClean( &key );
+        return VLC_EGENERIC;
+    }
+
+    struct cache_reader r = {
+        .p_data = p_data,
+        .i_data = i_data,
+        .b_error = false,
+    };
+
+    const size_t i_magic = sizeof(CACHE_MAGIC) - 1;
+    if( i_data < i_magic || memcmp( p_data, CACHE_MAGIC, i_magic ) )
+        r.b_error = true;
+    else
+    {
+        r.p_data += i_magic;
+        r.i_data -= i_magic;
+    }
+
+    bool b_valid = true;
+    for( size_t i = 0; i < ARRAY_SIZE(cache_layout); i++ )
+        b_valid &= ReadInt( &r ) == cache_layout[i];
+
+    /* The file changed since it was parsed, or the hash collided */
+    char *psz_uri = ReadString( &r );
+    int64_t i_size = ReadInt( &r );
+    int64_t i_mtime = ReadInt( &r );
+    int64_t i_mtime_nsec = ReadInt( &r );
+    b_valid = b_valid && !r.b_error && psz_uri != NULL
+           && !strcmp( psz_uri, key.psz_uri )
+           && i_size == key.i_size && i_mtime == key.i_mtime
+           && i_mtime_nsec == key.i_mtime_nsec;
+    free( psz_uri );
+    if( !b_valid )
+    {
+        free( p_data );
+        CacheKeyClean( &key );
+        return VLC_EGENERIC;
+    }
+
+    /* Read everything before touching the item, so that a truncated entry
+     * does not leave it half updated */
+    vlc_tick_t i_duration = ReadInt( &r );
+
+    vlc_meta_t *p_meta = vlc_meta_New();
+    if( unlikely(p_meta == NULL) )
+        r.b_error = true;
+    for( int i = 0; i < VLC_META_TYPE_COUNT && !r.b_error; i++ )
+    {
+        char *psz_value = ReadString( &r );
+        if( psz_value != NULL )
+            vlc_meta_Set( p_meta, i, psz_value );
+        free( psz_value );
+    }
+
+    int64_t i_extra = r.b_error ? 0 : ReadInt( &r );
+    for( int64_t i = 0; i < i_extra && !r.b_error; i++ )
+    {
+        char *psz_name = ReadString( &r );
+        char *psz_value = ReadString( &r );
+        if( psz_name != NULL )
+            vlc_meta_SetExtra( p_meta, psz_name, psz_value );
+        free( psz_name );
+        free( psz_value );
+    }
+
+    input_item_es_vector es_vec = VLC_VECTOR_INITIALIZER;
+    int64_t i_es = r.b_error ? 0 : ReadInt( &r );
+    if( i_es < 0 || (uint64_t) i_es > r.i_data
+     || !vlc_vector_reserve( &es_vec, i_es ) )
+        r.b_error = true;
+    for( int64_t i = 0; i < i_es && !r.b_error; i++ )
+    {
+        struct input_item_es item_es;
+        ReadEs( &r, &item_es );
+        vlc_vector_push( &es_vec, item_es );
+    }
+
+    if( !r.b_error )
+    {
+        vlc_mutex_lock( &p_item->lock );
+        vlc_meta_Merge( p_item->p_meta, p_meta );
+        vlc_mutex_unlock( &p_item->lock );
+
+        input_item_SetDuration( p_item, i_duration );
+
+        struct input_item_es *p_item_es;
+        vlc_vector_foreach_ref( p_item_es, &es_vec )
+            input_item_UpdateTracksInfo( p_item, &p_item_es->es, p_item_es->id,
+                                         p_item_es->id_stable );
+
+        msg_Dbg( obj, "preparsed %s from cache", key.psz_uri );
+    }
+
+    struct input_item_es *p_item_es;
+    vlc_vector_foreach_ref( p_item_es, &es_vec )
+    {
+        es_format_Clean( &p_item_es->es );
+        free( p_item_es->id );
+    }
+    vlc_vector_destroy( &es_vec );
+    if( p_meta != NULL )
+        vlc_meta_Delete( p_meta );
+    free( p_data );
+    CacheKeyClean( &key );
+
+    return r.b_error ? VLC_EGENERIC : VLC_SUCCESS;
+}
+
+void input_SavePreparsed( vlc_object_t *obj, input_item_t *p_item )
+{
+    /* Playlists and other files without tracks are cheap to parse again,
+     * and might need to expand their sub items */
+    vlc_mutex_lock( &p_item->lock );
+    bool b_has_es = p_item->es_vec.size > 0;
+    vlc_mutex_unlock( &p_item->lock );
+    if( !b_has_es )
+        return;
+
+    struct cache_key key;
+    if( CacheGetKey( p_item, &key ) != VLC_SUCCESS )
+        return;
+
+    struct vlc_memstream ms;
+    if( vlc_memstream_open( &ms ) )
+    {
+        CacheKeyClean( &key );
+        return;
+    }
+
+    vlc_memstream_write( &ms, CACHE_MAGIC, sizeof(CACHE_MAGIC) - 1 );
+    for( size_t i = 0; i < ARRAY_SIZE(cache_layout); i++ )
+        WriteInt( &ms, cache_layout[i] );
+    WriteString( &ms, key.psz_uri );
+    WriteInt( &ms, key.i_size );
+    WriteInt( &ms, key.i_mtime );
+    WriteInt( &ms, key.i_mtime_nsec );
+
+    vlc_mutex_lock( &p_item->lock );
+
+    WriteInt( &ms, p_item->i_duration );
+
+    for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+    {
+        const char *psz_value = p_item->p_meta ?
+                                vlc_meta_Get( p_item->p_meta, i ) : NULL;
+        WriteString( &ms, psz_value );
+    }
+
+    char **ppsz_names = p_item->p_meta ?
+                        vlc_meta_CopyExtraNames( p_item->p_meta ) : NULL;
+    int64_t i_extra = 0;
+    while( ppsz_names != NULL && ppsz_names[i_extra] != NULL )
+        i_extra++;
+    WriteInt( &ms, i_extra );
+    for( int64_t i = 0; i < i_extra; i++ )
+    {
+        WriteString( &ms, ppsz_names[i] );
+        WriteString( &ms, vlc_meta_GetExtra( p_item->p_meta, ppsz_names[i] ) );
+        free( ppsz_names[i] );
+    }
+    free( ppsz_names );
+
+    WriteInt( &ms, p_item->es_vec.size );
+    for( size_t i = 0; i < p_item->es_vec.size; i++ )
+        WriteEs( &ms, &p_item->es_vec.data[i] );
+
+    vlc_mutex_unlock( &p_item->lock );
+
+    if( vlc_memstream_close( &ms ) )
+    {
+        CacheKeyClean( &key );
+        return;
+    }
+
+    /* Write aside then rename, so that readers never see partial entries */
+    char *psz_tmp;
+    if( vlc_mkdir_parent( key.psz_dir, 0700 ) != 0 && errno != EEXIST )
+        psz_tmp = NULL;
+    else if( asprintf( &psz_tmp, "%s" DIR_SEP "tmp.XXXXXX", key.psz_dir ) == -1 )
+        psz_tmp = NULL;
+
+    int fd = psz_tmp != NULL ? vlc_mkstemp( psz_tmp ) : -1;
+    if( fd != -1 )
+    {
+        size_t i_written = 0;
+        while( i_written < ms.length )
+        {
+            ssize_t i_ret = vlc_write( fd, ms.ptr + i_written,
+                                       ms.length - i_written );
+            if( i_ret < 0 )
+            {
+                if( errno == EINTR )
+                    continue;
+                break;
+            }
+            i_written += i_ret;
+        }
+        vlc_close( fd );
+
+        if( i_written != ms.length
+         || vlc_rename( psz_tmp, key.psz_entry ) != 0 )
+        {
+            msg_Warn( obj, "cannot save %s to the preparse cache: %s",
+                      key.psz_uri, vlc_strerror_c( errno ) );
+            vlc_unlink( psz_tmp );
+        }
+    }
+
+    free( psz_tmp );
+    free( ms.ptr );
+    CacheKeyClean( &key );
+}
+
+struct cache_file
+{
+    char *psz_path;
+    int64_t i_size;
+    time_t i_mtime;
+};
+
+static int CacheFileCmp( const void *a, const void *b )
+{
+    const struct cache_file *fa = a, *fb = b;
+    return (fa->i_mtime > fb->i_mtime) - (fa->i_mtime < fb->i_mtime);
+}
+
+void input_PrunePreparsedCache( vlc_object_t *obj )
+{
+    char *psz_dir = CacheGetDir();
+    if( unlikely(psz_dir == NULL) )
+        return;
+
+    vlc_DIR *dir = vlc_opendir( psz_dir );
+    if( dir == NULL )
+    {
+        free( psz_dir );
+        return;
+    }
+
+    struct VLC_VECTOR(struct cache_file) files = VLC_VECTOR_INITIALIZER;
+    int64_t i_total = 0;
+    time_t now = time( NULL );
+
+    const char *psz_name;
+    while( (psz_name = vlc_readdir( dir )) != NULL )
+    {
+        if( psz_name[0] == '.' )
+            continue;
+
+        char *psz_path;
+        if( asprintf( &psz_path, "%s" DIR_SEP "%s", psz_dir, psz_name ) == -1 )
+            break;
+
+        struct stat st;
+        if( vlc_stat( psz_path, &st ) != 0 || !S_ISREG( st.st_mode ) )
+        {
+            free( psz_path );
+            continue;
+        }
+
+        if( !strncmp( psz_name, "tmp.", 4 ) )
+        {
+            /* Other savers rename their file within milliseconds */
+            if( now - st.st_mtime > CACHE_TMP_MAX_AGE )
+                vlc_unlink( psz_path );
+            free( psz_path );
+            continue;
+        }
+
+        struct cache_file file = {
+            .psz_path = psz_path,
+            .i_size = st.st_size,
+            .i_mtime = st.st_mtime,
+        };
+        if( !vlc_vector_push( &files, file ) )
+        {
+            free( psz_path );
+            break;
+        }
+        i_total += st.st_size;
+    }
+    vlc_closedir( dir );
+    free( psz_dir );
+
+    if( i_total > CACHE_MAX_SIZE )
+    {
+        /* Entries are written once per file change: evict the oldest ones */
+        qsort( files.data, files.size, sizeof(*files.data), CacheFileCmp );
+
+        size_t i_evicted = 0;
+        for( size_t i = 0; i < files.size
+                        && i_total > CACHE_MAX_SIZE / 4 * 3; i++ )
+        {
+            if( vlc_unlink( files.data[i].psz_path ) == 0 )
+            {
+                i_total -= files.data[i].i_size;
+                i_evicted++;
+            }
+        }
+        msg_Dbg( obj, "evicted %zu entries from the preparse cache",
+                 i_evicted );
+    }
+
+    struct cache_file *p_file;
+    vlc_vector_foreach_ref( p_file, &files )
+        free( p_file->psz_path );
+    vlc_vector_destroy( &files );
+}
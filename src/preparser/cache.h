@@ -0,0 +1,46 @@
+/*****************************************************************************
+ * cache.h : Preparsing results cache
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _INPUT_PREPARSER_CACHE_H
+#define _INPUT_PREPARSER_CACHE_H 1
+
+/**
+ * Restores the meta data, duration and tracks of a previous parsing, if the
+ * item is a local file whose size and modification time did not change.
+ *
+ * @return VLC_SUCCESS if the item was found in the cache
+ */
+int input_FindPreparsedInCache( vlc_object_t *, input_item_t * );
+
+/**
+ * Saves the meta data, duration and tracks of a parsed local file item.
+ *
+ * Items without tracks are not saved. Items with attachments must not be
+ * saved either, since attachments are not restored from the cache.
+ */
+void input_SavePreparsed( vlc_object_t *, input_item_t * );
+
+/**
+ * Removes the temporary files left by interrupted saves, and evicts the
+ * oldest entries once the cache grows above its size limit.
+ */
+void input_PrunePreparsedCache( vlc_object_t * );
+
+#endif
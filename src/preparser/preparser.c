@@ -31,16 +31,23 @@
 #include <vlc_interrupt.h>
 #include <vlc_modules.h>
 #include <vlc_fs.h>
+#include <vlc_image.h>
+#include <vlc_vector.h>
 
 #include "input/input_interface.h"
 #include "input/input_internal.h"
 #include "fetcher.h"
+#include "cache.h"
+
+/* Number of cache saves between two prunings, starting with the first one */
+#define PREPARSER_CACHE_PRUNE_INTERVAL 256
 
 union vlc_preparser_cbs
 {
     const input_item_parser_cbs_t *parser;
     const struct vlc_thumbnailer_cbs *thumbnailer;
     const struct vlc_thumbnailer_to_files_cbs *thumbnailer_to_files;
+    const struct vlc_thumbnailer_storyboard_cbs *storyboard;
 };
 
 struct vlc_preparser_t
@@ -51,6 +58,8 @@ struct vlc_preparser_t
     vlc_executor_t *thumbnailer;
     vlc_executor_t *thumbnailer_to_files;
     vlc_tick_t timeout;
+    bool cache; /**< reuse the results of unchanged local files */
+    atomic_uint cache_saves; /**< to prune the cache every few saves */
 
     vlc_mutex_t lock;
     vlc_preparser_req_id current_id;
@@ -67,6 +76,24 @@ struct task_thumbnail_output
     unsigned int creat_mode;
 };
 
+struct task_storyboard
+{
+    vlc_tick_t *times; /**< seek points, NULL in interval mode */
+    size_t count; /**< number of seek points, or limit in interval mode */
+    vlc_tick_t interval;
+    bool fast_seek;
+    unsigned columns;
+    unsigned tile_width;
+    unsigned tile_height;
+
+    /* Updated from the input events */
+    atomic_bool seekable;
+    _Atomic vlc_tick_t length;
+
+    struct VLC_VECTOR(vlc_tick_t) index; /**< time of each generated frame */
+    struct VLC_VECTOR(picture_t *) tiles; /**< scaled frames, if columns > 0 */
+};
+
 struct task
 {
     vlc_preparser_t *preparser;
@@ -81,9 +108,12 @@ struct task
     picture_t *pic;
     struct task_thumbnail_output *outputs;
     size_t output_count;
+    struct task_storyboard *storyboard;
 
     vlc_sem_t preparse_ended;
     int preparse_status;
+    bool subtree_added;
+    bool attachments_added;
     atomic_bool interrupted;
 
     struct vlc_runnable runnable; /**< to be passed to the executor */
@@ -108,6 +138,7 @@ TaskNew(vlc_preparser_t *preparser, void (*run)(void *), input_item_t *item,
     task->pic = NULL;
     task->outputs = NULL;
     task->output_count = 0;
+    task->storyboard = NULL;
 
     if (thumb_arg == NULL)
         task->thumb_arg = (struct vlc_thumbnailer_arg) {
@@ -121,6 +152,8 @@ TaskNew(vlc_preparser_t *preparser, void (*run)(void *), input_item_t *item,
 
     vlc_sem_init(&task->preparse_ended, 0);
     task->preparse_status = VLC_EGENERIC;
+    task->subtree_added = false;
+    task->attachments_added = false;
     atomic_init(&task->interrupted, false);
 
     task->runnable.run = run;
@@ -140,6 +173,17 @@ TaskDelete(struct task *task)
     for (size_t i = 0; i < task->output_count; ++i)
         free(task->outputs[i].file_path);
     free(task->outputs);
+    if (task->storyboard != NULL)
+    {
+        struct task_storyboard *sb = task->storyboard;
+        picture_t *tile;
+        vlc_vector_foreach(tile, &sb->tiles)
+            picture_Release(tile);
+        vlc_vector_destroy(&sb->tiles);
+        vlc_vector_destroy(&sb->index);
+        free(sb->times);
+        free(sb);
+    }
     if (task->i11e_ctx != NULL)
         vlc_interrupt_destroy(task->i11e_ctx);
     free(task);
@@ -205,6 +249,7 @@ OnParserSubtreeAdded(input_item_t *item, input_item_node_t *subtree,
     if (atomic_load(&task->interrupted))
         return;
 
+    task->subtree_added = true;
     if (task->cbs.parser->on_subtree_added)
         task->cbs.parser->on_subtree_added(task->item, subtree, task->userdata);
 }
@@ -220,6 +265,7 @@ OnParserAttachmentsAdded(input_item_t *item,
     if (atomic_load(&task->interrupted))
         return;
 
+    task->attachments_added = true;
     if (task->cbs.parser->on_attachments_added)
         task->cbs.parser->on_attachments_added(task->item, array, count, 
                                                task->userdata);
@@ -311,7 +357,24 @@ ParserRun(void *userdata)
             goto end;
         }
 
-        Parse(task, deadline);
+        if (preparser->cache
+         && input_FindPreparsedInCache(preparser->owner, task->item) == VLC_SUCCESS)
+            task->preparse_status = VLC_SUCCESS;
+        else
+        {
+            Parse(task, deadline);
+
+            /* Attachments are only available from a running input */
+            if (preparser->cache && task->preparse_status == VLC_SUCCESS
+             && !task->subtree_added && !task->attachments_added
+             && !atomic_load(&task->interrupted))
+            {
+                if (atomic_fetch_add(&preparser->cache_saves, 1)
+                        % PREPARSER_CACHE_PRUNE_INTERVAL == 0)
+                    input_PrunePreparsedCache(preparser->owner);
+                input_SavePreparsed(preparser->owner, task->item);
+            }
+        }
     }
 
     PreparserRemoveTask(preparser, task);
@@ -559,6 +622,280 @@ error:
         TaskDelete(task);
 }
 
+static bool
+on_storyboard_input_event( input_thread_t *input,
+                           const struct vlc_input_event *event, void *userdata )
+{
+    struct task *task = userdata;
+    struct task_storyboard *sb = task->storyboard;
+
+    switch (event->type)
+    {
+        case INPUT_EVENT_CAPABILITIES:
+            atomic_store(&sb->seekable,
+                (event->capabilities & VLC_INPUT_CAPABILITIES_SEEKABLE) != 0);
+            return true;
+        case INPUT_EVENT_TIMES:
+            if (event->times.length != VLC_TICK_INVALID)
+                atomic_store(&sb->length, event->times.length);
+            return true;
+        case INPUT_EVENT_THUMBNAIL_READY:
+            /* Only one frame is expected per seek point, the next one is
+             * only requested once this one is consumed */
+            if (task->pic != NULL)
+                return true;
+            task->pic = picture_Hold(event->thumbnail);
+            /* Don't demux up to the end of stream while the next seek point
+             * is not requested yet: the END_S state of a position that is
+             * already consumed would end the storyboard early */
+            input_ControlPushHelper(input, INPUT_CONTROL_SET_STATE,
+                                    &(vlc_value_t) { .i_int = PAUSE_S });
+            break;
+        case INPUT_EVENT_STATE:
+            if (event->state.value != ERROR_S && event->state.value != END_S)
+                return false;
+            break;
+        default:
+            return false;
+    }
+
+    vlc_sem_post(&task->preparse_ended);
+    return true;
+}
+
+static bool
+StoryboardGetTime(struct task_storyboard *sb, size_t index, vlc_tick_t *time)
+{
+    if (sb->count != 0 && index >= sb->count)
+        return false;
+
+    *time = sb->times != NULL ? sb->times[index]
+                              : (vlc_tick_t) index * sb->interval;
+
+    /* Don't wait for the end of stream when the length is known */
+    vlc_tick_t length = atomic_load(&sb->length);
+    return index == 0 || length == VLC_TICK_INVALID || *time < length;
+}
+
+static int
+StoryboardAddFrame(struct task *task, image_handler_t *image,
+                   vlc_tick_t time, picture_t *pic)
+{
+    struct task_storyboard *sb = task->storyboard;
+
+    if (task->cbs.storyboard->on_picture != NULL)
+        task->cbs.storyboard->on_picture(task->item, sb->index.size, time, pic,
+                                         task->userdata);
+
+    if (sb->columns > 0)
+    {
+        video_format_t fmt_in = pic->format;
+        if (fmt_in.i_sar_num == 0 || fmt_in.i_sar_den == 0)
+            fmt_in.i_sar_num = fmt_in.i_sar_den = 1;
+        if (fmt_in.i_visible_width == 0 || fmt_in.i_visible_height == 0)
+        {
+            fmt_in.i_visible_width = fmt_in.i_width;
+            fmt_in.i_visible_height = fmt_in.i_height;
+        }
+
+        /* All tiles share the size derived from the first frame */
+        if (sb->tile_height == 0)
+        {
+            sb->tile_height = (uint64_t) sb->tile_width
+                            * fmt_in.i_visible_height * fmt_in.i_sar_den
+                            / fmt_in.i_visible_width / fmt_in.i_sar_num;
+            if (sb->tile_height == 0)
+                sb->tile_height = 1;
+        }
+
+        video_format_t fmt_out;
+        video_format_Init(&fmt_out, VLC_CODEC_RGBA);
+        fmt_out.i_width = fmt_out.i_visible_width = sb->tile_width;
+        fmt_out.i_height = fmt_out.i_visible_height = sb->tile_height;
+        fmt_out.i_sar_num = fmt_out.i_sar_den = 1;
+
+        picture_t *tile = image_Convert(image, pic, &fmt_in, &fmt_out);
+        video_format_Clean(&fmt_out);
+        if (tile == NULL)
+            return VLC_EGENERIC;
+
+        if (!vlc_vector_push(&sb->tiles, tile))
+        {
+            picture_Release(tile);
+            return VLC_ENOMEM;
+        }
+    }
+
+    if (!vlc_vector_push(&sb->index, time))
+        return VLC_ENOMEM;
+    return VLC_SUCCESS;
+}
+
+static picture_t *
+StoryboardTile(const struct task_storyboard *sb)
+{
+    size_t count = sb->tiles.size;
+    assert(count > 0 && sb->columns > 0);
+
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_RGBA);
+    fmt.i_width = fmt.i_visible_width =
+        __MIN(sb->columns, count) * sb->tile_width;
+    fmt.i_height = fmt.i_visible_height =
+        (count + sb->columns - 1) / sb->columns * sb->tile_height;
+    fmt.i_sar_num = fmt.i_sar_den = 1;
+
+    picture_t *sprite = picture_NewFromFormat(&fmt);
+    video_format_Clean(&fmt);
+    if (sprite == NULL)
+        return NULL;
+
+    /* The tiles after the last frame stay transparent */
+    plane_t *dst = &sprite->p[0];
+    memset(dst->p_pixels, 0, (size_t) dst->i_pitch * dst->i_lines);
+
+    size_t line = (size_t) sb->tile_width * dst->i_pixel_pitch;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const plane_t *src = &sb->tiles.data[i]->p[0];
+        uint8_t *p = dst->p_pixels
+                   + i / sb->columns * sb->tile_height * dst->i_pitch
+                   + i % sb->columns * line;
+
+        for (unsigned y = 0; y < sb->tile_height; ++y)
+            memcpy(p + y * dst->i_pitch, src->p_pixels + y * src->i_pitch,
+                   line);
+    }
+    return sprite;
+}
+
+static void
+StoryboardRun(void *userdata)
+{
+    vlc_thread_set_name("vlc-run-story");
+
+    struct task *task = userdata;
+    vlc_preparser_t *preparser = task->preparser;
+    struct task_storyboard *sb = task->storyboard;
+
+    static const struct vlc_input_thread_callbacks cbs = {
+        .on_event = on_storyboard_input_event,
+    };
+
+    const struct vlc_input_thread_cfg cfg = {
+        .type = INPUT_TYPE_THUMBNAILING,
+        .hw_dec = task->thumb_arg.hw_dec ? INPUT_CFG_HW_DEC_ENABLED
+                                         : INPUT_CFG_HW_DEC_DISABLED,
+        .cbs = &cbs,
+        .cbs_data = task,
+    };
+
+    vlc_tick_t deadline = preparser->timeout != VLC_TICK_INVALID ?
+                          vlc_tick_now() + preparser->timeout :
+                          VLC_TICK_INVALID;
+
+    image_handler_t *image = NULL;
+    int status = VLC_EGENERIC;
+
+    if (sb->columns > 0)
+    {
+        image = image_HandlerCreate(preparser->owner);
+        if (image == NULL)
+            goto end;
+    }
+
+    input_thread_t* input =
+            input_Create( preparser->owner, task->item, &cfg );
+    if (!input)
+        goto end;
+
+    vlc_tick_t time;
+    size_t index = 0;
+    bool has_time = StoryboardGetTime(sb, index, &time);
+    assert(has_time); (void) has_time;
+    if (time > 0)
+        input_SetTime(input, time, sb->fast_seek);
+
+    if (input_Start(input) != VLC_SUCCESS)
+    {
+        input_Close(input);
+        goto end;
+    }
+
+    /* Seek points are requested one after the other: the thumbnailing
+     * decoder outputs the first picture after each flush, the input is only
+     * opened and probed once for the whole storyboard */
+    for (;;)
+    {
+        if (deadline == VLC_TICK_INVALID)
+            vlc_sem_wait(&task->preparse_ended);
+        else if (vlc_sem_timedwait(&task->preparse_ended, deadline))
+        {
+            status = VLC_ETIMEOUT;
+            break;
+        }
+
+        if (atomic_load(&task->interrupted))
+        {
+            status = -EINTR;
+            break;
+        }
+
+        picture_t *pic = task->pic;
+        if (pic == NULL)
+        {
+            /* End of stream or error */
+            status = sb->index.size > 0 ? VLC_SUCCESS : VLC_EGENERIC;
+            break;
+        }
+
+        status = StoryboardAddFrame(task, image, time, pic);
+        task->pic = NULL;
+        picture_Release(pic);
+        if (status != VLC_SUCCESS)
+            break;
+
+        if (!atomic_load(&sb->seekable)
+         || !StoryboardGetTime(sb, ++index, &time))
+            break;
+        input_SetTime(input, time, sb->fast_seek);
+        input_ControlPushHelper(input, INPUT_CONTROL_SET_STATE,
+                                &(vlc_value_t) { .i_int = PLAYING_S });
+    }
+
+    input_Stop(input);
+    input_Close(input);
+
+    /* A last frame might have been received after a timeout */
+    if (task->pic != NULL)
+        picture_Release(task->pic);
+
+end:
+    PreparserRemoveTask(preparser, task);
+
+    picture_t *sprite = NULL;
+    if (status == VLC_SUCCESS && sb->columns > 0)
+    {
+        sprite = StoryboardTile(sb);
+        if (sprite == NULL)
+            status = VLC_ENOMEM;
+    }
+
+    if (status == VLC_SUCCESS)
+        task->cbs.storyboard->on_ended(task->item, status, sprite,
+                                       sb->index.data, sb->index.size,
+                                       task->userdata);
+    else
+        task->cbs.storyboard->on_ended(task->item, status, NULL, NULL, 0,
+                                       task->userdata);
+
+    if (sprite != NULL)
+        picture_Release(sprite);
+    if (image != NULL)
+        image_HandlerDelete(image);
+    TaskDelete(task);
+}
+
 static void
 Interrupt(struct task *task)
 {
@@ -580,7 +917,8 @@ vlc_preparser_t* vlc_preparser_New( vlc_object_t *parent,
     assert(request_type & (VLC_PREPARSER_TYPE_FETCHMETA_ALL|
                            VLC_PREPARSER_TYPE_PARSE|
                            VLC_PREPARSER_TYPE_THUMBNAIL|
-                           VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES));
+                           VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES|
+                           VLC_PREPARSER_TYPE_STORYBOARD));
 
     unsigned parser_threads = cfg->max_parser_threads == 0 ? 1 :
                               cfg->max_parser_threads;
@@ -593,6 +931,8 @@ vlc_preparser_t* vlc_preparser_New( vlc_object_t *parent,
 
     preparser->timeout = cfg->timeout;
     preparser->owner = parent;
+    preparser->cache = var_InheritBool(parent, "preparse-cache");
+    atomic_init(&preparser->cache_saves, 0);
 
     if (request_type & VLC_PREPARSER_TYPE_PARSE)
     {
@@ -613,7 +953,8 @@ vlc_preparser_t* vlc_preparser_New( vlc_object_t *parent,
         preparser->fetcher = NULL;
 
     if (request_type & (VLC_PREPARSER_TYPE_THUMBNAIL |
-                        VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES))
+                        VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES |
+                        VLC_PREPARSER_TYPE_STORYBOARD))
     {
         preparser->thumbnailer = vlc_executor_New(thumbnailer_threads);
         if (!preparser->thumbnailer)
@@ -658,6 +999,7 @@ vlc_preparser_req_id vlc_preparser_Push( vlc_preparser_t *preparser, input_item_
 {
     assert((type_options & VLC_PREPARSER_TYPE_THUMBNAIL) == 0);
     assert((type_options & VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES) == 0);
+    assert((type_options & VLC_PREPARSER_TYPE_STORYBOARD) == 0);
 
     assert(type_options & VLC_PREPARSER_TYPE_PARSE
         || type_options & VLC_PREPARSER_TYPE_FETCHMETA_ALL);
@@ -857,6 +1199,71 @@ vlc_preparser_GenerateThumbnailToFiles( vlc_preparser_t *preparser, input_item_t
     return id;
 }
 
+vlc_preparser_req_id
+vlc_preparser_GenerateStoryboard( vlc_preparser_t *preparser, input_item_t *item,
+                                  const struct vlc_thumbnailer_storyboard_arg *arg,
+                                  const struct vlc_thumbnailer_storyboard_cbs *cbs,
+                                  void *cbs_userdata )
+{
+    assert(preparser->thumbnailer != NULL);
+    assert(arg != NULL);
+    assert(arg->times != NULL ? arg->count > 0 : arg->interval > 0);
+    assert(arg->columns == 0 || arg->tile_width > 0);
+    assert(cbs != NULL && cbs->on_ended != NULL);
+
+    union vlc_preparser_cbs task_cbs = {
+        .storyboard = cbs,
+    };
+
+    const struct vlc_thumbnailer_arg thumb_arg = {
+        .seek.type = VLC_THUMBNAILER_SEEK_NONE,
+        .hw_dec = arg->hw_dec,
+    };
+
+    struct task *task =
+        TaskNew(preparser, StoryboardRun, item, VLC_PREPARSER_TYPE_STORYBOARD,
+                &thumb_arg, task_cbs, cbs_userdata);
+    if (task == NULL)
+        return VLC_PREPARSER_REQ_ID_INVALID;
+
+    struct task_storyboard *sb = malloc(sizeof(*sb));
+    if (unlikely(sb == NULL))
+    {
+        TaskDelete(task);
+        return VLC_PREPARSER_REQ_ID_INVALID;
+    }
+
+    sb->times = NULL;
+    sb->count = arg->count;
+    sb->interval = arg->interval;
+    sb->fast_seek = arg->speed == VLC_THUMBNAILER_STORYBOARD_FAST;
+    sb->columns = arg->columns;
+    sb->tile_width = arg->tile_width;
+    sb->tile_height = arg->tile_height;
+    atomic_init(&sb->seekable, false);
+    atomic_init(&sb->length, VLC_TICK_INVALID);
+    vlc_vector_init(&sb->index);
+    vlc_vector_init(&sb->tiles);
+    task->storyboard = sb;
+
+    if (arg->times != NULL)
+    {
+        sb->times = vlc_alloc(arg->count, sizeof(*sb->times));
+        if (unlikely(sb->times == NULL))
+        {
+            TaskDelete(task);
+            return VLC_PREPARSER_REQ_ID_INVALID;
+        }
+        memcpy(sb->times, arg->times, arg->count * sizeof(*sb->times));
+    }
+
+    vlc_preparser_req_id id = PreparserAddTask(preparser, task);
+
+    vlc_executor_Submit(preparser->thumbnailer, &task->runnable);
+
+    return id;
+}
+
 size_t vlc_preparser_Cancel( vlc_preparser_t *preparser, vlc_preparser_req_id id )
 {
     vlc_mutex_lock(&preparser->lock);
@@ -877,7 +1284,8 @@ size_t vlc_preparser_Cancel( vlc_preparser_t *preparser, vlc_preparser_req_id id
                                                &task->runnable);
             }
             else if (task->options & (VLC_PREPARSER_TYPE_THUMBNAIL |
-                                      VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES))
+                                      VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES |
+                                      VLC_PREPARSER_TYPE_STORYBOARD))
             {
                 assert(preparser->thumbnailer != NULL);
                 canceled = vlc_executor_Cancel(preparser->thumbnailer,
@@ -912,6 +1320,10 @@ size_t vlc_preparser_Cancel( vlc_preparser_t *preparser, vlc_preparser_req_id id
                                                     task->preparse_status, NULL,
                                                     task->userdata);
                 }
+                else if (task->options & VLC_PREPARSER_TYPE_STORYBOARD)
+                    task->cbs.storyboard->on_ended(task->item,
+                                                   task->preparse_status, NULL,
+                                                   NULL, 0, task->userdata);
                 else
                 {
                     assert(task->options & VLC_PREPARSER_TYPE_THUMBNAIL_TO_FILES);
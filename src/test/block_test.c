@@ -86,11 +86,69 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Share (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    assert (block != NULL);
+
+    memcpy (block->p_buffer, text, sizeof (text));
+    block->i_pts = 42;
+
+    block = block_Shareable (block);
+    assert (block != NULL);
+    assert (block_Shareable (block) == block);
+    assert (!block_IsShared (block));
+
+    block_t *copy = block_Share (block);
+    assert (copy != NULL);
+    assert (block_IsShared (block));
+    assert (block_IsShared (copy));
+    assert (copy->p_buffer == block->p_buffer);
+    assert (copy->i_buffer == sizeof (text));
+    assert (copy->i_pts == 42);
+
+    /* Growing a shared payload must not alter the other references */
+    copy = block_Realloc (copy, 16, sizeof (text) + 16);
+    assert (copy != NULL);
+    assert (copy->p_buffer + 16 != block->p_buffer);
+    memset (copy->p_buffer, 'A', copy->i_buffer);
+    assert (!memcmp (block->p_buffer, text, sizeof (text)));
+    block_Release (copy);
+
+    /* Writers get a private copy of a shared payload */
+    copy = block_Share (block);
+    assert (copy != NULL);
+    copy = block_Unshare (copy);
+    assert (copy != NULL);
+    assert (!block_IsShared (copy));
+    assert (!block_IsShared (block));
+    assert (copy->p_buffer != block->p_buffer);
+    assert (copy->i_pts == 42);
+    memset (copy->p_buffer, 'A', copy->i_buffer);
+    assert (!memcmp (block->p_buffer, text, sizeof (text)));
+    block_Release (copy);
+
+    /* The payload outlives the frame it came from */
+    copy = block_Share (block);
+    assert (copy != NULL);
+    block_Release (block);
+    assert (!memcmp (copy->p_buffer, text, sizeof (text)));
+    assert (!block_IsShared (copy));
+    assert (block_Unshare (copy) == copy);
+
+    /* Last reference owns the payload again */
+    copy = block_Realloc (copy, 0, sizeof (text) + 16);
+    assert (copy != NULL);
+    assert (!memcmp (copy->p_buffer, text, sizeof (text)));
+    block_Release (copy);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_Share ();
     return 0;
 }
 
@@ -0,0 +1,214 @@
+/*****************************************************************************
+ * fifo.c: Test for vlc_fifo_t
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_frame.h>
+
+#define COUNT 100000
+
+static vlc_frame_t *frame_New (unsigned index)
+{
+    vlc_frame_t *frame = vlc_frame_Alloc (index % 10);
+    assert (frame != NULL);
+    frame->i_dts = index;
+    return frame;
+}
+
+static void test_accounting (vlc_fifo_t *fifo)
+{
+    vlc_fifo_Lock (fifo);
+    assert (vlc_fifo_IsEmpty (fifo));
+    assert (vlc_fifo_GetCount (fifo) == 0);
+    assert (vlc_fifo_GetBytes (fifo) == 0);
+
+    /* Chains are accounted frame by frame */
+    vlc_frame_t *chain = NULL;
+    vlc_frame_t **lastp = &chain;
+    size_t bytes = 0;
+    for (unsigned i = 0; i < 10; i++)
+    {
+        vlc_frame_t *frame = frame_New (i);
+        bytes += frame->i_buffer;
+        *lastp = frame;
+        lastp = &frame->p_next;
+    }
+    vlc_fifo_QueueUnlocked (fifo, chain);
+    vlc_fifo_QueueUnlocked (fifo, NULL);
+    assert (!vlc_fifo_IsEmpty (fifo));
+    assert (vlc_fifo_GetCount (fifo) == 10);
+    assert (vlc_fifo_GetBytes (fifo) == bytes);
+
+    vlc_frame_t *frame = vlc_fifo_DequeueUnlocked (fifo);
+    assert (frame != NULL);
+    assert (frame->i_dts == 0);
+    assert (frame->p_next == NULL);
+    bytes -= frame->i_buffer;
+    vlc_frame_Release (frame);
+    assert (vlc_fifo_GetCount (fifo) == 9);
+    assert (vlc_fifo_GetBytes (fifo) == bytes);
+
+    /* Zero-sized frames are counted */
+    frame = frame_New (10);
+    assert (frame->i_buffer == 0);
+    vlc_fifo_QueueUnlocked (fifo, frame);
+    assert (vlc_fifo_GetCount (fifo) == 10);
+    assert (vlc_fifo_GetBytes (fifo) == bytes);
+
+    chain = vlc_fifo_DequeueAllUnlocked (fifo);
+    assert (vlc_fifo_IsEmpty (fifo));
+    assert (vlc_fifo_GetCount (fifo) == 0);
+    assert (vlc_fifo_GetBytes (fifo) == 0);
+    assert (vlc_fifo_DequeueUnlocked (fifo) == NULL);
+    vlc_fifo_Unlock (fifo);
+
+    unsigned count = 0;
+    for (frame = chain; frame != NULL; frame = frame->p_next)
+        assert (frame->i_dts == ++count);
+    assert (count == 10); /* 1 to 9, and the zero-sized one */
+    vlc_frame_ChainRelease (chain);
+
+    /* Frames left in the FIFO are released with it */
+    vlc_fifo_Put (fifo, frame_New (1));
+}
+
+struct consumer
+{
+    vlc_fifo_t *fifo;
+    bool batch;
+    unsigned received;
+    vlc_sem_t caught_up;
+};
+
+static void *consumer_thread (void *data)
+{
+    struct consumer *c = data;
+    vlc_fifo_t *fifo = c->fifo;
+
+    for (;;)
+    {
+        vlc_frame_t *chain;
+
+        vlc_fifo_Lock (fifo);
+        while (vlc_fifo_IsEmpty (fifo))
+            vlc_fifo_Wait (fifo);
+        if (c->batch)
+            chain = vlc_fifo_DequeueAllUnlocked (fifo);
+        else
+            chain = vlc_fifo_DequeueUnlocked (fifo);
+        vlc_fifo_Unlock (fifo);
+
+        while (chain != NULL)
+        {
+            vlc_frame_t *frame = chain;
+
+            chain = frame->p_next;
+            /* Frames are received in order, and none is lost */
+            assert (frame->i_dts == c->received);
+            assert (frame->i_buffer == frame->i_dts % 10);
+            c->received++;
+            vlc_frame_Release (frame);
+            if ((c->received % 1000) == 0)
+                vlc_sem_post (&c->caught_up);
+        }
+
+        if (c->received == COUNT)
+            return NULL;
+    }
+}
+
+/* Queues many frames, with the consumer being either behind (non-empty
+ * FIFO) or waiting (empty FIFO): no wake-up may be lost. */
+static void test_wakeup (vlc_fifo_t *fifo, bool batch)
+{
+    struct consumer c = { .fifo = fifo, .batch = batch, .received = 0 };
+    vlc_thread_t th;
+
+    vlc_sem_init (&c.caught_up, 0);
+    int ret = vlc_clone (&th, consumer_thread, &c);
+    assert (ret == 0);
+
+    for (unsigned i = 0; i < COUNT; i++)
+    {
+        vlc_fifo_Put (fifo, frame_New (i));
+        /* Let the consumer empty the FIFO and wait from time to time */
+        if ((i % 1000) == 999)
+            vlc_sem_wait (&c.caught_up);
+    }
+
+    vlc_join (th, NULL);
+    assert (c.received == COUNT);
+
+    vlc_fifo_Lock (fifo);
+    assert (vlc_fifo_IsEmpty (fifo));
+    assert (vlc_fifo_GetCount (fifo) == 0);
+    assert (vlc_fifo_GetBytes (fifo) == 0);
+    vlc_fifo_Unlock (fifo);
+}
+
+static void *get_thread (void *data)
+{
+    return vlc_fifo_Get (data);
+}
+
+static void test_get (vlc_fifo_t *fifo)
+{
+    vlc_thread_t th;
+
+    /* vlc_fifo_Get() waits for the next frame */
+    int ret = vlc_clone (&th, get_thread, fifo);
+    assert (ret == 0);
+    vlc_fifo_Put (fifo, frame_New (42));
+
+    void *frame;
+    vlc_join (th, &frame);
+    assert (frame != NULL);
+    assert (((vlc_frame_t *)frame)->i_dts == 42);
+    vlc_frame_Release (frame);
+}
+
+static void test_fifo (vlc_fifo_t *(*create)(void))
+{
+    vlc_fifo_t *fifo = create ();
+    assert (fifo != NULL);
+    test_accounting (fifo);
+    vlc_fifo_Delete (fifo);
+
+    fifo = create ();
+    assert (fifo != NULL);
+    test_wakeup (fifo, false);
+    test_wakeup (fifo, true);
+    test_get (fifo);
+    vlc_fifo_Delete (fifo);
+}
+
+int main (void)
+{
+    test_fifo (vlc_fifo_New);
+    test_fifo (vlc_fifo_NewSingleConsumer);
+    return 0;
+}
@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * frame_cache.c: Test for the vlc_frame_t cache
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_frame.h>
+#include "../libvlc.h"
+
+#define COUNT 200
+
+static void check_frame (vlc_frame_t *frame, size_t size)
+{
+    assert (frame != NULL);
+    assert (frame->i_buffer == size);
+    assert (frame->p_buffer >= frame->p_start);
+    assert (frame->p_buffer + size <= frame->p_start + frame->i_size);
+    assert (frame->p_next == NULL);
+    assert (frame->i_flags == 0);
+    assert (frame->i_pts == VLC_TICK_INVALID);
+    memset (frame->p_buffer, 0x55, size);
+}
+
+static void test_disabled (void)
+{
+    struct vlc_frame_cache_stats before, after;
+
+    vlc_frame_cache_GetStats (&before);
+    for (unsigned i = 0; i < COUNT; i++)
+    {
+        vlc_frame_t *frame = vlc_frame_Alloc (188);
+        check_frame (frame, 188);
+        vlc_frame_Release (frame);
+    }
+    vlc_frame_cache_GetStats (&after);
+    assert (after.hits == before.hits);
+    assert (after.misses == before.misses);
+    assert (after.recycled == before.recycled);
+}
+
+static void test_reuse (void)
+{
+    struct vlc_frame_cache_stats before, after;
+
+    vlc_frame_cache_GetStats (&before);
+
+    /* A released frame is handed out again, reset */
+    vlc_frame_t *frame = vlc_frame_Alloc (188);
+    check_frame (frame, 188);
+    unsigned char *start = frame->p_start;
+    frame->i_flags = VLC_FRAME_FLAG_DISCONTINUITY;
+    frame->i_pts = frame->i_dts = VLC_TICK_0;
+    vlc_frame_Release (frame);
+
+    frame = vlc_frame_Alloc (100);
+    check_frame (frame, 100);
+    assert (frame->p_start == start);
+    vlc_frame_Release (frame);
+
+    /* Up to the largest size of the class */
+    frame = vlc_frame_Alloc (256);
+    check_frame (frame, 256);
+    assert (frame->p_start == start);
+    vlc_frame_Release (frame);
+
+    /* Next class */
+    frame = vlc_frame_Alloc (257);
+    check_frame (frame, 257);
+    assert (frame->p_start != start);
+    vlc_frame_Release (frame);
+
+    /* Not cached */
+    frame = vlc_frame_Alloc (65537);
+    check_frame (frame, 65537);
+    vlc_frame_Release (frame);
+
+    /* Only the first use of each class can miss */
+    vlc_frame_cache_GetStats (&after);
+    assert (after.misses - before.misses <= 2);
+
+    /* Cached frames can be resized */
+    frame = vlc_frame_Alloc (188);
+    check_frame (frame, 188);
+    frame = vlc_frame_Realloc (frame, 16, 4096);
+    assert (frame != NULL);
+    assert (frame->i_buffer == 16 + 4096);
+    for (size_t i = 16; i < 16 + 188; i++)
+        assert (frame->p_buffer[i] == 0x55);
+    vlc_frame_Release (frame);
+}
+
+static void *alloc_thread (void *data)
+{
+    vlc_frame_t **frames = data;
+
+    for (unsigned i = 0; i < COUNT; i++)
+    {
+        frames[i] = vlc_frame_Alloc (1316);
+        check_frame (frames[i], 1316);
+    }
+    return NULL;
+}
+
+static void test_threads (void)
+{
+    vlc_frame_t *frames[COUNT];
+    struct vlc_frame_cache_stats before, after;
+    vlc_thread_t th;
+
+    /* Allocated by one thread, released by another one: the releasing
+     * thread overflows into the shared lists */
+    vlc_frame_cache_GetStats (&before);
+    int ret = vlc_clone (&th, alloc_thread, frames);
+    assert (ret == 0);
+    vlc_join (th, NULL);
+    for (unsigned i = 0; i < COUNT; i++)
+        vlc_frame_Release (frames[i]);
+    vlc_frame_cache_GetStats (&after);
+    assert (after.misses - before.misses <= COUNT);
+    assert (after.recycled > before.recycled);
+
+    /* Another thread refills from the shared lists, mostly without a miss */
+    before = after;
+    ret = vlc_clone (&th, alloc_thread, frames);
+    assert (ret == 0);
+    vlc_join (th, NULL);
+    vlc_frame_cache_GetStats (&after);
+    assert (after.misses - before.misses < COUNT);
+    for (unsigned i = 0; i < COUNT; i++)
+        vlc_frame_Release (frames[i]);
+
+    /* The hits of the exited threads are accounted */
+    assert (after.hits > before.hits);
+}
+
+int main (void)
+{
+    test_disabled ();
+
+    vlc_frame_cache_Hold ();
+    test_reuse ();
+    test_threads ();
+
+    /* Still enabled while it is held */
+    vlc_frame_cache_Hold ();
+    vlc_frame_cache_Release ();
+    test_reuse ();
+
+    /* Cached frames are freed once the last user is gone */
+    vlc_frame_t *frame = vlc_frame_Alloc (188);
+    check_frame (frame, 188);
+    vlc_frame_cache_Release ();
+    vlc_frame_Release (frame);
+    test_disabled ();
+    return 0;
+}
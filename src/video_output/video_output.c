@@ -119,6 +119,7 @@ typedef struct vout_thread_sys_t
         bool        is_interlaced;
         picture_t   *decoded; // decoded picture before passed through chain_static
         picture_t   *current;
+        bool        is_rendered; // current has been displayed at least once
         video_projection_mode_t projection;
     } displayed;
 
@@ -1093,6 +1094,10 @@ static picture_t *PreparePicture(vout_thread_sys_t *vout, bool reuse_decoded,
                 if (is_late_dropped
                  && IsPictureLateToStaticFilter(vout, system_pts - system_now))
                 {
+                    struct vlc_tracer *tracer = GetTracer(vout);
+                    if (tracer != NULL)
+                        vlc_tracer_TraceFrame(tracer, sys->str_id, "drop",
+                                              decoded->date);
                     picture_Release(decoded);
                     vout_statistic_AddLost(&sys->statistic, 1);
 
@@ -1130,6 +1135,10 @@ static picture_t *PreparePicture(vout_thread_sys_t *vout, bool reuse_decoded,
         vout_chrono_Start(&sys->chrono.static_filter);
         picture = filter_chain_VideoFilter(sys->filter.chain_static, sys->displayed.decoded);
         vout_chrono_Stop(&sys->chrono.static_filter);
+
+        struct vlc_tracer *tracer = GetTracer(vout);
+        if (tracer != NULL && picture != NULL)
+            vlc_tracer_TraceFrame(tracer, sys->str_id, "filter", picture->date);
     }
 
     vlc_mutex_unlock(&sys->filter.lock);
@@ -1441,6 +1450,8 @@ static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
     vout_chrono_Stop(&sys->chrono.render);
 
     struct vlc_tracer *tracer = GetTracer(sys);
+    if (tracer != NULL)
+        vlc_tracer_TraceFrame(tracer, sys->str_id, "prepare", pts);
     system_now = vlc_tick_now();
     if (!render_now)
     {
@@ -1503,6 +1514,9 @@ static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout_display_Display(vd, todisplay);
+    sys->displayed.is_rendered = true;
+    if (tracer != NULL)
+        vlc_tracer_TraceFrame(tracer, sys->str_id, "display", pts);
     vlc_clock_Lock(sys->clock);
     vlc_tick_t drift = vlc_clock_UpdateVideo(sys->clock,
                                              vlc_tick_now(),
@@ -1541,6 +1555,24 @@ static void UpdateDeinterlaceFilter(vout_thread_sys_t *sys)
     vlc_mutex_unlock(&sys->filter.lock);
 }
 
+static void ReplaceCurrentPicture(vout_thread_sys_t *sys, picture_t *next)
+{
+    picture_t *current = sys->displayed.current;
+    if (current != NULL)
+    {
+        if (!sys->displayed.is_rendered)
+        {
+            struct vlc_tracer *tracer = GetTracer(sys);
+            if (tracer != NULL)
+                vlc_tracer_TraceFrame(tracer, sys->str_id, "drop",
+                                      current->date);
+        }
+        picture_Release(current);
+    }
+    sys->displayed.current = next;
+    sys->displayed.is_rendered = false;
+}
+
 static int DisplayNextFrame(vout_thread_sys_t *sys)
 {
     UpdateDeinterlaceFilter(sys);
@@ -1548,11 +1580,7 @@ static int DisplayNextFrame(vout_thread_sys_t *sys)
     picture_t *next = PreparePicture(sys, !sys->displayed.current, true);
 
     if (next)
-    {
-        if (likely(sys->displayed.current != NULL))
-            picture_Release(sys->displayed.current);
-        sys->displayed.current = next;
-    }
+        ReplaceCurrentPicture(sys, next);
 
     if (!next)
         return VLC_EGENERIC;
@@ -1573,7 +1601,7 @@ static bool UpdateCurrentPicture(vout_thread_sys_t *sys)
 
     if (sys->displayed.current == NULL)
     {
-        sys->displayed.current = PreparePicture(sys, true, false);
+        ReplaceCurrentPicture(sys, PreparePicture(sys, true, false));
         return sys->displayed.current != NULL;
     }
 
@@ -1611,12 +1639,9 @@ static bool UpdateCurrentPicture(vout_thread_sys_t *sys)
     if (next == NULL)
         return false;
     /* We might have reset the current picture when preparing the next one,
-     * because filters had to be changed. In this case, avoid releasing the
-     * picture since it will lead to null pointer dereference errors. */
-    if (sys->displayed.current != NULL)
-        picture_Release(sys->displayed.current);
-
-    sys->displayed.current = next;
+     * because filters had to be changed. In this case, there is no picture
+     * to release. */
+    ReplaceCurrentPicture(sys, next);
 
     return true;
 }
@@ -1901,6 +1926,7 @@ static int vout_Start(vout_thread_sys_t *vout, vlc_video_context *vctx, const vo
     vlc_queuedmutex_unlock(&sys->display_lock);
 
     sys->displayed.current       = NULL;
+    sys->displayed.is_rendered   = false;
     sys->displayed.decoded       = NULL;
     sys->displayed.date          = VLC_TICK_INVALID;
     sys->displayed.timestamp     = VLC_TICK_INVALID;
@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * udp.c: UDP access batch receive tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_access.h>
+#include <vlc_block.h>
+#include <vlc_modules.h>
+#include <vlc_network.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+#ifdef HAVE_RECVMMSG
+/* Larger than the initial receive buffers of the access (2 KiB) */
+#define LARGE_SIZE 4000
+#define SMALL_SIZE 1316
+/* Fewer than the datagrams received per call, more than one */
+#define BATCH 8
+
+static void Send(int fd, unsigned i_index, size_t i_size)
+{
+    uint8_t buf[LARGE_SIZE];
+    assert(i_size <= sizeof(buf));
+    for (size_t i = 0; i < i_size; i++)
+        buf[i] = i_index + i;
+    ssize_t val = send(fd, buf, i_size, 0);
+    assert(val == (ssize_t) i_size);
+}
+
+static void Receive(stream_t *access, unsigned i_index, size_t i_size,
+                    bool b_truncated)
+{
+    block_t *block = vlc_stream_ReadBlock(access);
+    assert(block != NULL);
+    if (b_truncated)
+    {
+        assert(block->i_flags & BLOCK_FLAG_CORRUPTED);
+        assert(block->i_buffer < i_size);
+    }
+    else
+    {
+        assert(!(block->i_flags & BLOCK_FLAG_CORRUPTED));
+        assert(block->i_buffer == i_size);
+    }
+    for (size_t i = 0; i < block->i_buffer; i++)
+        assert(block->p_buffer[i] == (uint8_t)(i_index + i));
+    block_Release(block);
+}
+
+/* Returns a free loopback UDP port */
+static int GetPort(void)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd >= 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        .sin_port = 0,
+    };
+    int val = bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+    assert(val == 0);
+    socklen_t len = sizeof(addr);
+    val = getsockname(fd, (struct sockaddr *) &addr, &len);
+    assert(val == 0);
+    net_Close(fd);
+    return ntohs(addr.sin_port);
+}
+
+int main(void)
+{
+    test_init();
+
+    static const char * argv[] = {
+        "-v",
+        "--ignore-config",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    if (!module_exists("udp"))
+    {
+        fprintf(stderr, "skip: no \"udp\" module\n");
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    const int i_port = GetPort();
+    char mrl[64];
+    snprintf(mrl, sizeof(mrl), "udp://@127.0.0.1:%d", i_port);
+    stream_t *access = vlc_access_NewMRL(VLC_OBJECT(vlc->p_libvlc_int), mrl);
+    assert(access != NULL);
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd >= 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        .sin_port = htons(i_port),
+    };
+    int val = connect(fd, (struct sockaddr *) &addr, sizeof(addr));
+    assert(val == 0);
+
+    unsigned i_index = 0;
+
+    /* Small datagrams: a batch is received in one call, and the receive
+     * buffers of the whole ring are allocated at the initial size */
+    for (unsigned i = 0; i < BATCH; i++)
+        Send(fd, i_index + i, SMALL_SIZE);
+    for (unsigned i = 0; i < BATCH; i++)
+        Receive(access, i_index + i, SMALL_SIZE, false);
+    i_index += BATCH;
+
+    /* A large datagram is truncated, and raises the receive buffer size */
+    Send(fd, i_index, LARGE_SIZE);
+    Receive(access, i_index, LARGE_SIZE, true);
+    i_index++;
+
+    /* The next batches use large buffers only, including in the slots that
+     * were allocated before the size was raised */
+    for (unsigned j = 0; j < 3; j++)
+    {
+        for (unsigned i = 0; i < BATCH; i++)
+            Send(fd, i_index + i, LARGE_SIZE);
+        for (unsigned i = 0; i < BATCH; i++)
+            Receive(access, i_index + i, LARGE_SIZE, false);
+        i_index += BATCH;
+    }
+
+    net_Close(fd);
+    vlc_stream_Delete(access);
+    libvlc_release(vlc);
+    return 0;
+}
+#else
+int main(void)
+{
+    fprintf(stderr, "skip: no recvmmsg()\n");
+    return 77;
+}
+#endif
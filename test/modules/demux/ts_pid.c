@@ -0,0 +1,144 @@
+/*****************************************************************************
+ * ts_pid.c: MPEG TS pid list tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+
+#include "../../../modules/demux/mpeg/ts_pid.h"
+
+#include "../../libvlc/test.h"
+
+/* Only the pid list is tested: the typed pid contexts are never created */
+ts_pat_t *ts_pat_New( demux_t *d ) { VLC_UNUSED(d); abort(); }
+void ts_pat_Del( demux_t *d, ts_pat_t *p ) { VLC_UNUSED(d); VLC_UNUSED(p); abort(); }
+ts_pmt_t *ts_pmt_New( demux_t *d ) { VLC_UNUSED(d); abort(); }
+void ts_pmt_Del( demux_t *d, ts_pmt_t *p ) { VLC_UNUSED(d); VLC_UNUSED(p); abort(); }
+ts_stream_t *ts_stream_New( demux_t *d, ts_pmt_t *p ) { VLC_UNUSED(d); VLC_UNUSED(p); abort(); }
+void ts_stream_Del( demux_t *d, ts_stream_t *p ) { VLC_UNUSED(d); VLC_UNUSED(p); abort(); }
+ts_si_t *ts_si_New( demux_t *d ) { VLC_UNUSED(d); abort(); }
+void ts_si_Del( demux_t *d, ts_si_t *p ) { VLC_UNUSED(d); VLC_UNUSED(p); abort(); }
+ts_psip_t *ts_psip_New( demux_t *d ) { VLC_UNUSED(d); abort(); }
+void ts_psip_Del( demux_t *d, ts_psip_t *p ) { VLC_UNUSED(d); VLC_UNUSED(p); abort(); }
+
+#define ASSERT(a) do {\
+    if(!(a)) { \
+        fprintf(stderr, "failed line %d\n", __LINE__); \
+        return 1; } \
+    } while(0)
+
+static bool IsCommonPID(uint16_t i_pid)
+{
+    return i_pid == 0 || i_pid == 0x1FFB || i_pid == 0x1FFF;
+}
+
+/* Checks that iteration returns the dynamically allocated pids in order */
+static int CheckIteration(ts_pid_list_t *list, const bool *created,
+                          int i_expected)
+{
+    ts_pid_next_context_t ctx = ts_pid_NextContextInitValue;
+    ts_pid_t *pid;
+    int i_count = 0;
+    int i_prev = -1;
+    while((pid = ts_pid_Next(list, &ctx)) != NULL)
+    {
+        ASSERT(pid->i_pid > i_prev);
+        ASSERT(created[pid->i_pid]);
+        ASSERT(!IsCommonPID(pid->i_pid));
+        i_prev = pid->i_pid;
+        i_count++;
+    }
+    ASSERT(i_count == i_expected);
+    return 0;
+}
+
+int main(void)
+{
+    ts_pid_list_t list;
+    ts_pid_list_Init(&list);
+
+    bool created[8192] = { false };
+    ts_pid_t *seen[8192] = { NULL };
+    int i_created = 0;
+
+    /* Common pids are not allocated */
+    ASSERT(ts_pid_Get(&list, 0) == &list.pat);
+    ASSERT(ts_pid_Get(&list, 0x1FFB) == &list.base_si);
+    ASSERT(ts_pid_Get(&list, 0x1FFF) == &list.dummy);
+    ASSERT(CheckIteration(&list, created, 0) == 0);
+
+    /* Scattered pids, across index pages and page boundaries, in an order
+     * that inserts in front of, between and after already created ones */
+    static const uint16_t pids[] = {
+        0x1000, 0x0100, 0x1FFE, 0x0001, 0x00FF, 0x0200, 0x01FF, 0x1FFC,
+        0x0020, 0x0800, 0x0101, 0x1FFA, 0x0010, 0x0FFF, 0x1001, 0x0002,
+    };
+    for(size_t i = 0; i < ARRAY_SIZE(pids); i++)
+    {
+        ts_pid_t *pid = ts_pid_Get(&list, pids[i]);
+        ASSERT(pid != NULL);
+        ASSERT(pid->i_pid == pids[i]);
+        ASSERT(pid->type == TYPE_FREE);
+        ASSERT(pid->i_cc == 0xff);
+        seen[pids[i]] = pid;
+        created[pids[i]] = true;
+        i_created++;
+        ASSERT(CheckIteration(&list, created, i_created) == 0);
+    }
+
+    /* Lookups return the same pid, whatever the previous lookup was */
+    for(size_t i = 0; i < ARRAY_SIZE(pids); i++)
+    {
+        ASSERT(ts_pid_Get(&list, pids[i]) == seen[pids[i]]);
+        ASSERT(ts_pid_Get(&list, pids[ARRAY_SIZE(pids) - 1 - i]) ==
+               seen[pids[ARRAY_SIZE(pids) - 1 - i]]);
+    }
+    ASSERT(CheckIteration(&list, created, i_created) == 0);
+
+    /* Then the whole pid space */
+    for(unsigned i = 0; i < 8192; i++)
+    {
+        uint16_t i_pid = (i * 4099) & 0x1FFF; /* odd stride: all pids */
+        if(IsCommonPID(i_pid))
+            continue;
+        ts_pid_t *pid = ts_pid_Get(&list, i_pid);
+        ASSERT(pid != NULL);
+        ASSERT(pid->i_pid == i_pid);
+        if(seen[i_pid])
+            ASSERT(pid == seen[i_pid]);
+        else
+        {
+            seen[i_pid] = pid;
+            created[i_pid] = true;
+            i_created++;
+        }
+    }
+    ASSERT(i_created == 8192 - 3);
+    ASSERT(CheckIteration(&list, created, i_created) == 0);
+
+    for(unsigned i = 0; i < 8192; i++)
+        if(!IsCommonPID(i))
+            ASSERT(ts_pid_Get(&list, i) == seen[i]);
+
+    ts_pid_list_Release(NULL, &list);
+    return 0;
+}
@@ -0,0 +1,368 @@
+/*****************************************************************************
+ * ts_readahead.c: MPEG TS demux read-ahead, resync and seek tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_modules.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* More packets than the demux read-ahead buffer holds (100) */
+#define PES_COUNT     300
+#define PES_PID       0x100
+#define PMT_PID       0x20
+/* Each packet carries a PCR and a complete PES */
+#define PAYLOAD_SIZE  (188 - 4 - 8 - 14)
+/* Inserted after this PES packet */
+#define GARBAGE_AFTER 150
+#define GARBAGE_SIZE  250
+
+struct ts_file
+{
+    uint8_t *p_data;
+    size_t i_data;
+    size_t i_stride;
+    /* end offset of the packet of each PES */
+    size_t pes_end[PES_COUNT];
+};
+
+struct es_out_id_t
+{
+    int dummy;
+};
+
+struct test_es_out
+{
+    es_out_t out;
+    struct es_out_id_t id;
+    int i_last;     /* last received counter, -1 if none */
+    int i_first;    /* first received counter since reset, -1 if none */
+    bool b_discontinuity;
+};
+
+static uint32_t crc32_mpeg(const uint8_t *p, size_t i_size)
+{
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < i_size; i++)
+    {
+        crc ^= (uint32_t)p[i] << 24;
+        for (int j = 0; j < 8; j++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+    return crc;
+}
+
+static void WriteSection(uint8_t *pkt, uint16_t i_pid,
+                         const uint8_t *p_section, size_t i_section)
+{
+    memset(pkt, 0xff, 188);
+    pkt[0] = 0x47;
+    pkt[1] = 0x40 | (i_pid >> 8);
+    pkt[2] = i_pid & 0xff;
+    pkt[3] = 0x10;
+    pkt[4] = 0x00; /* pointer field */
+    memcpy(&pkt[5], p_section, i_section);
+    SetDWBE(&pkt[5 + i_section], crc32_mpeg(p_section, i_section));
+}
+
+static void WritePES(uint8_t *pkt, unsigned i_counter)
+{
+    const uint64_t i_pts = i_counter * 3600;
+
+    memset(pkt, 0xff, 188);
+    pkt[0] = 0x47;
+    pkt[1] = 0x40 | (PES_PID >> 8);
+    pkt[2] = PES_PID & 0xff;
+    pkt[3] = 0x30 | (i_counter & 0x0f);
+    /* adaptation field with PCR */
+    pkt[4] = 7;
+    pkt[5] = 0x10;
+    pkt[6] = i_pts >> 25;
+    pkt[7] = i_pts >> 17;
+    pkt[8] = i_pts >> 9;
+    pkt[9] = i_pts >> 1;
+    pkt[10] = ((i_pts & 1) << 7) | 0x7e;
+    pkt[11] = 0;
+    /* PES header with PTS */
+    uint8_t *pes = &pkt[12];
+    pes[0] = 0x00; pes[1] = 0x00; pes[2] = 0x01; pes[3] = 0xc0;
+    SetWBE(&pes[4], 3 + 5 + PAYLOAD_SIZE);
+    pes[6] = 0x80;
+    pes[7] = 0x80;
+    pes[8] = 5;
+    pes[9] = 0x21 | ((i_pts >> 29) & 0x0e);
+    pes[10] = i_pts >> 22;
+    pes[11] = ((i_pts >> 14) & 0xfe) | 1;
+    pes[12] = i_pts >> 7;
+    pes[13] = ((i_pts << 1) & 0xfe) | 1;
+    SetDWBE(&pes[14], i_counter);
+}
+
+static uint8_t *AppendPacket(struct ts_file *f, size_t i_header)
+{
+    uint8_t *pkt = &f->p_data[f->i_data];
+    memset(pkt, 0, f->i_stride);
+    f->i_data += f->i_stride;
+    return &pkt[i_header];
+}
+
+/* Builds PAT, PMT, then PES_COUNT packets with GARBAGE_SIZE bytes of garbage
+ * after GARBAGE_AFTER. The garbage holds false sync bytes that are never one
+ * packet away from another sync byte. */
+static void BuildFile(struct ts_file *f, size_t i_stride, size_t i_header)
+{
+    f->i_stride = i_stride;
+    f->i_data = 0;
+    f->p_data = malloc(i_stride * (PES_COUNT + 2) + GARBAGE_SIZE);
+    assert(f->p_data);
+
+    static const uint8_t pat[] = {
+        0x00, 0xb0, 0x0d, 0x00, 0x01, 0xc1, 0x00, 0x00,
+        0x00, 0x01, 0xe0 | (PMT_PID >> 8), PMT_PID & 0xff,
+    };
+    WriteSection(AppendPacket(f, i_header), 0, pat, sizeof(pat));
+
+    static const uint8_t pmt[] = {
+        0x02, 0xb0, 0x12, 0x00, 0x01, 0xc1, 0x00, 0x00,
+        0xe0 | (PES_PID >> 8), PES_PID & 0xff, 0xf0, 0x00,
+        0x03, 0xe0 | (PES_PID >> 8), PES_PID & 0xff, 0xf0, 0x00,
+    };
+    WriteSection(AppendPacket(f, i_header), PMT_PID, pmt, sizeof(pmt));
+
+    size_t i_garbage = 0;
+    for (unsigned i = 0; i < PES_COUNT; i++)
+    {
+        WritePES(AppendPacket(f, i_header), i);
+        f->pes_end[i] = f->i_data;
+        if (i == GARBAGE_AFTER)
+        {
+            i_garbage = f->i_data;
+            f->i_data += GARBAGE_SIZE;
+        }
+    }
+    uint8_t *garbage = &f->p_data[i_garbage];
+    memset(garbage, 0xff, GARBAGE_SIZE);
+    for (size_t i = 0; i < GARBAGE_SIZE; i++)
+    {
+        size_t i_pos = i_garbage + i;
+        bool b_sync = i % 5 == 1 &&
+            (i_pos + i_stride >= f->i_data ||
+             f->p_data[i_pos + i_stride] != 0x47) &&
+            f->p_data[i_pos - i_stride] != 0x47;
+        garbage[i] = b_sync ? 0x47 : 0xff;
+    }
+}
+
+static es_out_id_t *EsOutAdd(es_out_t *out, input_source_t *in,
+                             const es_format_t *fmt)
+{
+    (void) in;
+    struct test_es_out *ctx = container_of(out, struct test_es_out, out);
+    assert(fmt->i_cat == AUDIO_ES);
+    return &ctx->id;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct test_es_out *ctx = container_of(out, struct test_es_out, out);
+    assert(id == &ctx->id);
+
+    for (block_t *b = block; b != NULL; b = b->p_next)
+    {
+        assert(b->i_buffer == PAYLOAD_SIZE);
+        int i_counter = GetDWBE(b->p_buffer);
+        assert(i_counter >= 0 && i_counter < PES_COUNT);
+        if (ctx->i_first < 0)
+            ctx->i_first = i_counter;
+        else if (i_counter != ctx->i_last + 1)
+            ctx->b_discontinuity = true;
+        ctx->i_last = i_counter;
+    }
+    block_ChainRelease(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, input_source_t *in, int query,
+                        va_list args)
+{
+    (void) out; (void) in;
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+            (void) va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_IS_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_SET_ES:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_ES_CAT_POLICY:
+        case ES_OUT_SET_GROUP:
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_ES_FMT:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        case ES_OUT_SET_GROUP_META:
+        case ES_OUT_SET_GROUP_EPG:
+        case ES_OUT_DEL_GROUP:
+        case ES_OUT_SET_ES_SCRAMBLED_STATE:
+        case ES_OUT_SET_META:
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void EsOutDestroy(es_out_t *out)
+{
+    (void) out;
+}
+
+static const struct es_out_callbacks es_out_cbs =
+{
+    .add = EsOutAdd,
+    .send = EsOutSend,
+    .del = EsOutDel,
+    .control = EsOutControl,
+    .destroy = EsOutDestroy,
+};
+
+static void EsOutReset(struct test_es_out *ctx)
+{
+    ctx->i_first = ctx->i_last = -1;
+    ctx->b_discontinuity = false;
+}
+
+/* The demux position is its read offset, which does not include the data
+ * held in the read-ahead buffer */
+static void CheckPosition(demux_t *demux, const struct ts_file *f,
+                          const struct test_es_out *ctx)
+{
+    double f_pos;
+    int ret = demux_Control(demux, DEMUX_GET_POSITION, &f_pos);
+    assert(ret == VLC_SUCCESS);
+    const double f_offset = f_pos * f->i_data;
+    /* Each PES fits in one packet: the demux stops right after it */
+    const double f_expected = f->pes_end[ctx->i_last];
+    assert(f_offset > f_expected - 0.5 && f_offset < f_expected + 0.5);
+}
+
+static void DemuxToEnd(demux_t *demux, const struct ts_file *f,
+                       const struct test_es_out *ctx)
+{
+    int i_last = ctx->i_last;
+    int val;
+    while ((val = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS)
+    {
+        if (ctx->i_last != i_last)
+        {
+            CheckPosition(demux, f, ctx);
+            i_last = ctx->i_last;
+        }
+    }
+    assert(val == VLC_DEMUXER_EOF);
+    assert(!ctx->b_discontinuity);
+    assert(ctx->i_last == PES_COUNT - 1);
+}
+
+static void Test(libvlc_instance_t *vlc, size_t i_stride, size_t i_header)
+{
+    fprintf(stderr, "testing %zu bytes packets\n", i_stride);
+
+    struct ts_file f;
+    BuildFile(&f, i_stride, i_header);
+
+    stream_t *s = vlc_stream_MemoryNew(VLC_OBJECT(vlc->p_libvlc_int),
+                                       f.p_data, f.i_data, true);
+    assert(s != NULL);
+
+    struct test_es_out ctx = { .out = { .cbs = &es_out_cbs } };
+    EsOutReset(&ctx);
+
+    demux_t *demux = demux_New(VLC_OBJECT(vlc->p_libvlc_int), "ts",
+                               "vlc://nop", s, &ctx.out);
+    assert(demux != NULL);
+
+    /* Whole file, across the garbage: no packet is lost */
+    DemuxToEnd(demux, &f, &ctx);
+    assert(ctx.i_first == 0);
+
+    /* Seek in the middle of a packet: the demux resyncs on the next one */
+    const size_t i_seek = f.pes_end[200] - i_stride / 2;
+    EsOutReset(&ctx);
+    int ret = demux_Control(demux, DEMUX_SET_POSITION,
+                            (double) i_seek / f.i_data, false);
+    assert(ret == VLC_SUCCESS);
+    DemuxToEnd(demux, &f, &ctx);
+    assert(ctx.i_first == 201);
+
+    /* Seek back before the garbage */
+    EsOutReset(&ctx);
+    ret = demux_Control(demux, DEMUX_SET_POSITION,
+                        (double) f.pes_end[99] / f.i_data, false);
+    assert(ret == VLC_SUCCESS);
+    DemuxToEnd(demux, &f, &ctx);
+    assert(ctx.i_first == 100);
+
+    demux_Delete(demux); /* and its source stream */
+    free(f.p_data);
+}
+
+int main(void)
+{
+    test_init();
+
+    static const char * argv[] = {
+        "-v",
+        "--ignore-config",
+        /* positions from byte offsets, not from timestamps */
+        "--ts-seek-percent",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    if (!module_exists("ts"))
+    {
+        fprintf(stderr, "skip: no \"ts\" module\n");
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    Test(vlc, 188, 0);
+    Test(vlc, 192, 4); /* BluRay timestamp header */
+    Test(vlc, 204, 0); /* Reed-Solomon trailer */
+
+    libvlc_release(vlc);
+    return 0;
+}
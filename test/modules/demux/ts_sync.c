@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * ts_sync.c: MPEG TS sync byte scanning tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+
+#include "../../../modules/demux/mpeg/ts_sync.h"
+
+#include "../../libvlc/test.h"
+
+#define ASSERT(a) do {\
+    if(!(a)) { \
+        fprintf(stderr, "failed line %d\n", __LINE__); \
+        return 1; } \
+    } while(0)
+
+#define GARBAGE 500
+#define PACKETS 8
+
+static const struct
+{
+    size_t i_size;
+    size_t i_header;
+} formats[] = {
+    { 188, 0 },
+    { 192, 4 }, /* M2TS: sync byte after a 4 bytes timestamp */
+    { 204, 0 },
+};
+
+/* Garbage with false sync bytes: 61 bytes apart, which is not a multiple
+ * of any packet size */
+static void FillGarbage(uint8_t *p, size_t i_size)
+{
+    memset(p, 0xAA, i_size);
+    for(size_t i = 0; i < i_size; i += 61)
+        p[i] = TS_SYNC_BYTE;
+}
+
+static void FillPackets(uint8_t *p, size_t i_count, size_t i_size,
+                        size_t i_header)
+{
+    for(size_t i = 0; i < i_count; i++)
+    {
+        uint8_t *pkt = &p[i * i_size];
+        memset(pkt, 0x00, i_size);
+        pkt[i_header] = TS_SYNC_BYTE;
+        /* False sync bytes inside the packets too, never at the same
+         * offset in two consecutive packets */
+        pkt[i_header + 10 + i] = TS_SYNC_BYTE;
+    }
+}
+
+/* Exact size allocations, so that overreads are caught by sanitizers */
+static uint8_t *Dup(const uint8_t *p, size_t i_size)
+{
+    uint8_t *dup = malloc(i_size ? i_size : 1);
+    assert(dup);
+    memcpy(dup, p, i_size);
+    return dup;
+}
+
+static size_t Find(const uint8_t *p, size_t i_size, size_t i_stride,
+                   unsigned i_count)
+{
+    uint8_t *dup = Dup(p, i_size);
+    size_t i_ret = ts_sync_Find(dup, i_size, i_stride, i_count);
+    free(dup);
+    return i_ret;
+}
+
+static int TestFormat(size_t i_size, size_t i_header)
+{
+    const size_t i_stream = GARBAGE + PACKETS * i_size;
+    uint8_t *p = malloc(i_stream);
+    assert(p);
+
+    FillGarbage(p, GARBAGE);
+    FillPackets(&p[GARBAGE], PACKETS, i_size, i_header);
+    const size_t i_sync = GARBAGE + i_header;
+
+    /* No false positive in the garbage, for any requirement */
+    for(unsigned i_count = 2; i_count <= 4; i_count++)
+        ASSERT(Find(p, i_stream, i_size, i_count) == i_sync);
+
+    /* The false sync bytes pass a single check only */
+    ASSERT(ts_sync_Check(&p[0], i_size, 1));
+    ASSERT(!ts_sync_Check(&p[0], i_size, 2));
+    ASSERT(ts_sync_Check(&p[i_sync], i_size, PACKETS));
+    ASSERT(!ts_sync_Check(&p[i_sync + 10], i_size, 2));
+
+    /* Other strides do not match */
+    for(size_t i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        if(formats[i].i_size == i_size)
+            continue;
+        ASSERT(Find(&p[GARBAGE], PACKETS * i_size, formats[i].i_size, 4) ==
+               PACKETS * i_size - 3 * formats[i].i_size);
+    }
+
+    /* Buffer edges: the last sync byte of the match is the last byte */
+    for(unsigned i_count = 2; i_count <= 4; i_count++)
+    {
+        const size_t i_span = (i_count - 1) * i_size;
+        ASSERT(Find(p, i_sync + i_span + 1, i_size, i_count) == i_sync);
+
+        /* One byte short: nothing found, and the returned prefix is the
+         * part that cannot start a match, whatever follows */
+        size_t i_skip = Find(p, i_sync + i_span, i_size, i_count);
+        ASSERT(i_skip == i_sync);
+        ASSERT(Find(&p[i_skip], i_stream - i_skip, i_size, i_count) == 0);
+
+        /* Too short to hold a match at all */
+        ASSERT(Find(p, i_span, i_size, i_count) == 0);
+        ASSERT(Find(p, 0, i_size, i_count) == 0);
+    }
+
+    /* Packets only */
+    ASSERT(Find(&p[GARBAGE], PACKETS * i_size, i_size, 2) == i_header);
+
+    /* Garbage only: all of it but the last span can be discarded */
+    ASSERT(Find(p, GARBAGE, i_size, 2) == GARBAGE - i_size);
+
+    free(p);
+    return 0;
+}
+
+/* Resynchronization in the middle of a stream, as in the demuxer loop:
+ * corrupted bytes between packets are skipped */
+static int TestResync(size_t i_size, size_t i_header)
+{
+    const size_t i_stream = 2 * i_size + 37 + 4 * i_size;
+    uint8_t *p = malloc(i_stream);
+    assert(p);
+
+    FillPackets(p, 2, i_size, i_header);
+    FillGarbage(&p[2 * i_size], 37);
+    FillPackets(&p[2 * i_size + 37], 4, i_size, i_header);
+
+    /* Packets are accepted when the next one starts with a sync byte */
+    size_t i_pos = 0;
+    unsigned i_resyncs = 0;
+    while(i_pos + i_size < i_stream)
+    {
+        if(ts_sync_Check(&p[i_pos + i_header], i_size, 2))
+        {
+            i_pos += i_size;
+            continue;
+        }
+        size_t i_skip = Find(&p[i_pos + i_header], i_stream - i_pos - i_header,
+                             i_size, 2);
+        ASSERT(i_skip > 0);
+        i_pos += i_skip;
+        i_resyncs++;
+    }
+    ASSERT(i_resyncs == 1);
+    /* Stopped before the last packet, which has no next sync byte */
+    ASSERT(i_pos == 2 * i_size + 37 + 3 * i_size);
+
+    free(p);
+    return 0;
+}
+
+int main(void)
+{
+    for(size_t i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        if(TestFormat(formats[i].i_size, formats[i].i_header) ||
+           TestResync(formats[i].i_size, formats[i].i_header))
+        {
+            fprintf(stderr, "failed with %zu bytes packets\n",
+                    formats[i].i_size);
+            return 1;
+        }
+    }
+    return 0;
+}
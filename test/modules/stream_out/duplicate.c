@@ -0,0 +1,289 @@
+/*****************************************************************************
+ * duplicate.c: duplicate stream output shared payload tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_frame.h>
+#include <vlc_fs.h>
+#include <vlc_modules.h>
+#include <vlc_sout.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+#define FRAME_COUNT 30
+#define NAL_SIZE    600
+
+/* The duplicated branches share the payload of each frame: the mp4 muxers
+ * convert the Annex B start codes into NAL lengths, which must not be seen
+ * by the other branches. With two mp4 branches, one of them always converts
+ * after the other, whatever the muxing order. */
+static const char *const outputs[] = { "a.mp4", "b.mp4", "c.ts" };
+
+/* Fills one frame with one or two filler NAL units and 4 bytes start codes,
+ * which the mp4 muxer converts in place */
+static size_t MakeFrame(uint8_t *buf, unsigned i_index, bool b_length)
+{
+    const unsigned i_nals = 1 + (i_index & 1);
+    size_t i_size = 0;
+    for (unsigned j = 0; j < i_nals; j++)
+    {
+        const size_t i_nal = NAL_SIZE - j * 100;
+        if (b_length)
+            SetDWBE(&buf[i_size], i_nal);
+        else
+            SetDWBE(&buf[i_size], 1);
+        i_size += 4;
+        buf[i_size] = 0x0c; /* filler data */
+        for (size_t k = 1; k < i_nal; k++)
+            buf[i_size + k] = 1 + (i_index + j + k) % 255;
+        i_size += i_nal;
+    }
+    return i_size;
+}
+
+static uint8_t *ReadFile(const char *path, size_t *pi_size)
+{
+    FILE *f = vlc_fopen(path, "rb");
+    assert(f != NULL);
+    int ret = fseek(f, 0, SEEK_END);
+    assert(ret == 0);
+    long i_size = ftell(f);
+    assert(i_size > 0);
+    rewind(f);
+
+    uint8_t *p_data = malloc(i_size);
+    assert(p_data != NULL);
+    size_t i_read = fread(p_data, 1, i_size, f);
+    assert(i_read == (size_t) i_size);
+    fclose(f);
+
+    *pi_size = i_size;
+    return p_data;
+}
+
+/* Checks that the first frames are found intact, in order */
+static void CheckFrames(const uint8_t *p_data, size_t i_data, bool b_length,
+                        unsigned i_min)
+{
+    uint8_t frame[2 * (4 + NAL_SIZE)];
+    size_t i_pos = 0;
+    unsigned i_found = 0;
+    for (; i_found < FRAME_COUNT; i_found++)
+    {
+        const size_t i_frame = MakeFrame(frame, i_found, b_length);
+        while (i_pos + i_frame <= i_data &&
+               memcmp(&p_data[i_pos], frame, i_frame))
+            i_pos++;
+        if (i_pos + i_frame > i_data)
+            break;
+        i_pos += i_frame;
+    }
+    fprintf(stderr, "found %u frames\n", i_found);
+    assert(i_found >= i_min);
+}
+
+static void CheckMP4(const char *path)
+{
+    size_t i_file;
+    uint8_t *p_file = ReadFile(path, &i_file);
+
+    /* Top level boxes, the samples are stored in the only mdat */
+    const uint8_t *p_mdat = NULL;
+    size_t i_mdat = 0;
+    for (size_t i_pos = 0; i_pos + 8 <= i_file;)
+    {
+        uint64_t i_box = GetDWBE(&p_file[i_pos]);
+        size_t i_header = 8;
+        if (i_box == 1)
+        {
+            assert(i_pos + 16 <= i_file);
+            i_box = GetQWBE(&p_file[i_pos + 8]);
+            i_header = 16;
+        }
+        else if (i_box == 0)
+            i_box = i_file - i_pos;
+        assert(i_box >= i_header && i_box <= i_file - i_pos);
+
+        if (!memcmp(&p_file[i_pos + 4], "mdat", 4))
+        {
+            assert(p_mdat == NULL);
+            p_mdat = &p_file[i_pos + i_header];
+            i_mdat = i_box - i_header;
+        }
+        i_pos += i_box;
+    }
+    assert(p_mdat != NULL);
+
+    CheckFrames(p_mdat, i_mdat, true, FRAME_COUNT);
+    free(p_file);
+}
+
+static void CheckTS(const char *path)
+{
+    size_t i_file;
+    uint8_t *p_file = ReadFile(path, &i_file);
+    assert(i_file % 188 == 0);
+
+    /* Video PID, from the first PES header */
+    int i_video = -1;
+    uint8_t *p_es = malloc(i_file);
+    assert(p_es != NULL);
+    size_t i_es = 0;
+
+    for (size_t i = 0; i < i_file; i += 188)
+    {
+        const uint8_t *pkt = &p_file[i];
+        assert(pkt[0] == 0x47);
+        const int i_pid = ((pkt[1] & 0x1f) << 8) | pkt[2];
+        const bool b_unit_start = pkt[1] & 0x40;
+        if (!(pkt[3] & 0x10))
+            continue;
+
+        size_t i_payload = 4;
+        if (pkt[3] & 0x20)
+            i_payload += 1 + pkt[4];
+        assert(i_payload <= 188);
+
+        if (b_unit_start && i_payload + 9 <= 188 &&
+            !memcmp(&pkt[i_payload], "\x00\x00\x01\xe0", 4))
+        {
+            if (i_video == -1)
+                i_video = i_pid;
+            if (i_pid == i_video)
+                i_payload += 9 + pkt[i_payload + 8];
+        }
+        if (i_pid != i_video || i_payload > 188)
+            continue;
+
+        memcpy(&p_es[i_es], &pkt[i_payload], 188 - i_payload);
+        i_es += 188 - i_payload;
+    }
+    assert(i_video != -1);
+
+    /* The muxer may add access unit delimiters between the frames, and keep
+     * the last frames when it is closed */
+    CheckFrames(p_es, i_es, false, FRAME_COUNT / 2);
+    free(p_es);
+    free(p_file);
+}
+
+int main(void)
+{
+#ifndef ENABLE_SOUT
+    (void) outputs;
+    (void) CheckMP4;
+    (void) CheckTS;
+    return 77;
+#else
+    test_init();
+
+    static const char * argv[] = {
+        "-v",
+        "--ignore-config",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    static const char *const modules[] = {
+        "stream_out_duplicate", "stream_out_standard", "access_output_file",
+        "mux_mp4", "mux_ts",
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(modules); i++)
+    {
+        if (!module_exists(modules[i]))
+        {
+            fprintf(stderr, "skip: no \"%s\" module\n", modules[i]);
+            libvlc_release(vlc);
+            return 77;
+        }
+    }
+
+    char tmp_dir[] = "/tmp/libvlc_XXXXXX";
+    if (mkdtemp(tmp_dir) == NULL)
+    {
+        fprintf(stderr, "skip: mkdtemp failed\n");
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    char *paths[ARRAY_SIZE(outputs)];
+    for (size_t i = 0; i < ARRAY_SIZE(outputs); i++)
+    {
+        int ret = asprintf(&paths[i], "%s/%s", tmp_dir, outputs[i]);
+        assert(ret > 0);
+    }
+
+    char *chain;
+    int ret = asprintf(&chain,
+        "duplicate{dst=std{access=file,mux=mp4,dst=%s},"
+                  "dst=std{access=file,mux=mp4,dst=%s},"
+                  "dst=std{access=file,mux=ts,dst=%s}}",
+        paths[0], paths[1], paths[2]);
+    assert(ret > 0);
+
+    sout_stream_t *stream =
+        sout_StreamChainNew(VLC_OBJECT(vlc->p_libvlc_int), chain, NULL);
+    assert(stream != NULL);
+    free(chain);
+
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, VLC_CODEC_H264);
+    fmt.video.i_width = fmt.video.i_visible_width = 320;
+    fmt.video.i_height = fmt.video.i_visible_height = 240;
+    fmt.video.i_frame_rate = 25;
+    fmt.video.i_frame_rate_base = 1;
+    fmt.b_packetized = true;
+    void *id = sout_StreamIdAdd(stream, &fmt, "video");
+    assert(id != NULL);
+
+    for (unsigned i = 0; i < FRAME_COUNT; i++)
+    {
+        vlc_frame_t *frame = vlc_frame_Alloc(2 * (4 + NAL_SIZE));
+        assert(frame != NULL);
+        frame->i_buffer = MakeFrame(frame->p_buffer, i, false);
+        frame->i_dts = frame->i_pts = VLC_TICK_0 + i * VLC_TICK_FROM_MS(40);
+        frame->i_length = VLC_TICK_FROM_MS(40);
+        if (i == 0)
+            frame->i_flags |= VLC_FRAME_FLAG_TYPE_I;
+        ret = sout_StreamIdSend(stream, id, frame);
+        assert(ret == VLC_SUCCESS);
+    }
+
+    sout_StreamIdDel(stream, id);
+    sout_StreamChainDelete(stream, NULL);
+
+    CheckMP4(paths[0]);
+    CheckMP4(paths[1]);
+    CheckTS(paths[2]);
+
+    for (size_t i = 0; i < ARRAY_SIZE(outputs); i++)
+    {
+        vlc_unlink(paths[i]);
+        free(paths[i]);
+    }
+    rmdir(tmp_dir);
+
+    libvlc_release(vlc);
+    return 0;
+#endif
+}
@@ -0,0 +1,275 @@
+/*****************************************************************************
+ * cmaf.c: HLS stream output CMAF segments and DASH manifest tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_frame.h>
+#include <vlc_fs.h>
+#include <vlc_modules.h>
+#include <vlc_sout.h>
+#include "../../../../lib/libvlc_internal.h"
+
+#include "../../../libvlc/test.h"
+
+#define BASE_URL    "http://example.com/live"
+#define FRAME_RATE  25
+#define FRAME_COUNT (6 * FRAME_RATE)
+#define NAL_SIZE    600
+
+static char *ReadFile(const char *dir, const char *name, size_t *pi_size)
+{
+    char *path;
+    int ret = asprintf(&path, "%s/%s", dir, name);
+    assert(ret > 0);
+    FILE *f = vlc_fopen(path, "rb");
+    free(path);
+    if (f == NULL)
+        return NULL;
+
+    ret = fseek(f, 0, SEEK_END);
+    assert(ret == 0);
+    long i_size = ftell(f);
+    assert(i_size >= 0);
+    rewind(f);
+
+    /* Terminated, so that manifests can be searched as strings */
+    char *p_data = malloc(i_size + 1);
+    assert(p_data != NULL);
+    size_t i_read = fread(p_data, 1, i_size, f);
+    assert(i_read == (size_t) i_size);
+    p_data[i_size] = '\0';
+    fclose(f);
+
+    if (pi_size != NULL)
+        *pi_size = i_size;
+    return p_data;
+}
+
+static unsigned CountOccurrences(const char *str, const char *sub)
+{
+    unsigned i_count = 0;
+    for (const char *p = strstr(str, sub); p != NULL; p = strstr(p + 1, sub))
+        i_count++;
+    return i_count;
+}
+
+/* Checks the top level boxes of a segment, returns whether one has the
+ * given type */
+static bool HasBox(const char *p_file, size_t i_file, const char *type)
+{
+    bool b_found = false;
+    for (size_t i_pos = 0; i_pos + 8 <= i_file;)
+    {
+        uint32_t i_box = GetDWBE(&p_file[i_pos]);
+        assert(i_box >= 8 && i_box <= i_file - i_pos);
+        b_found |= !memcmp(&p_file[i_pos + 4], type, 4);
+        i_pos += i_box;
+    }
+    return b_found;
+}
+
+/* The DASH timeline and the HLS playlist describe the same segments */
+static void CheckSegments(const char *dir, bool b_ended)
+{
+    char *mpd = ReadFile(dir, "index.mpd", NULL);
+    assert(mpd != NULL);
+    char *m3u8 = ReadFile(dir, "playlist-0-index.m3u8", NULL);
+    assert(m3u8 != NULL);
+
+    assert(strstr(mpd, "<BaseURL>" BASE_URL "/</BaseURL>") != NULL);
+    assert(strstr(mpd, b_ended ? "type=\"static\"" : "type=\"dynamic\"")
+           != NULL);
+    assert(strstr(mpd, "mimeType=\"video/mp4\"") != NULL);
+    assert(strstr(mpd, "codecs=\"") != NULL);
+    assert(strstr(mpd, "initialization=\"playlist-0-init.mp4\"") != NULL);
+    assert(strstr(mpd, "media=\"playlist-0-$Number$.m4s\"") != NULL);
+    assert(strstr(mpd, "startNumber=\"0\"") != NULL);
+
+    assert(strstr(m3u8, "#EXT-X-MAP:URI=\"" BASE_URL "/playlist-0-init.mp4\"")
+           != NULL);
+    assert((strstr(m3u8, "#EXT-X-ENDLIST") != NULL) == b_ended);
+
+    /* Same segment count, the timeline starts at 0 and has no gap */
+    const unsigned i_segments = CountOccurrences(m3u8, "#EXTINF:");
+    assert(i_segments > 0);
+    assert(CountOccurrences(mpd, "<S ") == i_segments);
+    assert(CountOccurrences(mpd, "<S t=\"0\" d=\"") == 1);
+
+    vlc_tick_t i_total = 0;
+    for (const char *p = strstr(mpd, "<S "); p != NULL; p = strstr(p, "<S "))
+    {
+        p = strstr(p, " d=\"");
+        assert(p != NULL);
+        p += 4;
+        i_total += strtoll(p, NULL, 10);
+    }
+    if (b_ended)
+    {
+        /* All the frames are in the segments, the last one may be given
+         * its own length by the muxer */
+        const vlc_tick_t i_frame = vlc_tick_from_samples(1, FRAME_RATE);
+        assert(i_total >= (FRAME_COUNT - 1) * i_frame);
+        assert(i_total <= FRAME_COUNT * i_frame);
+        char duration[64];
+        snprintf(duration, sizeof(duration),
+                 "mediaPresentationDuration=\"PT%.3fS\"",
+                 secf_from_vlc_tick(i_total));
+        assert(strstr(mpd, duration) != NULL);
+    }
+
+    /* The initialization segment is followed by moof/mdat media segments */
+    size_t i_file;
+    char *p_file = ReadFile(dir, "playlist-0-init.mp4", &i_file);
+    assert(p_file != NULL);
+    assert(i_file >= 8 && !memcmp(&p_file[4], "ftyp", 4));
+    assert(HasBox(p_file, i_file, "moov"));
+    assert(!HasBox(p_file, i_file, "moof"));
+    free(p_file);
+
+    for (unsigned i = 0; i < i_segments; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "playlist-0-%u.m4s", i);
+        assert(strstr(m3u8, name) != NULL);
+
+        p_file = ReadFile(dir, name, &i_file);
+        assert(p_file != NULL);
+        assert(HasBox(p_file, i_file, "moof"));
+        assert(HasBox(p_file, i_file, "mdat"));
+        assert(!HasBox(p_file, i_file, "moov"));
+        assert(!HasBox(p_file, i_file, "mfra"));
+        free(p_file);
+    }
+
+    free(m3u8);
+    free(mpd);
+}
+
+static void RemoveDir(const char *dir)
+{
+    vlc_DIR *d = vlc_opendir(dir);
+    assert(d != NULL);
+    const char *name;
+    while ((name = vlc_readdir(d)) != NULL)
+    {
+        if (!strcmp(name, ".") || !strcmp(name, ".."))
+            continue;
+        char *path;
+        int ret = asprintf(&path, "%s/%s", dir, name);
+        assert(ret > 0);
+        vlc_unlink(path);
+        free(path);
+    }
+    vlc_closedir(d);
+    rmdir(dir);
+}
+
+int main(void)
+{
+#ifndef ENABLE_SOUT
+    (void) CheckSegments;
+    (void) RemoveDir;
+    return 77;
+#else
+    test_init();
+
+    static const char * argv[] = {
+        "-v",
+        "--ignore-config",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    static const char *const modules[] = { "stream_out_hls", "mux_mp4" };
+    for (size_t i = 0; i < ARRAY_SIZE(modules); i++)
+    {
+        if (!module_exists(modules[i]))
+        {
+            fprintf(stderr, "skip: no \"%s\" module\n", modules[i]);
+            libvlc_release(vlc);
+            return 77;
+        }
+    }
+
+    char tmp_dir[] = "/tmp/libvlc_XXXXXX";
+    if (mkdtemp(tmp_dir) == NULL)
+    {
+        fprintf(stderr, "skip: mkdtemp failed\n");
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    char *chain;
+    int ret = asprintf(&chain,
+        "hls{variants={{video}},out-dir=%s,base-url=" BASE_URL ",seg-len=1,"
+            "dash}", tmp_dir);
+    assert(ret > 0);
+
+    sout_stream_t *stream =
+        sout_StreamChainNew(VLC_OBJECT(vlc->p_libvlc_int), chain, NULL);
+    assert(stream != NULL);
+    free(chain);
+
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, VLC_CODEC_H264);
+    fmt.video.i_width = fmt.video.i_visible_width = 320;
+    fmt.video.i_height = fmt.video.i_visible_height = 240;
+    fmt.video.i_frame_rate = FRAME_RATE;
+    fmt.video.i_frame_rate_base = 1;
+    fmt.b_packetized = true;
+    void *id = sout_StreamIdAdd(stream, &fmt, "video");
+    assert(id != NULL);
+
+    for (unsigned i = 0; i < FRAME_COUNT; i++)
+    {
+        vlc_frame_t *frame = vlc_frame_Alloc(4 + NAL_SIZE);
+        assert(frame != NULL);
+        SetDWBE(frame->p_buffer, 1);
+        frame->p_buffer[4] = 0x0c; /* filler data */
+        memset(&frame->p_buffer[5], 0xff, NAL_SIZE - 1);
+        frame->i_dts = frame->i_pts =
+            VLC_TICK_0 + vlc_tick_from_samples(i, FRAME_RATE);
+        frame->i_length = vlc_tick_from_samples(1, FRAME_RATE);
+        /* One GOP per second */
+        if (i % FRAME_RATE == 0)
+            frame->i_flags |= VLC_FRAME_FLAG_TYPE_I;
+        ret = sout_StreamIdSend(stream, id, frame);
+        assert(ret == VLC_SUCCESS);
+        sout_StreamSetPCR(stream, VLC_TICK_0 +
+                          vlc_tick_from_samples(i, FRAME_RATE));
+
+        /* Live: published segments are already described */
+        if (i == FRAME_COUNT / 2)
+            CheckSegments(tmp_dir, false);
+    }
+
+    sout_StreamIdDel(stream, id);
+    sout_StreamChainDelete(stream, NULL);
+
+    /* Ended: every segment is described, and the manifest is static */
+    CheckSegments(tmp_dir, true);
+
+    RemoveDir(tmp_dir);
+    libvlc_release(vlc);
+    return 0;
+#endif
+}
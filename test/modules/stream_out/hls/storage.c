@@ -0,0 +1,168 @@
+/*****************************************************************************
+ * storage.c: HLS segment storage unit tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+
+#include "../../../libvlc/test.h"
+#include "../../../../modules/stream_out/hls/hls.h"
+#include "../../../../modules/stream_out/hls/storage.h"
+
+static const struct hls_storage_config STORAGE_CONFIG = {
+    .name = "segment-1.ts",
+    .mime = "video/MP2T",
+};
+
+static void check_content(block_t *chain, const char *expected)
+{
+    assert(chain != NULL);
+
+    size_t size;
+    block_ChainProperties(chain, NULL, &size, NULL);
+    assert(size == strlen(expected));
+
+    for (const block_t *it = chain; it != NULL; it = it->p_next)
+    {
+        assert(memcmp(it->p_buffer, expected, it->i_buffer) == 0);
+        expected += it->i_buffer;
+    }
+}
+
+static void test_mem_storage(void)
+{
+    const struct hls_config config = {.outdir = NULL};
+
+    block_t *content = NULL;
+    block_t **last = &content;
+    block_t *hello = block_Alloc(6);
+    block_t *world = block_Alloc(5);
+    assert(hello != NULL && world != NULL);
+    memcpy(hello->p_buffer, "Hello ", 6);
+    memcpy(world->p_buffer, "world", 5);
+    block_ChainLastAppend(&last, hello);
+    block_ChainLastAppend(&last, world);
+
+    hls_storage_t *storage =
+        hls_storage_FromBlocks(content, &STORAGE_CONFIG, &config);
+    assert(storage != NULL);
+    assert(hls_storage_GetSize(storage) == 11);
+
+    block_t *first = storage->get_content(storage);
+    block_t *second = storage->get_content(storage);
+    check_content(first, "Hello world");
+    check_content(second, "Hello world");
+
+    /* The views share the storage payload. */
+    assert(first->p_buffer == hello->p_buffer);
+    assert(second->p_buffer == hello->p_buffer);
+
+    /* Pending views keep the content alive. */
+    hls_storage_Destroy(storage);
+    check_content(first, "Hello world");
+    block_ChainRelease(first);
+    check_content(second, "Hello world");
+    block_ChainRelease(second);
+}
+
+static void test_fs_storage(void)
+{
+    char outdir[] = "/tmp/vlc-test-hls-storage-XXXXXX";
+    assert(mkdtemp(outdir) != NULL);
+    const struct hls_config config = {.outdir = outdir};
+
+    char *first_data = strdup("first");
+    assert(first_data != NULL);
+    hls_storage_t *first = hls_storage_FromBytes(
+        first_data, strlen(first_data), &STORAGE_CONFIG, &config);
+    assert(first != NULL);
+
+    block_t *first_view = first->get_content(first);
+    check_content(first_view, "first");
+
+    /* Replacing the file must not alter the content being served. */
+    char *second_data = strdup("second version");
+    assert(second_data != NULL);
+    hls_storage_t *second = hls_storage_FromBytes(
+        second_data, strlen(second_data), &STORAGE_CONFIG, &config);
+    assert(second != NULL);
+
+    hls_storage_Destroy(first);
+    block_t *second_view = second->get_content(second);
+    check_content(second_view, "second version");
+    check_content(first_view, "first");
+
+    block_ChainRelease(first_view);
+    block_ChainRelease(second_view);
+    hls_storage_Destroy(second);
+
+    char *path;
+    assert(asprintf(&path, "%s/%s", outdir, STORAGE_CONFIG.name) != -1);
+    vlc_unlink(path);
+    free(path);
+    rmdir(outdir);
+}
+
+static void test_fs_storage_remove(void)
+{
+    char outdir[] = "/tmp/vlc-test-hls-storage-XXXXXX";
+    assert(mkdtemp(outdir) != NULL);
+    const struct hls_config config = {.outdir = outdir};
+
+    char *data = strdup("part");
+    assert(data != NULL);
+    hls_storage_t *storage = hls_storage_FromBytes(
+        data, strlen(data), &STORAGE_CONFIG, &config);
+    assert(storage != NULL);
+
+    char *path;
+    assert(asprintf(&path, "%s/%s", outdir, STORAGE_CONFIG.name) != -1);
+    struct stat st;
+    assert(vlc_stat(path, &st) == 0);
+
+    /* The file is removed, the content being served is not. */
+    block_t *view = storage->get_content(storage);
+    check_content(view, "part");
+    hls_storage_Remove(storage);
+    assert(vlc_stat(path, &st) != 0);
+    check_content(view, "part");
+    block_ChainRelease(view);
+
+    free(path);
+    rmdir(outdir);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_mem_storage();
+    test_fs_storage();
+    test_fs_storage_remove();
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*****************************************************************************
+ * udp.c: UDP stream output batch send tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdatomic.h>
+
+#include <vlc_common.h>
+#include <vlc_frame.h>
+#include <vlc_modules.h>
+#include <vlc_network.h>
+#include <vlc_sout.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+#ifdef HAVE_POLL_H
+# include <poll.h>
+#endif
+
+#define FRAME_COUNT 50
+/* About 16 datagrams per frame: the muxer output chains hold more
+ * datagrams than are sent per system call */
+#define FRAME_SIZE  (20 * 1024)
+#define MTU         1400 /* default */
+
+struct receiver
+{
+    int fd;
+    atomic_bool done;
+    unsigned datagrams;
+    unsigned pes_starts;
+    unsigned cc_errors;
+    uint8_t cc[8192]; /* last continuity counter, 0xff if none */
+};
+
+static void CheckPacket(struct receiver *r, const uint8_t *pkt)
+{
+    assert(pkt[0] == 0x47);
+    assert(!(pkt[1] & 0x80));
+
+    const uint16_t i_pid = ((pkt[1] & 0x1f) << 8) | pkt[2];
+    const bool b_payload = pkt[3] & 0x10;
+    const uint8_t i_cc = pkt[3] & 0x0f;
+    if (i_pid == 0x1fff || !b_payload)
+        return;
+
+    /* A lost, duplicated or reordered datagram breaks the counters */
+    if (r->cc[i_pid] != 0xff && i_cc != ((r->cc[i_pid] + 1) & 0x0f))
+        r->cc_errors++;
+    r->cc[i_pid] = i_cc;
+
+    size_t i_payload = 4;
+    if (pkt[3] & 0x20)
+        i_payload += 1 + pkt[4];
+    if ((pkt[1] & 0x40) && i_payload + 4 <= 188 &&
+        !memcmp(&pkt[i_payload], "\x00\x00\x01\xe0", 4))
+        r->pes_starts++;
+}
+
+static void *ReceiverThread(void *data)
+{
+    struct receiver *r = data;
+    uint8_t buf[65536];
+
+    for (;;)
+    {
+        struct pollfd ufd = { .fd = r->fd, .events = POLLIN };
+        /* Once the output is closed, wait a little for the last ones */
+        int val = poll(&ufd, 1, atomic_load(&r->done) ? 500 : 100);
+        if (val == 0)
+        {
+            if (atomic_load(&r->done))
+                break;
+            continue;
+        }
+        assert(val == 1);
+
+        ssize_t len = recv(r->fd, buf, sizeof(buf), 0);
+        assert(len > 0);
+        assert(len <= MTU);
+        assert(len % 188 == 0);
+        for (ssize_t i = 0; i < len; i += 188)
+            CheckPacket(r, &buf[i]);
+        r->datagrams++;
+    }
+    return NULL;
+}
+
+#ifdef ENABLE_SOUT
+static int OpenReceiver(struct receiver *r)
+{
+    r->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(r->fd >= 0);
+
+    /* Best effort: the kernel caps it to the system maximum */
+    int size = 4 << 20;
+    setsockopt(r->fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        .sin_port = 0,
+    };
+    int val = bind(r->fd, (struct sockaddr *) &addr, sizeof(addr));
+    assert(val == 0);
+    socklen_t len = sizeof(addr);
+    val = getsockname(r->fd, (struct sockaddr *) &addr, &len);
+    assert(val == 0);
+    return ntohs(addr.sin_port);
+}
+#endif
+
+int main(void)
+{
+#ifndef ENABLE_SOUT
+    (void) ReceiverThread;
+    return 77;
+#else
+    test_init();
+
+    static const char * argv[] = {
+        "-v",
+        "--ignore-config",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    if (!module_exists("mux_ts"))
+    {
+        fprintf(stderr, "skip: no \"mux_ts\" module\n");
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    struct receiver r = { .datagrams = 0 };
+    atomic_init(&r.done, false);
+    memset(r.cc, 0xff, sizeof(r.cc));
+    const int i_port = OpenReceiver(&r);
+
+    vlc_thread_t thread;
+    int ret = vlc_clone(&thread, ReceiverThread, &r);
+    assert(ret == VLC_SUCCESS);
+
+    char chain[64];
+    snprintf(chain, sizeof(chain), "udp{dst=127.0.0.1:%d}", i_port);
+    sout_stream_t *stream =
+        sout_StreamChainNew(VLC_OBJECT(vlc->p_libvlc_int), chain, NULL);
+    assert(stream != NULL);
+
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, VLC_CODEC_MPGV);
+    fmt.video.i_width = fmt.video.i_visible_width = 320;
+    fmt.video.i_height = fmt.video.i_visible_height = 240;
+    void *id = sout_StreamIdAdd(stream, &fmt, "video");
+    assert(id != NULL);
+
+    for (unsigned i = 0; i < FRAME_COUNT; i++)
+    {
+        vlc_frame_t *frame = vlc_frame_Alloc(FRAME_SIZE);
+        assert(frame != NULL);
+        memset(frame->p_buffer, i, frame->i_buffer);
+        frame->i_dts = frame->i_pts = VLC_TICK_0 + i * VLC_TICK_FROM_MS(40);
+        frame->i_length = VLC_TICK_FROM_MS(40);
+        if (i % 12 == 0)
+            frame->i_flags |= VLC_FRAME_FLAG_TYPE_I;
+        ret = sout_StreamIdSend(stream, id, frame);
+        assert(ret == VLC_SUCCESS);
+    }
+
+    sout_StreamIdDel(stream, id);
+    sout_StreamChainDelete(stream, NULL);
+
+    atomic_store(&r.done, true);
+    vlc_join(thread, NULL);
+    net_Close(r.fd);
+
+    fprintf(stderr, "received %u datagrams, %u frames\n",
+            r.datagrams, r.pes_starts);
+    assert(r.cc_errors == 0);
+    /* The muxer may keep the last frames when it is closed */
+    assert(r.pes_starts > 0 && r.pes_starts <= FRAME_COUNT);
+    assert(r.pes_starts >= FRAME_COUNT / 2);
+    /* More than one full batch of datagrams was sent */
+    assert(r.datagrams > 64);
+
+    libvlc_release(vlc);
+    return 0;
+#endif
+}
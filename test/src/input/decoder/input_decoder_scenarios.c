@@ -47,6 +47,15 @@ static struct scenario_data
     bool stream_out_sent;
     size_t decoder_image_sent;
     size_t cc_track_idx;
+
+    /* keyframes only */
+    size_t frame_count;
+    uint32_t frame_type;
+    bool frame_decoded;
+    bool gop_dropped;
+    size_t dropped_gops;
+    bool keyframes_only_left;
+    bool full_gop_decoded;
 } scenario_data;
 
 static void decoder_fixed_size(decoder_t *dec, vlc_fourcc_t chroma,
@@ -607,6 +616,94 @@ static void cc_text_renderer_render_608_02(filter_t *filter,
     vlc_sem_post(&scenario_data.wait_stop);
 }
 
+/* Each GOP is made of a keyframe, alternated P and B frames and a frame of
+ * unknown type */
+#define KEYFRAMES_GOP_LENGTH 12
+
+static uint32_t keyframes_frame_type(size_t index)
+{
+    size_t pos = index % KEYFRAMES_GOP_LENGTH;
+    if (pos == 0)
+        return VLC_FRAME_FLAG_TYPE_I;
+    if (pos == KEYFRAMES_GOP_LENGTH - 1)
+        return 0;
+    return pos % 2 ? VLC_FRAME_FLAG_TYPE_P : VLC_FRAME_FLAG_TYPE_B;
+}
+
+static void keyframes_end_gop(void)
+{
+    if (!scenario_data.keyframes_only_left)
+    {
+        if (scenario_data.gop_dropped && ++scenario_data.dropped_gops == 2)
+        {
+            /* Let the interface go back to the normal rate */
+            scenario_data.keyframes_only_left = true;
+            vlc_sem_post(&scenario_data.wait_ready_to_flush);
+        }
+    }
+    else if (!scenario_data.gop_dropped && !scenario_data.full_gop_decoded)
+    {
+        scenario_data.full_gop_decoded = true;
+        vlc_sem_post(&scenario_data.wait_stop);
+    }
+}
+
+static void packetizer_set_frame_types(decoder_t *dec, vlc_frame_t *frame)
+{
+    (void)dec;
+
+    /* The previous frame was either decoded or dropped by now, only
+     * predicted frames can be dropped */
+    if (scenario_data.frame_count > 0 && !scenario_data.frame_decoded)
+    {
+        assert(scenario_data.frame_type & (VLC_FRAME_FLAG_TYPE_P |
+                                           VLC_FRAME_FLAG_TYPE_B));
+        scenario_data.gop_dropped = true;
+    }
+
+    uint32_t type = keyframes_frame_type(scenario_data.frame_count);
+    if (type == VLC_FRAME_FLAG_TYPE_I && scenario_data.frame_count > 0)
+    {
+        keyframes_end_gop();
+        scenario_data.gop_dropped = false;
+    }
+
+    frame->i_flags = (frame->i_flags & ~VLC_FRAME_FLAG_TYPE_MASK) | type;
+    scenario_data.frame_type = type;
+    scenario_data.frame_decoded = false;
+    scenario_data.frame_count++;
+}
+
+static int decoder_decode_check_keyframes(decoder_t *dec, picture_t *pic)
+{
+    (void)dec;
+
+    /* A predicted frame is only decoded if no frame of its GOP was dropped,
+     * even right after leaving the keyframes only mode */
+    if (scenario_data.frame_type & (VLC_FRAME_FLAG_TYPE_P |
+                                    VLC_FRAME_FLAG_TYPE_B))
+        assert(!scenario_data.gop_dropped);
+
+    scenario_data.frame_decoded = true;
+    picture_Release(pic);
+    return VLC_SUCCESS;
+}
+
+static void player_setup_keyframes_rate(vlc_player_t *player)
+{
+    vlc_player_ChangeRate(player, 8.f);
+}
+
+static void interface_setup_leave_keyframes_only(intf_thread_t *intf)
+{
+    vlc_player_t *player = (vlc_player_t *)intf->p_sys;
+    vlc_sem_wait(&scenario_data.wait_ready_to_flush);
+
+    vlc_player_Lock(player);
+    vlc_player_ChangeRate(player, 1.f);
+    vlc_player_Unlock(player);
+}
+
 static const vlc_fourcc_t subpicture_chromas[] = {
     VLC_CODEC_RGBA, 0
 };
@@ -759,6 +856,21 @@ struct input_decoder_scenario input_decoder_scenarios[] =
     .display_prepare = display_prepare_noop,
     .text_renderer_render = cc_text_renderer_render_608_02,
 },
+{
+    /* Check the keyframes only mode of video decoders:
+     * - the playback starts above the default "keyframes-rate"
+     * - P and B frames are dropped, keyframes and frames of unknown type are
+     *   still decoded
+     * - once the rate is back to normal, P and B frames are only decoded
+     *   again from the next keyframe */
+    .name = "only keyframes are decoded at high rates",
+    .source = source_800_600 ";video_packetized=false",
+    .packetizer_packetize = packetizer_set_frame_types,
+    .decoder_setup = decoder_i420_800_600,
+    .decoder_decode = decoder_decode_check_keyframes,
+    .player_setup_before_start = player_setup_keyframes_rate,
+    .interface_setup = interface_setup_leave_keyframes_only,
+},
 };
 
 size_t input_decoder_scenarios_count = ARRAY_SIZE(input_decoder_scenarios);
@@ -771,6 +883,13 @@ void input_decoder_scenario_init(void)
     scenario_data.stream_out_sent = false;
     scenario_data.decoder_image_sent = 0;
     scenario_data.cc_track_idx = 1;
+    scenario_data.frame_count = 0;
+    scenario_data.frame_type = 0;
+    scenario_data.frame_decoded = false;
+    scenario_data.gop_dropped = false;
+    scenario_data.dropped_gops = 0;
+    scenario_data.keyframes_only_left = false;
+    scenario_data.full_gop_decoded = false;
     vlc_sem_init(&scenario_data.wait_stop, 0);
     vlc_sem_init(&scenario_data.wait_ready_to_flush, 0);
 }
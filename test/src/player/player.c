@@ -28,6 +28,7 @@
 #include <vlc_vector.h>
 #include <vlc_modules.h>
 #include <vlc_filter.h>
+#include <vlc_stream.h>
 
 #if defined(ZVBI_COMPILED)
 # define TELETEXT_DECODER "zvbi,"
@@ -124,6 +125,12 @@ struct report_media_attachments
     size_t count;
 };
 
+struct report_timeshift
+{
+    vlc_tick_t length;
+    vlc_tick_t delay;
+};
+
 #define PLAYER_REPORT_LIST \
     X(input_item_t *, on_current_media_changed) \
     X(enum vlc_player_state, on_state_changed) \
@@ -153,6 +160,7 @@ struct report_media_attachments
     X(input_item_t *, on_media_epg_changed) \
     X(struct report_media_subitems, on_media_subitems_changed) \
     X(struct report_media_attachments, on_media_attachments_added) \
+    X(struct report_timeshift, on_timeshift_changed) \
 
 struct report_aout_first_pts
 {
@@ -226,6 +234,7 @@ struct media_params
 
     bool can_seek;
     bool can_pause;
+    bool can_control_pace;
     bool error;
     bool null_names;
     vlc_tick_t pts_delay;
@@ -251,6 +260,7 @@ struct media_params
     .attachment_count = 0, \
     .can_seek = true, \
     .can_pause = true, \
+    .can_control_pace = true, \
     .error = false, \
     .null_names = false, \
     .pts_delay = DEFAULT_PTS_DELAY, \
@@ -274,6 +284,11 @@ struct ctx
     struct VLC_VECTOR(input_item_t *) next_medias;
     struct VLC_VECTOR(input_item_t *) added_medias;
     struct VLC_VECTOR(input_item_t *) played_medias;
+    /* Medias opened by the mock access, in order. The access can't lock
+     * the player: it is held while inputs are joined. */
+    vlc_mutex_t opened_lock;
+    vlc_cond_t opened_wait;
+    struct VLC_VECTOR(input_item_t *) opened_medias;
 
     size_t program_switch_count;
     size_t extra_start_count;
@@ -625,6 +640,18 @@ player_on_media_attachments_added(vlc_player_t *player,
     VEC_PUSH(on_media_attachments_added, report);
 }
 
+static void
+player_on_timeshift_changed(vlc_player_t *player, vlc_tick_t length,
+                            vlc_tick_t delay, void *data)
+{
+    struct ctx *ctx = get_ctx(player, data);
+    struct report_timeshift report = {
+        .length = length,
+        .delay = delay,
+    };
+    VEC_PUSH(on_timeshift_changed, report);
+}
+
 #define VEC_LAST(vec) (vec)->data[(vec)->size - 1]
 #define assert_position(ctx, report) do { \
     assert(fabs((report)->pos - (report)->time / (float) ctx->params.length) < 0.001); \
@@ -788,6 +815,10 @@ REPORT_LIST
 
     vlc_vector_clear(&ctx->played_medias);
 
+    vlc_mutex_lock(&ctx->opened_lock);
+    vlc_vector_clear(&ctx->opened_medias);
+    vlc_mutex_unlock(&ctx->opened_lock);
+
     ctx->extra_start_count = 0;
     ctx->program_switch_count = 1;
     ctx->rate = 1.f;
@@ -807,7 +838,8 @@ create_mock_media(const char *name, const struct media_params *params)
         "sub_packetized=%d;length=%"PRId64";audio_sample_length=%"PRId64";"
         "video_frame_rate=%u;video_frame_rate_base=%u;"
         "title_count=%zu;chapter_count=%zu;"
-        "can_seek=%d;can_pause=%d;error=%d;null_names=%d;pts_delay=%"PRId64";"
+        "can_seek=%d;can_pause=%d;can_control_pace=%d;error=%d;null_names=%d;"
+        "pts_delay=%"PRId64";"
         "config=%s;discontinuities=%s;attachment_count=%zu",
         params->track_count[VIDEO_ES], params->track_count[AUDIO_ES],
         params->track_count[SPU_ES], params->program_count,
@@ -815,7 +847,8 @@ create_mock_media(const char *name, const struct media_params *params)
         params->sub_packetized, params->length, params->audio_sample_length,
         params->video_frame_rate, params->video_frame_rate_base,
         params->title_count, params->chapter_count,
-        params->can_seek, params->can_pause, params->error, params->null_names,
+        params->can_seek, params->can_pause, params->can_control_pace,
+        params->error, params->null_names,
         params->pts_delay,
         params->config ? params->config : "",
         params->discontinuities ? params->discontinuities : "",
@@ -898,6 +931,21 @@ player_set_rate(struct ctx *ctx, float rate)
     ctx->rate = rate;
 }
 
+/* Wait for the mock access to open that many medias, and return the last one */
+static input_item_t *
+wait_opened_medias(struct ctx *ctx, size_t count)
+{
+    /* The inputs need the player lock to reach the access */
+    vlc_player_Unlock(ctx->player);
+    vlc_mutex_lock(&ctx->opened_lock);
+    while (ctx->opened_medias.size < count)
+        vlc_cond_wait(&ctx->opened_wait, &ctx->opened_lock);
+    input_item_t *media = ctx->opened_medias.data[count - 1];
+    vlc_mutex_unlock(&ctx->opened_lock);
+    vlc_player_Lock(ctx->player);
+    return media;
+}
+
 static void
 player_start(struct ctx *ctx)
 {
@@ -1978,6 +2026,62 @@ test_seeks(struct ctx *ctx)
     test_end(ctx);
 }
 
+static void
+test_timeshift(struct ctx *ctx)
+{
+    test_log("timeshift\n");
+    vlc_player_t *player = ctx->player;
+    vlc_object_t *libvlc = VLC_OBJECT(ctx->vlc->p_libvlc_int);
+
+    var_Create(libvlc, "input-timeshift-window", VLC_VAR_INTEGER);
+    var_SetInteger(libvlc, "input-timeshift-window", 60);
+    var_Create(libvlc, "input-timeshift-size", VLC_VAR_INTEGER);
+    var_SetInteger(libvlc, "input-timeshift-size", 16 * 1024 * 1024);
+
+    /* Live media, buffered by the timeshift from the start */
+    struct media_params params = DEFAULT_MEDIA_PARAMS(VLC_TICK_FROM_SEC(3));
+    params.can_seek = false;
+    params.can_control_pace = false;
+    player_set_next_mock_media(ctx, "media1", &params);
+
+    vlc_tick_t length, delay;
+    int ret = vlc_player_GetTimeshiftWindow(player, &length, &delay);
+    assert(ret == VLC_EGENERIC);
+
+    player_start(ctx);
+
+    vec_on_timeshift_changed *vec = &ctx->report.on_timeshift_changed;
+    while (vec->size == 0 || VEC_LAST(vec).length < VLC_TICK_FROM_SEC(1))
+        vlc_player_CondWait(player, &ctx->wait);
+
+    ret = vlc_player_GetTimeshiftWindow(player, &length, &delay);
+    assert(ret == VLC_SUCCESS);
+    assert(length == VEC_LAST(vec).length);
+    assert(delay == VEC_LAST(vec).delay);
+    assert(delay < length);
+
+    /* Seek back to the start of the window */
+    size_t seek_idx = vec->size;
+    vlc_player_SeekTimeshift(player, length);
+    for (;;)
+    {
+        while (vec->size == seek_idx)
+            vlc_player_CondWait(player, &ctx->wait);
+        if (vec->data[seek_idx].delay >= length / 2)
+            break;
+        seek_idx++;
+    }
+    assert(vec->data[seek_idx].length >= length);
+
+    ret = vlc_player_GetTimeshiftWindow(player, &length, &delay);
+    assert(ret == VLC_SUCCESS);
+    assert(delay > 0 && delay <= length);
+
+    test_end(ctx);
+    var_Destroy(libvlc, "input-timeshift-size");
+    var_Destroy(libvlc, "input-timeshift-window");
+}
+
 #define assert_media_name(media, name) do { \
     assert(media); \
     char *media_name = input_item_GetName(media); \
@@ -2026,6 +2130,111 @@ test_next_media(struct ctx *ctx)
     test_end(ctx);
 }
 
+static void
+test_prepare_next(struct ctx *ctx)
+{
+    test_log("prepare_next\n");
+    const char *media_names[] = { "media1", "media2", "media3" };
+    const size_t media_count = ARRAY_SIZE(media_names);
+
+    vlc_object_t *libvlc = VLC_OBJECT(ctx->vlc->p_libvlc_int);
+    struct media_params params = DEFAULT_MEDIA_PARAMS(VLC_TICK_FROM_SEC(1));
+
+    /* Longer than the media: the next one is opened as soon as possible */
+    var_Create(libvlc, "prepare-next", VLC_VAR_INTEGER);
+    var_SetInteger(libvlc, "prepare-next", 10000);
+
+    for (size_t i = 0; i < media_count; ++i)
+        player_set_next_mock_media(ctx, media_names[i], &params);
+    player_set_rate(ctx, 4.f);
+    player_start(ctx);
+
+    wait_state(ctx, VLC_PLAYER_STATE_STOPPED);
+    assert_normal_state(ctx);
+
+    {
+        vec_on_current_media_changed *vec = &ctx->report.on_current_media_changed;
+
+        assert(vec->size == media_count);
+        assert(ctx->next_medias.size == 0);
+        for (size_t i = 0; i < ctx->played_medias.size; ++i)
+            assert_media_name(vec->data[i], media_names[i]);
+
+        /* Each media was opened once: the prepared inputs were played */
+        vlc_mutex_lock(&ctx->opened_lock);
+        assert(ctx->opened_medias.size == media_count);
+        for (size_t i = 0; i < media_count; ++i)
+            assert(ctx->opened_medias.data[i] == vec->data[i]);
+        vlc_mutex_unlock(&ctx->opened_lock);
+    }
+
+    test_end(ctx);
+    var_Destroy(libvlc, "prepare-next");
+}
+
+static void
+test_prepare_next_discard(struct ctx *ctx)
+{
+    test_log("prepare_next_discard\n");
+    vlc_player_t *player = ctx->player;
+
+    vlc_object_t *libvlc = VLC_OBJECT(ctx->vlc->p_libvlc_int);
+    struct media_params params = DEFAULT_MEDIA_PARAMS(VLC_TICK_FROM_SEC(10));
+
+    var_Create(libvlc, "prepare-next", VLC_VAR_INTEGER);
+    var_SetInteger(libvlc, "prepare-next", 60000);
+
+    player_set_current_mock_media(ctx, "media1", &params, false);
+
+    params.length = VLC_TICK_FROM_SEC(1);
+    /* Not played, so not in added_medias */
+    input_item_t *media2 = create_mock_media("media2", &params);
+    assert(media2);
+    vlc_player_SetNextMedia(player, media2);
+
+    player_start(ctx);
+
+    /* The next media is opened while the current one plays */
+    input_item_t *opened = wait_opened_medias(ctx, 2);
+    assert(opened == media2);
+    input_item_Release(media2);
+
+    /* Its input is discarded when the next media changes, and the new next
+     * media is prepared instead */
+    input_item_t *media3 = create_mock_media("media3", &params);
+    assert(media3);
+    bool success = vlc_vector_push(&ctx->added_medias, media3);
+    assert(success);
+    success = vlc_vector_push(&ctx->played_medias, media3);
+    assert(success);
+    vlc_player_SetNextMedia(player, media3);
+
+    opened = wait_opened_medias(ctx, 3);
+    assert(opened == media3);
+
+    /* Reach the end of the current media */
+    player_set_rate(ctx, 32.f);
+
+    wait_state(ctx, VLC_PLAYER_STATE_STOPPED);
+    assert_normal_state(ctx);
+
+    {
+        vec_on_current_media_changed *vec = &ctx->report.on_current_media_changed;
+
+        assert(vec->size == 2);
+        assert_media_name(vec->data[0], "media1");
+        assert(vec->data[1] == media3);
+
+        /* The discarded input was not reused nor opened again */
+        vlc_mutex_lock(&ctx->opened_lock);
+        assert(ctx->opened_medias.size == 3);
+        vlc_mutex_unlock(&ctx->opened_lock);
+    }
+
+    test_end(ctx);
+    var_Destroy(libvlc, "prepare-next");
+}
+
 static void
 test_same_media(struct ctx *ctx)
 {
@@ -2304,11 +2513,14 @@ PLAYER_REPORT_LIST
         .next_medias = VLC_VECTOR_INITIALIZER,
         .added_medias = VLC_VECTOR_INITIALIZER,
         .played_medias = VLC_VECTOR_INITIALIZER,
+        .opened_medias = VLC_VECTOR_INITIALIZER,
         .program_switch_count = 1,
         .extra_start_count = 0,
         .rate = 1.f,
     };
     vlc_cond_init(&ctx->wait);
+    vlc_mutex_init(&ctx->opened_lock);
+    vlc_cond_init(&ctx->opened_wait);
     reports_init(&ctx->report);
 
     /* Force wdummy window */
@@ -3151,7 +3363,10 @@ main(void)
     test_media_stopped(&ctx);
     test_set_current_media(&ctx);
     test_next_media(&ctx);
+    test_prepare_next(&ctx);
+    test_prepare_next_discard(&ctx);
     test_seeks(&ctx);
+    test_timeshift(&ctx);
     test_pause(&ctx);
     test_capabilities_pause(&ctx);
     test_capabilities_seek(&ctx);
@@ -3274,6 +3489,25 @@ static int aout_Open(vlc_object_t *obj)
     return VLC_SUCCESS;
 }
 
+static int mock_access_Open(vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+
+    struct ctx *ctx = var_InheritAddress(obj, "test-ctx");
+    if (ctx != NULL && access->p_input_item != NULL)
+    {
+        vlc_mutex_lock(&ctx->opened_lock);
+        bool success = vlc_vector_push(&ctx->opened_medias,
+                                       access->p_input_item);
+        assert(success);
+        vlc_cond_signal(&ctx->opened_wait);
+        vlc_mutex_unlock(&ctx->opened_lock);
+    }
+
+    /* Let the mock access open the media */
+    return VLC_EGENERIC;
+}
+
 static block_t *resampler_Resample(filter_t *filter, block_t *in)
 {
     VLC_UNUSED(filter);
@@ -3306,6 +3540,11 @@ vlc_module_begin()
      * Insert our own resampler that keeps blocks and pts untouched. */
         set_capability ("audio resampler", 9999)
         set_callback (resampler_Open)
+    add_submodule ()
+    /* Record the medias opened by the mock access before it opens them. */
+        set_capability ("access", 1)
+        add_shortcut ("mock")
+        set_callback (mock_access_Open)
 vlc_module_end()
 
 VLC_EXPORT const vlc_plugin_cb vlc_static_modules[] = {
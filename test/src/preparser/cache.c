@@ -0,0 +1,300 @@
+/*****************************************************************************
+ * cache.c: test the preparsing results cache
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_preparser.h>
+#include <vlc_input_item.h>
+#include <vlc_modules.h>
+#include <vlc_fs.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#define WAV_DATA_SIZE 1600
+
+struct context
+{
+    vlc_sem_t sem;
+    size_t track_count;
+    unsigned channels;
+};
+
+static void parser_on_ended(input_item_t *item, int status, void *userdata)
+{
+    struct context *context = userdata;
+    assert(status == VLC_SUCCESS);
+
+    vlc_mutex_lock(&item->lock);
+    context->track_count = item->es_vec.size;
+    if (item->es_vec.size > 0)
+    {
+        const es_format_t *fmt = &item->es_vec.data[0].es;
+        assert(fmt->i_cat == AUDIO_ES);
+        context->channels = fmt->audio.i_channels;
+    }
+    vlc_mutex_unlock(&item->lock);
+
+    vlc_sem_post(&context->sem);
+}
+
+/* Returns the number of channels of the only track of the file */
+static unsigned parse(vlc_preparser_t *preparser, const char *uri)
+{
+    static const struct input_item_parser_cbs_t cbs = {
+        .on_ended = parser_on_ended,
+    };
+
+    struct context context = { .track_count = 0, .channels = 0 };
+    vlc_sem_init(&context.sem, 0);
+
+    /* A new item each time, so that tracks do not add up */
+    input_item_t *item = input_item_New(uri, "cache");
+    assert(item != NULL);
+
+    vlc_preparser_req_id id =
+        vlc_preparser_Push(preparser, item, VLC_PREPARSER_TYPE_PARSE, &cbs,
+                           &context);
+    assert(id != VLC_PREPARSER_REQ_ID_INVALID);
+    vlc_sem_wait(&context.sem);
+    input_item_Release(item);
+
+    assert(context.track_count == 1);
+    return context.channels;
+}
+
+static void write_le(uint8_t *p, uint32_t value, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        p[i] = value >> (8 * i);
+}
+
+/* Writes a silent 16 bits PCM file, its size does not depend on the channel
+ * count, and sets its modification time */
+static void write_wav_ns(const char *path, unsigned channels, time_t mtime,
+                         long mtime_nsec)
+{
+    uint8_t wav[44 + WAV_DATA_SIZE] = { 0 };
+    memcpy(&wav[0], "RIFF", 4);
+    write_le(&wav[4], sizeof(wav) - 8, 4);
+    memcpy(&wav[8], "WAVEfmt ", 8);
+    write_le(&wav[16], 16, 4);
+    write_le(&wav[20], 1, 2); /* PCM */
+    write_le(&wav[22], channels, 2);
+    write_le(&wav[24], 8000, 4);
+    write_le(&wav[28], 8000 * 2 * channels, 4);
+    write_le(&wav[32], 2 * channels, 2);
+    write_le(&wav[34], 16, 2);
+    memcpy(&wav[36], "data", 4);
+    write_le(&wav[40], WAV_DATA_SIZE, 4);
+
+    FILE *f = vlc_fopen(path, "wb");
+    assert(f != NULL);
+    size_t written = fwrite(wav, 1, sizeof(wav), f);
+    assert(written == sizeof(wav));
+    fclose(f);
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    const struct timespec times[2] = {
+        { .tv_sec = mtime, .tv_nsec = mtime_nsec },
+        { .tv_sec = mtime, .tv_nsec = mtime_nsec },
+    };
+    int ret = utimensat(AT_FDCWD, path, times, 0);
+#else
+    assert(mtime_nsec == 0);
+    struct utimbuf times = { .actime = mtime, .modtime = mtime };
+    int ret = utime(path, &times);
+#endif
+    assert(ret == 0);
+}
+
+static void write_wav(const char *path, unsigned channels, time_t mtime)
+{
+    write_wav_ns(path, channels, mtime, 0);
+}
+
+/* Returns the path of the only entry of the cache */
+static char *get_entry(const char *cache_dir)
+{
+    vlc_DIR *dir = vlc_opendir(cache_dir);
+    assert(dir != NULL);
+
+    char *entry = NULL;
+    const char *name;
+    while ((name = vlc_readdir(dir)) != NULL)
+    {
+        if (name[0] == '.')
+            continue;
+        assert(strncmp(name, "tmp.", 4) != 0);
+        assert(entry == NULL);
+        int ret = asprintf(&entry, "%s/%s", cache_dir, name);
+        assert(ret > 0);
+    }
+    vlc_closedir(dir);
+
+    assert(entry != NULL);
+    return entry;
+}
+
+static void remove_dir(const char *path)
+{
+    vlc_DIR *dir = vlc_opendir(path);
+    if (dir == NULL)
+        return;
+
+    const char *name;
+    while ((name = vlc_readdir(dir)) != NULL)
+    {
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+            continue;
+
+        char *child;
+        int ret = asprintf(&child, "%s/%s", path, name);
+        assert(ret > 0);
+        struct stat st;
+        if (vlc_stat(child, &st) == 0 && S_ISDIR(st.st_mode))
+            remove_dir(child);
+        else
+            vlc_unlink(child);
+        free(child);
+    }
+    vlc_closedir(dir);
+    rmdir(path);
+}
+
+int main(void)
+{
+    test_init();
+
+    char tmp_dir[] = "/tmp/libvlc_XXXXXX";
+    if (mkdtemp(tmp_dir) == NULL)
+    {
+        fprintf(stderr, "skip: mkdtemp failed\n");
+        return 77;
+    }
+
+    /* Keep the cache of the user untouched */
+    setenv("XDG_CACHE_HOME", tmp_dir, 1);
+
+    static const char * argv[] = {
+        "-v",
+        "--ignore-config",
+        "--preparse-cache",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    if (!module_exists("wav"))
+    {
+        fprintf(stderr, "skip: no \"wav\" module\n");
+        libvlc_release(vlc);
+        remove_dir(tmp_dir);
+        return 77;
+    }
+
+    const struct vlc_preparser_cfg cfg = {
+        .types = VLC_PREPARSER_TYPE_PARSE,
+        .max_parser_threads = 1,
+        .timeout = VLC_TICK_INVALID,
+    };
+    vlc_preparser_t *preparser =
+        vlc_preparser_New(VLC_OBJECT(vlc->p_libvlc_int), &cfg);
+    assert(preparser != NULL);
+
+    char *path, *uri, *cache_dir;
+    int ret = asprintf(&path, "%s/media.wav", tmp_dir);
+    assert(ret > 0);
+    ret = asprintf(&uri, "file://%s", path);
+    assert(ret > 0);
+    ret = asprintf(&cache_dir, "%s/vlc/preparsed", tmp_dir);
+    assert(ret > 0);
+
+    /* The file is parsed and saved */
+    const time_t mtime = 1000000000;
+    write_wav(path, 1, mtime);
+    assert(parse(preparser, uri) == 1);
+    char *entry = get_entry(cache_dir);
+
+    /* Same size and modification time: the results come from the cache */
+    write_wav(path, 2, mtime);
+    assert(parse(preparser, uri) == 1);
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    /* Rewritten within the same second: the file is parsed again */
+    write_wav_ns(path, 2, mtime, 500000000);
+    assert(parse(preparser, uri) == 2);
+    write_wav_ns(path, 1, mtime, 500000000);
+    assert(parse(preparser, uri) == 2);
+#endif
+
+    /* The modification time changed: the file is parsed again */
+    write_wav(path, 2, mtime + 10);
+    assert(parse(preparser, uri) == 2);
+
+    /* Saved with other meta types or track formats: the file is parsed
+     * again. The layout follows the magic line. */
+    FILE *f = vlc_fopen(entry, "r+b");
+    assert(f != NULL);
+    ret = fseek(f, strlen("VLC preparsed 2\n"), SEEK_SET);
+    assert(ret == 0);
+    const int64_t meta_count = VLC_META_TYPE_COUNT + 1;
+    size_t written = fwrite(&meta_count, sizeof(meta_count), 1, f);
+    assert(written == 1);
+    fclose(f);
+    write_wav(path, 1, mtime + 10);
+    assert(parse(preparser, uri) == 1);
+
+    /* Truncated entry: the file is parsed again */
+    struct stat st;
+    ret = vlc_stat(entry, &st);
+    assert(ret == 0);
+    ret = truncate(entry, st.st_size / 2);
+    assert(ret == 0);
+    write_wav(path, 2, mtime + 10);
+    assert(parse(preparser, uri) == 2);
+
+    /* Corrupt entry: the file is parsed again */
+    ret = vlc_stat(entry, &st);
+    assert(ret == 0);
+    f = vlc_fopen(entry, "r+b");
+    assert(f != NULL);
+    for (off_t i = 0; i < st.st_size; ++i)
+        fputc(0xff, f);
+    fclose(f);
+    write_wav(path, 1, mtime + 10);
+    assert(parse(preparser, uri) == 1);
+
+    /* And saved again */
+    write_wav(path, 2, mtime + 10);
+    assert(parse(preparser, uri) == 1);
+
+    vlc_preparser_Delete(preparser);
+    libvlc_release(vlc);
+
+    free(entry);
+    free(cache_dir);
+    free(uri);
+    free(path);
+    remove_dir(tmp_dir);
+    return 0;
+}
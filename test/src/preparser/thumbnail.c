@@ -232,6 +232,171 @@ static void test_cancel_thumbnail( libvlc_instance_t* p_vlc )
     vlc_preparser_Delete( p_thumbnailer );
 }
 
+struct storyboard_ctx
+{
+    vlc_sem_t sem;
+    const vlc_tick_t *expected_times;
+    size_t expected_count;
+    size_t picture_count;
+    unsigned columns;
+    unsigned tile_width;
+    unsigned tile_height;
+};
+
+static void check_storyboard_sprite( const struct storyboard_ctx *ctx,
+                                     const picture_t *sprite, size_t count )
+{
+    assert( sprite != NULL );
+    assert( sprite->format.i_chroma == VLC_CODEC_RGBA );
+
+    size_t rows = ( count + ctx->columns - 1 ) / ctx->columns;
+    assert( sprite->format.i_visible_width ==
+            __MIN( ctx->columns, count ) * ctx->tile_width );
+    assert( sprite->format.i_visible_height == rows * ctx->tile_height );
+
+    /* The mock frames are filled with a non-zero color, the tiles after the
+     * last frame are left transparent */
+    const plane_t *p = &sprite->p[0];
+    for ( size_t i = 0; i < rows * ctx->columns; ++i )
+    {
+        size_t x = i % ctx->columns * ctx->tile_width + ctx->tile_width / 2;
+        size_t y = i / ctx->columns * ctx->tile_height + ctx->tile_height / 2;
+        const uint8_t *pixel = &p->p_pixels[y * p->i_pitch
+                                            + x * p->i_pixel_pitch];
+        if ( i < count )
+            assert( pixel[0] != 0 && pixel[3] != 0 );
+        else
+            assert( pixel[0] == 0 && pixel[3] == 0 );
+    }
+}
+
+static void storyboard_picture_callback( input_item_t *item, size_t index,
+                                         vlc_tick_t time, picture_t *picture,
+                                         void *data )
+{
+    (void) item;
+    struct storyboard_ctx *ctx = data;
+
+    assert( picture != NULL );
+    assert( picture->format.i_chroma == VLC_CODEC_ARGB );
+    assert( index == ctx->picture_count );
+    assert( index < ctx->expected_count );
+    assert( time == ctx->expected_times[index] );
+    ctx->picture_count++;
+}
+
+static void storyboard_ended_callback( input_item_t *item, int status,
+                                       picture_t *sprite,
+                                       const vlc_tick_t *times, size_t count,
+                                       void *data )
+{
+    (void) item;
+    struct storyboard_ctx *ctx = data;
+
+    assert( status == VLC_SUCCESS );
+    if ( ctx->columns > 0 )
+        check_storyboard_sprite( ctx, sprite, count );
+    else
+        assert( sprite == NULL );
+    assert( count == ctx->expected_count );
+    assert( count == ctx->picture_count );
+    for ( size_t i = 0; i < count; ++i )
+        assert( times[i] == ctx->expected_times[i] );
+
+    vlc_sem_post( &ctx->sem );
+}
+
+static void test_storyboard( libvlc_instance_t* p_vlc )
+{
+    const struct vlc_preparser_cfg cfg = {
+        .types = VLC_PREPARSER_TYPE_STORYBOARD,
+        .timeout = VLC_TICK_INVALID,
+    };
+    vlc_preparser_t* p_thumbnailer = vlc_preparser_New(
+                VLC_OBJECT( p_vlc->p_libvlc_int ), &cfg );
+    assert( p_thumbnailer != NULL );
+
+    char* psz_mrl;
+    if ( asprintf( &psz_mrl, "mock://video_track_count=1;audio_track_count=1"
+                   ";length=%" PRId64 ";video_chroma=ARGB", MOCK_DURATION ) < 0 )
+        assert( !"Failed to allocate mock mrl" );
+    input_item_t* p_item = input_item_New( psz_mrl, "mock item" );
+    assert( p_item != NULL );
+
+    static const struct vlc_thumbnailer_storyboard_cbs cbs = {
+        .on_picture = storyboard_picture_callback,
+        .on_ended = storyboard_ended_callback,
+    };
+
+    struct storyboard_ctx ctx;
+    vlc_sem_init( &ctx.sem, 0 );
+
+    /* Explicit seek points, all in the same input */
+    static const vlc_tick_t times[] = {
+        VLC_TICK_FROM_SEC( 10 ), VLC_TICK_FROM_SEC( 60 ), VLC_TICK_FROM_SEC( 120 ),
+    };
+    ctx.expected_times = times;
+    ctx.expected_count = ARRAY_SIZE( times );
+    ctx.picture_count = 0;
+    ctx.columns = 0;
+
+    struct vlc_thumbnailer_storyboard_arg arg = {
+        .times = times,
+        .count = ARRAY_SIZE( times ),
+        .speed = VLC_THUMBNAILER_STORYBOARD_FAST,
+    };
+    vlc_preparser_req_id id =
+        vlc_preparser_GenerateStoryboard( p_thumbnailer, p_item, &arg, &cbs,
+                                          &ctx );
+    assert( id != VLC_PREPARSER_REQ_ID_INVALID );
+    vlc_sem_wait( &ctx.sem );
+
+    /* One frame per minute, stopping at the end of the media */
+    static const vlc_tick_t interval_times[] = {
+        0, VLC_TICK_FROM_SEC( 60 ), VLC_TICK_FROM_SEC( 120 ),
+        VLC_TICK_FROM_SEC( 180 ), VLC_TICK_FROM_SEC( 240 ),
+    };
+    ctx.expected_times = interval_times;
+    ctx.expected_count = ARRAY_SIZE( interval_times );
+    ctx.picture_count = 0;
+    ctx.columns = 0;
+
+    arg = (struct vlc_thumbnailer_storyboard_arg) {
+        .interval = VLC_TICK_FROM_SEC( 60 ),
+        .speed = VLC_THUMBNAILER_STORYBOARD_PRECISE,
+    };
+    id = vlc_preparser_GenerateStoryboard( p_thumbnailer, p_item, &arg, &cbs,
+                                           &ctx );
+    assert( id != VLC_PREPARSER_REQ_ID_INVALID );
+    vlc_sem_wait( &ctx.sem );
+
+    /* Same seek points tiled in a 2x2 sprite, the last tile staying empty */
+    ctx.expected_times = times;
+    ctx.expected_count = ARRAY_SIZE( times );
+    ctx.picture_count = 0;
+    ctx.columns = 2;
+    ctx.tile_width = 32;
+    ctx.tile_height = 24;
+
+    arg = (struct vlc_thumbnailer_storyboard_arg) {
+        .times = times,
+        .count = ARRAY_SIZE( times ),
+        .speed = VLC_THUMBNAILER_STORYBOARD_FAST,
+        .columns = ctx.columns,
+        .tile_width = ctx.tile_width,
+        .tile_height = ctx.tile_height,
+    };
+    id = vlc_preparser_GenerateStoryboard( p_thumbnailer, p_item, &arg, &cbs,
+                                           &ctx );
+    assert( id != VLC_PREPARSER_REQ_ID_INVALID );
+    vlc_sem_wait( &ctx.sem );
+
+    input_item_Release( p_item );
+    free( psz_mrl );
+
+    vlc_preparser_Delete( p_thumbnailer );
+}
+
 int main( void )
 {
     test_init();
@@ -245,6 +410,7 @@ int main( void )
 
     test_thumbnails( vlc );
     test_cancel_thumbnail( vlc );
+    test_storyboard( vlc );
 
     libvlc_release( vlc );
 }